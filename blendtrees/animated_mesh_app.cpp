@@ -14,13 +14,32 @@
 #include <maths/math_utils.h>
 #include <graphics/renderer_3d.h>
 #include <graphics/scene.h>
+#include <system/job_system.h>
 #include <animation/skeleton.h>
 #include <animation/animation.h>
+#include <system/string_id.h>
+#include <assets/asset_loader.h>
+
+// blend tree variables, hashed at compile time so setting them every frame doesn't hash the names
+static constexpr gef::StringId kIdleWalkBlend = gef::ConstStringId("idle_walk_blend");
+static constexpr gef::StringId kWalkRunBlend = gef::ConstStringId("walk_run_blend");
+static constexpr gef::StringId kJumpBlend = gef::ConstStringId("jump_blend");
+
+// speed 0 to 1 blends from idle to walk, 1 to 2 from walk to run
+static const float kMaxSpeed = 2.0f;
+
+// milliseconds a frame the asset loader can spend creating what it has loaded
+static const float kAssetLoadBudgetMs = 1.0f;
+
+// how fast holding a key changes a blend, per second so it doesn't depend on the update rate
+static const float kBlendKeyRate = 0.6f;
 
 AnimatedMeshApp::AnimatedMeshApp(gef::Platform& platform) :
 	Application(platform),
 	sprite_renderer_(NULL),
 	font_(NULL),
+	asset_loader_(NULL),
+	run_anim_request_(NULL),
 	mesh_(NULL),
 	player_(NULL),
 	renderer_3d_(NULL),
@@ -28,7 +47,8 @@ AnimatedMeshApp::AnimatedMeshApp(gef::Platform& platform) :
 	walk_anim(NULL),
 	run_anim(NULL),
 	idle_anim(NULL),
-	jump_anim(NULL)
+	jump_anim(NULL),
+	run_clip_node(NULL)
 {
 }
 
@@ -37,6 +57,7 @@ void AnimatedMeshApp::Init()
 	sprite_renderer_ = gef::SpriteRenderer::Create(platform_);
 	renderer_3d_ = gef::Renderer3D::Create(platform_);
 	input_manager_ = gef::InputManager::Create(platform_);
+	asset_loader_ = new gef::AssetLoader(platform_);
 
 	InitFont();
 	SetupCamera();
@@ -49,7 +70,11 @@ void AnimatedMeshApp::Init()
 	model_scene_->ReadSceneFromFile(platform_, "xbot/xbot.scn");
 
 	// we do want to render the data stored in the scene file so lets create the materials from the material data present in the scene file
-	model_scene_->CreateMaterials(platform_);
+	// the textures are decoded on every core, the job system is only needed while loading
+	{
+		gef::JobSystem load_job_system;
+		model_scene_->CreateMaterials(platform_, &load_job_system);
+	}
 
 	// if there is mesh data in the scene, create a mesh to draw from the first mesh
 	mesh_ = GetFirstMesh(model_scene_);
@@ -68,7 +93,13 @@ void AnimatedMeshApp::Init()
 	jump_anim = LoadAnimation("xbot/xbot@jump.scn", "");
 	idle_anim = LoadAnimation("xbot/xbot@idle.scn", "");
 
+	// the run isn't needed until the player speeds up, so it's read on the loader thread while the app runs, see UpdateLoads
+	run_anim_request_ = asset_loader_->LoadScene("xbot/xbot@running_inplace.scn", 0);
+
 	InitBlendTree();
+
+	// animation only needs updating at 30Hz, Render interpolates between the updates
+	set_fixed_time_step(1.0f / 30.0f);
 }
 
 
@@ -76,12 +107,26 @@ void AnimatedMeshApp::CleanUp()
 {
 	CleanUpFont();
 
+	// a finished load's scene is ours to delete, Release abandons one that hasn't finished
+	if (run_anim_request_)
+	{
+		delete run_anim_request_->scene();
+		asset_loader_->Release(run_anim_request_);
+		run_anim_request_ = NULL;
+	}
+
+	delete asset_loader_;
+	asset_loader_ = NULL;
+
 	delete player_;
 	player_ = NULL;
 
 	delete walk_anim;
 	walk_anim = NULL;
 
+	delete run_anim;
+	run_anim = NULL;
+
 	delete mesh_;
 	mesh_ = NULL;
 
@@ -100,7 +145,11 @@ void AnimatedMeshApp::CleanUp()
 
 bool AnimatedMeshApp::Update(float frame_time)
 {
-	fps_ = 1.0f / frame_time;
+	// Update runs at the fixed time step, the frame rate comes from the real time the last frame took
+	fps_ = real_frame_time() > 0.0f ? 1.0f / real_frame_time() : 0.0f;
+	const float blend_step = kBlendKeyRate * frame_time;
+
+	UpdateLoads();
 
 	// read input devices
 	if (input_manager_)
@@ -119,20 +168,20 @@ bool AnimatedMeshApp::Update(float frame_time)
 		{
 			if (keyboard->IsKeyDown(keyboard->KC_2))
 			{
-				speed = speed >= 1.0f ? 1.0f : speed + 0.01f;
+				speed = speed + blend_step >= kMaxSpeed ? kMaxSpeed : speed + blend_step;
 			}
 			if (keyboard->IsKeyDown(keyboard->KC_1))
 			{
-				speed = speed <= 0 ? 0 : speed - 0.01f;
+				speed = speed - blend_step <= 0.0f ? 0.0f : speed - blend_step;
 			}
 
 			if (keyboard->IsKeyDown(keyboard->KC_NUMPADSTAR))
 			{
-				jumpBlend = jumpBlend >= 1.0f ? 1.0f : jumpBlend + 0.01f;
+				jumpBlend = jumpBlend + blend_step >= 1.0f ? 1.0f : jumpBlend + blend_step;
 			}
 			else if (keyboard->IsKeyDown(keyboard->KC_NUMPADSLASH))
 			{
-				jumpBlend = jumpBlend <= 0.0f ? 0.0f : jumpBlend - 0.01f;
+				jumpBlend = jumpBlend - blend_step <= 0.0f ? 0.0f : jumpBlend - blend_step;
 			}
 		}
 
@@ -141,13 +190,14 @@ bool AnimatedMeshApp::Update(float frame_time)
 
 	if(player_)
 	{
-		blend_tree.variables_["idle_walk_blend"] = speed;
-		blend_tree.variables_["jump_blend"] = jumpBlend;
+		blend_tree.variables_[kIdleWalkBlend] = speed < 1.0f ? speed : 1.0f;
+		blend_tree.variables_[kWalkRunBlend] = speed > 1.0f ? speed - 1.0f : 0.0f;
+		blend_tree.variables_[kJumpBlend] = jumpBlend;
 		blend_tree.Update(frame_time);
-		blended_pose = blend_tree.output_.output_pose_;
 
-		player_->UpdateBoneMatrices(blended_pose);
-		
+		// keep the last result so Render can interpolate between the two fixed rate updates
+		previous_blended_pose = blended_pose;
+		blended_pose = blend_tree.output_.output_pose_;
 	}
 
 	// build a transformation matrix that will position the character
@@ -191,7 +241,10 @@ void AnimatedMeshApp::Render()
 
 	// draw the player, the pose is defined by the bone matrices
 	if(player_)
+	{
+		player_->UpdateBoneMatrices(previous_blended_pose, blended_pose, interpolation_alpha());
 		renderer_3d_->DrawSkinnedMesh(*player_, player_->bone_matrices());
+	}
 
 	renderer_3d_->End();
 
@@ -280,27 +333,58 @@ gef::Animation* AnimatedMeshApp::LoadAnimation(const char* anim_scene_filename,
 
 	gef::Scene anim_scene;
 	if (anim_scene.ReadSceneFromFile(platform_, anim_scene_filename))
-	{
-		// if the animation name is specified then try and find the named anim
-		// otherwise return the first animation if there is one
-		std::map<gef::StringId, gef::Animation*>::const_iterator anim_node_iter;
-		if (anim_name)
-			anim_node_iter = anim_scene.animations.find(gef::GetStringId(anim_name));
-		else
-			anim_node_iter = anim_scene.animations.begin();
-
-		if (anim_node_iter != anim_scene.animations.end())
-			anim = new gef::Animation(*anim_node_iter->second);
-	}
+		anim = CopyAnimation(anim_scene, anim_name);
 
 	return anim;
 }
 
+gef::Animation* AnimatedMeshApp::CopyAnimation(const gef::Scene& anim_scene, const char* anim_name)
+{
+	gef::Animation* anim = NULL;
+
+	// if the animation name is specified then try and find the named anim
+	// otherwise return the first animation if there is one
+	std::map<gef::StringId, gef::Animation*>::const_iterator anim_node_iter;
+	if (anim_name)
+		anim_node_iter = anim_scene.animations.find(gef::GetStringId(anim_name));
+	else
+		anim_node_iter = anim_scene.animations.begin();
+
+	if (anim_node_iter != anim_scene.animations.end())
+		anim = new gef::Animation(*anim_node_iter->second);
+
+	return anim;
+}
+
+void AnimatedMeshApp::UpdateLoads()
+{
+	asset_loader_->Update(kAssetLoadBudgetMs);
+
+	if (run_anim_request_ && run_anim_request_->done())
+	{
+		gef::Scene* anim_scene = run_anim_request_->scene();
+		if (anim_scene)
+		{
+			run_anim = CopyAnimation(*anim_scene, NULL);
+			delete anim_scene;
+		}
+
+		asset_loader_->Release(run_anim_request_);
+		run_anim_request_ = NULL;
+
+		// until now the run input has been playing the walk
+		if (run_anim && run_clip_node)
+			run_clip_node->SetClip(run_anim);
+	}
+}
+
 void AnimatedMeshApp::InitBlendTree()
 {
 	if (player_ && player_->bind_pose().skeleton())
 	{
 		blend_tree.Init(player_->bind_pose());
+		blended_pose = player_->bind_pose();
+		previous_blended_pose = player_->bind_pose();
 
 		//create clip node for idle
 		ClipNode* idle_clip_node = new ClipNode(&blend_tree);
@@ -312,23 +396,34 @@ void AnimatedMeshApp::InitBlendTree()
 		ClipNode* jump_clip_node = new ClipNode(&blend_tree);
 		jump_clip_node->SetClip(jump_anim);
 
+		// the run clip is still loading, the walk stands in for it so the tree is valid until UpdateLoads swaps it in
+		run_clip_node = new ClipNode(&blend_tree);
+		run_clip_node->SetClip(run_anim ? run_anim : walk_anim);
+
 		//create linear2blend node
 		Linear2BlendNode* l2b_node_idle_walk = new Linear2BlendNode(&blend_tree);
+		Linear2BlendNode* l2b_node_walk_run = new Linear2BlendNode(&blend_tree);
 		Linear2BlendNode* l2b_node_move_jump = new Linear2BlendNode(&blend_tree);
 
 		//set variables
-		blend_tree.variables_["idle_walk_blend"] = speed;
-		l2b_node_idle_walk->SetVariable(0, "idle_walk_blend");
+		blend_tree.variables_[kIdleWalkBlend] = speed < 1.0f ? speed : 1.0f;
+		l2b_node_idle_walk->SetVariable(0, kIdleWalkBlend);
 
-		blend_tree.variables_["jump_blend"] = jumpBlend;
-		l2b_node_move_jump->SetVariable(0, "jump_blend");
+		blend_tree.variables_[kWalkRunBlend] = speed > 1.0f ? speed - 1.0f : 0.0f;
+		l2b_node_walk_run->SetVariable(0, kWalkRunBlend);
+
+		blend_tree.variables_[kJumpBlend] = jumpBlend;
+		l2b_node_move_jump->SetVariable(0, kJumpBlend);
 
 		//connect nodes
 		
 		l2b_node_idle_walk->SetInput(0, idle_clip_node);
 		l2b_node_idle_walk->SetInput(1, walk_clip_node);
 		
-		l2b_node_move_jump->SetInput(0, l2b_node_idle_walk);
+		l2b_node_walk_run->SetInput(0, l2b_node_idle_walk);
+		l2b_node_walk_run->SetInput(1, run_clip_node);
+
+		l2b_node_move_jump->SetInput(0, l2b_node_walk_run);
 		l2b_node_move_jump->SetInput(1, jump_clip_node);
 
 		blend_tree.output_.SetInput(0, l2b_node_move_jump);
@@ -23,6 +23,8 @@ namespace gef
 	class Scene;
 	class Skeleton;
 	class InputManager;
+	class AssetLoader;
+	class AssetRequest;
 }
 
 class AnimatedMeshApp : public gef::Application
@@ -45,7 +47,9 @@ private:
 	void SetupLights();
 	void SetupCamera();
 	void InitBlendTree();
+	void UpdateLoads();
 	gef::Animation* LoadAnimation(const char* anim_scene_filename, const char* anim_name);
+	gef::Animation* CopyAnimation(const gef::Scene& anim_scene, const char* anim_name);
 
 
 	gef::SpriteRenderer* sprite_renderer_;
@@ -53,6 +57,10 @@ private:
 	gef::InputManager* input_manager_;
 	gef::Font* font_;
 
+	// streams in the clips that aren't needed straight away
+	gef::AssetLoader* asset_loader_;
+	gef::AssetRequest* run_anim_request_;
+
 	float fps_;
 
 	class gef::Mesh* mesh_;
@@ -71,11 +79,13 @@ private:
 	gef::Animation* walk_anim;
 	MotionClipPlayer anim_player_run;
 	gef::Animation* run_anim;
+	ClipNode* run_clip_node;
 	MotionClipPlayer anim_player_idle;
 	gef::Animation* idle_anim;
 	MotionClipPlayer anim_player_jump;
 	gef::Animation* jump_anim;
 	gef::SkeletonPose blended_pose;
+	gef::SkeletonPose previous_blended_pose;
 
 	BlendTree blend_tree;
 
@@ -1,4 +1,6 @@
 #include "blend_tree.h"
+#include <system/profiler.h>
+#include <system/memory_tracker.h>
 
 BlendNode::BlendNode(BlendTree* _tree) :
 	tree_(_tree)
@@ -35,7 +37,7 @@ bool BlendNode::Update(float delta_time)
 	{
 		for (int variable_num = 0; variable_num < variables_.size(); ++variable_num)
 		{
-			const std::string& variable = variables_[variable_num];
+			const gef::StringId variable = variables_[variable_num];
 			bool variable_valid = tree_->variables_.find(variable) != tree_->variables_.end();
 
 			if (!variable_valid && all_variables_valid)
@@ -72,9 +74,9 @@ void BlendNode::SetInput(int input_num, BlendNode* node)
 }
 
 
-void BlendNode::SetVariable(int variable_num, const std::string& variable)
+void BlendNode::SetVariable(int variable_num, gef::StringId variable)
 {
-	if (variable.size() > 0 && variable_num < variables_.size())
+	if (variable != 0 && variable_num < variables_.size())
 	{
 		variables_[variable_num] = variable;
 	}
@@ -105,6 +107,9 @@ void BlendTree::Start()
 
 void BlendTree::Update(float delta_time)
 {
+	GEF_PROFILE_ZONE("BlendTree::Update");
+	GEF_MEMORY_TAG(gef::MT_ANIMATION);
+
 	bool valid = output_.Update(delta_time);
 }
 
@@ -1,5 +1,6 @@
 #pragma once
 #include <animation/skeleton.h>
+#include <system/string_id.h>
 #include <vector>
 #include "motion_clip_player.h"
 #include <map>
@@ -26,7 +27,7 @@ class BlendNode
 public:
 	BlendNode(BlendTree* _tree);
 	std::vector<BlendNodeInput> inputs_;
-	std::vector<std::string> variables_;
+	std::vector<gef::StringId> variables_;
 	gef::SkeletonPose output_pose_;
 	BlendTree* tree_;
 
@@ -35,7 +36,7 @@ public:
 	virtual bool Process(float delta_time) = 0;
 	virtual void StartInternal() {}
 	void SetInput(int input_num, BlendNode* node);
-	void SetVariable(int variable_num, const std::string& variable);
+	void SetVariable(int variable_num, gef::StringId variable);
 
 };
 
@@ -76,7 +77,7 @@ public:
 	OutputNode output_;
 	gef::SkeletonPose bind_pose_;
 
-	std::map<std::string, float> variables_;
+	std::map<gef::StringId, float> variables_;
 
 };
 
@@ -1,6 +1,7 @@
 #include "motion_clip_player.h"
 #include <animation/animation.h>
 #include <system/debug_log.h>
+#include <cmath>
 
 MotionClipPlayer::MotionClipPlayer() :
 clip_(NULL),
@@ -30,7 +31,7 @@ bool MotionClipPlayer::Update(const float delta_time, const gef::SkeletonPose& b
 			// if the animation is looping then wrap the playback time round to the beginning of the animation
 			// other wise set the playback time to the end of the animation and flag that we have reached the end
 			if(looping_)
-				anim_time_ = std::fmodf(anim_time_, clip_->duration());
+				anim_time_ = std::fmod(anim_time_, clip_->duration());
 			else
 			{
 				anim_time_ = clip_->duration();
@@ -17,7 +17,16 @@
 #include <animation/skeleton.h>
 #include <animation/animation.h>
 #include <system/debug_log.h>
+#include <system/memory_tracker.h>
+#include <system/job_system.h>
 #include "ragdoll.h"
+#include "gef_task_scheduler.h"
+
+#if BT_THREADSAFE
+#include "BulletCollision/CollisionDispatch/btCollisionDispatcherMt.h"
+#include "BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolverMt.h"
+#include "BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h"
+#endif
 
 std::string model_name("xbot");
 
@@ -37,11 +46,19 @@ AnimatedMeshApp::AnimatedMeshApp(gef::Platform& platform) :
 	solver_(NULL),
 	overlapping_pair_cache_(NULL),
 	dispatcher_(NULL),
+	solver_pool_(NULL),
+	job_system_(NULL),
+	task_scheduler_(NULL),
+	physics_thread_(NULL),
 	debug_drawer_(NULL),
 	floor_mesh_(NULL),
 	sphere_mesh_(NULL),
 	sphere_rb_(NULL),
-	ragdoll_(NULL)
+	ragdoll_template_(NULL),
+	ragdoll_(NULL),
+	ragdoll_instance_(NULL),
+	hit_reaction_joint_(-1),
+	is_hit_reacting_(false)
 {
 }
 
@@ -55,6 +72,9 @@ void AnimatedMeshApp::Init()
 	SetupCamera();
 	SetupLights();
 
+	// physics and animation are stepped at a fixed rate so the simulation is deterministic
+	set_fixed_time_step(1.0f / 60.0f);
+
 	// create a new scene object and read in the data from the file
 	// no meshes or materials are created yet
 	// we're not making any assumptions about what the data may be loaded in for
@@ -65,7 +85,11 @@ void AnimatedMeshApp::Init()
 	model_scene_->ReadSceneFromFile(platform_, model_scene_name.c_str());
 
 	// we do want to render the data stored in the scene file so lets create the materials from the material data present in the scene file
-	model_scene_->CreateMaterials(platform_);
+	// the textures are decoded on every core, the job system is only needed while loading
+	{
+		gef::JobSystem load_job_system;
+		model_scene_->CreateMaterials(platform_, &load_job_system);
+	}
 
 	// if there is mesh data in the scene, create a mesh to draw from the first mesh
 	mesh_ = GetFirstMesh(model_scene_);
@@ -92,6 +116,9 @@ void AnimatedMeshApp::Init()
 		const float scale = 0.01f;
 		player_transform.Scale(gef::Vector4(scale, scale, scale));
 		player_->set_transform(player_transform);
+
+		ragdoll_instance_ = new gef::SkinnedMeshInstance(*skeleton);
+		ragdoll_instance_->set_mesh(mesh_);
 	}
 
 
@@ -123,16 +150,41 @@ void AnimatedMeshApp::InitRagdoll()
 {
 	if (player_->bind_pose().skeleton())
 	{
-		ragdoll_ = new Ragdoll();
-		ragdoll_->set_scale_factor(0.01f);
-
+		// the physics file is only read once, every ragdoll for this model is created from the template
 		std::string ragdoll_filename;
 		ragdoll_filename = model_name + "/ragdoll.bullet";
 
-		ragdoll_->Init(player_->bind_pose(), dynamics_world_, ragdoll_filename.c_str());
+		ragdoll_template_ = new RagdollTemplate();
+		if (ragdoll_template_->Load(player_->bind_pose(), ragdoll_filename.c_str(), 0.01f))
+		{
+			gef::Matrix44 transform;
+			transform.SetIdentity();
+
+			ragdoll_ = new Ragdoll();
+			ragdoll_->Init(*ragdoll_template_, dynamics_world_, transform);
+		}
 	}
 
+	ragdoll_manager_.Init(dynamics_world_);
+
 	is_ragdoll_simulating_ = false;
+	is_hit_reacting_ = false;
+
+	if (player_->bind_pose().skeleton())
+		hit_reaction_joint_ = player_->bind_pose().skeleton()->FindJointIndex(gef::GetStringId("mixamorig:LeftArm"));
+}
+
+void AnimatedMeshApp::SpawnRagdoll()
+{
+	if (!ragdoll_template_ || !ragdoll_)
+		return;
+
+	// spawned ragdolls start from the current animation pose, lined up next to the player
+	gef::Matrix44 transform;
+	transform.SetIdentity();
+	transform.SetTranslation(gef::Vector4(1.0f * (ragdoll_manager_.ragdoll_count() + 1), 0.0f, 0.0f));
+
+	ragdoll_manager_.Spawn(*ragdoll_template_, transform, clip_player_.pose());
 }
 
 void AnimatedMeshApp::CleanUp()
@@ -151,6 +203,9 @@ void AnimatedMeshApp::CleanUp()
 
 	CleanUpFont();
 
+	delete ragdoll_instance_;
+	ragdoll_instance_ = NULL;
+
 	delete player_;
 	player_ = NULL;
 
@@ -179,13 +234,20 @@ void AnimatedMeshApp::CleanUp()
 
 void AnimatedMeshApp::CleanUpRagdoll()
 {
+	ragdoll_manager_.CleanUp();
+
 	delete ragdoll_;
 	ragdoll_ = NULL;
+
+	// the template owns the collision shapes the ragdolls share, so it goes last
+	delete ragdoll_template_;
+	ragdoll_template_ = NULL;
 }
 
 bool AnimatedMeshApp::Update(float frame_time)
 {
-	fps_ = 1.0f / frame_time;
+	// Update runs at the fixed time step, the frame rate comes from the real time the last frame took
+	fps_ = real_frame_time() > 0.0f ? 1.0f / real_frame_time() : 0.0f;
 
 
 	// read input devices
@@ -206,10 +268,28 @@ bool AnimatedMeshApp::Update(float frame_time)
 			if (keyboard->IsKeyPressed(gef::Keyboard::KC_SPACE))
 			{
 				is_ragdoll_simulating_ = !is_ragdoll_simulating_;
+				if (is_hit_reacting_ && ragdoll_)
+					ragdoll_->SetSimulatedSubtree(-1);
+				is_hit_reacting_ = false;
+			}
+
+			// H simulates the left arm only while the rest of the body carries on animating
+			if (keyboard->IsKeyPressed(gef::Keyboard::KC_H) && ragdoll_ && hit_reaction_joint_ != -1 && !is_ragdoll_simulating_)
+			{
+				is_hit_reacting_ = !is_hit_reacting_;
+				ragdoll_->SetSimulatedSubtree(is_hit_reacting_ ? hit_reaction_joint_ : -1);
+			}
+
+			if (keyboard->IsKeyPressed(gef::Keyboard::KC_R))
+			{
+				SpawnRagdoll();
 			}
 		}
 	}
 
+	// the animation is sampled while the physics thread steps the world
+	BeginPhysicsStep(frame_time);
+
 	// update the current animation that is playing
 	if (player_)
 	{
@@ -217,9 +297,12 @@ bool AnimatedMeshApp::Update(float frame_time)
 		player_->UpdateBoneMatrices(clip_player_.pose());
 	}
 
-	UpdatePhysicsWorld(frame_time);
+	EndPhysicsStep();
 	UpdateRigidBodies();
 
+	// spawned ragdolls are frozen once they settle and simulated more cheaply the further they are from the camera
+	ragdoll_manager_.Update(camera_eye_);
+
 
 
 	if (player_ && ragdoll_)
@@ -229,6 +312,15 @@ bool AnimatedMeshApp::Update(float frame_time)
 			ragdoll_->UpdatePoseFromRagdoll();
 			player_->UpdateBoneMatrices(ragdoll_->pose());
 		}
+		else if (is_hit_reacting_)
+		{
+			ragdoll_->UpdatePoseFromRagdoll();
+			ragdoll_->BlendPose(clip_player_.pose(), 1.0f);
+			player_->UpdateBoneMatrices(ragdoll_->blended_pose());
+
+			// the rest of the ragdoll follows the animation into the next physics step
+			ragdoll_->UpdateKinematicBodies(clip_player_.pose());
+		}
 		else
 		{
 			ragdoll_->set_pose(clip_player_.pose());
@@ -258,6 +350,18 @@ void AnimatedMeshApp::Render()
 		renderer_3d_->DrawSkinnedMesh(*player_, player_->bone_matrices());
 	}
 
+	// spawned ragdolls are drawn from their poses, frozen ones are out of the physics world so the debug draw misses them
+	if (ragdoll_instance_)
+	{
+		for (int ragdoll_num = 0; ragdoll_num < ragdoll_manager_.ragdoll_count(); ++ragdoll_num)
+		{
+			Ragdoll* ragdoll = ragdoll_manager_.ragdoll(ragdoll_num);
+			ragdoll_instance_->set_transform(ragdoll->model_to_world());
+			ragdoll_instance_->UpdateBoneMatrices(ragdoll->pose());
+			renderer_3d_->DrawSkinnedMesh(*ragdoll_instance_, ragdoll_instance_->bone_matrices());
+		}
+	}
+
 	renderer_3d_->DrawMesh(floor_gfx_);
 	renderer_3d_->DrawMesh(sphere_gfx_);
 
@@ -290,6 +394,9 @@ void AnimatedMeshApp::DrawHUD()
 	{
 		// display frame rate
 		font_->RenderText(sprite_renderer_, gef::Vector4(850.0f, 510.0f, -0.9f), 1.0f, 0xffffffff, gef::TJ_LEFT, "FPS: %.1f", fps_);
+
+		if (ragdoll_manager_.ragdoll_count())
+			font_->RenderText(sprite_renderer_, gef::Vector4(650.0f, 480.0f, -0.9f), 1.0f, 0xffffffff, gef::TJ_LEFT, "Ragdolls: %d active, %d frozen", ragdoll_manager_.active_count(), ragdoll_manager_.ragdoll_count() - ragdoll_manager_.active_count());
 	}
 }
 
@@ -369,19 +476,38 @@ gef::Animation* AnimatedMeshApp::LoadAnimation(const char* anim_scene_filename,
 
 void AnimatedMeshApp::InitPhysicsWorld()
 {
+#if BT_THREADSAFE
+	// Bullet's parallel loops run on the same worker threads as the rest of the app
+	job_system_ = new gef::JobSystem();
+	task_scheduler_ = new GefTaskScheduler(*job_system_);
+#endif
+
+	// the physics thread sets the task scheduler, so it is created before anything that needs it
+	physics_thread_ = new PhysicsThread(task_scheduler_);
+
 	/// collision configuration contains default setup for memory , collision setup . Advanced users can create their own configuration .
 	btDefaultCollisionConfiguration * collision_configuration = new btDefaultCollisionConfiguration();
 
-	/// use the default collision dispatcher . For parallel processing you can use a diffent dispatcher(see Extras / BulletMultiThreaded)
-	dispatcher_ = new btCollisionDispatcher(collision_configuration);
-
 	/// btDbvtBroadphase is a good general purpose broadphase . You can also try out btAxis3Sweep .
 	overlapping_pair_cache_ = new btDbvtBroadphase();
 
+#if BT_THREADSAFE
+	// narrowphase and island solving are spread over the task scheduler's threads
+	dispatcher_ = new btCollisionDispatcherMt(collision_configuration);
+	btConstraintSolverPoolMt* solver_pool = new btConstraintSolverPoolMt(task_scheduler_->getNumThreads());
+	solver_pool_ = solver_pool;
+	solver_ = new btSequentialImpulseConstraintSolverMt;
+
+	dynamics_world_ = new btDiscreteDynamicsWorldMt(dispatcher_, overlapping_pair_cache_, solver_pool, solver_, collision_configuration);
+#else
+	/// use the default collision dispatcher . For parallel processing you can use a diffent dispatcher(see Extras / BulletMultiThreaded)
+	dispatcher_ = new btCollisionDispatcher(collision_configuration);
+
 	/// the default constraint solver . For parallel processing you can use a different solver (see Extras / BulletMultiThreaded)
 	solver_ = new btSequentialImpulseConstraintSolver;
 
 	dynamics_world_ = new btDiscreteDynamicsWorld(dispatcher_, overlapping_pair_cache_, solver_, collision_configuration);
+#endif
 	dynamics_world_->setGravity(btVector3(0, -9.8f, 0));
 
 
@@ -429,6 +555,7 @@ void AnimatedMeshApp::CleanUpPhysicsWorld()
 
 	// delete solver
 	delete solver_;
+	delete solver_pool_;
 
 	// delete broadphase
 	delete overlapping_pair_cache_;
@@ -440,16 +567,31 @@ void AnimatedMeshApp::CleanUpPhysicsWorld()
 	solver_ = NULL;
 	overlapping_pair_cache_ = NULL;
 	dispatcher_ = NULL;
+	solver_pool_ = NULL;
 
 	// next line is optional : it will be cleared by the destructor when the array goes out of scope
 	collision_shapes_.clear();
+
+	// the task scheduler is handed back to Bullet's sequential one when the physics thread finishes
+	delete physics_thread_;
+	physics_thread_ = NULL;
+	delete task_scheduler_;
+	task_scheduler_ = NULL;
+	delete job_system_;
+	job_system_ = NULL;
 }
 
-void AnimatedMeshApp::UpdatePhysicsWorld(float delta_time)
+void AnimatedMeshApp::BeginPhysicsStep(float delta_time)
 {
+	// with the application running at a fixed time step delta_time is a whole number of simulation steps
 	const btScalar simulation_time_step = 1.0f / 60.0f;
-	const int max_sub_steps = 1;
-	dynamics_world_->stepSimulation(simulation_time_step, max_sub_steps);
+	const int max_sub_steps = 4;
+	physics_thread_->BeginStep(dynamics_world_, delta_time, max_sub_steps, simulation_time_step);
+}
+
+void AnimatedMeshApp::EndPhysicsStep()
+{
+	physics_thread_->EndStep();
 }
 
 void AnimatedMeshApp::CreateRigidBodies()
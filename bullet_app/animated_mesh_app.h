@@ -15,6 +15,8 @@
 
 #include "btBulletDynamicsCommon.h"
 #include "ragdoll.h"
+#include "ragdoll_manager.h"
+#include "physics_thread.h"
 
 
 // FRAMEWORK FORWARD DECLARATIONS
@@ -29,8 +31,11 @@ namespace gef
 	class Skeleton;
 	class InputManager;
 	class Animation;
+	class JobSystem;
 }
 
+class GefTaskScheduler;
+
 class AnimatedMeshApp : public gef::Application
 {
 public:
@@ -38,6 +43,7 @@ public:
 	void Init();
 
 	void InitRagdoll();
+	void SpawnRagdoll();
 
 	gef::Skeleton* GetFirstSkeleton(gef::Scene* scene);
 
@@ -57,7 +63,10 @@ private:
 
 	void InitPhysicsWorld();
 	void CleanUpPhysicsWorld();
-	void UpdatePhysicsWorld(float delta_time);
+
+	// the step runs on the physics thread until EndPhysicsStep, the world must not be touched in between
+	void BeginPhysicsStep(float delta_time);
+	void EndPhysicsStep();
 
 	void CreateRigidBodies();
 	void CleanUpRigidBodies();
@@ -95,6 +104,10 @@ private:
 	btSequentialImpulseConstraintSolver* solver_;
 	btBroadphaseInterface* overlapping_pair_cache_;
 	btCollisionDispatcher* dispatcher_;
+	btConstraintSolver* solver_pool_;
+	gef::JobSystem* job_system_;
+	GefTaskScheduler* task_scheduler_;
+	PhysicsThread* physics_thread_;
 	btAlignedObjectArray<btCollisionShape*> collision_shapes_;
 	GEFDebugDrawer* debug_drawer_;
 
@@ -105,10 +118,18 @@ private:
 	gef::Mesh* sphere_mesh_;
 	gef::MeshInstance sphere_gfx_;
 
+	RagdollTemplate* ragdoll_template_;
 	Ragdoll* ragdoll_;
+	RagdollManager ragdoll_manager_;
+	// draws the spawned ragdolls one after the other with the player's mesh
+	gef::SkinnedMeshInstance* ragdoll_instance_;
 
 	bool is_ragdoll_simulating_;
 
+	// a hit reaction simulates just this joint and the ones below it
+	int hit_reaction_joint_;
+	bool is_hit_reacting_;
+
 };
 
 #endif // _ANIMATED_MESH_APP_H
@@ -6,7 +6,8 @@
 GEFDebugDrawer::GEFDebugDrawer(gef::Renderer3D * renderer_3d) :
 	renderer_3d_(renderer_3d)
 {
-	primitive_renderer_ = new PrimitiveRenderer(const_cast<gef::Platform&>(renderer_3d_->platform()), 8192);
+	// lines are streamed in chunks, so this only sets how many are drawn at a time
+	primitive_renderer_ = new PrimitiveRenderer(const_cast<gef::Platform&>(renderer_3d_->platform()), kLinesPerChunk);
 	mode_ = 0;
 }
 
@@ -44,12 +45,14 @@ int GEFDebugDrawer::getDebugMode() const
 
 void GEFDebugDrawer::clearLines()
 {
+	// Bullet clears the lines at the start of debugDrawWorld, by which point the camera has been set up for culling
 	primitive_renderer_->Reset();
+	primitive_renderer_->BeginStreaming(*renderer_3d_);
 }
 
 void GEFDebugDrawer::flushLines()
 {
-	primitive_renderer_->Render(*renderer_3d_);
+	primitive_renderer_->FlushLines();
 }
 
 
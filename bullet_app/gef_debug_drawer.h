@@ -28,6 +28,8 @@ public:
 	virtual void clearLines() override;
 	virtual void flushLines() override;
 
+	const static int kLinesPerChunk = 4096;
+
 private:
 	PrimitiveRenderer * primitive_renderer_;
 	gef::Renderer3D* renderer_3d_;
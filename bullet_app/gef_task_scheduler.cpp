@@ -0,0 +1,68 @@
+#include "gef_task_scheduler.h"
+#include <system/job_system.h>
+#include <mutex>
+
+GefTaskScheduler::GefTaskScheduler(gef::JobSystem& job_system) :
+	btITaskScheduler("gef"),
+	job_system_(job_system),
+	loop_depth_(0)
+{
+}
+
+int GefTaskScheduler::getMaxNumThreads() const
+{
+	return getNumThreads();
+}
+
+int GefTaskScheduler::getNumThreads() const
+{
+	// Bullet gives every thread that calls into it an index below this, which includes
+	// the workers, the main thread and the thread stepping the world if that is a different one
+	return job_system_.worker_count() + 2;
+}
+
+void GefTaskScheduler::setNumThreads(int num_threads)
+{
+	// the job system has a fixed number of workers
+}
+
+void GefTaskScheduler::parallelFor(int begin, int end, int grain_size, const btIParallelForBody& body)
+{
+	if (loop_depth_.fetch_add(1) > 0)
+	{
+		body.forLoop(begin, end);
+	}
+	else
+	{
+		job_system_.ParallelFor(end - begin, grain_size, [&](Int32 batch_begin, Int32 batch_end)
+		{
+			body.forLoop(begin + batch_begin, begin + batch_end);
+		});
+	}
+
+	loop_depth_.fetch_sub(1);
+}
+
+btScalar GefTaskScheduler::parallelSum(int begin, int end, int grain_size, const btIParallelSumBody& body)
+{
+	btScalar sum = 0.0f;
+
+	if (loop_depth_.fetch_add(1) > 0)
+	{
+		sum = body.sumLoop(begin, end);
+	}
+	else
+	{
+		std::mutex sum_mutex;
+		job_system_.ParallelFor(end - begin, grain_size, [&](Int32 batch_begin, Int32 batch_end)
+		{
+			const btScalar batch_sum = body.sumLoop(begin + batch_begin, begin + batch_end);
+			std::lock_guard<std::mutex> lock(sum_mutex);
+			sum += batch_sum;
+		});
+	}
+
+	loop_depth_.fetch_sub(1);
+
+	return sum;
+}
@@ -0,0 +1,32 @@
+#ifndef _GEF_TASK_SCHEDULER_H
+#define _GEF_TASK_SCHEDULER_H
+
+#include "LinearMath/btThreads.h"
+#include <atomic>
+
+namespace gef
+{
+	class JobSystem;
+}
+
+// Runs Bullet's parallel loops on a gef::JobSystem, so physics shares its worker threads with the rest of the app
+// Only used when Bullet is built with BT_THREADSAFE
+class GefTaskScheduler : public btITaskScheduler
+{
+public:
+	GefTaskScheduler(gef::JobSystem& job_system);
+
+	virtual int getMaxNumThreads() const;
+	virtual int getNumThreads() const;
+	virtual void setNumThreads(int num_threads);
+	virtual void parallelFor(int begin, int end, int grain_size, const btIParallelForBody& body);
+	virtual btScalar parallelSum(int begin, int end, int grain_size, const btIParallelSumBody& body);
+
+private:
+	gef::JobSystem& job_system_;
+
+	// the job system runs one loop at a time, so loops started from inside a loop run inline
+	std::atomic<int> loop_depth_;
+};
+
+#endif // _GEF_TASK_SCHEDULER_H
@@ -0,0 +1,78 @@
+#include "physics_thread.h"
+#include <system/memory_tracker.h>
+#include <system/profiler.h>
+
+PhysicsThread::PhysicsThread(btITaskScheduler* task_scheduler) :
+	task_scheduler_(task_scheduler),
+	step_pending_(true),
+	quit_(false),
+	dynamics_world_(NULL),
+	time_step_(0.0f),
+	max_sub_steps_(1),
+	fixed_time_step_(1.0f / 60.0f)
+{
+	// the thread clears step_pending_ once it has set up the task scheduler
+	thread_ = std::thread(&PhysicsThread::ThreadMain, this);
+	EndStep();
+}
+
+PhysicsThread::~PhysicsThread()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		quit_ = true;
+	}
+	step_ready_.notify_one();
+	thread_.join();
+}
+
+void PhysicsThread::BeginStep(btDynamicsWorld* dynamics_world, btScalar time_step, int max_sub_steps, btScalar fixed_time_step)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		dynamics_world_ = dynamics_world;
+		time_step_ = time_step;
+		max_sub_steps_ = max_sub_steps;
+		fixed_time_step_ = fixed_time_step;
+		step_pending_ = true;
+	}
+	step_ready_.notify_one();
+}
+
+void PhysicsThread::EndStep()
+{
+	GEF_PROFILE_ZONE("PhysicsThread::EndStep");
+
+	std::unique_lock<std::mutex> lock(mutex_);
+	step_done_.wait(lock, [this] { return !step_pending_; });
+}
+
+void PhysicsThread::ThreadMain()
+{
+	GEF_MEMORY_TAG(gef::MT_PHYSICS);
+
+	if (task_scheduler_)
+		btSetTaskScheduler(task_scheduler_);
+
+	std::unique_lock<std::mutex> lock(mutex_);
+	for (;;)
+	{
+		step_pending_ = false;
+		step_done_.notify_one();
+
+		step_ready_.wait(lock, [this] { return step_pending_ || quit_; });
+		if (quit_)
+			break;
+
+		lock.unlock();
+		{
+			GEF_PROFILE_ZONE("PhysicsThread::Step");
+			dynamics_world_->stepSimulation(time_step_, max_sub_steps_, fixed_time_step_);
+		}
+		lock.lock();
+	}
+
+	// stop Bullet using the task scheduler so it can be deleted
+	if (task_scheduler_)
+		btSetTaskScheduler(btGetSequentialTaskScheduler());
+}
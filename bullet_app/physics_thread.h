@@ -0,0 +1,42 @@
+#ifndef _PHYSICS_THREAD_H
+#define _PHYSICS_THREAD_H
+
+#include "btBulletDynamicsCommon.h"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// Steps a dynamics world on its own thread so the frame can get on with other work, such as sampling animations,
+// while the simulation runs. Nothing may touch the world between BeginStep and EndStep.
+class PhysicsThread
+{
+public:
+	// Bullet treats the thread that sets its task scheduler as its main thread and only steps a multithreaded world from there,
+	// so when a task scheduler is given it is set from this thread before the constructor returns
+	// create the thread before the world, the multithreaded dispatcher and solver need the scheduler when they are created
+	PhysicsThread(btITaskScheduler* task_scheduler);
+	~PhysicsThread();
+
+	void BeginStep(btDynamicsWorld* dynamics_world, btScalar time_step, int max_sub_steps, btScalar fixed_time_step);
+	void EndStep();
+
+private:
+	void ThreadMain();
+
+	btITaskScheduler* task_scheduler_;
+
+	std::mutex mutex_;
+	std::condition_variable step_ready_;
+	std::condition_variable step_done_;
+	bool step_pending_;
+	bool quit_;
+
+	btDynamicsWorld* dynamics_world_;
+	btScalar time_step_;
+	int max_sub_steps_;
+	btScalar fixed_time_step_;
+
+	std::thread thread_;
+};
+
+#endif // _PHYSICS_THREAD_H
@@ -1,46 +1,52 @@
 #include "primitive_renderer.h"
 #include "vertex_colour_unlit_shader.h"
-#include "system\platform.h"
-#include "graphics\vertex_buffer.h"
-#include "graphics\index_buffer.h"
-#include "graphics\renderer_3d.h"
-#include "graphics\shader_interface.h"
+#include "system/platform.h"
+#include "graphics/vertex_buffer.h"
+#include "graphics/index_buffer.h"
+#include "graphics/renderer_3d.h"
+#include "graphics/shader_interface.h"
 
 
 
-PrimitiveRenderer::PrimitiveRenderer(gef::Platform& platform, UInt32 max_num_lines /* = kDefaultMaxNumLines */, UInt32 max_num_triangles /* = kDefaultMaxNumTriangles */)
-	: shader_(nullptr)
+PrimitiveRenderer::PrimitiveRenderer(gef::Platform& platform, UInt32 lines_per_chunk /* = kDefaultMaxNumLines */, UInt32 max_num_triangles /* = kDefaultMaxNumTriangles */)
+	: platform_(platform)
+	, shader_(nullptr)
 	, num_lines_(0)
 	, num_triangles_(0)
-	, lines_vertex_buffer_(nullptr)
 	, triangles_vertex_buffer_(nullptr)
-	, max_num_lines_(max_num_lines)
+	, lines_per_chunk_(lines_per_chunk)
 	, max_num_triangles_(max_num_triangles)
+	, line_chunk_(0)
+	, first_pending_chunk_(0)
+	, streaming_renderer_(nullptr)
+	, num_culled_lines_(0)
 {
 	shader_ = new VertexColourUnlitShader(platform);
 
-	lines_vertex_buffer_ = gef::VertexBuffer::Create(platform);
-	lines_vertex_buffer_->Init(platform, nullptr, max_num_lines_ * 2, sizeof(VertexColourUnlitShader::VertexData), false);
+	// start with one chunk, more are added as they are needed
+	line_chunks_.push_back(gef::VertexBuffer::Create(platform));
+	line_chunks_[0]->Init(platform, nullptr, lines_per_chunk_ * 2, sizeof(VertexColourUnlitShader::VertexData), false);
 
 	triangles_vertex_buffer_ = gef::VertexBuffer::Create(platform);
 	triangles_vertex_buffer_->Init(platform, nullptr, max_num_triangles_ * 3, sizeof(VertexColourUnlitShader::VertexData), false);
 
 
 
-	UInt32 max_num_indices = max_num_lines_ * 2 > max_num_triangles_ * 3 ? max_num_lines_ * 2 : max_num_triangles_ * 3;
+	UInt32 max_num_indices = lines_per_chunk_ * 2 > max_num_triangles_ * 3 ? lines_per_chunk_ * 2 : max_num_triangles_ * 3;
 
 	UInt32* indices;
 	indices = new UInt32[max_num_indices];
 	for (UInt32 i = 0; i < max_num_indices; ++i)
 		indices[i] = i;
 
+	// every chunk shares the same index buffer
 	lines_index_buffer_ = gef::IndexBuffer::Create(platform);
-	lines_index_buffer_->Init(platform, indices, max_num_lines * 2, sizeof(UInt32));
+	lines_index_buffer_->Init(platform, indices, lines_per_chunk_ * 2, sizeof(UInt32));
 
 	triangles_index_buffer_ = gef::IndexBuffer::Create(platform);
 	triangles_index_buffer_->Init(platform, indices, max_num_triangles_ * 3, sizeof(UInt32));
 
-	delete indices;
+	delete[] indices;
 	indices = nullptr;
 }
 
@@ -55,8 +61,9 @@ PrimitiveRenderer::~PrimitiveRenderer()
 	delete triangles_vertex_buffer_;
 	triangles_vertex_buffer_ = nullptr;
 
-	delete lines_vertex_buffer_;
-	lines_vertex_buffer_ = nullptr;
+	for (size_t chunk_num = 0; chunk_num < line_chunks_.size(); ++chunk_num)
+		delete line_chunks_[chunk_num];
+	line_chunks_.clear();
 
 	delete shader_;
 	shader_ = nullptr;
@@ -64,16 +71,9 @@ PrimitiveRenderer::~PrimitiveRenderer()
 
 void PrimitiveRenderer::Render(gef::Renderer3D& renderer_3d)
 {
-	lines_vertex_buffer_->Update(renderer_3d.platform());
 	triangles_vertex_buffer_->Update(renderer_3d.platform());
 
-	shader_->SetSceneData(renderer_3d.view_matrix(), renderer_3d.projection_matrix());
-
-	gef::Matrix44 world_transform;
-	world_transform.SetIdentity();
-	shader_->SetMeshData(world_transform);
-
-	shader_->device_interface()->UseProgram();
+	SetupShader(renderer_3d);
 
 	DrawTriangles(renderer_3d);
 	DrawLines(renderer_3d);
@@ -83,33 +83,93 @@ void PrimitiveRenderer::Reset()
 {
 	num_lines_ = 0;
 	num_triangles_ = 0;
+	line_chunk_ = 0;
+	first_pending_chunk_ = 0;
+	num_culled_lines_ = 0;
+}
+
+void PrimitiveRenderer::BeginStreaming(gef::Renderer3D& renderer_3d)
+{
+	streaming_renderer_ = &renderer_3d;
+
+	gef::Matrix44 view_projection;
+	view_projection = renderer_3d.view_matrix() * renderer_3d.projection_matrix();
+	frustum_.ExtractPlanes(view_projection, platform_.NdcZMin(), false);
+}
+
+void PrimitiveRenderer::EndStreaming()
+{
+	FlushLines();
+	streaming_renderer_ = nullptr;
+}
+
+void PrimitiveRenderer::FlushLines()
+{
+	// the lines are drawn and the stream moves on to the next chunk, so nothing gets drawn twice
+	if (streaming_renderer_ && num_lines_)
+		NextLineChunk();
 }
 
 void PrimitiveRenderer::AddLine(const gef::Vector4& start, const gef::Vector4& end, const gef::Colour& colour)
 {
-	if (num_lines_ < max_num_lines_)
+	if (streaming_renderer_ && frustum_.Intersects(start, end) == gef::FI_OUT)
 	{
-		VertexColourUnlitShader::VertexData* vertices = static_cast<VertexColourUnlitShader::VertexData*>(lines_vertex_buffer_->vertex_data());
+		num_culled_lines_++;
+		return;
+	}
 
-		vertices += num_lines_ * 2;
+	if (num_lines_ == lines_per_chunk_)
+		NextLineChunk();
+
+	VertexColourUnlitShader::VertexData* vertices = static_cast<VertexColourUnlitShader::VertexData*>(line_chunks_[line_chunk_]->vertex_data());
+
+	vertices += num_lines_ * 2;
+
+	vertices->x = start.x();
+	vertices->y = start.y();
+	vertices->z = start.z();
+	vertices->r = colour.r;
+	vertices->g = colour.g;
+	vertices->b = colour.b;
+	vertices->a = colour.a;
+	vertices++;
+	vertices->x = end.x();
+	vertices->y = end.y();
+	vertices->z = end.z();
+	vertices->r = colour.r;
+	vertices->g = colour.g;
+	vertices->b = colour.b;
+	vertices->a = colour.a;
+	num_lines_++;
+}
 
-		vertices->x = start.x();
-		vertices->y = start.y();
-		vertices->z = start.z();
-		vertices->r = colour.r;
-		vertices->g = colour.g;
-		vertices->b = colour.b;
-		vertices->a = colour.a;
-		vertices++;
-		vertices->x = end.x();
-		vertices->y = end.y();
-		vertices->z = end.z();
-		vertices->r = colour.r;
-		vertices->g = colour.g;
-		vertices->b = colour.b;
-		vertices->a = colour.a;
-		num_lines_++;
+void PrimitiveRenderer::NextLineChunk()
+{
+	if (streaming_renderer_)
+	{
+		// draw the chunk now and move round the ring, the chunks drawn just before are left alone while the GPU may still be using them
+		SetupShader(*streaming_renderer_);
+		DrawLines(*streaming_renderer_);
+
+		line_chunk_++;
+		if (line_chunk_ == (UInt32)kStreamingRingSize)
+			line_chunk_ = 0;
+		first_pending_chunk_ = line_chunk_;
 	}
+	else
+	{
+		// nothing can be drawn until Render, so keep the full chunk and carry on in the next one
+		line_chunk_++;
+	}
+
+	if (line_chunk_ == line_chunks_.size())
+	{
+		gef::VertexBuffer* chunk = gef::VertexBuffer::Create(platform_);
+		chunk->Init(platform_, nullptr, lines_per_chunk_ * 2, sizeof(VertexColourUnlitShader::VertexData), false);
+		line_chunks_.push_back(chunk);
+	}
+
+	num_lines_ = 0;
 }
 
 void PrimitiveRenderer::AddTriangle(const gef::Vector4& v0, const gef::Vector4& v1, const gef::Vector4& v2, const gef::Colour& colour)
@@ -149,9 +209,36 @@ void PrimitiveRenderer::AddTriangle(const gef::Vector4& v0, const gef::Vector4&
 
 void PrimitiveRenderer::DrawLines(gef::Renderer3D& renderer_3d)
 {
+	for (UInt32 chunk_num = first_pending_chunk_; chunk_num < line_chunk_; ++chunk_num)
+		DrawLineChunk(renderer_3d, chunk_num, lines_per_chunk_);
+	DrawLineChunk(renderer_3d, line_chunk_, num_lines_);
+
+	// the lines stay in their chunks so drawing again before Reset draws them again
+	first_pending_chunk_ = line_chunk_;
+}
+
+void PrimitiveRenderer::SetupShader(gef::Renderer3D& renderer_3d)
+{
+	shader_->SetSceneData(renderer_3d.view_matrix(), renderer_3d.projection_matrix());
+
+	gef::Matrix44 world_transform;
+	world_transform.SetIdentity();
+	shader_->SetMeshData(world_transform);
+
+	shader_->device_interface()->UseProgram();
+}
+
+void PrimitiveRenderer::DrawLineChunk(gef::Renderer3D& renderer_3d, UInt32 chunk_num, UInt32 num_lines)
+{
+	if (num_lines == 0)
+		return;
+
+	gef::VertexBuffer* lines_vertex_buffer = line_chunks_[chunk_num];
+	lines_vertex_buffer->Update(renderer_3d.platform());
+
 	renderer_3d.SetFillMode(gef::Renderer3D::kLines);
 
-	lines_vertex_buffer_->Bind(renderer_3d.platform());
+	lines_vertex_buffer->Bind(renderer_3d.platform());
 
 	// vertex format must be set after the vertex buffer is bound
 	shader_->device_interface()->SetVertexFormat();
@@ -161,11 +248,11 @@ void PrimitiveRenderer::DrawLines(gef::Renderer3D& renderer_3d)
 	lines_index_buffer_->Bind(renderer_3d.platform());
 
 	renderer_3d.SetPrimitiveType(gef::LINE_LIST);
-	renderer_3d.DrawPrimitive(lines_index_buffer_, num_lines_ * 2);
+	renderer_3d.DrawPrimitive(lines_index_buffer_, num_lines * 2);
 
 	lines_index_buffer_->Unbind(renderer_3d.platform());
 	shader_->device_interface()->ClearVertexFormat();
-	lines_vertex_buffer_->Unbind(renderer_3d.platform());
+	lines_vertex_buffer->Unbind(renderer_3d.platform());
 
 	renderer_3d.SetFillMode(gef::Renderer3D::kSolid);
 }
@@ -2,6 +2,8 @@
 #define _PRIMITIVE_RENDERER_H
 
 #include <gef.h>
+#include <maths/frustum.h>
+#include <vector>
 
 namespace gef
 {
@@ -15,16 +17,27 @@ namespace gef
 
 class VertexColourUnlitShader;
 
+// Lines are written into a chain of vertex buffer chunks of lines_per_chunk lines each, so there is no limit on how many can be added
+// Between BeginStreaming and EndStreaming each chunk is drawn as soon as it fills up and the chunks are reused as a ring,
+// and lines outside the view frustum are dropped before they are written
+// Otherwise the chain grows until Render draws everything
 class PrimitiveRenderer
 {
 public:
-	PrimitiveRenderer(gef::Platform& platform, UInt32 max_num_lines = kDefaultMaxNumLines, UInt32 max_num_triangles = kDefaultMaxNumTriangles);
+	PrimitiveRenderer(gef::Platform& platform, UInt32 lines_per_chunk = kDefaultMaxNumLines, UInt32 max_num_triangles = kDefaultMaxNumTriangles);
 	~PrimitiveRenderer();
 
 	void Render(gef::Renderer3D& renderer_3d);
 
 	void Reset();
 
+	// the renderer's view and projection matrices must already be set, they are used for the culling frustum
+	void BeginStreaming(gef::Renderer3D& renderer_3d);
+	void EndStreaming();
+
+	// draw the lines added since the last flush straight away, only while streaming
+	void FlushLines();
+
 	void AddLine(const gef::Vector4& start, const gef::Vector4& end, const gef::Colour& colour);
 	void AddTriangle(const gef::Vector4& v0, const gef::Vector4& v1, const gef::Vector4& v2, const gef::Colour& colour);
 
@@ -33,16 +46,34 @@ public:
 
 	const static int kDefaultMaxNumLines = 512;
 	const static int kDefaultMaxNumTriangles = 512;
+
+	// the number of chunks a stream cycles through before reusing the first one
+	const static int kStreamingRingSize = 3;
+
+	inline UInt32 num_culled_lines() const { return num_culled_lines_; }
 private:
+	void SetupShader(gef::Renderer3D& renderer_3d);
+	void DrawLineChunk(gef::Renderer3D& renderer_3d, UInt32 chunk_num, UInt32 num_lines);
+	void NextLineChunk();
+
+	gef::Platform& platform_;
 	VertexColourUnlitShader* shader_;
 	UInt32 num_lines_;
 	UInt32 num_triangles_;
-	gef::VertexBuffer* lines_vertex_buffer_;
+	std::vector<gef::VertexBuffer*> line_chunks_;
 	gef::VertexBuffer* triangles_vertex_buffer_;
 	gef::IndexBuffer* lines_index_buffer_;
 	gef::IndexBuffer* triangles_index_buffer_;
-	UInt32 max_num_lines_;
+	UInt32 lines_per_chunk_;
 	UInt32 max_num_triangles_;
+
+	// num_lines_ is the count in line_chunk_, the chunks from first_pending_chunk_ up to it have not been drawn yet
+	UInt32 line_chunk_;
+	UInt32 first_pending_chunk_;
+
+	gef::Renderer3D* streaming_renderer_;
+	gef::Frustum frustum_;
+	UInt32 num_culled_lines_;
 };
 
 #endif // _PRIMITIVE_RENDERER_H
\ No newline at end of file
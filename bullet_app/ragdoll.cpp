@@ -2,137 +2,719 @@
 
 #include <btBulletWorldImporter.h>
 #include <system/debug_log.h>
+#include <system/memory_tracker.h>
+#include <string>
 
-extern std::string model_name;
+// rigid bodies are named after the bone they are attached to by the Blender exporter
+static const char kBodyNamePrefix[] = "OBArmature_";
+static const char kBodyNameSuffix[] = "_hitbox";
 
-Ragdoll::Ragdoll() :
+static std::string JointNameFromBodyName(const char* body_name)
+{
+	std::string name(body_name ? body_name : "");
+	const size_t prefix_length = sizeof(kBodyNamePrefix) - 1;
+	const size_t suffix_length = sizeof(kBodyNameSuffix) - 1;
+	if (name.length() < prefix_length + suffix_length
+		|| name.compare(0, prefix_length, kBodyNamePrefix) != 0
+		|| name.compare(name.length() - suffix_length, suffix_length, kBodyNameSuffix) != 0)
+		return std::string();
+
+	return name.substr(prefix_length, name.length() - prefix_length - suffix_length);
+}
+
+// Bullet constraints can't be copied directly, so each type the exporter writes is rebuilt from the getters of the prototype
+static btTypedConstraint* CloneConstraint(btTypedConstraint* prototype, btRigidBody& rb_a, btRigidBody& rb_b)
+{
+	btTypedConstraint* constraint = NULL;
+
+	switch (prototype->getConstraintType())
+	{
+	case POINT2POINT_CONSTRAINT_TYPE:
+	{
+		btPoint2PointConstraint* source = static_cast<btPoint2PointConstraint*>(prototype);
+		btPoint2PointConstraint* p2p = new btPoint2PointConstraint(rb_a, rb_b, source->getPivotInA(), source->getPivotInB());
+		p2p->m_setting = source->m_setting;
+		constraint = p2p;
+		break;
+	}
+
+	case HINGE_CONSTRAINT_TYPE:
+	{
+		btHingeConstraint* source = static_cast<btHingeConstraint*>(prototype);
+		btHingeConstraint* hinge = new btHingeConstraint(rb_a, rb_b, source->getAFrame(), source->getBFrame(), source->getUseReferenceFrameA());
+		if (source->hasLimit())
+			hinge->setLimit(source->getLowerLimit(), source->getUpperLimit(), source->getLimitSoftness(), source->getLimitBiasFactor(), source->getLimitRelaxationFactor());
+		hinge->enableAngularMotor(source->getEnableAngularMotor(), source->getMotorTargetVelocity(), source->getMaxMotorImpulse());
+		constraint = hinge;
+		break;
+	}
+
+	case CONETWIST_CONSTRAINT_TYPE:
+	{
+		btConeTwistConstraint* source = static_cast<btConeTwistConstraint*>(prototype);
+		btConeTwistConstraint* cone_twist = new btConeTwistConstraint(rb_a, rb_b, source->getAFrame(), source->getBFrame());
+		cone_twist->setLimit(source->getSwingSpan1(), source->getSwingSpan2(), source->getTwistSpan(), source->getLimitSoftness(), source->getBiasFactor(), source->getRelaxationFactor());
+		cone_twist->setDamping(source->getDamping());
+		constraint = cone_twist;
+		break;
+	}
+
+	case D6_CONSTRAINT_TYPE:
+	case D6_SPRING_CONSTRAINT_TYPE:
+	{
+		btGeneric6DofConstraint* source = static_cast<btGeneric6DofConstraint*>(prototype);
+		btGeneric6DofConstraint* dof;
+		if (prototype->getConstraintType() == D6_SPRING_CONSTRAINT_TYPE)
+		{
+			btGeneric6DofSpringConstraint* spring_source = static_cast<btGeneric6DofSpringConstraint*>(prototype);
+			btGeneric6DofSpringConstraint* spring = new btGeneric6DofSpringConstraint(rb_a, rb_b, source->getFrameOffsetA(), source->getFrameOffsetB(), source->getUseLinearReferenceFrameA());
+			for (int axis = 0; axis < 6; ++axis)
+			{
+				spring->enableSpring(axis, spring_source->isSpringEnabled(axis));
+				spring->setStiffness(axis, spring_source->getStiffness(axis));
+				spring->setDamping(axis, spring_source->getDamping(axis));
+				spring->setEquilibriumPoint(axis, spring_source->getEquilibriumPoint(axis));
+			}
+			dof = spring;
+		}
+		else
+		{
+			dof = new btGeneric6DofConstraint(rb_a, rb_b, source->getFrameOffsetA(), source->getFrameOffsetB(), source->getUseLinearReferenceFrameA());
+		}
+
+		btVector3 limit;
+		source->getLinearLowerLimit(limit);
+		dof->setLinearLowerLimit(limit);
+		source->getLinearUpperLimit(limit);
+		dof->setLinearUpperLimit(limit);
+		source->getAngularLowerLimit(limit);
+		dof->setAngularLowerLimit(limit);
+		source->getAngularUpperLimit(limit);
+		dof->setAngularUpperLimit(limit);
+		constraint = dof;
+		break;
+	}
+
+	default:
+		gef::DebugOut("Ragdoll: constraint type %d is not supported\n", prototype->getConstraintType());
+		return NULL;
+	}
+
+	constraint->setBreakingImpulseThreshold(prototype->getBreakingImpulseThreshold());
+	constraint->setOverrideNumSolverIterations(prototype->getOverrideNumSolverIterations());
+	constraint->setDbgDrawSize(prototype->getDbgDrawSize());
+	constraint->setEnabled(prototype->isEnabled());
+
+	return constraint;
+}
+
+// bodies in the world are removed and added back so the world updates their collision filter and gravity
+static void SetBodyKinematic(btDiscreteDynamicsWorld* dynamics_world, btRigidBody* body, const RagdollTemplate::Body& template_body, bool kinematic)
+{
+	if (body->isKinematicObject() == kinematic)
+		return;
+
+	if (dynamics_world)
+		dynamics_world->removeRigidBody(body);
+
+	if (kinematic)
+	{
+		body->setCollisionFlags(body->getCollisionFlags() | btCollisionObject::CF_KINEMATIC_OBJECT);
+		body->setMassProps(0.0f, btVector3(0.0f, 0.0f, 0.0f));
+		body->forceActivationState(DISABLE_DEACTIVATION);
+	}
+	else
+	{
+		body->setCollisionFlags(body->getCollisionFlags() & ~btCollisionObject::CF_KINEMATIC_OBJECT);
+		body->setMassProps(template_body.mass, template_body.local_inertia);
+		body->forceActivationState(ACTIVE_TAG);
+		body->setDeactivationTime(0.0f);
+	}
+
+	body->setLinearVelocity(btVector3(0.0f, 0.0f, 0.0f));
+	body->setAngularVelocity(btVector3(0.0f, 0.0f, 0.0f));
+	body->updateInertiaTensor();
+
+	if (dynamics_world)
+		dynamics_world->addRigidBody(body);
+}
+
+// Bullet uses column vectors, so the rotation part of a transform is the transpose of a gef one
+static void GetBatchTransform(const btTransform& transform, TransformBatch& batch, int index)
+{
+	const btMatrix3x3& basis = transform.getBasis();
+	for (int row = 0; row < 3; ++row)
+	{
+		for (int column = 0; column < 3; ++column)
+			batch.element(row, column)[index] = basis[column][row];
+	}
+
+	const btVector3& origin = transform.getOrigin();
+	batch.element(3, 0)[index] = origin.x();
+	batch.element(3, 1)[index] = origin.y();
+	batch.element(3, 2)[index] = origin.z();
+}
+
+static void SetBatchTransform(const TransformBatch& batch, int index, btTransform& transform)
+{
+	transform.getBasis().setValue(
+		batch.element(0, 0)[index], batch.element(1, 0)[index], batch.element(2, 0)[index],
+		batch.element(0, 1)[index], batch.element(1, 1)[index], batch.element(2, 1)[index],
+		batch.element(0, 2)[index], batch.element(1, 2)[index], batch.element(2, 2)[index]);
+	transform.setOrigin(btVector3(batch.element(3, 0)[index], batch.element(3, 1)[index], batch.element(3, 2)[index]));
+}
+
+RagdollTemplate::RagdollTemplate() :
+	file_loader_(NULL),
 	scale_factor_(1.0f)
 {
+}
 
+RagdollTemplate::~RagdollTemplate()
+{
+	CleanUp();
 }
 
-void Ragdoll::Init(const gef::SkeletonPose & bind_pose, btDiscreteDynamicsWorld* dynamics_world, const char * physics_filename)
+bool RagdollTemplate::Load(const gef::SkeletonPose& bind_pose, const char* physics_filename, float scale_factor)
 {
+	GEF_MEMORY_TAG(gef::MT_PHYSICS);
+
+	CleanUp();
+
 	bind_pose_ = bind_pose;
-	pose_ = bind_pose;
+	scale_factor_ = scale_factor;
 
-	gef::Matrix44 identity;
-	identity.SetIdentity();
+	// without a world the importer only creates the bodies, shapes and constraints
+	// they are kept as prototypes for the Ragdolls and the shapes are shared between all of them
+	file_loader_ = new btBulletWorldImporter(NULL);
+	if (!file_loader_->loadFile(physics_filename))
+	{
+		gef::DebugOut("Ragdoll: failed to load %s\n", physics_filename);
+		CleanUp();
+		return false;
+	}
 
-	bone_rb_offset_matrices_.resize(bind_pose_.skeleton()->joint_count(), identity);
-	bone_rbs_.resize(bind_pose_.skeleton()->joint_count(), NULL);
-	bone_world_matrices_.resize(bind_pose_.skeleton()->joint_count());
+	// the offsets below are relative to the global pose so make sure it matches the local pose
+	bind_pose_.CalculateGlobalPose();
 
+	const gef::Skeleton* skeleton = bind_pose_.skeleton();
+	const int joint_count = skeleton ? skeleton->joint_count() : 0;
 
-	btBulletWorldImporter* fileLoader = new btBulletWorldImporter(dynamics_world);
+	// find bone in skeleton that matches the name of each rigid body
+	std::vector<btRigidBody*> joint_rbs(joint_count, NULL);
+	for (int i = 0; i < file_loader_->getNumRigidBodies(); i++)
+	{
+		btRigidBody* body = btRigidBody::upcast(file_loader_->getRigidBodyByIndex(i));
+		if (!body || !skeleton)
+			continue;
+
+		std::string joint_name = JointNameFromBodyName(file_loader_->getNameForPointer(body));
+		gef::StringId joint_name_id = gef::GetStringId(joint_name);
+		if (joint_name_id == 0)
+			continue;
+
+		int joint_num = skeleton->FindJointIndex(joint_name_id);
+		if (joint_num != -1 && !joint_rbs[joint_num])
+			joint_rbs[joint_num] = body;
+	}
 
-	std::string ragdoll_filename = model_name + "/ragdoll.bullet";
-	fileLoader->loadFile(ragdoll_filename.c_str());
+	// bodies are stored in joint order so parent bodies always come before their children
+	joint_bodies_.resize(joint_count, -1);
+	std::vector<bool> joint_simulated(joint_count, false);
+	for (int joint_num = 0; joint_num < joint_count; ++joint_num)
+	{
+		btRigidBody* body = joint_rbs[joint_num];
+		const int parent = skeleton->joint(joint_num).parent;
+
+		joint_simulated[joint_num] = body || (parent != -1 && joint_simulated[parent]);
+		if (joint_simulated[joint_num])
+			simulated_joints_.push_back(joint_num);
+
+		if (!body)
+			continue;
+
+		Body template_body;
+		template_body.prototype = body;
+		template_body.joint = joint_num;
+		template_body.mass = body->getInvMass() == 0.0f ? 0.0f : 1.0f / body->getInvMass();
+		template_body.local_inertia.setZero();
+		if (template_body.mass != 0.0f)
+			body->getCollisionShape()->calculateLocalInertia(template_body.mass, template_body.local_inertia);
+
+		template_body.parent_body = -1;
+		for (int ancestor = parent; ancestor != -1 && template_body.parent_body == -1; ancestor = skeleton->joint(ancestor).parent)
+			template_body.parent_body = joint_bodies_[ancestor];
+
+		joint_bodies_[joint_num] = (int)bodies_.size();
+		bodies_.push_back(template_body);
+	}
 
-	int numRigidBodies = fileLoader->getNumRigidBodies();
-	for (int i = 0; i < fileLoader->getNumRigidBodies(); i++)
+	// offsets are calculated with the skeleton scaled to the size of the physics ragdoll
+	gef::Matrix44 scale_matrix;
+	scale_matrix.Scale(gef::Vector4(scale_factor_, scale_factor_, scale_factor_));
+
+	const int body_count = (int)bodies_.size();
+	rb_offsets_.Resize(body_count);
+	rb_inv_offsets_.Resize(body_count);
+	parent_offsets_.Resize(body_count);
+	std::vector<gef::Matrix44> rb_offset_matrices(body_count);
+	for (int body_num = 0; body_num < body_count; ++body_num)
 	{
-		btCollisionObject* obj = fileLoader->getRigidBodyByIndex(i);
-		btRigidBody* body = btRigidBody::upcast(obj);
+		const Body& body = bodies_[body_num];
+		const std::vector<gef::Matrix44>& global_pose = bind_pose_.global_pose();
+
+		gef::Matrix44 inv_bone_world_transform;
+		inv_bone_world_transform.Inverse(global_pose[body.joint] * scale_matrix);
+		gef::Matrix44& rb_offset = rb_offset_matrices[body_num];
+		rb_offset = btTransform2Matrix(body.prototype->getWorldTransform()) * inv_bone_world_transform;
+
+		gef::Matrix44 rb_inv_offset;
+		rb_inv_offset.Inverse(rb_offset);
+
+		// joints between a body and its parent body are left in the bind pose while simulating
+		// so the parent joint is always at the same place relative to the parent body
+		const int parent = skeleton->joint(body.joint).parent;
+		gef::Matrix44 parent_offset;
+		parent_offset.SetIdentity();
+		if (parent != -1)
+			parent_offset.Inverse(global_pose[parent]);
+		if (body.parent_body != -1)
+			parent_offset = rb_offset_matrices[body.parent_body] * global_pose[bodies_[body.parent_body].joint] * parent_offset;
+
+		rb_offsets_.Set(body_num, rb_offset);
+		rb_inv_offsets_.Set(body_num, rb_inv_offset);
+		parent_offsets_.Set(body_num, parent_offset);
+	}
 
-		// properties
+	for (int i = 0; i < file_loader_->getNumConstraints(); i++)
+	{
+		btTypedConstraint* prototype = file_loader_->getConstraintByIndex(i);
 
-		// The Blender object name
-		std::string rb_name(fileLoader->getNameForPointer(body));
+		Constraint constraint;
+		constraint.prototype = prototype;
+		constraint.body_a = FindBody(&prototype->getRigidBodyA());
+		constraint.body_b = FindBody(&prototype->getRigidBodyB());
 
-		// trim the blender rigid body name to match bone names
-		rb_name = std::string(&rb_name.c_str()[sizeof("OBArmature_") - 1]);
-		char* new_name = (char*)rb_name.c_str();
-		new_name[rb_name.length() - sizeof("_hitbox") + 1] = 0;
-		rb_name = std::string(new_name);
+		// constraints between bodies that aren't part of the skeleton are dropped
+		if (constraint.body_a == -1 && constraint.body_b == -1)
+			continue;
 
-		gef::DebugOut("  object name = %s\n", rb_name.c_str());	
-		gef::DebugOut("  get position = (%4.3f,%4.3f,%4.3f)\n",
-			body->getCenterOfMassPosition().getX(),
-			body->getCenterOfMassPosition().getY(),
-			body->getCenterOfMassPosition().getZ());			// Blender CoM
-		if (body->getInvMass() == 0)
-			gef::DebugOut("  static object\n");
-		else
-		{
-			gef::DebugOut("  mass = %4.3f\n", 1 / body->getInvMass());		// Blender Mass
-		}
-		gef::DebugOut("\n");
+		constraints_.push_back(constraint);
+	}
 
-		if (bind_pose_.skeleton())
-		{
-			gef::StringId joint_name_id = gef::GetStringId(rb_name);
-			if (joint_name_id != 0)
-			{
-				// find bone in skeleton that matches the name of the rigid body
-				int joint_num = bind_pose_.skeleton()->FindJointIndex(joint_name_id);
-				if (joint_num != -1)
-				{
-					bone_rbs_[joint_num] = body;
-
-					// CALCULATE THE BONE TO RIGID BODY OFFSET MATRIX HERE
-				}
-			}
-		}
+	gef::DebugOut("Ragdoll: %s has %d bodies and %d constraints\n", physics_filename, (int)bodies_.size(), (int)constraints_.size());
+
+	return true;
+}
+
+void RagdollTemplate::CleanUp()
+{
+	if (file_loader_)
+	{
+		file_loader_->deleteAllData();
+		delete file_loader_;
+		file_loader_ = NULL;
+	}
+
+	bodies_.clear();
+	constraints_.clear();
+	joint_bodies_.clear();
+	simulated_joints_.clear();
+}
+
+int RagdollTemplate::FindBody(const btRigidBody* body) const
+{
+	for (size_t body_num = 0; body_num < bodies_.size(); ++body_num)
+	{
+		if (bodies_[body_num].prototype == body)
+			return (int)body_num;
+	}
+
+	return -1;
+}
+
+Ragdoll::Ragdoll() :
+	ragdoll_template_(NULL),
+	dynamics_world_(NULL),
+	pose_from_animation_(true),
+	in_world_(false)
+{
+
+}
+
+void Ragdoll::Init(const RagdollTemplate& ragdoll_template, btDiscreteDynamicsWorld* dynamics_world, const gef::Matrix44& transform)
+{
+	GEF_MEMORY_TAG(gef::MT_PHYSICS);
+
+	CleanUp();
+
+	ragdoll_template_ = &ragdoll_template;
+	dynamics_world_ = dynamics_world;
+
+	const gef::SkeletonPose& bind_pose = ragdoll_template.bind_pose();
+	pose_ = bind_pose;
+	pose_from_animation_ = true;
+
+	const int joint_count = bind_pose.skeleton() ? bind_pose.skeleton()->joint_count() : 0;
+	bone_rbs_.resize(joint_count, NULL);
+	joint_mask_.resize(joint_count, 0.0f);
+
+	// the pose is in the space of the animated model, which is scaled down to the size of the ragdoll and then placed in the world
+	const float scale_factor = ragdoll_template.scale_factor();
+	model_to_world_.Scale(gef::Vector4(scale_factor, scale_factor, scale_factor));
+	model_to_world_ = model_to_world_ * transform;
+	world_to_model_.Inverse(model_to_world_);
+
+	const btTransform world_transform = Matrix2btTransform(transform);
+
+	const std::vector<RagdollTemplate::Body>& bodies = ragdoll_template.bodies();
+	rbs_.reserve(bodies.size());
+	for (size_t body_num = 0; body_num < bodies.size(); ++body_num)
+	{
+		const RagdollTemplate::Body& template_body = bodies[body_num];
+		btRigidBody* prototype = template_body.prototype;
+
+		btRigidBody::btRigidBodyConstructionInfo rb_info(template_body.mass, NULL, prototype->getCollisionShape(), template_body.local_inertia);
+		rb_info.m_startWorldTransform = world_transform * prototype->getWorldTransform();
+		rb_info.m_friction = prototype->getFriction();
+		rb_info.m_rollingFriction = prototype->getRollingFriction();
+		rb_info.m_restitution = prototype->getRestitution();
+		rb_info.m_linearDamping = prototype->getLinearDamping();
+		rb_info.m_angularDamping = prototype->getAngularDamping();
+		rb_info.m_linearSleepingThreshold = prototype->getLinearSleepingThreshold();
+		rb_info.m_angularSleepingThreshold = prototype->getAngularSleepingThreshold();
+
+		btRigidBody* body = new btRigidBody(rb_info);
+		body->setCollisionFlags(prototype->getCollisionFlags());
+
+		rbs_.push_back(body);
+		bone_rbs_[template_body.joint] = body;
 	}
 
-	delete fileLoader;
-	fileLoader = NULL;
+	const std::vector<RagdollTemplate::Constraint>& constraints = ragdoll_template.constraints();
+	constraints_.reserve(constraints.size());
+	for (size_t constraint_num = 0; constraint_num < constraints.size(); ++constraint_num)
+	{
+		const RagdollTemplate::Constraint& template_constraint = constraints[constraint_num];
+		btRigidBody& rb_a = template_constraint.body_a == -1 ? btTypedConstraint::getFixedBody() : *rbs_[template_constraint.body_a];
+		btRigidBody& rb_b = template_constraint.body_b == -1 ? btTypedConstraint::getFixedBody() : *rbs_[template_constraint.body_b];
+
+		btTypedConstraint* constraint = CloneConstraint(template_constraint.prototype, rb_a, rb_b);
+		if (!constraint)
+			continue;
+
+		constraints_.push_back(constraint);
+	}
+
+	AddToWorld();
+	SetSimulatedSubtree(-1);
 }
 
 Ragdoll::~Ragdoll()
 {
+	CleanUp();
 }
 
-void Ragdoll::UpdatePoseFromRagdoll()
+void Ragdoll::CleanUp()
+{
+	RemoveFromWorld();
+
+	// the collision shapes belong to the template
+	for (size_t constraint_num = 0; constraint_num < constraints_.size(); ++constraint_num)
+		delete constraints_[constraint_num];
+	constraints_.clear();
+
+	for (size_t body_num = 0; body_num < rbs_.size(); ++body_num)
+		delete rbs_[body_num];
+	rbs_.clear();
+	bone_rbs_.clear();
+	dynamic_bodies_.clear();
+	kinematic_bodies_.clear();
+	top_dynamic_bodies_.clear();
+	simulated_joints_.clear();
+	joint_mask_.clear();
+}
+
+void Ragdoll::AddToWorld()
+{
+	if (in_world_ || !dynamics_world_)
+		return;
+
+	for (size_t body_num = 0; body_num < rbs_.size(); ++body_num)
+	{
+		dynamics_world_->addRigidBody(rbs_[body_num]);
+		if (!rbs_[body_num]->isKinematicObject())
+			rbs_[body_num]->activate(true);
+	}
+
+	// neighbouring bodies of a ragdoll overlap at the joints
+	for (size_t constraint_num = 0; constraint_num < constraints_.size(); ++constraint_num)
+		dynamics_world_->addConstraint(constraints_[constraint_num], true);
+
+	in_world_ = true;
+}
+
+void Ragdoll::RemoveFromWorld()
+{
+	if (!in_world_)
+		return;
+
+	for (size_t constraint_num = 0; constraint_num < constraints_.size(); ++constraint_num)
+		dynamics_world_->removeConstraint(constraints_[constraint_num]);
+
+	for (size_t body_num = 0; body_num < rbs_.size(); ++body_num)
+		dynamics_world_->removeRigidBody(rbs_[body_num]);
+
+	in_world_ = false;
+}
+
+bool Ragdoll::IsSettled() const
 {
-	for (int bone_num = 0; bone_num < bind_pose_.skeleton()->joint_count(); ++bone_num)
+	// Bullet puts the bodies of an island to sleep once they have all been below their sleeping thresholds for a while
+	for (size_t body_num = 0; body_num < dynamic_bodies_.size(); ++body_num)
 	{
-		const gef::Joint& joint = bind_pose_.skeleton()->joint(bone_num);
-		gef::Matrix44 anim_bone_local_transform;
+		if (rbs_[dynamic_bodies_[body_num]]->isActive())
+			return false;
+	}
 
+	return true;
+}
 
-		btRigidBody* bone_rb = bone_rbs_[bone_num];
-		if (bone_rb)
+void Ragdoll::SetSolverIterations(int num_iterations)
+{
+	for (size_t constraint_num = 0; constraint_num < constraints_.size(); ++constraint_num)
+		constraints_[constraint_num]->setOverrideNumSolverIterations(num_iterations);
+}
+
+const btTransform& Ragdoll::root_transform() const
+{
+	// a ragdoll whose physics file matched none of the skeleton's joints has no bodies
+	if (rbs_.empty())
+		return btTransform::getIdentity();
+
+	return rbs_[0]->getWorldTransform();
+}
+
+void Ragdoll::SetSimulatedSubtree(int root_joint)
+{
+	GEF_MEMORY_TAG(gef::MT_PHYSICS);
+
+	const gef::Skeleton* skeleton = ragdoll_template_->bind_pose().skeleton();
+	const std::vector<RagdollTemplate::Body>& bodies = ragdoll_template_->bodies();
+	const std::vector<int>& joint_bodies = ragdoll_template_->joint_bodies();
+	const int joint_count = (int)joint_mask_.size();
+
+	// joints are stored parents first, so one pass marks every joint in the subtree
+	// the mask is used to hold the marks until the bodies have been sorted
+	for (int joint_num = 0; joint_num < joint_count; ++joint_num)
+	{
+		const int parent = skeleton->joint(joint_num).parent;
+		const bool in_subtree = root_joint == -1 || joint_num == root_joint || (parent != -1 && joint_mask_[parent] != 0.0f);
+		joint_mask_[joint_num] = in_subtree ? 1.0f : 0.0f;
+	}
+
+	dynamic_bodies_.clear();
+	kinematic_bodies_.clear();
+	top_dynamic_bodies_.clear();
+	for (int body_num = 0; body_num < (int)bodies.size(); ++body_num)
+	{
+		const RagdollTemplate::Body& body = bodies[body_num];
+		const bool dynamic = joint_mask_[body.joint] != 0.0f;
+		if (dynamic)
 		{
-			// REPLACE THIS LINE BELOW TO CALCULATE THE BONE LOCAL TRANSFORM
-			// BASED ON THE RIGID BODY WORLD TRANSFORM
-			anim_bone_local_transform = bind_pose_.local_pose()[bone_num].GetMatrix();
+			if (body.parent_body == -1 || joint_mask_[bodies[body.parent_body].joint] == 0.0f)
+				top_dynamic_bodies_.push_back((int)dynamic_bodies_.size());
+			dynamic_bodies_.push_back(body_num);
 		}
 		else
 		{
-			anim_bone_local_transform = bind_pose_.local_pose()[bone_num].GetMatrix();
+			kinematic_bodies_.push_back(body_num);
 		}
 
-		// calculate bone world transforms for anim skeleton
-		if (joint.parent == -1)
-		{
-			bone_world_matrices_[bone_num] = anim_bone_local_transform;
-		}
-		else
+		SetBodyKinematic(in_world_ ? dynamics_world_ : NULL, rbs_[body_num], body, !dynamic);
+	}
+
+	// the simulated joints are the ones at or below a dynamic body
+	simulated_joints_.clear();
+	for (int joint_num = 0; joint_num < joint_count; ++joint_num)
+	{
+		const int parent = skeleton->joint(joint_num).parent;
+		const bool simulated = (joint_bodies[joint_num] != -1 && joint_mask_[joint_num] != 0.0f) || (parent != -1 && joint_mask_[parent] != 0.0f);
+		joint_mask_[joint_num] = simulated ? 1.0f : 0.0f;
+		if (simulated)
+			simulated_joints_.push_back(joint_num);
+	}
+
+	// gather the template offsets so the sync only processes the bodies it needs to
+	const int dynamic_count = (int)dynamic_bodies_.size();
+	dynamic_rb_inv_offsets_.Resize(dynamic_count);
+	dynamic_parent_offsets_.Resize(dynamic_count);
+	rb_transforms_.Resize(dynamic_count);
+	parent_transforms_.Resize(dynamic_count);
+	for (int dynamic_num = 0; dynamic_num < dynamic_count; ++dynamic_num)
+	{
+		const int body_num = dynamic_bodies_[dynamic_num];
+		dynamic_rb_inv_offsets_.Copy(dynamic_num, ragdoll_template_->rb_inv_offsets(), body_num);
+		dynamic_parent_offsets_.Copy(dynamic_num, ragdoll_template_->parent_offsets(), body_num);
+
+		// bodies without a parent body are placed relative to the model rather than another body
+		if (bodies[body_num].parent_body == -1)
+			parent_transforms_.Set(dynamic_num, world_to_model_);
+	}
+
+	const int kinematic_count = (int)kinematic_bodies_.size();
+	kinematic_rb_offsets_.Resize(kinematic_count);
+	for (int kinematic_num = 0; kinematic_num < kinematic_count; ++kinematic_num)
+		kinematic_rb_offsets_.Copy(kinematic_num, ragdoll_template_->rb_offsets(), kinematic_bodies_[kinematic_num]);
+}
+
+void Ragdoll::UpdatePoseFromRagdoll()
+{
+	GEF_MEMORY_TAG(gef::MT_PHYSICS);
+
+	const gef::SkeletonPose& bind_pose = ragdoll_template_->bind_pose();
+	const std::vector<RagdollTemplate::Body>& bodies = ragdoll_template_->bodies();
+	const int body_count = (int)dynamic_bodies_.size();
+
+	// joints without a rigid body are held in the bind pose while the ragdoll is simulating
+	// they only need setting when the pose has come from somewhere else
+	if (pose_from_animation_)
+	{
+		const std::vector<int>& joint_bodies = ragdoll_template_->joint_bodies();
+		for (size_t joint_num = 0; joint_num < joint_bodies.size(); ++joint_num)
 		{
-			bone_world_matrices_[bone_num] = anim_bone_local_transform * bone_world_matrices_[joint.parent];
+			if (joint_bodies[joint_num] == -1)
+				pose_.local_pose()[joint_num] = bind_pose.local_pose()[joint_num];
 		}
 	}
 
-	pose_.CalculateLocalPose(bone_world_matrices_);
-	pose_.CalculateGlobalPose();
+	temp_transforms_[0].Resize(body_count);
+	temp_transforms_[1].Resize(body_count);
+
+	for (int body_num = 0; body_num < body_count; ++body_num)
+	{
+		const int parent_body = bodies[dynamic_bodies_[body_num]].parent_body;
+		GetBatchTransform(rbs_[dynamic_bodies_[body_num]]->getWorldTransform(), rb_transforms_, body_num);
+		if (parent_body != -1)
+			GetBatchTransform(rbs_[parent_body]->getWorldTransform(), temp_transforms_[1], body_num);
+	}
+
+	// the local transform of a bone is its body transform relative to the parent body,
+	// so the world transform cancels out and no general matrix inverse is needed
+	TransformBatch::RigidInverse(temp_transforms_[1], temp_transforms_[0]);
+	for (int body_num = 0; body_num < body_count; ++body_num)
+	{
+		if (bodies[dynamic_bodies_[body_num]].parent_body != -1)
+			parent_transforms_.Copy(body_num, temp_transforms_[0], body_num);
+	}
+
+	TransformBatch::Multiply(dynamic_rb_inv_offsets_, rb_transforms_, temp_transforms_[0]);
+	TransformBatch::Multiply(temp_transforms_[0], parent_transforms_, temp_transforms_[1]);
+	TransformBatch::Multiply(temp_transforms_[1], dynamic_parent_offsets_, temp_transforms_[0]);
+
+	for (int body_num = 0; body_num < body_count; ++body_num)
+		pose_.local_pose()[bodies[dynamic_bodies_[body_num]].joint].Set(temp_transforms_[0].Get(body_num));
+
+	// only the joints below the dynamic bodies move
+	if (pose_from_animation_)
+		pose_.CalculateGlobalPose();
+	else
+		pose_.UpdateGlobalPose(simulated_joints_);
+
+	pose_from_animation_ = false;
 }
 
 void Ragdoll::UpdateRagdollFromPose()
 {
-	for (int bone_num = 0; bone_num < bind_pose_.skeleton()->joint_count(); ++bone_num)
+	GEF_MEMORY_TAG(gef::MT_PHYSICS);
+
+	const std::vector<RagdollTemplate::Body>& bodies = ragdoll_template_->bodies();
+	const int body_count = (int)bodies.size();
+
+	temp_transforms_[0].Resize(body_count);
+	temp_transforms_[1].Resize(body_count);
+
+	for (int body_num = 0; body_num < body_count; ++body_num)
+		temp_transforms_[0].Set(body_num, pose_.global_pose()[bodies[body_num].joint]);
+
+	TransformBatch::Multiply(ragdoll_template_->rb_offsets(), temp_transforms_[0], temp_transforms_[1]);
+	TransformBatch::Multiply(temp_transforms_[1], model_to_world_, temp_transforms_[0]);
+
+	for (int body_num = 0; body_num < body_count; ++body_num)
+	{
+		btRigidBody* bone_rb = rbs_[body_num];
+
+		btTransform transform;
+		SetBatchTransform(temp_transforms_[0], body_num, transform);
+		bone_rb->setWorldTransform(transform);
+		bone_rb->setInterpolationWorldTransform(transform);
+		bone_rb->setLinearVelocity(btVector3(0.0f, 0.0f, 0.0f));
+		bone_rb->setAngularVelocity(btVector3(0.0f, 0.0f, 0.0f));
+	}
+}
+
+void Ragdoll::UpdateKinematicBodies(const gef::SkeletonPose& anim_pose)
+{
+	GEF_MEMORY_TAG(gef::MT_PHYSICS);
+
+	const std::vector<RagdollTemplate::Body>& bodies = ragdoll_template_->bodies();
+	const int body_count = (int)kinematic_bodies_.size();
+	if (body_count == 0)
+		return;
+
+	temp_transforms_[0].Resize(body_count);
+	temp_transforms_[1].Resize(body_count);
+
+	for (int body_num = 0; body_num < body_count; ++body_num)
+		temp_transforms_[0].Set(body_num, anim_pose.global_pose()[bodies[kinematic_bodies_[body_num]].joint]);
+
+	TransformBatch::Multiply(kinematic_rb_offsets_, temp_transforms_[0], temp_transforms_[1]);
+	TransformBatch::Multiply(temp_transforms_[1], model_to_world_, temp_transforms_[0]);
+
+	// the interpolation transform is left alone so Bullet works out the velocity of the kinematic body from the move
+	for (int body_num = 0; body_num < body_count; ++body_num)
+	{
+		btTransform transform;
+		SetBatchTransform(temp_transforms_[0], body_num, transform);
+		rbs_[kinematic_bodies_[body_num]]->setWorldTransform(transform);
+	}
+}
+
+void Ragdoll::BlendPose(const gef::SkeletonPose& anim_pose, float blend_weight)
+{
+	GEF_MEMORY_TAG(gef::MT_PHYSICS);
+
+	const gef::Skeleton* skeleton = ragdoll_template_->bind_pose().skeleton();
+	const std::vector<RagdollTemplate::Body>& bodies = ragdoll_template_->bodies();
+
+	blended_pose_ = anim_pose;
+
+	for (size_t joint_num = 0; joint_num < simulated_joints_.size(); ++joint_num)
+	{
+		const int joint = simulated_joints_[joint_num];
+		blended_pose_.local_pose()[joint].Linear2TransformBlend(anim_pose.local_pose()[joint], pose_.local_pose()[joint], blend_weight * joint_mask_[joint]);
+	}
+
+	// the top bodies hang off the animated skeleton rather than the bind pose, so their local transforms are worked out
+	// against the animation pose using the body transforms from the last UpdatePoseFromRagdoll
+	for (size_t top_num = 0; top_num < top_dynamic_bodies_.size(); ++top_num)
 	{
-		const gef::Joint& joint = bind_pose_.skeleton()->joint(bone_num);
+		const int dynamic_num = top_dynamic_bodies_[top_num];
+		const int joint = bodies[dynamic_bodies_[dynamic_num]].joint;
+		const int parent = skeleton->joint(joint).parent;
 
-		btRigidBody* bone_rb = bone_rbs_[bone_num];
-		if (bone_rb)
+		gef::Matrix44 global_transform = dynamic_rb_inv_offsets_.Get(dynamic_num) * rb_transforms_.Get(dynamic_num) * world_to_model_;
+		if (parent != -1)
 		{
-			// CALCULATE THE RIGID BODY WORLD TRANSFORM BASED ON THE CURRENT SKELETON POSE
+			gef::Matrix44 inv_parent_transform;
+			inv_parent_transform.Inverse(anim_pose.global_pose()[parent]);
+			global_transform = global_transform * inv_parent_transform;
 		}
 
+		blended_pose_.local_pose()[joint].Linear2TransformBlend(anim_pose.local_pose()[joint], gef::Transform(global_transform), blend_weight * joint_mask_[joint]);
 	}
 
+	blended_pose_.UpdateGlobalPose(simulated_joints_);
 }
 
 gef::Matrix44 btTransform2Matrix(const btTransform& transform)
@@ -3,32 +3,156 @@
 
 #include "btBulletDynamicsCommon.h"
 #include "animation/skeleton.h"
+#include "transform_batch.h"
+
+class btBulletWorldImporter;
+
+// The parsed contents of a ragdoll physics file for one skeleton
+// The file is loaded once and any number of Ragdolls can be created from it, sharing its collision shapes
+class RagdollTemplate
+{
+public:
+	// a rigid body in the file that matches a joint in the skeleton
+	struct Body
+	{
+		btRigidBody* prototype;
+		int joint;
+		int parent_body;	// body of the nearest ancestor joint that has one, or -1
+		btScalar mass;
+		btVector3 local_inertia;
+	};
+
+	// a constraint in the file, with the template bodies it connects
+	// -1 is used when a constraint is attached to the world rather than another body
+	struct Constraint
+	{
+		btTypedConstraint* prototype;
+		int body_a;
+		int body_b;
+	};
+
+	RagdollTemplate();
+	~RagdollTemplate();
+
+	bool Load(const gef::SkeletonPose& bind_pose, const char* physics_filename, float scale_factor);
+	void CleanUp();
+
+	inline const gef::SkeletonPose& bind_pose() const { return bind_pose_; }
+	inline float scale_factor() const { return scale_factor_; }
+	inline const std::vector<Body>& bodies() const { return bodies_; }
+	inline const std::vector<Constraint>& constraints() const { return constraints_; }
+
+	// index into bodies() for each joint, -1 for joints without a rigid body
+	inline const std::vector<int>& joint_bodies() const { return joint_bodies_; }
+
+	// joints with a rigid body and all the joints below them, parents first
+	inline const std::vector<int>& simulated_joints() const { return simulated_joints_; }
+
+	// per body, in the same order as bodies()
+	// rb_offsets take a bone world transform to its rigid body world transform and rb_inv_offsets do the reverse
+	// parent_offsets take the world transform of the parent body to the world transform of the parent joint, inverted
+	inline const TransformBatch& rb_offsets() const { return rb_offsets_; }
+	inline const TransformBatch& rb_inv_offsets() const { return rb_inv_offsets_; }
+	inline const TransformBatch& parent_offsets() const { return parent_offsets_; }
+
+private:
+	int FindBody(const btRigidBody* body) const;
+
+	btBulletWorldImporter* file_loader_;
+	gef::SkeletonPose bind_pose_;
+	std::vector<Body> bodies_;
+	std::vector<Constraint> constraints_;
+	std::vector<int> joint_bodies_;
+	std::vector<int> simulated_joints_;
+	TransformBatch rb_offsets_;
+	TransformBatch rb_inv_offsets_;
+	TransformBatch parent_offsets_;
+	float scale_factor_;
+};
 
 class Ragdoll
 {
 public:
 	Ragdoll();
-	void Init(const gef::SkeletonPose& bind_pose, btDiscreteDynamicsWorld* dynamics_world, const char* physics_filename);
+	void Init(const RagdollTemplate& ragdoll_template, btDiscreteDynamicsWorld* dynamics_world, const gef::Matrix44& transform);
 	~Ragdoll();
+	void CleanUp();
 	void UpdatePoseFromRagdoll();
 	void UpdateRagdollFromPose();
 
+	// Only simulate the bodies at and below root_joint, for example one arm for a hit reaction
+	// The other bodies become kinematic and follow the animation pose passed to UpdateKinematicBodies
+	// -1 simulates the whole ragdoll again
+	void SetSimulatedSubtree(int root_joint);
+	void UpdateKinematicBodies(const gef::SkeletonPose& anim_pose);
+
+	// Ragdolls that have settled can be taken out of the world and put back if they need simulating again
+	void AddToWorld();
+	void RemoveFromWorld();
+
+	// true once Bullet has put all the dynamic bodies to sleep
+	bool IsSettled() const;
+
+	// override the number of solver iterations for the ragdoll's constraints, -1 uses the world setting
+	void SetSolverIterations(int num_iterations);
+
+	// world transform of the first body, the one closest to the root of the skeleton, or identity without any bodies
+	const btTransform& root_transform() const;
+
+	// Blend the simulated joints from pose() over the animation pose using the joint mask, the result is in blended_pose()
+	void BlendPose(const gef::SkeletonPose& anim_pose, float blend_weight);
+
 
 	inline gef::SkeletonPose& pose() { return pose_; }
 	inline void set_pose(const gef::SkeletonPose& pose) {
 		pose_ = pose;
+		pose_from_animation_ = true;
 	}
-	inline void set_scale_factor(float scale_factor) { scale_factor_ = scale_factor; }
-	inline float scale_factor() const { return scale_factor_;  }
-	inline std::vector<gef::Matrix44>& bone_world_matrices() { return bone_world_matrices_; }
+	inline const gef::SkeletonPose& blended_pose() const { return blended_pose_; }
+	// transform for drawing pose() with the animated model's mesh, including the scale down to ragdoll size
+	inline const gef::Matrix44& model_to_world() const { return model_to_world_; }
+	inline float scale_factor() const { return ragdoll_template_->scale_factor();  }
+	inline const std::vector<btRigidBody*>& bone_rbs() const { return bone_rbs_; }
+	inline bool in_world() const { return in_world_; }
+	inline int body_count() const { return (int)rbs_.size(); }
+
+	// per joint blend weights, 1 for the simulated joints and 0 for the rest
+	// set when the simulated subtree changes and can be adjusted afterwards to soften the edges of the mask
+	inline std::vector<float>& joint_mask() { return joint_mask_; }
 
 private:
-	gef::SkeletonPose bind_pose_;
+	const RagdollTemplate* ragdoll_template_;
+	btDiscreteDynamicsWorld* dynamics_world_;
 	gef::SkeletonPose pose_;
-	std::vector<gef::Matrix44> bone_rb_offset_matrices_;
+	gef::SkeletonPose blended_pose_;
+	bool pose_from_animation_;
+	bool in_world_;
 	std::vector<btRigidBody*> bone_rbs_;
-	std::vector<gef::Matrix44> bone_world_matrices_;
-	float scale_factor_;
+	std::vector<btRigidBody*> rbs_;
+	std::vector<btTypedConstraint*> constraints_;
+	gef::Matrix44 model_to_world_;
+	gef::Matrix44 world_to_model_;
+
+	// the bodies being simulated and the bodies following the animation, as indices into the template bodies
+	std::vector<int> dynamic_bodies_;
+	std::vector<int> kinematic_bodies_;
+
+	// the dynamic bodies whose parent body is kinematic, or that have no parent body, as indices into dynamic_bodies_
+	std::vector<int> top_dynamic_bodies_;
+
+	// joints at and below the dynamic bodies, parents first
+	std::vector<int> simulated_joints_;
+	std::vector<float> joint_mask_;
+
+	// the template offsets gathered for the dynamic and kinematic bodies
+	TransformBatch dynamic_rb_inv_offsets_;
+	TransformBatch dynamic_parent_offsets_;
+	TransformBatch kinematic_rb_offsets_;
+
+	// scratch space for synchronising the pose and the rigid bodies a batch at a time
+	TransformBatch rb_transforms_;
+	TransformBatch parent_transforms_;
+	TransformBatch temp_transforms_[2];
 };
 
 gef::Matrix44 btTransform2Matrix(const btTransform& transform);
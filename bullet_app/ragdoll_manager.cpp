@@ -0,0 +1,104 @@
+#include "ragdoll_manager.h"
+#include <system/memory_tracker.h>
+
+RagdollManager::RagdollManager() :
+	dynamics_world_(NULL),
+	active_count_(0),
+	lod_distance_(10.0f),
+	far_lod_distance_(25.0f),
+	lod_solver_iterations_(4),
+	far_lod_solver_iterations_(2)
+{
+}
+
+RagdollManager::~RagdollManager()
+{
+	CleanUp();
+}
+
+void RagdollManager::Init(btDiscreteDynamicsWorld* dynamics_world)
+{
+	CleanUp();
+	dynamics_world_ = dynamics_world;
+}
+
+void RagdollManager::CleanUp()
+{
+	for (size_t ragdoll_num = 0; ragdoll_num < ragdolls_.size(); ++ragdoll_num)
+		delete ragdolls_[ragdoll_num].ragdoll;
+	ragdolls_.clear();
+	active_count_ = 0;
+}
+
+Ragdoll* RagdollManager::Spawn(const RagdollTemplate& ragdoll_template, const gef::Matrix44& transform, const gef::SkeletonPose& pose)
+{
+	GEF_MEMORY_TAG(gef::MT_PHYSICS);
+
+	Ragdoll* ragdoll = new Ragdoll();
+	ragdoll->Init(ragdoll_template, dynamics_world_, transform);
+	ragdoll->set_pose(pose);
+	ragdoll->UpdateRagdollFromPose();
+
+	ManagedRagdoll managed_ragdoll;
+	managed_ragdoll.ragdoll = ragdoll;
+	managed_ragdoll.frozen = false;
+	managed_ragdoll.lod = 0;
+	ragdolls_.push_back(managed_ragdoll);
+	active_count_++;
+
+	return ragdoll;
+}
+
+void RagdollManager::Update(const gef::Vector4& viewer_position)
+{
+	GEF_MEMORY_TAG(gef::MT_PHYSICS);
+
+	const btVector3 viewer(viewer_position.x(), viewer_position.y(), viewer_position.z());
+
+	for (size_t ragdoll_num = 0; ragdoll_num < ragdolls_.size(); ++ragdoll_num)
+	{
+		ManagedRagdoll& managed_ragdoll = ragdolls_[ragdoll_num];
+		if (managed_ragdoll.frozen)
+			continue;
+
+		Ragdoll* ragdoll = managed_ragdoll.ragdoll;
+
+		// the last pose from the bodies is kept as the frozen snapshot, after that the ragdoll costs nothing
+		ragdoll->UpdatePoseFromRagdoll();
+		if (ragdoll->IsSettled())
+		{
+			ragdoll->RemoveFromWorld();
+			managed_ragdoll.frozen = true;
+			active_count_--;
+			continue;
+		}
+
+		if (ragdoll->body_count() == 0)
+			continue;
+
+		const btScalar distance_sqr = (ragdoll->root_transform().getOrigin() - viewer).length2();
+		int lod = 0;
+		if (distance_sqr > far_lod_distance_ * far_lod_distance_)
+			lod = 2;
+		else if (distance_sqr > lod_distance_ * lod_distance_)
+			lod = 1;
+
+		if (lod != managed_ragdoll.lod)
+		{
+			const int solver_iterations[] = { -1, lod_solver_iterations_, far_lod_solver_iterations_ };
+			ragdoll->SetSolverIterations(solver_iterations[lod]);
+			managed_ragdoll.lod = lod;
+		}
+	}
+}
+
+void RagdollManager::Wake(int ragdoll_num)
+{
+	ManagedRagdoll& managed_ragdoll = ragdolls_[ragdoll_num];
+	if (!managed_ragdoll.frozen)
+		return;
+
+	managed_ragdoll.ragdoll->AddToWorld();
+	managed_ragdoll.frozen = false;
+	active_count_++;
+}
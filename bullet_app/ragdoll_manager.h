@@ -0,0 +1,55 @@
+#ifndef _RAGDOLL_MANAGER_H
+#define _RAGDOLL_MANAGER_H
+
+#include "ragdoll.h"
+#include <maths/vector4.h>
+
+// Owns the ragdolls spawned into a world and keeps the cost of simulating them down
+// Ragdolls that have settled are frozen: their last pose is kept for drawing and their bodies are taken out of the world
+// Ragdolls further from the viewer are simulated with fewer constraint solver iterations
+class RagdollManager
+{
+public:
+	RagdollManager();
+	~RagdollManager();
+
+	void Init(btDiscreteDynamicsWorld* dynamics_world);
+	void CleanUp();
+
+	// create a simulating ragdoll starting from the given pose, the manager owns the ragdoll
+	Ragdoll* Spawn(const RagdollTemplate& ragdoll_template, const gef::Matrix44& transform, const gef::SkeletonPose& pose);
+
+	// call after the physics world has been stepped
+	void Update(const gef::Vector4& viewer_position);
+
+	// put a frozen ragdoll back into the world, for example when it gets hit again
+	void Wake(int ragdoll_num);
+
+	inline int ragdoll_count() const { return (int)ragdolls_.size(); }
+	inline Ragdoll* ragdoll(int ragdoll_num) const { return ragdolls_[ragdoll_num].ragdoll; }
+	inline bool frozen(int ragdoll_num) const { return ragdolls_[ragdoll_num].frozen; }
+	inline int active_count() const { return active_count_; }
+
+	// ragdolls beyond lod_distance use lod_solver_iterations, and beyond far_lod_distance far_lod_solver_iterations
+	inline void set_lod_distances(float lod_distance, float far_lod_distance) { lod_distance_ = lod_distance; far_lod_distance_ = far_lod_distance; }
+	inline void set_lod_solver_iterations(int lod_solver_iterations, int far_lod_solver_iterations) { lod_solver_iterations_ = lod_solver_iterations; far_lod_solver_iterations_ = far_lod_solver_iterations; }
+
+private:
+	struct ManagedRagdoll
+	{
+		Ragdoll* ragdoll;
+		bool frozen;
+		int lod;
+	};
+
+	btDiscreteDynamicsWorld* dynamics_world_;
+	std::vector<ManagedRagdoll> ragdolls_;
+	int active_count_;
+
+	float lod_distance_;
+	float far_lod_distance_;
+	int lod_solver_iterations_;
+	int far_lod_solver_iterations_;
+};
+
+#endif // _RAGDOLL_MANAGER_H
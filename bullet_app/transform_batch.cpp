@@ -0,0 +1,129 @@
+#include "transform_batch.h"
+
+TransformBatch::TransformBatch() :
+	count_(0)
+{
+}
+
+void TransformBatch::Resize(int count)
+{
+	count_ = count;
+	elements_.resize(count * 12);
+}
+
+void TransformBatch::Set(int index, const gef::Matrix44& matrix)
+{
+	for (int row = 0; row < 4; ++row)
+	{
+		for (int column = 0; column < 3; ++column)
+			element(row, column)[index] = matrix.m(row, column);
+	}
+}
+
+gef::Matrix44 TransformBatch::Get(int index) const
+{
+	gef::Matrix44 matrix;
+	for (int row = 0; row < 4; ++row)
+	{
+		for (int column = 0; column < 3; ++column)
+			matrix.set_m(row, column, element(row, column)[index]);
+		matrix.set_m(row, 3, row == 3 ? 1.0f : 0.0f);
+	}
+
+	return matrix;
+}
+
+void TransformBatch::Copy(int index, const TransformBatch& source, int source_index)
+{
+	for (int row = 0; row < 4; ++row)
+	{
+		for (int column = 0; column < 3; ++column)
+			element(row, column)[index] = source.element(row, column)[source_index];
+	}
+}
+
+void TransformBatch::Multiply(const TransformBatch& a, const TransformBatch& b, TransformBatch& result)
+{
+	const int count = a.count();
+
+	for (int row = 0; row < 4; ++row)
+	{
+		const float* a0 = a.element(row, 0);
+		const float* a1 = a.element(row, 1);
+		const float* a2 = a.element(row, 2);
+
+		for (int column = 0; column < 3; ++column)
+		{
+			const float* b0 = b.element(0, column);
+			const float* b1 = b.element(1, column);
+			const float* b2 = b.element(2, column);
+			float* r = result.element(row, column);
+
+			for (int i = 0; i < count; ++i)
+				r[i] = a0[i] * b0[i] + a1[i] * b1[i] + a2[i] * b2[i];
+
+			// the translation row picks up the translation of b
+			if (row == 3)
+			{
+				const float* b3 = b.element(3, column);
+				for (int i = 0; i < count; ++i)
+					r[i] += b3[i];
+			}
+		}
+	}
+}
+
+void TransformBatch::Multiply(const TransformBatch& a, const gef::Matrix44& matrix, TransformBatch& result)
+{
+	const int count = a.count();
+
+	for (int row = 0; row < 4; ++row)
+	{
+		const float* a0 = a.element(row, 0);
+		const float* a1 = a.element(row, 1);
+		const float* a2 = a.element(row, 2);
+
+		for (int column = 0; column < 3; ++column)
+		{
+			const float b0 = matrix.m(0, column);
+			const float b1 = matrix.m(1, column);
+			const float b2 = matrix.m(2, column);
+			const float b3 = row == 3 ? matrix.m(3, column) : 0.0f;
+			float* r = result.element(row, column);
+
+			for (int i = 0; i < count; ++i)
+				r[i] = a0[i] * b0 + a1[i] * b1 + a2[i] * b2 + b3;
+		}
+	}
+}
+
+void TransformBatch::RigidInverse(const TransformBatch& a, TransformBatch& result)
+{
+	const int count = a.count();
+
+	// the inverse rotation is the transpose
+	for (int row = 0; row < 3; ++row)
+	{
+		for (int column = 0; column < 3; ++column)
+		{
+			const float* source = a.element(column, row);
+			float* r = result.element(row, column);
+			for (int i = 0; i < count; ++i)
+				r[i] = source[i];
+		}
+	}
+
+	// and the inverse translation is the negated translation rotated by it
+	const float* tx = a.element(3, 0);
+	const float* ty = a.element(3, 1);
+	const float* tz = a.element(3, 2);
+	for (int column = 0; column < 3; ++column)
+	{
+		const float* r0 = a.element(column, 0);
+		const float* r1 = a.element(column, 1);
+		const float* r2 = a.element(column, 2);
+		float* r = result.element(3, column);
+		for (int i = 0; i < count; ++i)
+			r[i] = -(tx[i] * r0[i] + ty[i] * r1[i] + tz[i] * r2[i]);
+	}
+}
@@ -0,0 +1,41 @@
+#ifndef _TRANSFORM_BATCH_H
+#define _TRANSFORM_BATCH_H
+
+#include <maths/matrix44.h>
+#include <vector>
+
+// A batch of affine transforms stored as a structure of arrays
+// Rows 0-2 hold the rotation and scale and row 3 the translation, with the same row vector convention as gef::Matrix44
+// The operations work on one element of every transform at a time so the compiler can process several transforms per SIMD instruction
+class TransformBatch
+{
+public:
+	TransformBatch();
+
+	void Resize(int count);
+
+	void Set(int index, const gef::Matrix44& matrix);
+	gef::Matrix44 Get(int index) const;
+
+	// copy a transform between batches, for gathering transforms into a batch
+	void Copy(int index, const TransformBatch& source, int source_index);
+
+	// result = a * b for each pair of transforms, result must not be either operand
+	static void Multiply(const TransformBatch& a, const TransformBatch& b, TransformBatch& result);
+
+	// result = a * matrix for every transform in a
+	static void Multiply(const TransformBatch& a, const gef::Matrix44& matrix, TransformBatch& result);
+
+	// inverse of transforms that only contain a rotation and translation
+	static void RigidInverse(const TransformBatch& a, TransformBatch& result);
+
+	inline float* element(int row, int column) { return elements_.data() + (row * 3 + column) * count_; }
+	inline const float* element(int row, int column) const { return elements_.data() + (row * 3 + column) * count_; }
+	inline int count() const { return count_; }
+
+private:
+	std::vector<float> elements_;
+	int count_;
+};
+
+#endif // _TRANSFORM_BATCH_H
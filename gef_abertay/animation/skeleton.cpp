@@ -1,5 +1,7 @@
 #include <animation/skeleton.h>
 #include <animation/animation.h>
+#include <system/profiler.h>
+#include <system/memory_tracker.h>
 
 namespace gef
 {
@@ -42,6 +44,9 @@ namespace gef
 
 	void SkeletonPose::CalculateGlobalPose(const gef::Matrix44 * const pose_transform)
 	{
+		GEF_PROFILE_ZONE("SkeletonPose::CalculateGlobalPose");
+		GEF_MEMORY_TAG(MT_ANIMATION);
+
 		if(skeleton_)
 		{
 			const std::vector<Joint>& joints = skeleton_->joints();
@@ -68,6 +73,25 @@ namespace gef
 		}
 	}
 
+	void SkeletonPose::UpdateGlobalPose(const std::vector<Int32>& joint_indices)
+	{
+		GEF_PROFILE_ZONE("SkeletonPose::UpdateGlobalPose");
+
+		if(skeleton_)
+		{
+			const std::vector<Joint>& joints = skeleton_->joints();
+			for(size_t index=0; index<joint_indices.size(); index++)
+			{
+				const Int32 jointNum = joint_indices[index];
+				const Joint& joint = joints[jointNum];
+				if(joint.parent == -1)
+					global_pose_[jointNum] = local_pose_[jointNum].GetMatrix();
+				else
+					global_pose_[jointNum] = local_pose_[jointNum].GetMatrix() * global_pose_[joint.parent];
+			}
+		}
+	}
+
 	void SkeletonPose::CalculateLocalPose(const std::vector<Matrix44>& global_pose_matrices)
 	{
 		if(skeleton_)
@@ -132,6 +156,9 @@ namespace gef
 
 	void SkeletonPose::SetPoseFromAnim(const Animation& anim, const SkeletonPose& bind_pose, float time, const bool updateGlobalPose)
 	{
+		GEF_PROFILE_ZONE("SkeletonPose::SetPoseFromAnim");
+		GEF_MEMORY_TAG(MT_ANIMATION);
+
 		Int32 joint_index=0;
 		for(std::vector<JointPose>::iterator joint_iter = local_pose_.begin(); joint_iter != local_pose_.end(); ++joint_iter, ++joint_index)
 		{
@@ -46,6 +46,10 @@ namespace gef
 		SkeletonPose();
 		void CalculateGlobalPose(const gef::Matrix44 * const pose_transform = NULL);
 		void CalculateLocalPose(const std::vector<Matrix44>& global_pose);
+
+		// recalculate the global transforms of only the given joints, which must be listed parents first
+		// the global transforms of all the other joints must already be up to date
+		void UpdateGlobalPose(const std::vector<Int32>& joint_indices);
 		void SetPoseFromAnim(const class Animation& _anim, const SkeletonPose& _bindPose, const float _time, const bool _updateGlobalPose = true);
 	//	void SetLocalJointPoseFromAnim(JointPose& _jointPose, const UInt32 _jointNum, const JointPose& _jointBindPose, const class Anim& _anim, const float _time);
 		void Linear2PoseBlend(const SkeletonPose& _startPose, const SkeletonPose& _endPose, const float _time);
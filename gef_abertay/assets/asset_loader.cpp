@@ -0,0 +1,339 @@
+#include <assets/asset_loader.h>
+#include <assets/png_loader.h>
+#include <assets/texture_cache.h>
+#include <graphics/scene.h>
+#include <graphics/texture.h>
+#include <graphics/font.h>
+#include <graphics/image_data.h>
+#include <system/platform.h>
+#include <system/profiler.h>
+#include <system/memory_tracker.h>
+#include <algorithm>
+
+namespace gef
+{
+	AssetRequest::AssetRequest(AssetType type, const char* filename, UInt32 flags) :
+		type_(type),
+		filename_(filename),
+		flags_(flags),
+		state_(ALS_QUEUED),
+		released_(false),
+		scene_(NULL),
+		texture_(NULL),
+		font_(NULL),
+		image_data_(NULL)
+	{
+	}
+
+	AssetRequest::~AssetRequest()
+	{
+		DeleteImageData();
+	}
+
+	void AssetRequest::DeleteAssets()
+	{
+		delete scene_;
+		scene_ = NULL;
+		delete texture_;
+		texture_ = NULL;
+		delete font_;
+		font_ = NULL;
+	}
+
+	void AssetRequest::DeleteImageData()
+	{
+		delete image_data_;
+		image_data_ = NULL;
+
+		for (std::map<StringId, ImageData*>::iterator image_iter = scene_image_data_.begin(); image_iter != scene_image_data_.end(); ++image_iter)
+			delete image_iter->second;
+		scene_image_data_.clear();
+	}
+
+	AssetLoader::AssetLoader(Platform& platform, Int32 num_threads, const TextureCache* texture_cache) :
+		platform_(platform),
+		texture_cache_(texture_cache),
+		loading_count_(0),
+		quit_(false)
+	{
+		num_threads = std::max(num_threads, 1);
+
+		workers_.reserve(num_threads);
+		for (Int32 worker_num = 0; worker_num < num_threads; ++worker_num)
+			workers_.push_back(std::thread(&AssetLoader::WorkerMain, this));
+	}
+
+	AssetLoader::~AssetLoader()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			quit_ = true;
+		}
+		work_ready_.notify_all();
+
+		for (size_t worker_num = 0; worker_num < workers_.size(); ++worker_num)
+			workers_[worker_num].join();
+
+		for (std::deque<AssetRequest*>::iterator request_iter = load_queue_.begin(); request_iter != load_queue_.end(); ++request_iter)
+			delete *request_iter;
+
+		for (std::deque<AssetRequest*>::iterator request_iter = create_queue_.begin(); request_iter != create_queue_.end(); ++request_iter)
+		{
+			(*request_iter)->DeleteAssets();
+			delete *request_iter;
+		}
+	}
+
+	AssetRequest* AssetLoader::LoadScene(const char* filename, UInt32 flags)
+	{
+		return Queue(new AssetRequest(AT_SCENE, filename, flags));
+	}
+
+	AssetRequest* AssetLoader::LoadTexture(const char* filename)
+	{
+		return Queue(new AssetRequest(AT_TEXTURE, filename, 0));
+	}
+
+	AssetRequest* AssetLoader::LoadFont(const char* font_name)
+	{
+		return Queue(new AssetRequest(AT_FONT, font_name, 0));
+	}
+
+	AssetRequest* AssetLoader::Queue(AssetRequest* request)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			load_queue_.push_back(request);
+		}
+		work_ready_.notify_one();
+
+		return request;
+	}
+
+	void AssetLoader::Release(AssetRequest* request)
+	{
+		if (request == NULL)
+			return;
+
+		std::lock_guard<std::mutex> lock(mutex_);
+		switch (request->state())
+		{
+		case ALS_QUEUED:
+			load_queue_.erase(std::find(load_queue_.begin(), load_queue_.end(), request));
+			break;
+
+		case ALS_LOADING:
+			// the loader thread deletes it once it has finished with it
+			request->released_ = true;
+			return;
+
+		case ALS_CREATING:
+			create_queue_.erase(std::find(create_queue_.begin(), create_queue_.end(), request));
+			request->DeleteAssets();
+			break;
+
+		default:
+			break;
+		}
+
+		delete request;
+	}
+
+	Int32 AssetLoader::pending_count() const
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		return (Int32)(load_queue_.size() + create_queue_.size()) + loading_count_;
+	}
+
+	void AssetLoader::WorkerMain()
+	{
+		for (;;)
+		{
+			AssetRequest* request = NULL;
+			{
+				std::unique_lock<std::mutex> lock(mutex_);
+				work_ready_.wait(lock, [this] { return quit_ || !load_queue_.empty(); });
+				if (quit_)
+					return;
+
+				request = load_queue_.front();
+				load_queue_.pop_front();
+				request->state_.store(ALS_LOADING, std::memory_order_release);
+				loading_count_++;
+			}
+
+			const bool success = LoadOnWorker(request);
+
+			std::lock_guard<std::mutex> lock(mutex_);
+			loading_count_--;
+			if (request->released_)
+			{
+				request->DeleteAssets();
+				delete request;
+			}
+			else if (success)
+			{
+				request->state_.store(ALS_CREATING, std::memory_order_release);
+				create_queue_.push_back(request);
+			}
+			else
+			{
+				request->DeleteAssets();
+				request->DeleteImageData();
+				request->state_.store(ALS_FAILED, std::memory_order_release);
+			}
+		}
+	}
+
+	bool AssetLoader::LoadOnWorker(AssetRequest* request)
+	{
+		GEF_PROFILE_ZONE("AssetLoader::LoadOnWorker");
+
+		bool success = false;
+
+		switch (request->type_)
+		{
+		case AT_SCENE:
+			{
+				request->scene_ = new Scene();
+				success = request->scene_->ReadSceneFromFile(platform_, request->filename_.c_str());
+				if (!success)
+					break;
+
+				const std::list<MaterialData>& material_data = request->scene_->material_data;
+				if (request->flags_ & SLF_CREATE_MATERIALS)
+				{
+					GEF_MEMORY_TAG(MT_RENDERING);
+
+					// decode each diffuse texture once, the main thread only has to create the textures
+					for (std::list<MaterialData>::const_iterator material_iter = material_data.begin(); material_iter != material_data.end(); ++material_iter)
+					{
+						if (material_iter->diffuse_texture == "")
+							continue;
+
+						ImageData*& image_data = request->scene_image_data_[GetStringId(material_iter->diffuse_texture)];
+						if (image_data == NULL)
+						{
+							image_data = new ImageData();
+							DecodeTexture(material_iter->diffuse_texture.c_str(), *image_data);
+						}
+					}
+				}
+
+				request->next_material_ = (request->flags_ & SLF_CREATE_MATERIALS) ? material_data.begin() : material_data.end();
+				request->next_mesh_ = (request->flags_ & SLF_CREATE_MESHES) ? request->scene_->mesh_data.begin() : request->scene_->mesh_data.end();
+			}
+			break;
+
+		case AT_TEXTURE:
+			{
+				GEF_MEMORY_TAG(MT_RENDERING);
+
+				request->image_data_ = new ImageData();
+				DecodeTexture(request->filename_.c_str(), *request->image_data_);
+				success = request->image_data_->image() != NULL;
+			}
+			break;
+
+		case AT_FONT:
+			{
+				GEF_MEMORY_TAG(MT_RENDERING);
+
+				request->font_ = new Font(platform_);
+				request->image_data_ = new ImageData();
+				success = request->font_->LoadConfig(request->filename_.c_str(), *request->image_data_);
+			}
+			break;
+		}
+
+		return success;
+	}
+
+	void AssetLoader::DecodeTexture(const char* filename, ImageData& image_data) const
+	{
+		if (texture_cache_)
+		{
+			texture_cache_->Load(filename, image_data);
+		}
+		else
+		{
+			PNGLoader png_loader;
+			png_loader.Load(filename, platform_, image_data);
+		}
+	}
+
+	void AssetLoader::Update(float time_budget_ms)
+	{
+		GEF_PROFILE_ZONE("AssetLoader::Update");
+
+		const UInt64 start_ns = Profiler::GetTimeNs();
+		const UInt64 budget_ns = (UInt64)(std::max(time_budget_ms, 0.0f) * 1000000.0f);
+
+		for (;;)
+		{
+			AssetRequest* request = NULL;
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				if (create_queue_.empty())
+					break;
+				request = create_queue_.front();
+			}
+
+			// only the main thread takes requests off the create queue, so the request can't go anywhere while the lock is released
+			if (CreateStep(request))
+			{
+				request->DeleteImageData();
+
+				std::lock_guard<std::mutex> lock(mutex_);
+				create_queue_.pop_front();
+				request->state_.store(ALS_COMPLETE, std::memory_order_release);
+			}
+
+			if (Profiler::GetTimeNs() - start_ns >= budget_ns)
+				break;
+		}
+	}
+
+	bool AssetLoader::CreateStep(AssetRequest* request)
+	{
+		switch (request->type_)
+		{
+		case AT_SCENE:
+			{
+				Scene* scene = request->scene_;
+				if (request->next_material_ != scene->material_data.end())
+				{
+					const MaterialData& material_data = *request->next_material_++;
+
+					// passing the decoded image, even if decoding failed, stops CreateMaterial loading it again here
+					const ImageData* image_data = NULL;
+					if (material_data.diffuse_texture != "")
+						image_data = request->scene_image_data_[GetStringId(material_data.diffuse_texture)];
+
+					scene->CreateMaterial(platform_, material_data, image_data);
+					return false;
+				}
+
+				if (request->next_mesh_ != scene->mesh_data.end())
+				{
+					GEF_MEMORY_TAG(MT_RENDERING);
+
+					scene->meshes.push_back(scene->CreateMesh(platform_, *request->next_mesh_++));
+					return request->next_mesh_ == scene->mesh_data.end();
+				}
+			}
+			return true;
+
+		case AT_TEXTURE:
+			request->texture_ = Texture::Create(platform_, *request->image_data_);
+			return true;
+
+		case AT_FONT:
+			if (request->image_data_->image() != NULL)
+				request->font_->CreateTexture(*request->image_data_);
+			return true;
+		}
+
+		return true;
+	}
+}
@@ -0,0 +1,141 @@
+#ifndef _GEF_ASSET_LOADER_H
+#define _GEF_ASSET_LOADER_H
+
+#include <gef.h>
+#include <system/string_id.h>
+#include <graphics/mesh_data.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace gef
+{
+	class Platform;
+	class Scene;
+	class Texture;
+	class Font;
+	class ImageData;
+	class TextureCache;
+
+	enum AssetType
+	{
+		AT_SCENE = 0,
+		AT_TEXTURE,
+		AT_FONT
+	};
+
+	enum AssetLoadState
+	{
+		ALS_QUEUED = 0,		// waiting for a loader thread
+		ALS_LOADING,		// being read and decoded on a loader thread
+		ALS_CREATING,		// waiting for AssetLoader::Update to create the GPU resources
+		ALS_COMPLETE,
+		ALS_FAILED
+	};
+
+	enum SceneLoadFlags
+	{
+		SLF_CREATE_MATERIALS = 0x1,
+		SLF_CREATE_MESHES = 0x2
+	};
+
+	/// Handle for a load started by an AssetLoader.
+	/// Poll done() from the main thread, once the load is complete the asset belongs to the caller and the request can be released.
+	class AssetRequest
+	{
+	public:
+		inline AssetType type() const { return type_; }
+		inline const std::string& filename() const { return filename_; }
+		inline AssetLoadState state() const { return (AssetLoadState)state_.load(std::memory_order_acquire); }
+		inline bool done() const { return state() >= ALS_COMPLETE; }
+		inline bool succeeded() const { return state() == ALS_COMPLETE; }
+
+		/// NULL until the load is complete
+		inline Scene* scene() const { return succeeded() ? scene_ : NULL; }
+		inline Texture* texture() const { return succeeded() ? texture_ : NULL; }
+		inline Font* font() const { return succeeded() ? font_ : NULL; }
+
+	private:
+		friend class AssetLoader;
+
+		AssetRequest(AssetType type, const char* filename, UInt32 flags);
+		~AssetRequest();
+
+		void DeleteAssets();
+		void DeleteImageData();
+
+		AssetType type_;
+		std::string filename_;
+		UInt32 flags_;
+		std::atomic<Int32> state_;
+		bool released_;
+
+		Scene* scene_;
+		Texture* texture_;
+		Font* font_;
+
+		// decoded on the loader thread for the texture and font, and per diffuse texture for a scene
+		ImageData* image_data_;
+		std::map<StringId, ImageData*> scene_image_data_;
+
+		// how far through creating the scene Update has got
+		std::list<MaterialData>::const_iterator next_material_;
+		std::list<MeshData>::const_iterator next_mesh_;
+	};
+
+	/// Loads scenes, textures and fonts without stalling the main thread.
+	/// Files are read and parsed, and PNGs decoded, on the loader's own threads.
+	/// Creating materials, meshes and textures has to happen on the main thread so it is done a step at a time in Update, within a per frame time budget.
+	class AssetLoader
+	{
+	public:
+		/// with a texture cache, scene and texture PNGs are loaded through it rather than decoded every time
+		AssetLoader(Platform& platform, Int32 num_threads = 1, const TextureCache* texture_cache = NULL);
+
+		/// Anything still loading is abandoned. Requests that have finished must be released first.
+		~AssetLoader();
+
+		AssetRequest* LoadScene(const char* filename, UInt32 flags = SLF_CREATE_MATERIALS | SLF_CREATE_MESHES);
+		AssetRequest* LoadTexture(const char* filename);
+		AssetRequest* LoadFont(const char* font_name);
+
+		/// Call once a frame from the main thread.
+		/// Takes creation steps (a material, a mesh or a texture each) until time_budget_ms is used up, always at least one if there is work waiting.
+		void Update(float time_budget_ms);
+
+		/// Frees the request. If it hasn't finished the load is abandoned and anything created for it is deleted,
+		/// otherwise the asset is left for the caller.
+		void Release(AssetRequest* request);
+
+		/// requests that haven't finished yet
+		Int32 pending_count() const;
+
+	private:
+		AssetRequest* Queue(AssetRequest* request);
+		void WorkerMain();
+		bool LoadOnWorker(AssetRequest* request);
+		void DecodeTexture(const char* filename, ImageData& image_data) const;
+
+		// returns true once there are no more steps for the request
+		bool CreateStep(AssetRequest* request);
+
+		Platform& platform_;
+		const TextureCache* texture_cache_;
+		std::vector<std::thread> workers_;
+
+		mutable std::mutex mutex_;
+		std::condition_variable work_ready_;
+		std::deque<AssetRequest*> load_queue_;
+		std::deque<AssetRequest*> create_queue_;
+		Int32 loading_count_;
+		bool quit_;
+	};
+}
+
+#endif // _GEF_ASSET_LOADER_H
@@ -1,360 +1,894 @@
 #include <assets/obj_loader.h>
-#include <vector>
-#include <maths/vector4.h>
-#include <maths/vector2.h>
+#include <assets/png_loader.h>
 #include <graphics/mesh.h>
 #include <graphics/primitive.h>
-#include <system/platform.h>
 #include <graphics/model.h>
-#include <assets/png_loader.h>
 #include <graphics/texture.h>
 #include <graphics/image_data.h>
-#include <system/file.h>
-#include <system/memory_stream_buffer.h>
 #include <graphics/material.h>
-
+#include <maths/aabb.h>
+#include <maths/sphere.h>
+#include <system/platform.h>
+#include <system/file.h>
+#include <system/mapped_file.h>
+#include <system/job_system.h>
+#include <system/profiler.h>
+#include <system/memory_tracker.h>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
 #include <cstdio>
 #include <cstring>
-#include <istream>
-#include <cfloat>
+#include <fstream>
 
 namespace gef
 {
+	struct OBJCacheHeader
+	{
+		UInt32 magic;
+		UInt32 version;
+		UInt64 source_time;				// 0 where the platform has no modification times
+		Int32 source_size;
+		Int32 vertex_count;				// also the index count, every triangle corner is its own vertex
+		Int32 primitive_count;
+		Int32 texture_count;
+		float bounds_min[3];
+		float bounds_max[3];
+		UInt32 vertices_offset;			// from the start of the file, each section is kCacheAlignment aligned
+		UInt32 indices_offset;
+		UInt32 primitives_offset;
+		UInt32 texture_filenames_offset;	// texture_count null terminated filenames
+		UInt32 file_size;
+		UInt32 pad;
+	};
+
+	static const UInt32 kCacheAlignment = 16;
+
+	// a range of the model's index array and the texture it is drawn with
+	struct OBJPrimitive
+	{
+		Int32 first_index;
+		Int32 index_count;
+		Int32 texture_index;		// -1 for no material
+	};
 
+	enum OBJStatementType
+	{
+		OST_MTLLIB = 0,
+		OST_USEMTL
+	};
 
-bool OBJLoader::Load(const char* filename, Platform& platform, Model& model)
-{
-	bool success = true;
+	// mtllib and usemtl lines are kept in file order and applied once every chunk has been parsed
+	struct OBJStatement
+	{
+		OBJStatementType type;
+		Int32 corner_offset;		// triangle corners in the chunk before the statement
+		const char* name;			// points into the file
+		Int32 name_length;
+	};
+
+	// a run of whole lines of the file and what they parse to
+	struct OBJChunk
+	{
+		const char* begin;
+		const char* end;
+		bool success;
+
+		std::vector<float> positions;	// xyz
+		std::vector<float> normals;		// xyz
+		std::vector<float> uvs;			// uv
+		std::vector<Int32> corners;		// position, uv and normal index of each triangle corner as written in the file, in draw order
+		std::vector<OBJStatement> statements;
+
+		// triangle corners in the chunks before this one, which is also where its vertices start
+		Int32 corner_base;
+		float bounds_min[3];
+		float bounds_max[3];
+	};
+
+	// the model as it is created on the platform and stored in the cache
+	struct OBJModelData
+	{
+		std::vector<Mesh::Vertex> vertices;
+		std::vector<UInt32> indices;
+		std::vector<OBJPrimitive> primitives;
+		std::vector<std::string> texture_filenames;
+		float bounds_min[3];
+		float bounds_max[3];
+	};
+
+	static inline bool IsSpace(char character)
+	{
+		return character == ' ' || character == '\t' || character == '\r';
+	}
+
+	static inline bool IsDigit(char character)
+	{
+		return character >= '0' && character <= '9';
+	}
 
-	std::vector<Texture*> textures;
-	std::vector<gef::Vector4> positions;
-	std::vector<gef::Vector4> normals;
-	std::vector<gef::Vector2> uvs;
-	std::vector<Int32> face_indices;
-	std::vector<Int32> primitive_indices;
-	std::vector<Int32> texture_indices;
+	static inline const char* SkipSpaces(const char* text, const char* end)
+	{
+		while (text < end && IsSpace(*text))
+			++text;
+		return text;
+	}
 
-	std::map<std::string, Int32> materials;
+	// returns the start of the next line
+	static inline const char* SkipLine(const char* text, const char* end)
+	{
+		const char* line_end = static_cast<const char*>(memchr(text, '\n', end - text));
+		return line_end ? line_end + 1 : end;
+	}
+
+	static inline const char* TokenEnd(const char* text, const char* end)
+	{
+		while (text < end && !IsSpace(*text) && *text != '\n')
+			++text;
+		return text;
+	}
 
-	std::string obj_filename(filename);
-	void* obj_file_data = NULL;
-	Int32 file_size = 0;
-	gef::File* file = gef::File::Create();
+	static inline bool TokenIs(const char* token, const char* token_end, const char* keyword)
+	{
+		const size_t length = strlen(keyword);
+		return (size_t)(token_end - token) == length && memcmp(token, keyword, length) == 0;
+	}
 
-	success = file->Open(obj_filename.c_str());
-	if(success)
+	static const double kPowersOfTen[] =
 	{
-		success = file->GetSize(file_size);
-		if(success)
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+
+	// Decimal and scientific notation. The digits are gathered into an integer and scaled by an exact power of ten,
+	// which is within a rounding step of strtof for the digits an exporter writes.
+	// Returns NULL if there is no number at text.
+	static const char* ParseFloat(const char* text, const char* end, float& value)
+	{
+		bool negative = false;
+		if (text < end && (*text == '-' || *text == '+'))
+			negative = *text++ == '-';
+
+		UInt64 mantissa = 0;
+		Int32 significant_digits = 0;
+		Int32 exponent = 0;
+		bool has_digits = false;
+
+		for (; text < end && IsDigit(*text); ++text)
+		{
+			has_digits = true;
+			if (significant_digits < 19)
+			{
+				mantissa = mantissa * 10 + (*text - '0');
+				if (mantissa != 0)
+					++significant_digits;
+			}
+			else
+				++exponent;
+		}
+
+		if (text < end && *text == '.')
+		{
+			for (++text; text < end && IsDigit(*text); ++text)
+			{
+				has_digits = true;
+				if (significant_digits < 19)
+				{
+					mantissa = mantissa * 10 + (*text - '0');
+					if (mantissa != 0)
+						++significant_digits;
+					--exponent;
+				}
+			}
+		}
+
+		if (!has_digits)
+			return NULL;
+
+		if (text < end && (*text == 'e' || *text == 'E'))
 		{
-			obj_file_data = malloc(file_size);
-			success = obj_file_data != NULL;
-			if(success)
+			const char* exponent_text = text + 1;
+			bool negative_exponent = false;
+			if (exponent_text < end && (*exponent_text == '-' || *exponent_text == '+'))
+				negative_exponent = *exponent_text++ == '-';
+
+			if (exponent_text < end && IsDigit(*exponent_text))
 			{
-				Int32 bytes_read;
-				success = file->Read(obj_file_data, file_size, bytes_read);
-				if(success)
-					success = bytes_read == file_size;
+				Int32 written_exponent = 0;
+				for (; exponent_text < end && IsDigit(*exponent_text); ++exponent_text)
+				{
+					if (written_exponent < 10000)
+						written_exponent = written_exponent * 10 + (*exponent_text - '0');
+				}
+				exponent += negative_exponent ? -written_exponent : written_exponent;
+				text = exponent_text;
 			}
 		}
+
+		double result = (double)mantissa;
+		if (exponent < 0)
+			result = exponent >= -22 ? result / kPowersOfTen[-exponent] : result / pow(10.0, -exponent);
+		else if (exponent > 0)
+			result = exponent <= 22 ? result * kPowersOfTen[exponent] : result * pow(10.0, exponent);
+
+		value = (float)(negative ? -result : result);
+		return text;
 	}
 
-	if(!success)
+	static const char* ParseInt(const char* text, const char* end, Int32& value)
 	{
-		free(obj_file_data);
-		obj_file_data = NULL;
+		bool negative = false;
+		if (text < end && *text == '-')
+		{
+			negative = true;
+			++text;
+		}
+
+		if (text == end || !IsDigit(*text))
+			return NULL;
 
-		delete file;
-		file = NULL;
-		return false;
+		Int32 result = 0;
+		for (; text < end && IsDigit(*text); ++text)
+		{
+			if (result < 100000000)
+				result = result * 10 + (*text - '0');
+		}
+
+		value = negative ? -result : result;
+		return text;
 	}
-	gef::MemoryStreamBuffer buffer((char*)obj_file_data, file_size);
-	std::istream stream(&buffer);
 
+	static const char* ParseFloats(const char* text, const char* end, Int32 count, std::vector<float>& values)
 	{
-		while( !stream.eof() )
+		for (Int32 value_num = 0; value_num < count; ++value_num)
 		{
-		    char line[128];
-			stream >> line;
-			if ( strcmp( line, "mtllib" ) == 0 )
-			{
-				char material_filename[256];
-				stream >> material_filename;
+			float value;
+			text = ParseFloat(SkipSpaces(text, end), end, value);
+			if (text == NULL)
+				return NULL;
+			values.push_back(value);
+		}
 
-				LoadMaterials(platform, material_filename, materials, textures);
-			}
+		return text;
+	}
+
+	// a v, v/vt, v//vn or v/vt/vn face corner, indices that aren't given are 0
+	static const char* ParseCorner(const char* text, const char* end, Int32* indices)
+	{
+		indices[0] = indices[1] = indices[2] = 0;
+
+		text = ParseInt(text, end, indices[0]);
+		if (text == NULL || text == end || *text != '/')
+			return text;
+
+		++text;
+		if (text < end && *text != '/')
+		{
+			text = ParseInt(text, end, indices[1]);
+			if (text == NULL)
+				return NULL;
+		}
+
+		if (text < end && *text == '/')
+			text = ParseInt(text + 1, end, indices[2]);
+
+		return text;
+	}
+
+	// Polygons are split into a fan of triangles.
+	// Each triangle's corners are stored last to first, which is the winding the meshes are drawn with.
+	static const char* ParseFace(const char* text, const char* end, std::vector<Int32>& corners)
+	{
+		Int32 first[3];
+		Int32 previous[3];
+		Int32 corner_count = 0;
 
-			// vertices
-			else if ( strcmp( line, "v" ) == 0 )
+		for (;;)
+		{
+			text = SkipSpaces(text, end);
+			if (text == end || *text == '\n' || *text == '#')
+				break;
+
+			Int32 corner[3];
+			text = ParseCorner(text, end, corner);
+			if (text == NULL)
+				return NULL;
+
+			if (corner_count == 0)
 			{
-				float x, y, z;
-				stream >> x;
-				stream >> y;
-				stream >> z;
-				positions.push_back(gef::Vector4(x, y, z));
+				memcpy(first, corner, sizeof(first));
 			}
-
-			// normals
-			else if ( strcmp( line, "vn" ) == 0 )
+			else if (corner_count >= 2)
 			{
-				float nx, ny, nz;
-				stream >> nx;
-				stream >> ny;
-				stream >> nz;
-				normals.push_back(gef::Vector4(nx, ny, nz));
+				corners.insert(corners.end(), corner, corner + 3);
+				corners.insert(corners.end(), previous, previous + 3);
+				corners.insert(corners.end(), first, first + 3);
 			}
 
-			// uvs
-			else if ( strcmp( line, "vt" ) == 0 )
+			memcpy(previous, corner, sizeof(previous));
+			++corner_count;
+		}
+
+		return corner_count >= 3 ? text : NULL;
+	}
+
+	static void ParseChunk(OBJChunk& chunk)
+	{
+		GEF_PROFILE_ZONE("OBJLoader::ParseChunk");
+
+		const char* text = chunk.begin;
+		const char* const end = chunk.end;
+
+		// roughly one value per eight bytes of text saves most of the reallocations as the arrays grow
+		const size_t value_estimate = (end - text) / 8;
+		chunk.positions.reserve(value_estimate);
+		chunk.corners.reserve(value_estimate);
+
+		while (text < end)
+		{
+			const char* token = SkipSpaces(text, end);
+			const char* token_end = TokenEnd(token, end);
+			text = SkipSpaces(token_end, end);
+
+			if (TokenIs(token, token_end, "v"))
+			{
+				text = ParseFloats(text, end, 3, chunk.positions);
+			}
+			else if (TokenIs(token, token_end, "vn"))
+			{
+				text = ParseFloats(text, end, 3, chunk.normals);
+			}
+			else if (TokenIs(token, token_end, "vt"))
 			{
-				float u, v;
-				stream >> u;
-				stream >> v;
-				uvs.push_back(gef::Vector2(u, v));
+				text = ParseFloats(text, end, 2, chunk.uvs);
+			}
+			else if (TokenIs(token, token_end, "f"))
+			{
+				text = ParseFace(text, end, chunk.corners);
+			}
+			else if (TokenIs(token, token_end, "usemtl") || TokenIs(token, token_end, "mtllib"))
+			{
+				OBJStatement statement;
+				statement.type = *token == 'u' ? OST_USEMTL : OST_MTLLIB;
+				statement.corner_offset = (Int32)chunk.corners.size() / 3;
+				statement.name = text;
+				statement.name_length = (Int32)(TokenEnd(text, end) - text);
+				chunk.statements.push_back(statement);
 			}
 
-			else if(strcmp( line, "usemtl" ) == 0)
+			if (text == NULL)
 			{
+				chunk.success = false;
+				return;
+			}
 
-				char material_name[256];
-				stream >> material_name;
+			text = SkipLine(text, end);
+		}
 
-				// any time the material is changed
-				// a new primitive is created
-				primitive_indices.push_back((Int32)face_indices.size());
+		chunk.success = true;
+	}
 
-				texture_indices.push_back(materials[material_name]);
-			}
-			else if ( strcmp( line, "f" ) == 0 )
+	// the attribute arrays of the whole file that the corners index into
+	struct OBJAttributes
+	{
+		const float* positions;
+		const float* normals;
+		const float* uvs;
+		Int32 position_count;
+		Int32 normal_count;
+		Int32 uv_count;
+	};
+
+	static void BuildVertices(OBJChunk& chunk, const OBJAttributes& attributes, Mesh::Vertex* vertices)
+	{
+		for (Int32 axis = 0; axis < 3; ++axis)
+		{
+			chunk.bounds_min[axis] = FLT_MAX;
+			chunk.bounds_max[axis] = -FLT_MAX;
+		}
+
+		const Int32 corner_count = (Int32)chunk.corners.size() / 3;
+		const Int32* corner = corner_count > 0 ? &chunk.corners[0] : NULL;
+		Mesh::Vertex* vertex = vertices + chunk.corner_base;
+
+		for (Int32 corner_num = 0; corner_num < corner_count; ++corner_num, corner += 3, ++vertex)
+		{
+			const Int32 position_index = corner[0] - 1;
+			const Int32 uv_index = corner[1] - 1;
+			const Int32 normal_index = corner[2] - 1;
+
+			// indices relative to the end of the list, or past it, aren't supported
+			if (position_index < 0 || position_index >= attributes.position_count
+				|| uv_index < -1 || uv_index >= attributes.uv_count
+				|| normal_index < -1 || normal_index >= attributes.normal_count)
 			{
-				Int32 vertexIndex[3], uvIndex[3], normalIndex[3];
-/*
-    //std::string vertex1, vertex2, vertex3;
-				Int32 matches = fscanf(file, "%d/%d/%d %d/%d/%d %d/%d/%d\n", &vertexIndex[0], &uvIndex[0], &normalIndex[0], &vertexIndex[1], &uvIndex[1], &normalIndex[1], &vertexIndex[2], &uvIndex[2], &normalIndex[2] );
-				if (matches != 9)
-				{
-//					printf("File can't be read by our simple parser : ( Try exporting with other options\n");
-					success = false;
-				}
-*/
+				chunk.success = false;
+				return;
+			}
 
-				stream >> vertexIndex[0]; stream.ignore(); stream >> uvIndex[0]; stream.ignore(); stream >> normalIndex[0];
-				stream >> vertexIndex[1]; stream.ignore(); stream >> uvIndex[1]; stream.ignore(); stream >> normalIndex[1];
-				stream >> vertexIndex[2]; stream.ignore(); stream >> uvIndex[2]; stream.ignore(); stream >> normalIndex[2];
+			const float* position = attributes.positions + position_index * 3;
+			vertex->px = position[0];
+			vertex->py = position[1];
+			vertex->pz = position[2];
 
-				face_indices.push_back(vertexIndex[2]);
-				face_indices.push_back(uvIndex[2]);
-				face_indices.push_back(normalIndex[2]);
+			if (normal_index >= 0)
+			{
+				const float* normal = attributes.normals + normal_index * 3;
+				vertex->nx = normal[0];
+				vertex->ny = normal[1];
+				vertex->nz = normal[2];
+			}
+			else
+			{
+				vertex->nx = vertex->ny = vertex->nz = 0.0f;
+			}
 
-				face_indices.push_back(vertexIndex[1]);
-				face_indices.push_back(uvIndex[1]);
-				face_indices.push_back(normalIndex[1]);
+			if (uv_index >= 0)
+			{
+				const float* uv = attributes.uvs + uv_index * 2;
+				vertex->u = uv[0];
+				vertex->v = -uv[1];
+			}
+			else
+			{
+				vertex->u = vertex->v = 0.0f;
+			}
 
-				face_indices.push_back(vertexIndex[0]);
-				face_indices.push_back(uvIndex[0]);
-				face_indices.push_back(normalIndex[0]);
+			for (Int32 axis = 0; axis < 3; ++axis)
+			{
+				chunk.bounds_min[axis] = std::min(chunk.bounds_min[axis], position[axis]);
+				chunk.bounds_max[axis] = std::max(chunk.bounds_max[axis], position[axis]);
 			}
 		}
+	}
 
-		// don't need the font file data any more
-		free(obj_file_data);
-		obj_file_data = NULL;
-
-		// finished reading the file
-//		fclose(file);
-		// start building the mesh
-		Int32 num_faces = (Int32)face_indices.size() / 9;
-		Int32 num_vertices = num_faces*3;
-
-		// create vertex buffer
-		gef::Mesh::Vertex* vertices = new gef::Mesh::Vertex[num_vertices];
-
-		// need to record min and max position values for mesh bounds
-		gef::Vector4 pos_min(FLT_MAX, FLT_MAX, FLT_MAX), pos_max(-FLT_MAX, -FLT_MAX, -FLT_MAX);
-
-		for(Int32 vertex_num = 0; vertex_num < num_vertices; ++vertex_num)
-		{
-			gef::Mesh::Vertex* vertex = &vertices[vertex_num];
-			gef::Vector4 position = positions[face_indices[vertex_num*3]-1];
-			gef::Vector2 uv = uvs[face_indices[vertex_num*3+1]-1];
-			gef::Vector4 normal = normals[face_indices[vertex_num*3+2]-1];
-
-			vertex->px = position.x();
-			vertex->py = position.y();
-			vertex->pz = position.z();
-			vertex->nx = normal.x();
-			vertex->ny = normal.y();
-			vertex->nz = normal.z();
-			vertex->u = uv.x;
-			vertex->v = -uv.y;
-
-			// update min and max positions for bounds
-			if (position.x() < pos_min.x())
-				pos_min.set_x(position.x());
-			if (position.y() < pos_min.y())
-				pos_min.set_y(position.y());
-			if (position.z() < pos_min.z())
-				pos_min.set_z(position.z());
-			if (position.x() > pos_max.x())
-				pos_max.set_x(position.x());
-			if (position.y() > pos_max.y())
-				pos_max.set_y(position.y());
-			if (position.z() > pos_max.z())
-				pos_max.set_z(position.z());
+	// calls func(begin, end) over every chunk, across the job system if there is one
+	template<typename Func>
+	static void ForEachChunk(JobSystem* job_system, Int32 chunk_count, const Func& func)
+	{
+		if (job_system && chunk_count > 1)
+			job_system->ParallelFor(chunk_count, 1, func);
+		else
+			func(0, chunk_count);
+	}
+
+	// concatenates one attribute array from every chunk, unless there is only one chunk and its array can be used as it is
+	static const float* GatherAttribute(const std::vector<OBJChunk>& chunks, std::vector<float> OBJChunk::*attribute, std::vector<float>& gathered, Int32& count, Int32 components)
+	{
+		if (chunks.size() == 1)
+		{
+			const std::vector<float>& values = chunks[0].*attribute;
+			count = (Int32)values.size() / components;
+			return values.empty() ? NULL : &values[0];
 		}
 
+		size_t total_size = 0;
+		for (size_t chunk_num = 0; chunk_num < chunks.size(); ++chunk_num)
+			total_size += (chunks[chunk_num].*attribute).size();
+
+		gathered.reserve(total_size);
+		for (size_t chunk_num = 0; chunk_num < chunks.size(); ++chunk_num)
+			gathered.insert(gathered.end(), (chunks[chunk_num].*attribute).begin(), (chunks[chunk_num].*attribute).end());
+
+		count = (Int32)gathered.size() / components;
+		return gathered.empty() ? NULL : &gathered[0];
+	}
+
+	static void CreateModel(Platform& platform, Model& model, const Mesh::Vertex* vertices, Int32 vertex_count, const UInt32* indices,
+		const OBJPrimitive* primitives, Int32 primitive_count, const std::vector<std::string>& texture_filenames, const float* bounds_min, const float* bounds_max)
+	{
+		GEF_PROFILE_ZONE("OBJLoader::CreateModel");
+
+		PNGLoader png_loader;
+		std::vector<Texture*> textures;
+		textures.reserve(texture_filenames.size());
+		for (std::vector<std::string>::const_iterator filename = texture_filenames.begin(); filename != texture_filenames.end(); ++filename)
+		{
+			ImageData image_data;
+			png_loader.Load(filename->c_str(), platform, image_data);
+			textures.push_back(Texture::Create(platform, image_data));
+		}
 
 		Mesh* mesh = new Mesh(platform);
 		model.set_mesh(mesh);
 		model.set_textures(textures);
 
 		// set bounds
-		gef::Aabb aabb(pos_min, pos_max);
-		gef::Sphere sphere(aabb);
+		Aabb aabb(Vector4(bounds_min[0], bounds_min[1], bounds_min[2]), Vector4(bounds_max[0], bounds_max[1], bounds_max[2]));
+		Sphere sphere(aabb);
 		mesh->set_aabb(aabb);
 		mesh->set_bounding_sphere(sphere);
 
-
 		// create materials for each texture
-		for(std::vector<Texture*>::iterator texture=textures.begin(); texture != textures.end(); ++texture)
+		for (std::vector<Texture*>::iterator texture = textures.begin(); texture != textures.end(); ++texture)
 		{
 			Material* material = new Material();
 			material->set_texture(*texture);
 			model.AddMaterial(material);
 		}
 
-		mesh->InitVertexBuffer(platform, vertices, num_vertices, sizeof(gef::Mesh::Vertex));
-
-		// create primitives
-		mesh->AllocatePrimitives((UInt32)primitive_indices.size());
+		mesh->InitVertexBuffer(platform, vertices, vertex_count, sizeof(Mesh::Vertex));
 
-		std::vector<UInt32*> indices;
-		indices.resize(primitive_indices.size());
-		for(UInt32 primitive_num=0;primitive_num<primitive_indices.size();++primitive_num)
+		mesh->AllocatePrimitives(primitive_count);
+		for (Int32 primitive_num = 0; primitive_num < primitive_count; ++primitive_num)
 		{
-			Int32 index_count = 0;
+			const OBJPrimitive& obj_primitive = primitives[primitive_num];
+			Primitive* primitive = mesh->GetPrimitive(primitive_num);
 
-			if(primitive_num == primitive_indices.size()-1)
-				index_count = (Int32)face_indices.size() - primitive_indices[primitive_num];
-			else
-				index_count = primitive_indices[primitive_num+1] - primitive_indices[primitive_num];
+			primitive->set_type(TRIANGLE_LIST);
+			primitive->InitIndexBuffer(platform, indices + obj_primitive.first_index, obj_primitive.index_count, sizeof(UInt32));
+			primitive->set_material(obj_primitive.texture_index == -1 ? NULL : model.material(obj_primitive.texture_index));
+		}
+	}
 
-			// 9 indices per triangle, index count is the number of vertices in this primitive
-			index_count /= 3;
+	static inline UInt32 AlignCacheOffset(size_t offset)
+	{
+		return (UInt32)(offset + kCacheAlignment - 1) & ~(kCacheAlignment - 1);
+	}
 
-			indices[primitive_num] = new UInt32[index_count];
+	OBJLoader::OBJLoader() :
+		job_system_(NULL),
+		use_cache_(false)
+	{
+	}
 
-			for(Int32 index=0;index<index_count;++index)
-				indices[primitive_num][index] = primitive_indices[primitive_num]+index;
+	std::string OBJLoader::CacheFilename(const char* filename) const
+	{
+		return std::string(filename) + ".gobj";
+	}
 
-			mesh->GetPrimitive(primitive_num)->set_type(gef::TRIANGLE_LIST);
-			mesh->GetPrimitive(primitive_num)->InitIndexBuffer(platform, indices[primitive_num], index_count, sizeof(UInt32));
-//			mesh->GetPrimitive(primitive_num)->InitIndexBuffer(platform, indices[primitive_num], 3, sizeof(UInt32));
+	bool OBJLoader::Load(const char* filename, Platform& platform, Model& model)
+	{
+		GEF_PROFILE_ZONE("OBJLoader::Load");
+		GEF_MEMORY_TAG(MT_RENDERING);
 
+		UInt64 source_time = 0;
+		Int32 source_size = -1;
+		const std::string cache_filename = CacheFilename(filename);
+		if (use_cache_)
+		{
+			File* file = File::Create();
+			if (!file->GetModifiedTime(filename, source_time))
+				source_time = 0;
+			if (file->Open(filename))
+			{
+				if (!file->GetSize(source_size))
+					source_size = -1;
+				file->Close();
+			}
+			delete file;
 
-			Int32 texture_index = texture_indices[primitive_num];
-			if(texture_index == -1)
-				mesh->GetPrimitive(primitive_num)->set_material(NULL);
-			else
-				mesh->GetPrimitive(primitive_num)->set_material(model.material(texture_index));
-			//mesh->GetPrimitive(primitive_num)->set_texture(textures_[0]);
+			if (LoadCacheFile(cache_filename, source_time, source_size, platform, model))
+				return true;
 		}
 
-		// mesh construction complete
-		// clean up
-		DeleteArrayNull(vertices);
-		for(UInt32 primitive_num=0;primitive_num<indices.size();++primitive_num)
-			DeleteArrayNull(indices[primitive_num]);
+		MappedFile* mapped_file = MappedFile::Create();
+		if (!mapped_file->Open(filename))
+		{
+			delete mapped_file;
+			return false;
+		}
 
-	}
-	return success;
-}
+		OBJModelData model_data;
+		const bool success = Parse(static_cast<const char*>(mapped_file->data()), mapped_file->size(), model_data);
+		delete mapped_file;
 
-bool OBJLoader::LoadMaterials(Platform& platform, const char* filename, std::map<std::string, Int32>& materials, std::vector<Texture*>& textures)
-{
-	PNGLoader png_loader;
+		if (!success)
+			return false;
 
-	bool success = true;
+		CreateModel(platform, model, model_data.vertices.empty() ? NULL : &model_data.vertices[0], (Int32)model_data.vertices.size(),
+			model_data.indices.empty() ? NULL : &model_data.indices[0], model_data.primitives.empty() ? NULL : &model_data.primitives[0],
+			(Int32)model_data.primitives.size(), model_data.texture_filenames, model_data.bounds_min, model_data.bounds_max);
 
+		// the model can still be used if the cache can't be written, it will just be parsed again next time
+		if (use_cache_)
+			WriteCacheFile(cache_filename, source_time, source_size, model_data);
+
+		return true;
+	}
 
-	std::string mtl_filename(filename);
-	void* mtl_file_data = NULL;
-	Int32 file_size = 0;
-	gef::File* file = gef::File::Create();
-	success = file->Open(mtl_filename.c_str());
-	if(success)
+	bool OBJLoader::Parse(const char* text, Int32 size, OBJModelData& model_data)
 	{
-		success = file->GetSize(file_size);
-		if(success)
+		GEF_PROFILE_ZONE("OBJLoader::Parse");
+
+		// split into chunks of whole lines, a few per thread so uneven chunks even out
+		Int32 chunk_count = 1;
+		if (job_system_ && size >= kParallelParseSize)
+			chunk_count = std::min((job_system_->worker_count() + 1) * 4, size / (kParallelParseSize / 4));
+
+		std::vector<OBJChunk> chunks(chunk_count);
+		const char* const end = text + size;
+		const char* chunk_begin = text;
+		for (Int32 chunk_num = 0; chunk_num < chunk_count; ++chunk_num)
+		{
+			const char* chunk_end = chunk_num == chunk_count - 1 ? end : text + (Int64)size * (chunk_num + 1) / chunk_count;
+			if (chunk_end < chunk_begin)
+				chunk_end = chunk_begin;
+			if (chunk_end < end)
+				chunk_end = SkipLine(chunk_end, end);
+
+			chunks[chunk_num].begin = chunk_begin;
+			chunks[chunk_num].end = chunk_end;
+			chunk_begin = chunk_end;
+		}
+
+		ForEachChunk(job_system_, chunk_count, [&chunks](Int32 begin, Int32 end)
+		{
+			for (Int32 chunk_num = begin; chunk_num < end; ++chunk_num)
+				ParseChunk(chunks[chunk_num]);
+		});
+
+		Int32 corner_count = 0;
+		for (Int32 chunk_num = 0; chunk_num < chunk_count; ++chunk_num)
 		{
-			mtl_file_data = malloc(file_size);
-			success = mtl_file_data != NULL;
-			if(success)
+			if (!chunks[chunk_num].success)
+				return false;
+
+			chunks[chunk_num].corner_base = corner_count;
+			corner_count += (Int32)chunks[chunk_num].corners.size() / 3;
+		}
+
+		// materials and primitives, in file order
+		std::map<std::string, Int32> materials;
+		model_data.primitives.clear();
+		OBJPrimitive first_primitive = { 0, 0, -1 };
+		model_data.primitives.push_back(first_primitive);
+
+		for (Int32 chunk_num = 0; chunk_num < chunk_count; ++chunk_num)
+		{
+			const std::vector<OBJStatement>& statements = chunks[chunk_num].statements;
+			for (std::vector<OBJStatement>::const_iterator statement = statements.begin(); statement != statements.end(); ++statement)
 			{
-				Int32 bytes_read;
-				success = file->Read(mtl_file_data, file_size, bytes_read);
-				if(success)
-					success = bytes_read == file_size;
+				const std::string name(statement->name, statement->name_length);
+				if (statement->type == OST_MTLLIB)
+				{
+					LoadMaterials(name.c_str(), materials, model_data.texture_filenames);
+					continue;
+				}
+
+				// any time the material is changed a new primitive is created
+				std::map<std::string, Int32>::const_iterator material = materials.find(name);
+				const Int32 texture_index = material != materials.end() ? material->second : -1;
+				const Int32 first_index = chunks[chunk_num].corner_base + statement->corner_offset;
+
+				if (model_data.primitives.back().first_index == first_index)
+				{
+					// nothing was drawn with the previous material
+					model_data.primitives.back().texture_index = texture_index;
+				}
+				else
+				{
+					OBJPrimitive primitive = { first_index, 0, texture_index };
+					model_data.primitives.push_back(primitive);
+				}
 			}
 		}
-	}
 
-	if(!success)
-	{
-		free(mtl_file_data);
-		mtl_file_data = NULL;
+		for (size_t primitive_num = 0; primitive_num < model_data.primitives.size(); ++primitive_num)
+		{
+			const Int32 next_index = primitive_num + 1 < model_data.primitives.size() ? model_data.primitives[primitive_num + 1].first_index : corner_count;
+			model_data.primitives[primitive_num].index_count = next_index - model_data.primitives[primitive_num].first_index;
+		}
 
-		delete file;
-		file = NULL;
-		return false;
-	}
-	gef::MemoryStreamBuffer buffer((char*)mtl_file_data, file_size);
-	std::istream stream(&buffer);
+		if (model_data.primitives.back().index_count == 0)
+			model_data.primitives.pop_back();
+
+		// vertices
+		std::vector<float> positions;
+		std::vector<float> normals;
+		std::vector<float> uvs;
+		OBJAttributes attributes;
+		attributes.positions = GatherAttribute(chunks, &OBJChunk::positions, positions, attributes.position_count, 3);
+		attributes.normals = GatherAttribute(chunks, &OBJChunk::normals, normals, attributes.normal_count, 3);
+		attributes.uvs = GatherAttribute(chunks, &OBJChunk::uvs, uvs, attributes.uv_count, 2);
+
+		model_data.vertices.resize(corner_count);
+		Mesh::Vertex* vertices = corner_count > 0 ? &model_data.vertices[0] : NULL;
+		ForEachChunk(job_system_, chunk_count, [&chunks, &attributes, vertices](Int32 begin, Int32 end)
+		{
+			for (Int32 chunk_num = begin; chunk_num < end; ++chunk_num)
+				BuildVertices(chunks[chunk_num], attributes, vertices);
+		});
+
+		for (Int32 axis = 0; axis < 3; ++axis)
+		{
+			model_data.bounds_min[axis] = FLT_MAX;
+			model_data.bounds_max[axis] = -FLT_MAX;
+		}
+
+		for (Int32 chunk_num = 0; chunk_num < chunk_count; ++chunk_num)
+		{
+			if (!chunks[chunk_num].success)
+				return false;
 
+			for (Int32 axis = 0; axis < 3; ++axis)
+			{
+				model_data.bounds_min[axis] = std::min(model_data.bounds_min[axis], chunks[chunk_num].bounds_min[axis]);
+				model_data.bounds_max[axis] = std::max(model_data.bounds_max[axis], chunks[chunk_num].bounds_max[axis]);
+			}
+		}
+
+		// every corner is its own vertex, so each primitive's indices are just a range of vertices
+		model_data.indices.resize(corner_count);
+		for (Int32 index = 0; index < corner_count; ++index)
+			model_data.indices[index] = index;
 
+		return true;
+	}
+
+	bool OBJLoader::LoadMaterials(const char* filename, std::map<std::string, Int32>& materials, std::vector<std::string>& texture_filenames)
 	{
+		MappedFile* mapped_file = MappedFile::Create();
+		if (!mapped_file->Open(filename))
+		{
+			delete mapped_file;
+			return false;
+		}
+
+		const char* text = static_cast<const char*>(mapped_file->data());
+		const char* const end = text + mapped_file->size();
+
 		std::map<std::string, std::string> material_name_mappings;
-		char material_name[256];
-		while( !stream.eof() )
+		std::string material_name;
+		while (text < end)
 		{
-		    char line[128];
-			stream >> line;
+			const char* token = SkipSpaces(text, end);
+			const char* token_end = TokenEnd(token, end);
+			const char* name = SkipSpaces(token_end, end);
+			const std::string value(name, TokenEnd(name, end));
 
-			if ( strcmp( line, "newmtl" ) == 0 )
+			if (TokenIs(token, token_end, "newmtl"))
 			{
-				stream >> material_name;
+				material_name = value;
 				material_name_mappings[material_name] = "";
 			}
-			else if(strcmp( line, "map_Kd" ) == 0)
+			else if (TokenIs(token, token_end, "map_Kd"))
 			{
-				char texture_name[256];
-				stream >> texture_name;
-				material_name_mappings[material_name] = texture_name;
+				material_name_mappings[material_name] = value;
 			}
+
+			text = SkipLine(name, end);
 		}
 
-		free(mtl_file_data);
-		mtl_file_data = NULL;
+		delete mapped_file;
 
-		for(std::map<std::string, std::string>::iterator iter = material_name_mappings.begin(); iter != material_name_mappings.end(); ++iter)
+		for (std::map<std::string, std::string>::iterator iter = material_name_mappings.begin(); iter != material_name_mappings.end(); ++iter)
 		{
-			if(iter->second.compare("") != 0)
+			if (iter->second.empty())
 			{
-				gef::ImageData image_data;
-				png_loader.Load(iter->second.c_str(), platform, image_data);
-				Texture* texture = gef::Texture::Create(platform, image_data);
-				textures.push_back(texture);
-				materials[iter->first] = (Int32)textures.size()-1;
+				materials[iter->first] = -1;
+				continue;
 			}
-			else
+
+			// materials that share a texture share its index
+			std::vector<std::string>::iterator texture_filename = std::find(texture_filenames.begin(), texture_filenames.end(), iter->second);
+			if (texture_filename == texture_filenames.end())
+				texture_filename = texture_filenames.insert(texture_filenames.end(), iter->second);
+
+			materials[iter->first] = (Int32)(texture_filename - texture_filenames.begin());
+		}
+
+		return true;
+	}
+
+	bool OBJLoader::LoadCacheFile(const std::string& cache_filename, UInt64 source_time, Int32 source_size, Platform& platform, Model& model)
+	{
+		GEF_PROFILE_ZONE("OBJLoader::LoadCacheFile");
+
+		MappedFile* mapped_file = MappedFile::Create();
+		bool success = mapped_file->Open(cache_filename.c_str()) && mapped_file->size() >= (Int32)sizeof(OBJCacheHeader);
+
+		const char* file_data = static_cast<const char*>(mapped_file->data());
+		const OBJCacheHeader* header = reinterpret_cast<const OBJCacheHeader*>(file_data);
+		const UInt64 file_size = (UInt64)mapped_file->size();
+
+		success = success && header->magic == kCacheMagic && header->version == kCacheVersion
+			&& header->file_size == file_size
+			&& header->vertex_count >= 0 && header->primitive_count >= 0 && header->texture_count >= 0
+			&& header->vertices_offset % kCacheAlignment == 0 && header->indices_offset % kCacheAlignment == 0 && header->primitives_offset % kCacheAlignment == 0
+			&& header->vertices_offset + (UInt64)header->vertex_count * sizeof(Mesh::Vertex) <= file_size
+			&& header->indices_offset + (UInt64)header->vertex_count * sizeof(UInt32) <= file_size
+			&& header->primitives_offset + (UInt64)header->primitive_count * sizeof(OBJPrimitive) <= file_size
+			&& header->texture_filenames_offset <= file_size;
+
+		// without the source the cache is used as it is, for data that is only shipped cached
+		if (success && source_size >= 0)
+			success = header->source_size == source_size && header->source_time == source_time;
+
+		const OBJPrimitive* primitives = success ? reinterpret_cast<const OBJPrimitive*>(file_data + header->primitives_offset) : NULL;
+		for (Int32 primitive_num = 0; success && primitive_num < header->primitive_count; ++primitive_num)
+		{
+			const OBJPrimitive& primitive = primitives[primitive_num];
+			success = primitive.first_index >= 0 && primitive.index_count >= 0 && primitive.index_count <= header->vertex_count - primitive.first_index
+				&& primitive.texture_index >= -1 && primitive.texture_index < header->texture_count;
+		}
+
+		std::vector<std::string> texture_filenames;
+		const char* texture_filename = success ? file_data + header->texture_filenames_offset : NULL;
+		for (Int32 texture_num = 0; success && texture_num < header->texture_count; ++texture_num)
+		{
+			const char* filename_end = static_cast<const char*>(memchr(texture_filename, '\0', file_data + file_size - texture_filename));
+			success = filename_end != NULL;
+			if (success)
 			{
-				materials[iter->first] = -1;
+				texture_filenames.push_back(std::string(texture_filename, filename_end));
+				texture_filename = filename_end + 1;
 			}
 		}
+
+		if (success)
+		{
+			CreateModel(platform, model, reinterpret_cast<const Mesh::Vertex*>(file_data + header->vertices_offset), header->vertex_count,
+				reinterpret_cast<const UInt32*>(file_data + header->indices_offset), primitives, header->primitive_count, texture_filenames,
+				header->bounds_min, header->bounds_max);
+		}
+
+		delete mapped_file;
+		return success;
 	}
 
-	return success;
+	bool OBJLoader::WriteCacheFile(const std::string& cache_filename, UInt64 source_time, Int32 source_size, const OBJModelData& model_data)
+	{
+		OBJCacheHeader header;
+		memset(&header, 0, sizeof(OBJCacheHeader));
+		header.magic = kCacheMagic;
+		header.version = kCacheVersion;
+		header.source_time = source_time;
+		header.source_size = source_size;
+		header.vertex_count = (Int32)model_data.vertices.size();
+		header.primitive_count = (Int32)model_data.primitives.size();
+		header.texture_count = (Int32)model_data.texture_filenames.size();
+		memcpy(header.bounds_min, model_data.bounds_min, sizeof(header.bounds_min));
+		memcpy(header.bounds_max, model_data.bounds_max, sizeof(header.bounds_max));
+		header.vertices_offset = AlignCacheOffset(sizeof(OBJCacheHeader));
+		header.indices_offset = AlignCacheOffset(header.vertices_offset + model_data.vertices.size() * sizeof(Mesh::Vertex));
+		header.primitives_offset = AlignCacheOffset(header.indices_offset + model_data.indices.size() * sizeof(UInt32));
+		header.texture_filenames_offset = AlignCacheOffset(header.primitives_offset + model_data.primitives.size() * sizeof(OBJPrimitive));
+		header.file_size = header.texture_filenames_offset;
+		for (std::vector<std::string>::const_iterator filename = model_data.texture_filenames.begin(); filename != model_data.texture_filenames.end(); ++filename)
+			header.file_size += (UInt32)filename->size() + 1;
+
+		const char padding[kCacheAlignment] = { 0 };
+		UInt32 offset = 0;
+
+		// written to one side and moved into place, so anything still mapping the old file isn't truncated under it
+		const std::string temp_filename = cache_filename + ".tmp";
+		std::ofstream file_stream(temp_filename.c_str(), std::ios::out | std::ios::binary);
+
+		file_stream.write((const char*)&header, sizeof(OBJCacheHeader));
+		offset += sizeof(OBJCacheHeader);
+
+		file_stream.write(padding, header.vertices_offset - offset);
+		if (!model_data.vertices.empty())
+			file_stream.write((const char*)&model_data.vertices[0], model_data.vertices.size() * sizeof(Mesh::Vertex));
+		offset = header.vertices_offset + (UInt32)(model_data.vertices.size() * sizeof(Mesh::Vertex));
+
+		file_stream.write(padding, header.indices_offset - offset);
+		if (!model_data.indices.empty())
+			file_stream.write((const char*)&model_data.indices[0], model_data.indices.size() * sizeof(UInt32));
+		offset = header.indices_offset + (UInt32)(model_data.indices.size() * sizeof(UInt32));
+
+		file_stream.write(padding, header.primitives_offset - offset);
+		if (!model_data.primitives.empty())
+			file_stream.write((const char*)&model_data.primitives[0], model_data.primitives.size() * sizeof(OBJPrimitive));
+		offset = header.primitives_offset + (UInt32)(model_data.primitives.size() * sizeof(OBJPrimitive));
+
+		file_stream.write(padding, header.texture_filenames_offset - offset);
+		for (std::vector<std::string>::const_iterator filename = model_data.texture_filenames.begin(); filename != model_data.texture_filenames.end(); ++filename)
+			file_stream.write(filename->c_str(), filename->size() + 1);
+
+		file_stream.close();
+
+		bool success = !file_stream.fail();
+		if (success)
+		{
+			remove(cache_filename.c_str());
+			success = rename(temp_filename.c_str(), cache_filename.c_str()) == 0;
+		}
 
-}
+		if (!success)
+			remove(temp_filename.c_str());
 
+		return success;
+	}
 }
@@ -10,16 +10,44 @@ namespace gef
 {
 	class Platform;
 	class Model;
-	class Texture;
+	class JobSystem;
+	struct OBJModelData;
 
+	/// Loads Wavefront .obj models with their .mtl diffuse textures.
+	/// The file is mapped and parsed in place, without copying it or going through a stream.
 	class OBJLoader
 	{
 	public:
+		OBJLoader();
+
 		bool Load(const char* filename, Platform& platform, Model& model);
+
+		/// Files of at least kParallelParseSize bytes are split into chunks of whole lines and parsed across the job system.
+		/// NULL, the default, parses on the calling thread.
+		inline void set_job_system(JobSystem* job_system) { job_system_ = job_system; }
+
+		/// When enabled the vertex and index buffers built from an .obj are written to its cache file, and later loads
+		/// map the cache file instead of parsing, until the .obj's size or modification time changes.
+		/// The .mtl files aren't checked, delete the cache file after changing one.
+		inline void set_use_cache(bool use_cache) { use_cache_ = use_cache; }
+		inline bool use_cache() const { return use_cache_; }
+
+		std::string CacheFilename(const char* filename) const;
+
+		static const UInt32 kCacheMagic = 0x4a424f47;	// "GOBJ"
+		static const UInt32 kCacheVersion = 1;
+		static const Int32 kParallelParseSize = 256 * 1024;
+
 	private:
-		bool LoadMaterials(Platform& platform, const char* filename, std::map<std::string, Int32>& materials, std::vector<Texture*>& textures);
+		bool Parse(const char* text, Int32 size, OBJModelData& model_data);
+		bool LoadMaterials(const char* filename, std::map<std::string, Int32>& materials, std::vector<std::string>& texture_filenames);
+		bool LoadCacheFile(const std::string& cache_filename, UInt64 source_time, Int32 source_size, Platform& platform, Model& model);
+		bool WriteCacheFile(const std::string& cache_filename, UInt64 source_time, Int32 source_size, const OBJModelData& model_data);
+
+		JobSystem* job_system_;
+		bool use_cache_;
 	};
 }
 
 
-#endif // _OBJ_LOADER_H
\ No newline at end of file
+#endif // _GEF_OBJ_LOADER_H
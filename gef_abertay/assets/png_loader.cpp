@@ -133,9 +133,10 @@ namespace gef
                         }
                     }
 
+                    // read callbacks use this until the whole image has been decoded
+                    PNGData data;
                     if(success)
                     {
-						PNGData data;
 						data.p = buffer;
 						data.len = file_size;
 
@@ -202,7 +203,7 @@ namespace gef
 						if (colorType == PNG_COLOR_TYPE_RGB_ALPHA)
 						{
 							UInt32 row_bytes = (UInt32)png_get_rowbytes(png_ptr, info_ptr);
-							UInt8* image_bytes = (UInt8*)malloc(row_bytes * height);
+							UInt8* image_bytes = new UInt8[row_bytes * height];
 							image_data.set_image(image_bytes);
 						}
 
@@ -231,6 +232,8 @@ namespace gef
                 buffer = NULL;
             }
         }
+
+        delete png_file;
     }
 
     void PNGLoader::ParseRGBA(UInt8* out_image_buffer, void* the_png_ptr,
@@ -0,0 +1,224 @@
+#include <assets/texture_cache.h>
+#include <assets/png_loader.h>
+#include <graphics/image_data.h>
+#include <system/file.h>
+#include <system/mapped_file.h>
+#include <system/string_id.h>
+#include <system/profiler.h>
+#include <system/memory_tracker.h>
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace gef
+{
+	struct TextureCacheHeader
+	{
+		UInt32 magic;
+		UInt32 version;
+		UInt64 source_time;			// 0 where the platform has no modification times
+		Int32 source_size;
+		UInt32 width;
+		UInt32 height;
+		UInt32 mip_count;
+		UInt32 source_path_length;	// the source path follows the header
+		UInt32 image_offset;		// from the start of the file, kImageAlignment aligned
+		UInt32 image_size;			// all the mip levels
+		UInt32 pad;
+	};
+
+	static const UInt32 kImageAlignment = 16;
+
+	static UInt32 MipChainLength(UInt32 width, UInt32 height)
+	{
+		UInt32 mip_count = 1;
+		while (ImageData::MipSize(width, mip_count - 1) > 1 || ImageData::MipSize(height, mip_count - 1) > 1)
+			++mip_count;
+		return mip_count;
+	}
+
+	// each level is a 2x2 box filter of the one above, edge texels are repeated for odd sizes
+	static void BuildMipChain(const ImageData& source, ImageData& image_data)
+	{
+		image_data.set_width(source.width());
+		image_data.set_height(source.height());
+		image_data.set_mip_count(MipChainLength(source.width(), source.height()));
+
+		UInt8* image = new UInt8[image_data.MipOffset(image_data.mip_count())];
+		memcpy(image, source.image(), source.width() * source.height() * 4);
+		image_data.set_image(image);
+
+		for (UInt32 level = 1; level < image_data.mip_count(); ++level)
+		{
+			const UInt32 source_width = ImageData::MipSize(source.width(), level - 1);
+			const UInt32 source_height = ImageData::MipSize(source.height(), level - 1);
+			const UInt32 width = ImageData::MipSize(source.width(), level);
+			const UInt32 height = ImageData::MipSize(source.height(), level);
+			const UInt8* source_texels = image + image_data.MipOffset(level - 1);
+			UInt8* texels = image + image_data.MipOffset(level);
+
+			for (UInt32 y = 0; y < height; ++y)
+			{
+				const UInt8* row0 = source_texels + std::min(y * 2, source_height - 1) * source_width * 4;
+				const UInt8* row1 = source_texels + std::min(y * 2 + 1, source_height - 1) * source_width * 4;
+				for (UInt32 x = 0; x < width; ++x)
+				{
+					const UInt32 x0 = std::min(x * 2, source_width - 1) * 4;
+					const UInt32 x1 = std::min(x * 2 + 1, source_width - 1) * 4;
+					for (UInt32 channel = 0; channel < 4; ++channel)
+						*texels++ = (UInt8)((row0[x0 + channel] + row0[x1 + channel] + row1[x0 + channel] + row1[x1 + channel] + 2) >> 2);
+				}
+			}
+		}
+	}
+
+	// unique for every write, so threads or processes writing the same cache file at once each have their own temporary file
+	static std::string TempFilename(const std::string& cache_filename)
+	{
+		static const UInt32 process_key = std::random_device()();
+		static std::atomic<UInt32> write_count(0);
+
+		char suffix[32];
+		sprintf(suffix, ".%08x%08x.tmp", process_key, write_count.fetch_add(1, std::memory_order_relaxed));
+		return cache_filename + suffix;
+	}
+
+	TextureCache::TextureCache(const Platform& platform, const char* cache_directory) :
+		platform_(platform)
+	{
+		if (cache_directory)
+			cache_directory_ = cache_directory;
+	}
+
+	std::string TextureCache::CacheFilename(const char* png_filename) const
+	{
+		if (cache_directory_.empty())
+			return std::string(png_filename) + ".gtx";
+
+		char name[16];
+		sprintf(name, "%08x.gtx", GetStringId(png_filename));
+		return cache_directory_ + "/" + name;
+	}
+
+	bool TextureCache::Load(const char* png_filename, ImageData& image_data) const
+	{
+		GEF_PROFILE_ZONE("TextureCache::Load");
+		GEF_MEMORY_TAG(MT_RENDERING);
+
+		UInt64 source_time = 0;
+		Int32 source_size = -1;
+		File* file = File::Create();
+		if (!file->GetModifiedTime(png_filename, source_time))
+			source_time = 0;
+		if (file->Open(png_filename))
+		{
+			if (!file->GetSize(source_size))
+				source_size = -1;
+			file->Close();
+		}
+		delete file;
+
+		const std::string cache_filename = CacheFilename(png_filename);
+		if (LoadCacheFile(png_filename, cache_filename, source_time, source_size, image_data))
+			return true;
+
+		if (source_size < 0)
+			return false;
+
+		ImageData decoded_image_data;
+		PNGLoader png_loader;
+		png_loader.Load(png_filename, platform_, decoded_image_data);
+		if (decoded_image_data.image() == NULL)
+			return false;
+
+		BuildMipChain(decoded_image_data, image_data);
+
+		// the texture can still be used if the cache can't be written, it will just be decoded again next time
+		WriteCacheFile(png_filename, cache_filename, source_time, source_size, image_data);
+
+		return true;
+	}
+
+	bool TextureCache::LoadCacheFile(const char* png_filename, const std::string& cache_filename, UInt64 source_time, Int32 source_size, ImageData& image_data) const
+	{
+		MappedFile* mapped_file = MappedFile::Create();
+		bool success = mapped_file->Open(cache_filename.c_str()) && mapped_file->size() >= (Int32)sizeof(TextureCacheHeader);
+
+		const char* file_data = static_cast<const char*>(mapped_file->data());
+		const TextureCacheHeader* header = reinterpret_cast<const TextureCacheHeader*>(file_data);
+		const UInt32 source_path_length = (UInt32)strlen(png_filename);
+
+		success = success && header->magic == kMagic && header->version == kVersion
+			&& header->source_path_length == source_path_length
+			&& sizeof(TextureCacheHeader) + source_path_length <= (UInt32)mapped_file->size()
+			&& memcmp(file_data + sizeof(TextureCacheHeader), png_filename, source_path_length) == 0
+			&& header->mip_count == MipChainLength(header->width, header->height)
+			&& header->image_offset % kImageAlignment == 0
+			&& header->image_offset <= (UInt32)mapped_file->size() && header->image_size <= (UInt32)mapped_file->size() - header->image_offset;
+
+		// without the source the cache is used as it is, for data that is only shipped cached
+		if (success && source_size >= 0)
+			success = header->source_size == source_size && header->source_time == source_time;
+
+		if (success)
+		{
+			image_data.set_width(header->width);
+			image_data.set_height(header->height);
+			image_data.set_mip_count(header->mip_count);
+			success = header->image_size == image_data.MipOffset(header->mip_count);
+		}
+
+		if (!success)
+		{
+			delete mapped_file;
+			return false;
+		}
+
+		image_data.set_image((UInt8*)file_data + header->image_offset);
+		image_data.set_mapped_file(mapped_file);
+		return true;
+	}
+
+	bool TextureCache::WriteCacheFile(const char* png_filename, const std::string& cache_filename, UInt64 source_time, Int32 source_size, const ImageData& image_data) const
+	{
+		TextureCacheHeader header;
+		memset(&header, 0, sizeof(TextureCacheHeader));
+		header.magic = kMagic;
+		header.version = kVersion;
+		header.source_time = source_time;
+		header.source_size = source_size;
+		header.width = image_data.width();
+		header.height = image_data.height();
+		header.mip_count = image_data.mip_count();
+		header.source_path_length = (UInt32)strlen(png_filename);
+		header.image_offset = (UInt32)(sizeof(TextureCacheHeader) + header.source_path_length + kImageAlignment - 1) & ~(kImageAlignment - 1);
+		header.image_size = image_data.MipOffset(image_data.mip_count());
+
+		const char padding[kImageAlignment] = { 0 };
+
+		// written to one side and moved into place, so anything still mapping the old file isn't truncated under it
+		const std::string temp_filename = TempFilename(cache_filename);
+		std::ofstream file_stream(temp_filename.c_str(), std::ios::out | std::ios::binary);
+		file_stream.write((const char*)&header, sizeof(TextureCacheHeader));
+		file_stream.write(png_filename, header.source_path_length);
+		file_stream.write(padding, header.image_offset - sizeof(TextureCacheHeader) - header.source_path_length);
+		file_stream.write((const char*)image_data.image(), header.image_size);
+		file_stream.close();
+
+		bool success = !file_stream.fail();
+		// rename replaces the old file in one step where it can, otherwise it has to be removed first
+		if (success && rename(temp_filename.c_str(), cache_filename.c_str()) != 0)
+		{
+			remove(cache_filename.c_str());
+			success = rename(temp_filename.c_str(), cache_filename.c_str()) == 0;
+		}
+
+		if (!success)
+			remove(temp_filename.c_str());
+
+		return success;
+	}
+}
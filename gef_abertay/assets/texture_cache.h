@@ -0,0 +1,43 @@
+#ifndef _GEF_TEXTURE_CACHE_H
+#define _GEF_TEXTURE_CACHE_H
+
+#include <gef.h>
+#include <string>
+
+namespace gef
+{
+	class Platform;
+	class ImageData;
+
+	/// Decoded PNGs kept on disk so textures can be loaded without going through libpng.
+	/// A cache file holds the RGBA image at its exact size followed by a box filtered mip chain down to 1x1.
+	/// Loading maps the file and the ImageData points straight into it, so there is nothing to decode or copy.
+	/// Cache files are named after the source path and are rebuilt when the source's size or modification time changes,
+	/// they can be built offline by loading every texture once, or are written the first time a texture is used.
+	class TextureCache
+	{
+	public:
+		/// cache_directory must already exist, NULL keeps each cache file next to its PNG
+		TextureCache(const Platform& platform, const char* cache_directory = NULL);
+
+		/// Fills in image_data from the cache, decoding the PNG and writing a new cache file first when needed.
+		/// Safe to call from several threads at once, including for the same texture, as when two scenes sharing a texture
+		/// load on different AssetLoader threads. If its cache file is missing each thread decodes the PNG and writes its own
+		/// temporary file, the last one moved into place is kept and every thread gets the decoded image.
+		bool Load(const char* png_filename, ImageData& image_data) const;
+
+		std::string CacheFilename(const char* png_filename) const;
+
+		static const UInt32 kMagic = 0x58455447;	// "GTEX"
+		static const UInt32 kVersion = 1;
+
+	private:
+		bool LoadCacheFile(const char* png_filename, const std::string& cache_filename, UInt64 source_time, Int32 source_size, ImageData& image_data) const;
+		bool WriteCacheFile(const char* png_filename, const std::string& cache_filename, UInt64 source_time, Int32 source_size, const ImageData& image_data) const;
+
+		const Platform& platform_;
+		std::string cache_directory_;
+	};
+}
+
+#endif // _GEF_TEXTURE_CACHE_H
@@ -38,6 +38,16 @@ Font::~Font()
 }
 
 bool Font::Load(const char* font_name)
+{
+	gef::ImageData image_data;
+	bool config_initialised = LoadConfig(font_name, image_data);
+	if(image_data.image() != NULL)
+		CreateTexture(image_data);
+
+	return config_initialised;
+}
+
+bool Font::LoadConfig(const char* font_name, ImageData& image_data)
 {
 	std::string font_config_filename(font_name);
 	font_config_filename += ".fnt";
@@ -85,15 +95,18 @@ bool Font::Load(const char* font_name)
 		std::string font_texture_filename(font_name);
 		font_texture_filename += "_0.png";
 		PNGLoader png_loader;
-		gef::ImageData image_data;
 		png_loader.Load(font_texture_filename.c_str(), platform_, image_data);
-		font_texture_ = gef::Texture::Create(platform_, image_data);
-		platform_.AddTexture(font_texture_);
 	}
 
 	return config_initialised;
 }
 
+void Font::CreateTexture(const ImageData& image_data)
+{
+	font_texture_ = gef::Texture::Create(platform_, image_data);
+	platform_.AddTexture(font_texture_);
+}
+
 
 bool Font::ParseFont( std::istream& Stream, Font::Charset& CharsetDesc )
 {
@@ -11,6 +11,7 @@ namespace gef
 	class Texture;
 	class Platform;
 	class Vector4;
+	class ImageData;
 
 	enum TextJustification
 	{
@@ -25,6 +26,12 @@ namespace gef
 		Font(Platform& platform);
 		~Font();
 		bool Load(const char* font_name);
+
+		/// Load split in two so the file reading and decoding can be done on another thread.
+		/// LoadConfig parses the .fnt file and decodes the font texture into image_data, CreateTexture must be called on the main thread.
+		bool LoadConfig(const char* font_name, ImageData& image_data);
+		void CreateTexture(const ImageData& image_data);
+
 		void RenderText(SpriteRenderer* renderer, const Vector4& pos, const float scale, const UInt32 colour, const TextJustification justification, const char * text, ...) const;
 		float GetStringLength(const char * text) const;
 
@@ -1,17 +1,33 @@
 #include <graphics/image_data.h>
+#include <system/mapped_file.h>
 #include <cstdlib>
 
 namespace gef
 {
 	ImageData::ImageData() :
 		image_(NULL),
-		clut_(NULL)
+		clut_(NULL),
+		width_(0),
+		height_(0),
+		mip_count_(1),
+		mapped_file_(NULL)
 	{
 	}
 
 	ImageData::~ImageData()
 	{
-		delete image_;
-		delete clut_;
+		if (mapped_file_)
+			delete mapped_file_;
+		else
+			delete[] image_;
+		delete[] clut_;
 	}
-}
\ No newline at end of file
+
+	UInt32 ImageData::MipOffset(const UInt32 level) const
+	{
+		UInt32 offset = 0;
+		for (UInt32 level_num = 0; level_num < level; ++level_num)
+			offset += MipSize(width_, level_num) * MipSize(height_, level_num) * 4;
+		return offset;
+	}
+}
@@ -5,6 +5,8 @@
 
 namespace gef
 {
+	class MappedFile;
+
 	class ImageData
 	{
 	public:
@@ -20,11 +22,26 @@ namespace gef
 		const UInt32 height() const { return height_; }
 		void set_height(const UInt32 height) { height_ = height; }
 
+		/// Number of levels in image(), 1 unless a mip chain follows the top level.
+		/// Each level is half the size of the last, rounded down to no less than 1, and the RGBA levels are packed one after another.
+		const UInt32 mip_count() const { return mip_count_; }
+		void set_mip_count(const UInt32 mip_count) { mip_count_ = mip_count; }
+
+		/// When set, image() points into this file instead of an allocation and the file is closed rather than the image deleted
+		void set_mapped_file(MappedFile* const mapped_file) { mapped_file_ = mapped_file; }
+
+		/// byte offset of a mip level from image()
+		UInt32 MipOffset(const UInt32 level) const;
+
+		static UInt32 MipSize(const UInt32 size, const UInt32 level) { return (size >> level) ? (size >> level) : 1; }
+
 	private:
 		UInt8* image_;
 		UInt8* clut_;
 		UInt32 width_;
 		UInt32 height_;
+		UInt32 mip_count_;
+		MappedFile* mapped_file_;
 	};
 }
 
@@ -64,13 +64,14 @@ namespace gef
 
 
 	VertexData::VertexData() :
-		vertices(NULL)
+		vertices(NULL),
+		owns_vertices(true)
 	{
 	}
 
 	VertexData::~VertexData()
 	{
-		if (vertices)
+		if (vertices && owns_vertices)
 		{
 			free(vertices);
 			vertices = NULL;
@@ -107,13 +108,15 @@ namespace gef
 
 	PrimitiveData::PrimitiveData() :
 		indices(NULL),
+		owns_indices(true),
 		material_name_id(0)
 	{
 	}
 
 	PrimitiveData::~PrimitiveData()
 	{
-		free(indices);
+		if (owns_indices)
+			free(indices);
 		indices = NULL;
 	}
 
@@ -32,6 +32,7 @@ namespace gef
 		bool Write(std::ostream& stream) const;
 
 		void* indices;
+		bool owns_indices;	// false when indices point into a mapped scene file
 		//MaterialData* material;
 		gef::StringId material_name_id;
 		Int32 num_indices;
@@ -48,6 +49,7 @@ namespace gef
 		bool Write(std::ostream& stream) const;
 
 		void* vertices;
+		bool owns_vertices;	// false when vertices point into a mapped scene file
 		Int32 num_vertices;
 		Int32 vertex_byte_size;
 	};
@@ -2,6 +2,8 @@
 #include <graphics/shader.h>
 #include <system/platform.h>
 #include <graphics/texture.h>
+#include <system/profiler.h>
+#include <system/memory_tracker.h>
 
 namespace gef
 {
@@ -35,6 +37,9 @@ namespace gef
 
 	void Renderer3D::DrawSkinnedMesh(const MeshInstance& mesh_instance, const std::vector<Matrix44>& bone_matrices, bool use_default_shader)
 	{
+		GEF_PROFILE_ZONE("Renderer3D::DrawSkinnedMesh");
+		GEF_MEMORY_TAG(MT_RENDERING);
+
 		Shader* previous_shader = shader_;
 		if(use_default_shader)
 		{
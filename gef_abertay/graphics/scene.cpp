@@ -7,15 +7,23 @@
 #include <system/platform.h>
 #include <graphics/image_data.h>
 #include <assets/png_loader.h>
+#include <assets/texture_cache.h>
 #include <graphics/material.h>
+#include <graphics/scene_file.h>
 
-#include <system/file.h>
 #include <system/memory_stream_buffer.h>
+#include <system/profiler.h>
+#include <system/memory_tracker.h>
+#include <system/job_system.h>
 #include <fstream>
 #include <assert.h>
 
 namespace gef
 {
+	Scene::Scene()
+	{
+	}
+
 	Scene::~Scene()
 	{
 		// free up skeletons
@@ -42,6 +50,10 @@ namespace gef
 		// free up animations
 		for(std::map<gef::StringId, Animation*>::iterator animation_iter = animations.begin(); animation_iter != animations.end(); ++animation_iter)
 			delete animation_iter->second;
+
+		// the mesh data that points into these doesn't free its vertices and indices
+		for (std::vector<SceneFile*>::iterator scene_file_iter = scene_files_.begin(); scene_file_iter != scene_files_.end(); ++scene_file_iter)
+			delete *scene_file_iter;
 	}
 
 	Mesh* Scene::CreateMesh(Platform& platform, const MeshData& mesh_data, const bool read_only)
@@ -83,6 +95,8 @@ namespace gef
 
 	void Scene::CreateMeshes(Platform& platform, const bool read_only)
 	{
+		GEF_MEMORY_TAG(MT_RENDERING);
+
 		for (std::list<MeshData>::const_iterator meshIter = mesh_data.begin(); meshIter != mesh_data.end(); ++meshIter)
 		{
 			meshes.push_back(CreateMesh(platform, *meshIter, read_only));
@@ -91,58 +105,122 @@ namespace gef
 	}
 
 
-	void Scene::CreateMaterials(const Platform& platform)
+	void Scene::CreateMaterials(const Platform& platform, JobSystem* job_system, const TextureCache* texture_cache)
 	{
+		GEF_PROFILE_ZONE("Scene::CreateMaterials");
+		GEF_MEMORY_TAG(MT_RENDERING);
+
+		// each texture that isn't already loaded is decoded once, however many materials use it
+		std::vector<const std::string*> texture_filenames;
+		std::map<gef::StringId, Int32> texture_indices;
+		for(std::list<MaterialData>::const_iterator materialIter = material_data.begin();materialIter!=material_data.end();++materialIter)
+		{
+			if(materialIter->diffuse_texture == "")
+				continue;
+
+			gef::StringId texture_name_id = gef::GetStringId(materialIter->diffuse_texture);
+			if(textures_map.find(texture_name_id) == textures_map.end() && texture_indices.find(texture_name_id) == texture_indices.end())
+			{
+				texture_indices[texture_name_id] = (Int32)texture_filenames.size();
+				texture_filenames.push_back(&materialIter->diffuse_texture);
+			}
+		}
+
+		// libpng decoding is most of the cost, so that part is spread over the workers
+		std::vector<ImageData> image_data(texture_filenames.size());
+		auto decode_textures = [&](Int32 begin, Int32 end)
+		{
+			GEF_PROFILE_ZONE("Scene::DecodeTextures");
+			GEF_MEMORY_TAG(MT_RENDERING);
+
+			PNGLoader png_loader;
+			for(Int32 texture_num = begin; texture_num < end; ++texture_num)
+			{
+				if(texture_cache)
+					texture_cache->Load(texture_filenames[texture_num]->c_str(), image_data[texture_num]);
+				else
+					png_loader.Load(texture_filenames[texture_num]->c_str(), platform, image_data[texture_num]);
+			}
+		};
+
+		if(job_system)
+			job_system->ParallelFor((Int32)texture_filenames.size(), 1, decode_textures);
+		else
+			decode_textures(0, (Int32)texture_filenames.size());
 
 		// go through all the materials and create new textures for them
-//		for(std::map<std::string, std::string>::iterator materialIter = materials_.begin();materialIter!=materials_.end();++materialIter)
 		for(std::list<MaterialData>::iterator materialIter = material_data.begin();materialIter!=material_data.end();++materialIter)
 		{
-			Material* material = new Material();
-			materials.push_back(material);
-			materials_map[materialIter->name_id] = material;
+			const ImageData* material_image_data = NULL;
+			if(materialIter->diffuse_texture != "")
+			{
+				std::map<gef::StringId, Int32>::const_iterator find_result = texture_indices.find(gef::GetStringId(materialIter->diffuse_texture));
+				if(find_result != texture_indices.end())
+					material_image_data = &image_data[find_result->second];
+			}
 
+			CreateMaterial(platform, *materialIter, material_image_data);
+		}
+	}
+
+	Material* Scene::CreateMaterial(const Platform& platform, const MaterialData& material_desc, const ImageData* image_data)
+	{
+		GEF_MEMORY_TAG(MT_RENDERING);
 
-			// colour
-			material->set_colour(materialIter->colour);
+		Material* material = new Material();
+		materials.push_back(material);
+		materials_map[material_desc.name_id] = material;
 
-			// texture
-			if(materialIter->diffuse_texture != "")
+
+		// colour
+		material->set_colour(material_desc.colour);
+
+		// texture
+		if(material_desc.diffuse_texture != "")
+		{
+			gef::StringId texture_name_id = gef::GetStringId(material_desc.diffuse_texture);
+			std::map<gef::StringId, Texture*>::iterator find_result = textures_map.find(texture_name_id);
+			if(find_result == textures_map.end())
 			{
-				gef::StringId texture_name_id = gef::GetStringId(materialIter->diffuse_texture);
-				std::map<gef::StringId, Texture*>::iterator find_result = textures_map.find(texture_name_id);
-				if(find_result == textures_map.end())
-				{
-					string_id_table.Add(materialIter->diffuse_texture);
+				string_id_table.Add(material_desc.diffuse_texture);
 
-					ImageData image_data;
+				ImageData loaded_image_data;
+				if(image_data == NULL)
+				{
 					PNGLoader png_loader;
-					png_loader.Load(materialIter->diffuse_texture.c_str(), platform, image_data);
-					if(image_data.image() != NULL)
-					{
-						Texture* texture = Texture::Create(platform, image_data);
-						textures.push_back(texture);
-						textures_map[texture_name_id] = texture;
-						material->set_texture(texture);
-					}
+					png_loader.Load(material_desc.diffuse_texture.c_str(), platform, loaded_image_data);
+					image_data = &loaded_image_data;
 				}
-				else
+
+				if(image_data->image() != NULL)
 				{
-					material->set_texture(find_result->second);
+					Texture* texture = Texture::Create(platform, *image_data);
+					textures.push_back(texture);
+					textures_map[texture_name_id] = texture;
+					material->set_texture(texture);
 				}
 			}
+			else
+			{
+				material->set_texture(find_result->second);
+			}
 		}
+
+		return material;
 	}
 
 
-	bool Scene::WriteSceneToFile(const Platform& platform, const char* filename) const
+	bool Scene::WriteSceneToFile(const Platform& platform, const char* filename, const UInt32 version, const Int32 compression_level) const
 	{
 		bool success = true;
 
 		std::ofstream file_stream(filename, std::ios::out | std::ios::binary);
 		if(file_stream.is_open())
 		{
-			success = WriteScene(file_stream);
+			if (version >= SceneFile::kMinVersion)
+				success = SceneFile::Write(*this, file_stream, compression_level);
+			else
+				success = WriteScene(file_stream);
 		}
 		else
 		{
@@ -156,48 +234,103 @@ namespace gef
 
 	bool Scene::ReadSceneFromFile(const Platform& platform, const char* filename)
 	{
-		bool success = true;
-		void* file_data = NULL;
-		File* file = gef::File::Create();
-		Int32 file_size;
+		GEF_MEMORY_TAG(MT_SCENE);
 
-		success = file->Open(filename);
-		if(success)
+		SceneFile* scene_file = new SceneFile();
+		bool success = scene_file->Open(filename);
+		if(success && scene_file->version() >= SceneFile::kMinVersion)
 		{
-			success = file->GetSize(file_size);
-			if(success)
-			{
-				file_data = malloc(file_size);
-				success = file_data != NULL;
-				if(success)
-				{
-					Int32 bytes_read;
-					success = file->Read(file_data, file_size, bytes_read);
-					if(success)
-						success = bytes_read == file_size;
-				}
+			success = ReadScene(*scene_file);
 
-				if(success)
-				{
-					gef::MemoryStreamBuffer stream_buffer((char*)file_data, file_size);
+			// keep the file mapped, the mesh data points into it
+			scene_files_.push_back(scene_file);
+			scene_file = NULL;
+		}
+		else if(success)
+		{
+			// version 1 files are parsed straight out of the mapping
+			gef::MemoryStreamBuffer stream_buffer((char*)scene_file->data(), scene_file->size());
+
+			std::istream input_stream(&stream_buffer);
+			success = ReadScene(input_stream);
+		}
 
-					std::istream input_stream(&stream_buffer);
-					success = ReadScene(input_stream);
+		delete scene_file;
 
-					// don't need the font file data any more
-					free(file_data);
-					file_data = NULL;
-				}
+		return success;
+	}
+
+	bool Scene::ReadScene(const SceneFile& scene_file)
+	{
+		GEF_PROFILE_ZONE("Scene::ReadScene");
+		GEF_MEMORY_TAG(MT_SCENE);
+
+		// string table
+		const Int32 string_count = scene_file.count(SST_STRINGS);
+		for(Int32 string_num=0;string_num<string_count;++string_num)
+		{
+			const char* string = scene_file.GetString(string_num);
+			if(!string)
+				return false;
+			string_id_table.Add(string);
+		}
+
+		// materials
+		const Int32 material_count = scene_file.count(SST_MATERIALS);
+		for(Int32 material_num=0;material_num<material_count;++material_num)
+		{
+			material_data.push_back(MaterialData());
+
+			MaterialData& material = material_data.back();
+			if(!scene_file.GetMaterialData(material_num, material))
+			{
+				material_data.pop_back();
+				return false;
+			}
+
+			material_data_map[material.name_id] = &material;
+		}
 
+		// mesh_data, the vertices and indices are left in the file
+		const Int32 mesh_count = scene_file.count(SST_MESHES);
+		for(Int32 mesh_num=0;mesh_num<mesh_count;++mesh_num)
+		{
+			mesh_data.push_back(MeshData());
+			if(!scene_file.GetMeshData(mesh_num, mesh_data.back()))
+			{
+				mesh_data.pop_back();
+				return false;
 			}
+		}
+
+		// skeletons
+		const Int32 skeleton_count = scene_file.count(SST_SKELETONS);
+		for(Int32 skeleton_num=0;skeleton_num<skeleton_count;++skeleton_num)
+		{
+			Skeleton* skeleton = scene_file.CreateSkeleton(skeleton_num);
+			if(!skeleton)
+				return false;
+			skeletons.push_back(skeleton);
+		}
 
-			file->Close();
+		// animations
+		const Int32 animation_count = scene_file.count(SST_ANIMATIONS);
+		for(Int32 animation_num=0;animation_num<animation_count;++animation_num)
+		{
+			Animation* animation = scene_file.CreateAnimation(animation_num);
+			if(!animation)
+				return false;
+			animations[animation->name_id()] = animation;
 		}
-		return success;
+
+		return true;
 	}
 
 	bool Scene::ReadScene(std::istream& stream)
 	{
+		GEF_PROFILE_ZONE("Scene::ReadScene");
+		GEF_MEMORY_TAG(MT_SCENE);
+
 		bool success = true;
 
 		Int32 mesh_count;
@@ -15,20 +15,37 @@ namespace gef
 	class Animation;
 	class Platform;
 	class Material;
+	class SceneFile;
+	class ImageData;
+	class JobSystem;
+	class TextureCache;
 
 	class Scene
 	{
 	public:
+		Scene();
 		~Scene();
 
 		Mesh* CreateMesh(Platform& platform, const MeshData& mesh_data, const bool read_only = true);
 		void CreateMeshes(Platform& platform, const bool read_only = true);
-		void CreateMaterials(const Platform& platform);
+		/// The diffuse textures are decoded first, across the job system's workers if there is one, then the materials and textures are created in order on the calling thread.
+		/// With a texture cache the decoded textures come from the cache instead of the PNGs.
+		void CreateMaterials(const Platform& platform, JobSystem* job_system = NULL, const TextureCache* texture_cache = NULL);
 
-		bool WriteSceneToFile(const Platform& platform, const char* filename) const;
+		/// Creates the material for one entry in material_data and adds it to materials and materials_map.
+		/// image_data is the already decoded diffuse texture, when it is NULL the texture is loaded here if it hasn't been already.
+		Material* CreateMaterial(const Platform& platform, const MaterialData& material_desc, const ImageData* image_data = NULL);
+
+		/// version 1, the default, is the original stream format that every loader can read.
+		/// Anything later writes the current memory mapped format described in graphics/scene_file.h, pass SceneFile::kVersion to ask for it.
+		/// compression_level is only used by the mapped format, see SceneFile::Write
+		bool WriteSceneToFile(const Platform& platform, const char* filename, const UInt32 version = 1, const Int32 compression_level = 0) const;
+
+		/// reads any version, mapped files stay mapped for as long as the scene as the mesh data points into them
 		bool ReadSceneFromFile(const Platform& platform, const char* filename);
 
 		bool ReadScene(std::istream& Stream);
+		bool ReadScene(const SceneFile& scene_file);
 		bool WriteScene(std::ostream& Stream) const;
 //		void WriteStringTable(std::istream& Stream) const;
 //		void ReadStringTable(std::istream& Stream);
@@ -52,6 +69,9 @@ namespace gef
 		std::map<gef::StringId, Texture*> textures_map;
 
 		std::vector<gef::StringId> skin_cluster_name_ids;
+
+	private:
+		std::vector<SceneFile*> scene_files_;
 	};
 }
 
@@ -0,0 +1,954 @@
+#include <graphics/scene_file.h>
+#include <graphics/scene.h>
+#include <graphics/mesh_data.h>
+#include <animation/skeleton.h>
+#include <animation/animation.h>
+#include <system/mapped_file.h>
+#include <system/memory_tracker.h>
+#include <system/profiler.h>
+#include <zlib.h>
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+namespace gef
+{
+	// records stored in the sections, offsets are from the start of the section they are in
+
+	struct SceneFileMaterial
+	{
+		StringId name_id;
+		UInt32 colour;
+		UInt32 diffuse_texture;		// offset of a null terminated string
+		UInt32 pad;
+	};
+
+	struct SceneFileMesh
+	{
+		StringId name_id;
+		Int32 primitive_count;
+		UInt32 primitives;			// offset of primitive_count SceneFilePrimitives
+		Int32 num_vertices;
+		Int32 vertex_byte_size;
+		UInt32 vertices;
+		float aabb_min[3];
+		float aabb_max[3];
+	};
+
+	struct SceneFilePrimitive
+	{
+		StringId material_name_id;
+		Int32 num_indices;
+		Int32 index_byte_size;
+		Int32 type;
+		UInt32 indices;
+		UInt32 pad[3];
+	};
+
+	struct SceneFileSkeleton
+	{
+		Int32 joint_count;
+		UInt32 joints;
+	};
+
+	struct SceneFileAnimation
+	{
+		StringId name_id;
+		float start_time;
+		float end_time;
+		Int32 node_count;
+		UInt32 nodes;				// offset of node_count SceneFileAnimNodes
+		UInt32 pad[3];
+	};
+
+	struct SceneFileAnimNode
+	{
+		StringId name_id;
+		Int32 type;
+		Int32 key_counts[3];		// scale, rotation and translation keys for transform nodes, only the first is used by channel nodes
+		UInt32 keys[3];
+	};
+
+	// Joints and transform keys are converted to and from these rather than copying Joint, Vector3Key and QuaternionKey,
+	// so the file doesn't depend on how the compiler lays out the maths classes.
+	// They match the layout the raw copies had, so files written before them still read the same.
+	struct SceneFileJoint
+	{
+		StringId name_id;
+		float inv_bind_pose[16];	// row major
+		Int32 parent;
+	};
+
+	struct SceneFileKey
+	{
+		float value[4];				// x, y, z, w of the vector or quaternion
+		float time;
+	};
+
+	static_assert(sizeof(SceneFileJoint) == 72 && sizeof(SceneFileKey) == 20, "scene file joint and key records must keep their layout");
+	static_assert(sizeof(ChannelKey) == 2 * sizeof(float), "channel keys are stored as they are");
+
+	// size of the record at the start of each section for every item in it
+	static const UInt32 kSectionRecordSizes[NUM_SCENE_SECTION_TYPES] =
+	{
+		sizeof(UInt32),
+		sizeof(SceneFileMaterial),
+		sizeof(SceneFileMesh),
+		sizeof(SceneFileSkeleton),
+		sizeof(SceneFileAnimation)
+	};
+
+	// true if size bytes from offset fit in a section of section_size bytes, in 64 bits so counts from the file can't wrap
+	static bool InSection(UInt32 section_size, UInt32 offset, UInt64 size)
+	{
+		return offset <= section_size && size <= section_size - offset;
+	}
+
+	// count records of T at offset, NULL if they are misaligned or don't fit in the section
+	template<typename T>
+	static const T* SectionArray(const char* section_data, UInt32 section_size, UInt32 offset, Int32 count)
+	{
+		if (count < 0 || offset % alignof(T) != 0 || !InSection(section_size, offset, (UInt64)count * sizeof(T)))
+			return NULL;
+		return reinterpret_cast<const T*>(section_data + offset);
+	}
+
+	// null terminated string at offset, NULL if it runs off the end of the section
+	static const char* SectionString(const char* section_data, UInt32 section_size, UInt32 offset)
+	{
+		if (offset >= section_size || !memchr(section_data + offset, 0, section_size - offset))
+			return NULL;
+		return section_data + offset;
+	}
+
+	static void KeyToRecord(const Vector3Key& key, SceneFileKey& record)
+	{
+		record.value[0] = key.value.x();
+		record.value[1] = key.value.y();
+		record.value[2] = key.value.z();
+		record.value[3] = key.value.w();
+		record.time = key.time;
+	}
+
+	static void KeyToRecord(const QuaternionKey& key, SceneFileKey& record)
+	{
+		record.value[0] = key.value.x;
+		record.value[1] = key.value.y;
+		record.value[2] = key.value.z;
+		record.value[3] = key.value.w;
+		record.time = key.time;
+	}
+
+	static void KeyFromRecord(const SceneFileKey& record, Vector3Key& key)
+	{
+		key.value = Vector4(record.value[0], record.value[1], record.value[2], record.value[3]);
+		key.time = record.time;
+	}
+
+	static void KeyFromRecord(const SceneFileKey& record, QuaternionKey& key)
+	{
+		key.value = Quaternion(record.value[0], record.value[1], record.value[2], record.value[3]);
+		key.time = record.time;
+	}
+
+	// joints and keys are read this many at a time, converting each batch into the skeleton or animation
+	static const Int32 kRecordBatchSize = 64;
+
+	// true if count records of record_size at offset fit in the section
+	static bool InSectionArray(UInt32 section_size, UInt32 offset, Int32 count, UInt32 record_size)
+	{
+		return count >= 0 && InSection(section_size, offset, (UInt64)count * record_size);
+	}
+
+	// builds up the contents of one section
+	class SceneSectionWriter
+	{
+	public:
+		UInt32 Reserve(UInt32 size)
+		{
+			Align();
+			UInt32 offset = (UInt32)bytes_.size();
+			bytes_.resize(offset + size, 0);
+			return offset;
+		}
+
+		UInt32 Append(const void* data, UInt32 size)
+		{
+			UInt32 offset = Reserve(size);
+			if (size)
+				memcpy(&bytes_[offset], data, size);
+			return offset;
+		}
+
+		template<typename KeyType>
+		UInt32 AppendKeys(const std::vector<KeyType>& keys)
+		{
+			std::vector<SceneFileKey> records(keys.size());
+			for (size_t key_num = 0; key_num < keys.size(); ++key_num)
+				KeyToRecord(keys[key_num], records[key_num]);
+			return Append(records.data(), (UInt32)(records.size() * sizeof(SceneFileKey)));
+		}
+
+		UInt32 AppendString(const char* text)
+		{
+			UInt32 offset = (UInt32)bytes_.size();
+			bytes_.insert(bytes_.end(), text, text + strlen(text) + 1);
+			return offset;
+		}
+
+		void Set(UInt32 offset, const void* data, UInt32 size)
+		{
+			memcpy(&bytes_[offset], data, size);
+		}
+
+		void Align()
+		{
+			bytes_.resize((bytes_.size() + SceneFile::kSceneFileAlignment - 1) & ~(size_t)(SceneFile::kSceneFileAlignment - 1), 0);
+		}
+
+		inline const std::vector<char>& bytes() const { return bytes_; }
+
+	private:
+		std::vector<char> bytes_;
+	};
+
+	// Inflates a compressed section a piece at a time into the caller's buffers, so the joints and keys go straight
+	// from the mapping into the skeleton and animation without the whole section being inflated first.
+	// Reads are expected in order of offset, as they are written, reading behind the last one starts again from the beginning.
+	// The item records at the start of the section are kept so every item can be looked up once the stream has moved past them.
+	class SceneSectionStream
+	{
+	public:
+		SceneSectionStream(const char* compressed_data, UInt32 compressed_size, UInt32 records_size) :
+			compressed_data_(compressed_data),
+			compressed_size_(compressed_size),
+			position_(0),
+			initialised_(false),
+			valid_(false)
+		{
+			memset(&stream_, 0, sizeof(z_stream));
+			records_.resize(records_size);
+		}
+
+		~SceneSectionStream()
+		{
+			if (initialised_)
+				inflateEnd(&stream_);
+		}
+
+		bool Read(UInt32 offset, void* dest, UInt32 size)
+		{
+			if (!valid_ && !Restart())
+				return false;
+
+			if (offset < records_.size())
+			{
+				if (!InSection((UInt32)records_.size(), offset, size))
+					return false;
+				if (size)
+					memcpy(dest, &records_[offset], size);
+				return true;
+			}
+
+			if (offset < position_ && !Restart())
+				return false;
+
+			char skipped[1024];
+			while (position_ < offset)
+			{
+				if (!Inflate(skipped, std::min(offset - position_, (UInt32)sizeof(skipped))))
+					return false;
+			}
+
+			return Inflate(dest, size);
+		}
+
+	private:
+		bool Restart()
+		{
+			valid_ = initialised_ ? inflateReset(&stream_) == Z_OK : inflateInit(&stream_) == Z_OK;
+			initialised_ = true;
+			if (!valid_)
+				return false;
+
+			stream_.next_in = (Bytef*)compressed_data_;
+			stream_.avail_in = compressed_size_;
+			position_ = 0;
+			return records_.empty() || Inflate(&records_[0], (UInt32)records_.size());
+		}
+
+		bool Inflate(void* dest, UInt32 size)
+		{
+			stream_.next_out = (Bytef*)dest;
+			stream_.avail_out = size;
+			while (valid_ && stream_.avail_out > 0)
+			{
+				const int result = inflate(&stream_, Z_NO_FLUSH);
+				valid_ = result == Z_OK || (result == Z_STREAM_END && stream_.avail_out == 0);
+			}
+
+			position_ += size - stream_.avail_out;
+			return valid_;
+		}
+
+		const char* compressed_data_;
+		UInt32 compressed_size_;
+		std::vector<char> records_;
+		z_stream stream_;
+		UInt32 position_;
+		bool initialised_;
+		bool valid_;
+	};
+
+	SceneFile::SceneFile() :
+		mapped_file_(NULL),
+		version_(0)
+	{
+		for (Int32 section_num = 0; section_num < NUM_SCENE_SECTION_TYPES; ++section_num)
+		{
+			has_section_[section_num] = false;
+			inflated_sections_[section_num] = NULL;
+			section_streams_[section_num] = NULL;
+		}
+	}
+
+	SceneFile::~SceneFile()
+	{
+		Close();
+	}
+
+	bool SceneFile::Open(const char* const filename)
+	{
+		GEF_PROFILE_ZONE("SceneFile::Open");
+		GEF_MEMORY_TAG(MT_SCENE);
+
+		Close();
+
+		mapped_file_ = MappedFile::Create();
+		if (!mapped_file_->Open(filename))
+		{
+			Close();
+			return false;
+		}
+
+		const char* file_data = static_cast<const char*>(mapped_file_->data());
+		const UInt32 file_size = (UInt32)mapped_file_->size();
+		const SceneFileHeader* header = reinterpret_cast<const SceneFileHeader*>(file_data);
+
+		// version 1 files start with the mesh count rather than a header
+		if (file_size < sizeof(SceneFileHeader) || header->magic != kMagic)
+		{
+			version_ = 1;
+			return true;
+		}
+
+		// version 2 section records stop before the compression fields
+		const UInt32 section_stride = header->version == 2 ? (UInt32)offsetof(SceneFileSection, compression) : (UInt32)sizeof(SceneFileSection);
+
+		bool success = header->version >= kMinVersion && header->version <= kVersion && header->file_size == file_size && header->section_count >= 0
+			&& sizeof(SceneFileHeader) + (UInt64)header->section_count * section_stride <= file_size;
+
+		const char* section_records = file_data + sizeof(SceneFileHeader);
+		for (Int32 section_num = 0; success && section_num < header->section_count; ++section_num)
+		{
+			SceneFileSection section;
+			memcpy(&section, section_records + section_num * section_stride, section_stride);
+			if (section_stride < sizeof(SceneFileSection))
+			{
+				section.compression = SSC_NONE;
+				section.uncompressed_size = section.size;
+			}
+
+			success = section.offset % kSceneFileAlignment == 0 && section.offset <= file_size && section.size <= file_size - section.offset
+				&& section.compression <= SSC_ZLIB && (section.compression != SSC_NONE || section.uncompressed_size == section.size);
+
+			// unknown sections are skipped so newer files can add them
+			if (success && section.type < NUM_SCENE_SECTION_TYPES)
+			{
+				// the records for every item come first, anything they point to is checked when it is read
+				success = section.count >= 0 && (UInt64)section.count * kSectionRecordSizes[section.type] <= section.uncompressed_size;
+				sections_[section.type] = section;
+				has_section_[section.type] = true;
+			}
+		}
+
+		if (!success)
+		{
+			Close();
+			return false;
+		}
+
+		version_ = header->version;
+		return true;
+	}
+
+	bool SceneFile::InflateSection(SceneSectionType type) const
+	{
+		GEF_PROFILE_ZONE("SceneFile::InflateSection");
+		GEF_MEMORY_TAG(MT_SCENE);
+
+		const SceneFileSection& section = sections_[type];
+		char* inflated_section = new char[section.uncompressed_size];
+
+		// the whole section goes in one pass, from the mapping straight into the buffer the data is used from
+		z_stream stream;
+		memset(&stream, 0, sizeof(z_stream));
+		bool success = inflateInit(&stream) == Z_OK;
+		if (success)
+		{
+			stream.next_in = (Bytef*)(static_cast<const char*>(mapped_file_->data()) + section.offset);
+			stream.avail_in = section.size;
+			stream.next_out = (Bytef*)inflated_section;
+			stream.avail_out = section.uncompressed_size;
+
+			success = inflate(&stream, Z_FINISH) == Z_STREAM_END && stream.avail_out == 0;
+			inflateEnd(&stream);
+		}
+
+		if (!success)
+		{
+			delete[] inflated_section;
+			return false;
+		}
+
+		inflated_sections_[type] = inflated_section;
+		return true;
+	}
+
+	void SceneFile::Close()
+	{
+		delete mapped_file_;
+		mapped_file_ = NULL;
+		version_ = 0;
+		for (Int32 section_num = 0; section_num < NUM_SCENE_SECTION_TYPES; ++section_num)
+		{
+			has_section_[section_num] = false;
+			delete[] inflated_sections_[section_num];
+			inflated_sections_[section_num] = NULL;
+			delete section_streams_[section_num];
+			section_streams_[section_num] = NULL;
+		}
+	}
+
+	const void* SceneFile::data() const
+	{
+		return mapped_file_ ? mapped_file_->data() : NULL;
+	}
+
+	Int32 SceneFile::size() const
+	{
+		return mapped_file_ ? mapped_file_->size() : 0;
+	}
+
+	Int32 SceneFile::count(SceneSectionType type) const
+	{
+		return has_section_[type] ? sections_[type].count : 0;
+	}
+
+	const char* SceneFile::SectionData(SceneSectionType type) const
+	{
+		if (sections_[type].compression == SSC_NONE)
+			return static_cast<const char*>(mapped_file_->data()) + sections_[type].offset;
+
+		if (!inflated_sections_[type] && !InflateSection(type))
+			return NULL;
+
+		return inflated_sections_[type];
+	}
+
+	bool SceneFile::ReadSection(SceneSectionType type, UInt32 offset, void* dest, UInt32 size) const
+	{
+		if (!InSection(SectionSize(type), offset, size))
+			return false;
+
+		// uncompressed sections, and compressed ones something else has already needed all of, are read in place
+		if (sections_[type].compression == SSC_NONE || inflated_sections_[type])
+		{
+			if (size)
+				memcpy(dest, SectionData(type) + offset, size);
+			return true;
+		}
+
+		if (!section_streams_[type])
+		{
+			GEF_MEMORY_TAG(MT_SCENE);
+
+			const SceneFileSection& section = sections_[type];
+			section_streams_[type] = new SceneSectionStream(static_cast<const char*>(mapped_file_->data()) + section.offset, section.size,
+				(UInt32)section.count * kSectionRecordSizes[type]);
+		}
+
+		return section_streams_[type]->Read(offset, dest, size);
+	}
+
+	const char* SceneFile::GetString(Int32 index) const
+	{
+		if (index < 0 || index >= count(SST_STRINGS))
+			return NULL;
+
+		const char* section_data = SectionData(SST_STRINGS);
+		if (!section_data)
+			return NULL;
+
+		const UInt32* string_offsets = reinterpret_cast<const UInt32*>(section_data);
+		return SectionString(section_data, SectionSize(SST_STRINGS), string_offsets[index]);
+	}
+
+	bool SceneFile::GetMaterialData(Int32 index, MaterialData& material_data) const
+	{
+		if (index < 0 || index >= count(SST_MATERIALS))
+			return false;
+
+		const char* section_data = SectionData(SST_MATERIALS);
+		if (!section_data)
+			return false;
+
+		const SceneFileMaterial& material = reinterpret_cast<const SceneFileMaterial*>(section_data)[index];
+		const char* diffuse_texture = SectionString(section_data, SectionSize(SST_MATERIALS), material.diffuse_texture);
+		if (!diffuse_texture)
+			return false;
+
+		material_data.name_id = material.name_id;
+		material_data.colour = material.colour;
+		material_data.diffuse_texture = diffuse_texture;
+		return true;
+	}
+
+	bool SceneFile::GetMeshData(Int32 index, MeshData& mesh_data) const
+	{
+		if (index < 0 || index >= count(SST_MESHES))
+			return false;
+
+		char* section_data = const_cast<char*>(SectionData(SST_MESHES));
+		if (!section_data)
+			return false;
+
+		const UInt32 section_size = SectionSize(SST_MESHES);
+		const SceneFileMesh& mesh = reinterpret_cast<const SceneFileMesh*>(section_data)[index];
+
+		// check everything the mesh points to before building any of it
+		if (mesh.num_vertices < 0 || mesh.vertex_byte_size < 0 || !InSection(section_size, mesh.vertices, (UInt64)mesh.num_vertices * (UInt64)mesh.vertex_byte_size))
+			return false;
+
+		const SceneFilePrimitive* primitives = SectionArray<SceneFilePrimitive>(section_data, section_size, mesh.primitives, mesh.primitive_count);
+		if (!primitives)
+			return false;
+
+		for (Int32 prim_num = 0; prim_num < mesh.primitive_count; ++prim_num)
+		{
+			const SceneFilePrimitive& primitive = primitives[prim_num];
+			if (primitive.num_indices < 0 || primitive.index_byte_size < 0 || !InSection(section_size, primitive.indices, (UInt64)primitive.num_indices * (UInt64)primitive.index_byte_size))
+				return false;
+		}
+
+		mesh_data.name_id = mesh.name_id;
+		mesh_data.aabb.Update(Vector4(mesh.aabb_min[0], mesh.aabb_min[1], mesh.aabb_min[2]));
+		mesh_data.aabb.Update(Vector4(mesh.aabb_max[0], mesh.aabb_max[1], mesh.aabb_max[2]));
+
+		mesh_data.vertex_data.num_vertices = mesh.num_vertices;
+		mesh_data.vertex_data.vertex_byte_size = mesh.vertex_byte_size;
+		mesh_data.vertex_data.vertices = section_data + mesh.vertices;
+		mesh_data.vertex_data.owns_vertices = false;
+
+		for (Int32 prim_num = 0; prim_num < mesh.primitive_count; ++prim_num)
+		{
+			const SceneFilePrimitive& primitive = primitives[prim_num];
+
+			PrimitiveData* primitive_data = new PrimitiveData();
+			primitive_data->material_name_id = primitive.material_name_id;
+			primitive_data->num_indices = primitive.num_indices;
+			primitive_data->index_byte_size = primitive.index_byte_size;
+			primitive_data->type = (PrimitiveType)primitive.type;
+			primitive_data->indices = section_data + primitive.indices;
+			primitive_data->owns_indices = false;
+			mesh_data.primitives.push_back(primitive_data);
+		}
+
+		return true;
+	}
+
+	template<typename KeyType>
+	bool SceneFile::ReadKeys(UInt32 offset, Int32 count, std::vector<KeyType>& keys) const
+	{
+		keys.resize(count);
+
+		SceneFileKey records[kRecordBatchSize];
+		for (Int32 first_key = 0; first_key < count; first_key += kRecordBatchSize)
+		{
+			const Int32 batch_count = std::min(count - first_key, kRecordBatchSize);
+			if (!ReadSection(SST_ANIMATIONS, offset + first_key * (UInt32)sizeof(SceneFileKey), records, batch_count * (UInt32)sizeof(SceneFileKey)))
+				return false;
+
+			for (Int32 key_num = 0; key_num < batch_count; ++key_num)
+				KeyFromRecord(records[key_num], keys[first_key + key_num]);
+		}
+
+		return true;
+	}
+
+	Skeleton* SceneFile::CreateSkeleton(Int32 index) const
+	{
+		if (index < 0 || index >= count(SST_SKELETONS))
+			return NULL;
+
+		SceneFileSkeleton skeleton_record;
+		if (!ReadSection(SST_SKELETONS, index * (UInt32)sizeof(SceneFileSkeleton), &skeleton_record, sizeof(SceneFileSkeleton))
+			|| !InSectionArray(SectionSize(SST_SKELETONS), skeleton_record.joints, skeleton_record.joint_count, sizeof(SceneFileJoint)))
+			return NULL;
+
+		Skeleton* skeleton = new Skeleton();
+		skeleton->joints().resize(skeleton_record.joint_count);
+
+		SceneFileJoint joint_records[kRecordBatchSize];
+		for (Int32 first_joint = 0; first_joint < skeleton_record.joint_count; first_joint += kRecordBatchSize)
+		{
+			const Int32 batch_count = std::min(skeleton_record.joint_count - first_joint, kRecordBatchSize);
+			if (!ReadSection(SST_SKELETONS, skeleton_record.joints + first_joint * (UInt32)sizeof(SceneFileJoint), joint_records, batch_count * (UInt32)sizeof(SceneFileJoint)))
+			{
+				delete skeleton;
+				return NULL;
+			}
+
+			for (Int32 joint_num = 0; joint_num < batch_count; ++joint_num)
+			{
+				const SceneFileJoint& joint_record = joint_records[joint_num];
+				Joint& joint = skeleton->joints()[first_joint + joint_num];
+				joint.name_id = joint_record.name_id;
+				joint.parent = joint_record.parent;
+				for (Int32 element = 0; element < 16; ++element)
+					joint.inv_bind_pose.set_m(element / 4, element % 4, joint_record.inv_bind_pose[element]);
+			}
+		}
+
+		return skeleton;
+	}
+
+	Animation* SceneFile::CreateAnimation(Int32 index) const
+	{
+		if (index < 0 || index >= count(SST_ANIMATIONS))
+			return NULL;
+
+		const UInt32 section_size = SectionSize(SST_ANIMATIONS);
+		SceneFileAnimation animation_record;
+		if (!ReadSection(SST_ANIMATIONS, index * (UInt32)sizeof(SceneFileAnimation), &animation_record, sizeof(SceneFileAnimation))
+			|| !InSectionArray(section_size, animation_record.nodes, animation_record.node_count, sizeof(SceneFileAnimNode)))
+			return NULL;
+
+		// the node records all come before their keys, so they are read first
+		std::vector<SceneFileAnimNode> nodes(animation_record.node_count);
+		if (!ReadSection(SST_ANIMATIONS, animation_record.nodes, nodes.data(), animation_record.node_count * (UInt32)sizeof(SceneFileAnimNode)))
+			return NULL;
+
+		// check every node's keys before building any of it
+		for (Int32 node_num = 0; node_num < animation_record.node_count; ++node_num)
+		{
+			const SceneFileAnimNode& node = nodes[node_num];
+			bool keys_valid = true;
+			switch (node.type)
+			{
+			case AnimNode::kTransform:
+				keys_valid = InSectionArray(section_size, node.keys[0], node.key_counts[0], sizeof(SceneFileKey))
+					&& InSectionArray(section_size, node.keys[1], node.key_counts[1], sizeof(SceneFileKey))
+					&& InSectionArray(section_size, node.keys[2], node.key_counts[2], sizeof(SceneFileKey));
+				break;
+
+			case AnimNode::kChannel:
+				keys_valid = InSectionArray(section_size, node.keys[0], node.key_counts[0], sizeof(ChannelKey));
+				break;
+			}
+
+			if (!keys_valid)
+				return NULL;
+		}
+
+		Animation* animation = new Animation();
+		animation->set_name_id(animation_record.name_id);
+		animation->set_start_time(animation_record.start_time);
+		animation->set_end_time(animation_record.end_time);
+
+		bool success = true;
+		for (Int32 node_num = 0; success && node_num < animation_record.node_count; ++node_num)
+		{
+			const SceneFileAnimNode& node = nodes[node_num];
+
+			AnimNode* anim_node = NULL;
+			switch (node.type)
+			{
+			case AnimNode::kTransform:
+				{
+					TransformAnimNode* transform_node = new TransformAnimNode();
+					success = ReadKeys(node.keys[0], node.key_counts[0], transform_node->scale_keys())
+						&& ReadKeys(node.keys[1], node.key_counts[1], transform_node->rotation_keys())
+						&& ReadKeys(node.keys[2], node.key_counts[2], transform_node->translation_keys());
+					anim_node = transform_node;
+				}
+				break;
+
+			case AnimNode::kChannel:
+				{
+					// channel keys have the same layout in the file, so they are read straight into the node
+					ChannelAnimNode* channel_node = new ChannelAnimNode();
+					channel_node->keys().resize(node.key_counts[0]);
+					success = ReadSection(SST_ANIMATIONS, node.keys[0], channel_node->keys().data(), node.key_counts[0] * (UInt32)sizeof(ChannelKey));
+					anim_node = channel_node;
+				}
+				break;
+			}
+
+			if (anim_node)
+			{
+				anim_node->set_name_id(node.name_id);
+				animation->AddNode(anim_node);
+			}
+		}
+
+		if (!success)
+		{
+			delete animation;
+			return NULL;
+		}
+
+		animation->CalculateDuration();
+
+		return animation;
+	}
+
+	static void WriteStrings(const Scene& scene, SceneSectionWriter& writer)
+	{
+		const std::map<StringId, std::string>& table = scene.string_id_table.table();
+
+		std::vector<UInt32> string_offsets;
+		UInt32 offsets_offset = writer.Reserve((UInt32)(table.size() * sizeof(UInt32)));
+		for (std::map<StringId, std::string>::const_iterator string_iter = table.begin(); string_iter != table.end(); ++string_iter)
+			string_offsets.push_back(writer.AppendString(string_iter->second.c_str()));
+
+		if (!string_offsets.empty())
+			writer.Set(offsets_offset, &string_offsets[0], (UInt32)(string_offsets.size() * sizeof(UInt32)));
+	}
+
+	static void WriteMaterials(const Scene& scene, SceneSectionWriter& writer)
+	{
+		std::vector<SceneFileMaterial> materials;
+		UInt32 materials_offset = writer.Reserve((UInt32)(scene.material_data.size() * sizeof(SceneFileMaterial)));
+		for (std::list<MaterialData>::const_iterator material_iter = scene.material_data.begin(); material_iter != scene.material_data.end(); ++material_iter)
+		{
+			SceneFileMaterial material;
+			memset(&material, 0, sizeof(SceneFileMaterial));
+			material.name_id = material_iter->name_id;
+			material.colour = material_iter->colour;
+			material.diffuse_texture = writer.AppendString(material_iter->diffuse_texture.c_str());
+			materials.push_back(material);
+		}
+
+		if (!materials.empty())
+			writer.Set(materials_offset, &materials[0], (UInt32)(materials.size() * sizeof(SceneFileMaterial)));
+	}
+
+	static void WriteMeshes(const Scene& scene, SceneSectionWriter& writer)
+	{
+		std::vector<SceneFileMesh> meshes;
+		UInt32 meshes_offset = writer.Reserve((UInt32)(scene.mesh_data.size() * sizeof(SceneFileMesh)));
+		for (std::list<MeshData>::const_iterator mesh_iter = scene.mesh_data.begin(); mesh_iter != scene.mesh_data.end(); ++mesh_iter)
+		{
+			SceneFileMesh mesh;
+			memset(&mesh, 0, sizeof(SceneFileMesh));
+			mesh.name_id = mesh_iter->name_id;
+			mesh.primitive_count = (Int32)mesh_iter->primitives.size();
+			mesh.num_vertices = mesh_iter->vertex_data.num_vertices;
+			mesh.vertex_byte_size = mesh_iter->vertex_data.vertex_byte_size;
+			mesh.aabb_min[0] = mesh_iter->aabb.min_vtx().x();
+			mesh.aabb_min[1] = mesh_iter->aabb.min_vtx().y();
+			mesh.aabb_min[2] = mesh_iter->aabb.min_vtx().z();
+			mesh.aabb_max[0] = mesh_iter->aabb.max_vtx().x();
+			mesh.aabb_max[1] = mesh_iter->aabb.max_vtx().y();
+			mesh.aabb_max[2] = mesh_iter->aabb.max_vtx().z();
+
+			mesh.vertices = writer.Append(mesh_iter->vertex_data.vertices, mesh.num_vertices * mesh.vertex_byte_size);
+
+			std::vector<SceneFilePrimitive> primitives;
+			mesh.primitives = writer.Reserve(mesh.primitive_count * sizeof(SceneFilePrimitive));
+			for (std::vector<PrimitiveData*>::const_iterator prim_iter = mesh_iter->primitives.begin(); prim_iter != mesh_iter->primitives.end(); ++prim_iter)
+			{
+				SceneFilePrimitive primitive;
+				memset(&primitive, 0, sizeof(SceneFilePrimitive));
+				primitive.material_name_id = (*prim_iter)->material_name_id;
+				primitive.num_indices = (*prim_iter)->num_indices;
+				primitive.index_byte_size = (*prim_iter)->index_byte_size;
+				primitive.type = (*prim_iter)->type;
+				primitive.indices = writer.Append((*prim_iter)->indices, primitive.num_indices * primitive.index_byte_size);
+				primitives.push_back(primitive);
+			}
+
+			if (!primitives.empty())
+				writer.Set(mesh.primitives, &primitives[0], (UInt32)(primitives.size() * sizeof(SceneFilePrimitive)));
+
+			meshes.push_back(mesh);
+		}
+
+		if (!meshes.empty())
+			writer.Set(meshes_offset, &meshes[0], (UInt32)(meshes.size() * sizeof(SceneFileMesh)));
+	}
+
+	static void WriteSkeletons(const Scene& scene, SceneSectionWriter& writer)
+	{
+		std::vector<SceneFileSkeleton> skeletons;
+		UInt32 skeletons_offset = writer.Reserve((UInt32)(scene.skeletons.size() * sizeof(SceneFileSkeleton)));
+		for (std::list<Skeleton*>::const_iterator skeleton_iter = scene.skeletons.begin(); skeleton_iter != scene.skeletons.end(); ++skeleton_iter)
+		{
+			SceneFileSkeleton skeleton;
+			skeleton.joint_count = (*skeleton_iter)->joint_count();
+			std::vector<SceneFileJoint> joint_records(skeleton.joint_count);
+			for (Int32 joint_num = 0; joint_num < skeleton.joint_count; ++joint_num)
+			{
+				const Joint& joint = (*skeleton_iter)->joint(joint_num);
+				SceneFileJoint& joint_record = joint_records[joint_num];
+				joint_record.name_id = joint.name_id;
+				joint_record.parent = joint.parent;
+				for (Int32 element = 0; element < 16; ++element)
+					joint_record.inv_bind_pose[element] = joint.inv_bind_pose.m(element / 4, element % 4);
+			}
+			skeleton.joints = writer.Append(joint_records.data(), skeleton.joint_count * sizeof(SceneFileJoint));
+			skeletons.push_back(skeleton);
+		}
+
+		if (!skeletons.empty())
+			writer.Set(skeletons_offset, &skeletons[0], (UInt32)(skeletons.size() * sizeof(SceneFileSkeleton)));
+	}
+
+	static void WriteAnimations(const Scene& scene, SceneSectionWriter& writer)
+	{
+		std::vector<SceneFileAnimation> animations;
+		UInt32 animations_offset = writer.Reserve((UInt32)(scene.animations.size() * sizeof(SceneFileAnimation)));
+		for (std::map<StringId, Animation*>::const_iterator animation_iter = scene.animations.begin(); animation_iter != scene.animations.end(); ++animation_iter)
+		{
+			const Animation* source = animation_iter->second;
+
+			SceneFileAnimation animation;
+			memset(&animation, 0, sizeof(SceneFileAnimation));
+			animation.name_id = source->name_id();
+			animation.start_time = source->start_time();
+			animation.end_time = source->end_time();
+			animation.node_count = (Int32)source->anim_nodes().size();
+
+			std::vector<SceneFileAnimNode> nodes;
+			animation.nodes = writer.Reserve(animation.node_count * sizeof(SceneFileAnimNode));
+			for (std::map<StringId, AnimNode*>::const_iterator node_iter = source->anim_nodes().begin(); node_iter != source->anim_nodes().end(); ++node_iter)
+			{
+				SceneFileAnimNode node;
+				memset(&node, 0, sizeof(SceneFileAnimNode));
+				node.name_id = node_iter->second->name_id();
+				node.type = node_iter->second->type();
+
+				switch (node_iter->second->type())
+				{
+				case AnimNode::kTransform:
+					{
+						const TransformAnimNode* transform_node = static_cast<const TransformAnimNode*>(node_iter->second);
+						node.key_counts[0] = (Int32)transform_node->scale_keys().size();
+						node.key_counts[1] = (Int32)transform_node->rotation_keys().size();
+						node.key_counts[2] = (Int32)transform_node->translation_keys().size();
+						node.keys[0] = writer.AppendKeys(transform_node->scale_keys());
+						node.keys[1] = writer.AppendKeys(transform_node->rotation_keys());
+						node.keys[2] = writer.AppendKeys(transform_node->translation_keys());
+					}
+					break;
+
+				case AnimNode::kChannel:
+					{
+						const ChannelAnimNode* channel_node = static_cast<const ChannelAnimNode*>(node_iter->second);
+						node.key_counts[0] = (Int32)channel_node->keys().size();
+						node.keys[0] = writer.Append(channel_node->keys().data(), node.key_counts[0] * sizeof(ChannelKey));
+					}
+					break;
+				}
+
+				nodes.push_back(node);
+			}
+
+			if (!nodes.empty())
+				writer.Set(animation.nodes, &nodes[0], (UInt32)(nodes.size() * sizeof(SceneFileAnimNode)));
+
+			animations.push_back(animation);
+		}
+
+		if (!animations.empty())
+			writer.Set(animations_offset, &animations[0], (UInt32)(animations.size() * sizeof(SceneFileAnimation)));
+	}
+
+	// returns false if deflating doesn't make the data any smaller
+	static bool DeflateSection(const std::vector<char>& section_bytes, Int32 compression_level, std::vector<char>& compressed_bytes)
+	{
+		if (section_bytes.empty())
+			return false;
+
+		uLongf compressed_size = compressBound((uLong)section_bytes.size());
+		compressed_bytes.resize(compressed_size);
+		if (compress2((Bytef*)&compressed_bytes[0], &compressed_size, (const Bytef*)&section_bytes[0], (uLong)section_bytes.size(), compression_level) != Z_OK)
+			return false;
+
+		compressed_bytes.resize(compressed_size);
+		return compressed_bytes.size() < section_bytes.size();
+	}
+
+	bool SceneFile::Write(const Scene& scene, std::ostream& stream, Int32 compression_level)
+	{
+		SceneSectionWriter section_writers[NUM_SCENE_SECTION_TYPES];
+		WriteStrings(scene, section_writers[SST_STRINGS]);
+		WriteMaterials(scene, section_writers[SST_MATERIALS]);
+		WriteMeshes(scene, section_writers[SST_MESHES]);
+		WriteSkeletons(scene, section_writers[SST_SKELETONS]);
+		WriteAnimations(scene, section_writers[SST_ANIMATIONS]);
+
+		const Int32 section_counts[NUM_SCENE_SECTION_TYPES] =
+		{
+			(Int32)scene.string_id_table.table().size(),
+			(Int32)scene.material_data.size(),
+			(Int32)scene.mesh_data.size(),
+			(Int32)scene.skeletons.size(),
+			(Int32)scene.animations.size()
+		};
+
+		// the header and section table, then each section aligned after the last
+		SceneSectionWriter file_writer;
+		SceneFileHeader header;
+		UInt32 header_offset = file_writer.Reserve(sizeof(SceneFileHeader));
+		UInt32 sections_offset = file_writer.Reserve(NUM_SCENE_SECTION_TYPES * sizeof(SceneFileSection));
+
+		// the strings and materials are small and needed first, only the bulk data is worth compressing
+		const bool compress_section[NUM_SCENE_SECTION_TYPES] = { false, false, true, true, true };
+
+		SceneFileSection sections[NUM_SCENE_SECTION_TYPES];
+		for (Int32 section_num = 0; section_num < NUM_SCENE_SECTION_TYPES; ++section_num)
+		{
+			const std::vector<char>* section_bytes = &section_writers[section_num].bytes();
+
+			sections[section_num].type = section_num;
+			sections[section_num].count = section_counts[section_num];
+			sections[section_num].compression = SSC_NONE;
+			sections[section_num].uncompressed_size = (UInt32)section_bytes->size();
+
+			std::vector<char> compressed_bytes;
+			if (compression_level > 0 && compress_section[section_num] && DeflateSection(*section_bytes, compression_level, compressed_bytes))
+			{
+				sections[section_num].compression = SSC_ZLIB;
+				section_bytes = &compressed_bytes;
+			}
+
+			sections[section_num].size = (UInt32)section_bytes->size();
+			sections[section_num].offset = file_writer.Append(section_bytes->empty() ? NULL : &(*section_bytes)[0], sections[section_num].size);
+		}
+		file_writer.Align();
+
+		header.magic = kMagic;
+		header.version = kVersion;
+		header.section_count = NUM_SCENE_SECTION_TYPES;
+		header.file_size = (UInt32)file_writer.bytes().size();
+		file_writer.Set(header_offset, &header, sizeof(SceneFileHeader));
+		file_writer.Set(sections_offset, sections, sizeof(sections));
+
+		stream.write(&file_writer.bytes()[0], file_writer.bytes().size());
+
+		return !stream.fail();
+	}
+}
@@ -0,0 +1,130 @@
+#ifndef _GEF_SCENE_FILE_H
+#define _GEF_SCENE_FILE_H
+
+#include <gef.h>
+#include <system/string_id.h>
+#include <ostream>
+#include <vector>
+
+namespace gef
+{
+	class MappedFile;
+	class Scene;
+	class Skeleton;
+	class Animation;
+	struct MaterialData;
+	struct MeshData;
+	class SceneSectionStream;
+
+	enum SceneSectionType
+	{
+		SST_STRINGS = 0,
+		SST_MATERIALS,
+		SST_MESHES,
+		SST_SKELETONS,
+		SST_ANIMATIONS,
+		NUM_SCENE_SECTION_TYPES
+	};
+
+	enum SceneSectionCompression
+	{
+		SSC_NONE = 0,
+		SSC_ZLIB
+	};
+
+	/// Version 2 and 3 .scn files start with this header followed by a table of section_count sections.
+	/// Every section starts on a kSceneFileAlignment boundary and offsets inside a section are from the start of the section,
+	/// so the vertex, index, joint and key data can be used straight from the mapped file.
+	/// Joints and keys are stored as fixed records of floats and integers rather than copies of the in memory structs.
+	/// Everything is stored in the byte order of the machine that wrote it, so files are only readable on little endian targets.
+	struct SceneFileHeader
+	{
+		UInt32 magic;
+		UInt32 version;
+		Int32 section_count;
+		UInt32 file_size;
+	};
+
+	struct SceneFileSection
+	{
+		UInt32 type;
+		Int32 count;		// number of items in the section
+		UInt32 offset;		// from the start of the file
+		UInt32 size;		// in the file
+		UInt32 compression;	// SceneSectionCompression, version 2 sections stop before this and are never compressed
+		UInt32 uncompressed_size;
+	};
+
+	/// Lazy access to a memory mapped .scn file.
+	/// Opening a file only checks the header and section table, each section is only touched when it is first asked for.
+	/// A compressed string, material or mesh section is inflated into its own buffer on first use, since its data is used in place.
+	/// Compressed skeleton and animation sections are never inflated whole, their joints and keys are inflated in batches straight into the new skeleton or animation.
+	/// Reading is not thread safe, even through the const functions.
+	/// Version 1 files have no header, they can be opened but have to be read with Scene::ReadScene.
+	class SceneFile
+	{
+	public:
+		SceneFile();
+		~SceneFile();
+
+		bool Open(const char* const filename);
+		void Close();
+
+		/// 1 for files without a header, 2 or 3 for mapped files, 0 if the file failed to open or is not a scene
+		inline UInt32 version() const { return version_; }
+
+		const void* data() const;
+		Int32 size() const;
+
+		/// number of items in a section, 0 if the file does not have the section
+		Int32 count(SceneSectionType type) const;
+
+		/// Every offset and count read from a record is checked against the size of its section,
+		/// the functions below return false or NULL if the record points outside it.
+
+		/// points into the file
+		const char* GetString(Int32 index) const;
+
+		bool GetMaterialData(Int32 index, MaterialData& material_data) const;
+
+		/// The vertices and indices point into the file, or the inflated section, rather than being copied, so mesh_data must not outlive the SceneFile.
+		/// The mapping is copy on write so they can still be modified.
+		bool GetMeshData(Int32 index, MeshData& mesh_data) const;
+
+		Skeleton* CreateSkeleton(Int32 index) const;
+		Animation* CreateAnimation(Int32 index) const;
+
+		/// compression_level 1 to 9 deflates the mesh, skeleton and animation sections, 0 leaves everything uncompressed.
+		/// A section is only stored compressed if that makes it smaller.
+		static bool Write(const Scene& scene, std::ostream& stream, Int32 compression_level = 0);
+
+		static const UInt32 kMagic = 0x4e435347;	// "GSCN"
+		static const UInt32 kVersion = 3;
+		static const UInt32 kMinVersion = 2;
+		static const UInt32 kSceneFileAlignment = 16;
+
+	private:
+		// NULL if a compressed section fails to inflate
+		const char* SectionData(SceneSectionType type) const;
+		inline UInt32 SectionSize(SceneSectionType type) const { return sections_[type].uncompressed_size; }
+		bool InflateSection(SceneSectionType type) const;
+
+		// copies size bytes from offset in the uncompressed section, false if they are outside it or fail to inflate
+		bool ReadSection(SceneSectionType type, UInt32 offset, void* dest, UInt32 size) const;
+		template<typename KeyType>
+		bool ReadKeys(UInt32 offset, Int32 count, std::vector<KeyType>& keys) const;
+
+		MappedFile* mapped_file_;
+		UInt32 version_;
+
+		// copied out of the file so version 2 sections can be filled in
+		SceneFileSection sections_[NUM_SCENE_SECTION_TYPES];
+		bool has_section_[NUM_SCENE_SECTION_TYPES];
+
+		// NULL for sections that are used straight from the mapping, or haven't been needed yet
+		mutable char* inflated_sections_[NUM_SCENE_SECTION_TYPES];
+		mutable SceneSectionStream* section_streams_[NUM_SCENE_SECTION_TYPES];
+	};
+}
+
+#endif // _GEF_SCENE_FILE_H
@@ -30,8 +30,9 @@ namespace gef
 #if 1
 		free(vertex_shader_variable_data_);
 		free(pixel_shader_variable_data_);
-		free(vs_shader_source_);
-		free(ps_shader_source_);
+		// shader sources are copied in with new[]
+		delete[] vs_shader_source_;
+		delete[] ps_shader_source_;
 #endif
 	}
 #if 1
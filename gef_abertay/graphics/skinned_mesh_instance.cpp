@@ -1,4 +1,6 @@
 #include <graphics/skinned_mesh_instance.h>
+#include <system/profiler.h>
+#include <system/memory_tracker.h>
 
 namespace gef
 {
@@ -6,6 +8,7 @@ namespace gef
 	{
 		bind_pose_.CreateBindPose(&skeleton);
 		bone_matrices_.resize(skeleton.joints().size());
+		interpolated_pose_ = bind_pose_;
 	}
 
 	SkinnedMeshInstance::~SkinnedMeshInstance()
@@ -15,6 +18,9 @@ namespace gef
 
 	void SkinnedMeshInstance::UpdateBoneMatrices(const gef::SkeletonPose& pose)
 	{
+		GEF_PROFILE_ZONE("SkinnedMeshInstance::UpdateBoneMatrices");
+		GEF_MEMORY_TAG(MT_ANIMATION);
+
 		// calculate bone matrices that need to be passed to the shader
 		// this should be the final pose if multiple animations are blended together
 		std::vector<gef::Matrix44>::const_iterator pose_matrix_iter = pose.global_pose().begin();
@@ -24,5 +30,10 @@ namespace gef
 			*bone_matrix_iter = (joint_iter->inv_bind_pose * *pose_matrix_iter);
 	}
 
-}
+	void SkinnedMeshInstance::UpdateBoneMatrices(const gef::SkeletonPose& previous_pose, const gef::SkeletonPose& current_pose, float alpha)
+	{
+		interpolated_pose_.Linear2PoseBlend(previous_pose, current_pose, alpha);
+		UpdateBoneMatrices(interpolated_pose_);
+	}
 
+}
@@ -16,11 +16,15 @@ namespace gef
 
 		void UpdateBoneMatrices(const gef::SkeletonPose& pose);
 
+		/// Bone matrices for a pose part way between two poses, for rendering between fixed rate updates
+		void UpdateBoneMatrices(const gef::SkeletonPose& previous_pose, const gef::SkeletonPose& current_pose, float alpha);
+
 		inline std::vector<gef::Matrix44>& bone_matrices() { return bone_matrices_; }
 		inline const gef::SkeletonPose& bind_pose() const { return bind_pose_; }
 	protected:
 		std::vector<gef::Matrix44> bone_matrices_;
 		gef::SkeletonPose bind_pose_;
+		gef::SkeletonPose interpolated_pose_;
 	};
 
 }
@@ -84,11 +84,34 @@ namespace gef
 
 	}
 
+	FrustumIntersect Frustum::Intersects(const Vector4& start, const Vector4& end) const
+	{
+		int total_in = 0;
+
+		for (int p = 0; p < 6; ++p)
+		{
+			const bool start_behind = planes_[p].ClassifyPoint(start) == PP_BEHIND;
+			const bool end_behind = planes_[p].ClassifyPoint(end) == PP_BEHIND;
+
+			// both ends outside of plane p?
+			if (start_behind && end_behind)
+				return FI_OUT;
+
+			if (!start_behind && !end_behind)
+				++total_in;
+		}
+
+		if (total_in == 6)
+			return FI_IN;
+
+		return FI_INTERSECTS;
+	}
+
 	//
 	// http://gamedevs.org/uploads/fast-extraction-viewing-frustum-planes-from-world-view-projection-matrix.pdf
 	//
 
-	void Frustum::ExtractPlanesD3D(const Matrix44& viewproj, bool normalise)
+	void Frustum::ExtractPlanes(const Matrix44& viewproj, float ndc_z_min, bool normalise)
 	{
 		// Left clipping plane
 		planes_[0].set_a(viewproj.m(0,3) + viewproj.m(0,0));
@@ -96,25 +119,25 @@ namespace gef
 		planes_[0].set_c(viewproj.m(2,3) + viewproj.m(2,0));
 		planes_[0].set_d(viewproj.m(3,3) + viewproj.m(3,0));
 		// Right clipping plane
-		planes_[0].set_a(viewproj.m(0,3) - viewproj.m(0,0));
-		planes_[0].set_b(viewproj.m(1,3) - viewproj.m(1,0));
-		planes_[0].set_c(viewproj.m(2,3) - viewproj.m(2,0));
-		planes_[0].set_d(viewproj.m(3,3) - viewproj.m(3,0));
+		planes_[1].set_a(viewproj.m(0,3) - viewproj.m(0,0));
+		planes_[1].set_b(viewproj.m(1,3) - viewproj.m(1,0));
+		planes_[1].set_c(viewproj.m(2,3) - viewproj.m(2,0));
+		planes_[1].set_d(viewproj.m(3,3) - viewproj.m(3,0));
 		// Top clipping plane
-		planes_[1].set_a(viewproj.m(0,3) - viewproj.m(0,1));
-		planes_[1].set_b(viewproj.m(1,3) - viewproj.m(1,1));
-		planes_[1].set_c(viewproj.m(2,3) - viewproj.m(2,1));
-		planes_[1].set_d(viewproj.m(3,3) - viewproj.m(3,1));
+		planes_[2].set_a(viewproj.m(0,3) - viewproj.m(0,1));
+		planes_[2].set_b(viewproj.m(1,3) - viewproj.m(1,1));
+		planes_[2].set_c(viewproj.m(2,3) - viewproj.m(2,1));
+		planes_[2].set_d(viewproj.m(3,3) - viewproj.m(3,1));
 		// Bottom clipping plane
-		planes_[2].set_a(viewproj.m(0,3) + viewproj.m(0,1));
-		planes_[2].set_b(viewproj.m(1,3) + viewproj.m(1,1));
-		planes_[2].set_c(viewproj.m(2,3) + viewproj.m(2,1));
-		planes_[2].set_d(viewproj.m(3,3) + viewproj.m(3,1));
-		// Near clipping plane
-		planes_[3].set_a(viewproj.m(0,2));
-		planes_[3].set_b(viewproj.m(1,2));
-		planes_[3].set_c(viewproj.m(2,2));
-		planes_[3].set_d(viewproj.m(3,2));
+		planes_[3].set_a(viewproj.m(0,3) + viewproj.m(0,1));
+		planes_[3].set_b(viewproj.m(1,3) + viewproj.m(1,1));
+		planes_[3].set_c(viewproj.m(2,3) + viewproj.m(2,1));
+		planes_[3].set_d(viewproj.m(3,3) + viewproj.m(3,1));
+		// Near clipping plane, z >= ndc_z_min * w
+		planes_[4].set_a(viewproj.m(0,2) - ndc_z_min * viewproj.m(0,3));
+		planes_[4].set_b(viewproj.m(1,2) - ndc_z_min * viewproj.m(1,3));
+		planes_[4].set_c(viewproj.m(2,2) - ndc_z_min * viewproj.m(2,3));
+		planes_[4].set_d(viewproj.m(3,2) - ndc_z_min * viewproj.m(3,3));
 		// Far clipping plane
 		planes_[5].set_a(viewproj.m(0,3) - viewproj.m(0,2));
 		planes_[5].set_b(viewproj.m(1,3) - viewproj.m(1,2));
@@ -133,6 +156,11 @@ namespace gef
 	}
 
 
+	void Frustum::ExtractPlanesD3D(const Matrix44& viewproj, bool normalise)
+	{
+		ExtractPlanes(viewproj, 0.0f, normalise);
+	}
+
 	void Frustum::ExtractPlanesGL(const Matrix44& viewproj, bool normalise)
 	{
 		// Left clipping plane
@@ -141,25 +169,25 @@ namespace gef
 		planes_[0].set_c(viewproj.m(3,2) + viewproj.m(0,2));
 		planes_[0].set_d(viewproj.m(3,3) + viewproj.m(0,3));
 		// Right clipping plane
-		planes_[0].set_a(viewproj.m(3,0) - viewproj.m(0,0));
-		planes_[0].set_b(viewproj.m(3,1) - viewproj.m(0,1));
-		planes_[0].set_c(viewproj.m(3,2) - viewproj.m(0,2));
-		planes_[0].set_d(viewproj.m(3,3) - viewproj.m(0,3));
+		planes_[1].set_a(viewproj.m(3,0) - viewproj.m(0,0));
+		planes_[1].set_b(viewproj.m(3,1) - viewproj.m(0,1));
+		planes_[1].set_c(viewproj.m(3,2) - viewproj.m(0,2));
+		planes_[1].set_d(viewproj.m(3,3) - viewproj.m(0,3));
 		// Top clipping plane
-		planes_[1].set_a(viewproj.m(3,0) - viewproj.m(1,0));
-		planes_[1].set_b(viewproj.m(3,1) - viewproj.m(1,1));
-		planes_[1].set_c(viewproj.m(3,2) - viewproj.m(1,2));
-		planes_[1].set_d(viewproj.m(3,3) - viewproj.m(1,3));
+		planes_[2].set_a(viewproj.m(3,0) - viewproj.m(1,0));
+		planes_[2].set_b(viewproj.m(3,1) - viewproj.m(1,1));
+		planes_[2].set_c(viewproj.m(3,2) - viewproj.m(1,2));
+		planes_[2].set_d(viewproj.m(3,3) - viewproj.m(1,3));
 		// Bottom clipping plane
-		planes_[2].set_a(viewproj.m(3,0) + viewproj.m(1,0));
-		planes_[2].set_b(viewproj.m(3,1) + viewproj.m(1,1));
-		planes_[2].set_c(viewproj.m(3,2) + viewproj.m(1,2));
-		planes_[2].set_d(viewproj.m(3,3) + viewproj.m(1,3));
+		planes_[3].set_a(viewproj.m(3,0) + viewproj.m(1,0));
+		planes_[3].set_b(viewproj.m(3,1) + viewproj.m(1,1));
+		planes_[3].set_c(viewproj.m(3,2) + viewproj.m(1,2));
+		planes_[3].set_d(viewproj.m(3,3) + viewproj.m(1,3));
 		// Near clipping plane
-		planes_[3].set_a(viewproj.m(3,0) + viewproj.m(2,0));
-		planes_[3].set_b(viewproj.m(3,1) + viewproj.m(2,1));
-		planes_[3].set_c(viewproj.m(3,2) + viewproj.m(2,2));
-		planes_[3].set_d(viewproj.m(3,3) + viewproj.m(2,3));
+		planes_[4].set_a(viewproj.m(3,0) + viewproj.m(2,0));
+		planes_[4].set_b(viewproj.m(3,1) + viewproj.m(2,1));
+		planes_[4].set_c(viewproj.m(3,2) + viewproj.m(2,2));
+		planes_[4].set_d(viewproj.m(3,3) + viewproj.m(2,3));
 		// Far clipping plane
 		planes_[5].set_a(viewproj.m(3,0) - viewproj.m(2,0));
 		planes_[5].set_b(viewproj.m(3,1) - viewproj.m(2,1));
@@ -31,7 +31,20 @@ namespace gef
 	public:
 		FrustumIntersect Intersects(const Sphere& sphere) const;
 		FrustumIntersect Intersects(const Aabb& aabb) const;
+
+		/// A line segment is only reported as FI_OUT when both ends are behind the same plane,
+		/// so segments passing outside a corner of the frustum can come back as FI_INTERSECTS.
+		FrustumIntersect Intersects(const Vector4& start, const Vector4& end) const;
+
+		/// Planes of a gef view projection matrix, whose near plane is at clip space z/w of ndc_z_min,
+		/// e.g. platform.NdcZMin() for a projection made by the platform.
+		void ExtractPlanes(const Matrix44& viewproj, float ndc_z_min, bool normalise);
+
+		/// ExtractPlanes for a projection following the D3D convention, the near plane at z/w = 0.
 		void ExtractPlanesD3D(const Matrix44& viewproj, bool normalise);
+
+		/// For an OpenGL matrix in column vector layout, the transpose of gef's.
+		/// A gef matrix from PerspectiveFovGL needs ExtractPlanes with an ndc_z_min of -1 instead.
 		void ExtractPlanesGL(const Matrix44& viewproj, bool normalise);
 	protected:
 		Plane planes_[NUM_FRUSTUM_PLANES];
@@ -3,6 +3,10 @@
 
 namespace gef
 {
+	Plane::Plane()
+	{
+	}
+
 	Plane::Plane(float a, float b, float c, float d) :
 		Vector4(a, b, c, d)
 	{
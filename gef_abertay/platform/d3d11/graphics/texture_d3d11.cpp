@@ -2,6 +2,7 @@
 #include <platform/d3d11/system/platform_d3d11.h>
 #include <graphics/image_data.h>
 #include <gef.h>
+#include <vector>
 
 namespace gef
 {
@@ -26,12 +27,40 @@ TextureD3D11::TextureD3D11(const Platform& platform, const ImageData& image_data
 	device_context_(NULL),
 	Texture(platform, image_data)
 {
-	// get the size of the texture data
-	const UInt32 data_size = image_data.width()*image_data.height()*4;
-	image_data_buffer_ = new UInt8[data_size];
-	memcpy(image_data_buffer_, image_data.image(),data_size);
+	if(image_data.mip_count() > 1)
+	{
+		// the mip chain from the texture cache is uploaded as it is, the GPU copy is all that's kept
+		std::vector<D3D11_SUBRESOURCE_DATA> subresource_data(image_data.mip_count());
+		for(UInt32 level = 0; level < image_data.mip_count(); ++level)
+		{
+			subresource_data[level].pSysMem = image_data.image() + image_data.MipOffset(level);
+			subresource_data[level].SysMemPitch = ImageData::MipSize(image_data.width(), level)*4;
+			subresource_data[level].SysMemSlicePitch = 0;
+		}
+
+		D3D11_TEXTURE2D_DESC texture_desc;
+		texture_desc.Width = image_data.width();
+		texture_desc.Height = image_data.height();
+		texture_desc.MipLevels = image_data.mip_count();
+		texture_desc.ArraySize = 1;
+		texture_desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+		texture_desc.SampleDesc.Count = 1;
+		texture_desc.SampleDesc.Quality = 0;
+		texture_desc.Usage = D3D11_USAGE_DEFAULT;
+		texture_desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+		texture_desc.CPUAccessFlags = 0;
+		texture_desc.MiscFlags = 0;
+		CreateTexture(platform, texture_desc, &subresource_data[0]);
+	}
+	else
+	{
+		// get the size of the texture data
+		const UInt32 data_size = image_data.width()*image_data.height()*4;
+		image_data_buffer_ = new UInt8[data_size];
+		memcpy(image_data_buffer_, image_data.image(),data_size);
 
-	CreateTexture(platform, image_data.width(), image_data.height(), (UInt8*)image_data_buffer_, true);
+		CreateTexture(platform, image_data.width(), image_data.height(), (UInt8*)image_data_buffer_, true);
+	}
 
 	device_context_ = static_cast<const PlatformD3D11&>(platform).device_context();
 }
@@ -132,7 +161,7 @@ bool TextureD3D11::CreateTexture(const class Platform& platform, const D3D11_TEX
 		ZeroMemory(&desc_SRV, sizeof(D3D11_SHADER_RESOURCE_VIEW_DESC));
 		desc_SRV.Format = texture_desc.Format;
 		desc_SRV.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-		desc_SRV.Texture2D.MipLevels = 1;
+		desc_SRV.Texture2D.MipLevels = (UINT)-1;	// every level the texture has
 		hresult = platform_d3d.device()->CreateShaderResourceView(texture_, &desc_SRV, &shader_resource_view_);
 	}
 
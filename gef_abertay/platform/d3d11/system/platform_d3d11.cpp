@@ -483,6 +483,11 @@ namespace gef
 		return projection_matrix;
 	}
 
+	float PlatformD3D11::NdcZMin() const
+	{
+		return 0.0f;
+	}
+
 	void PlatformD3D11::BeginScene() const
 	{
 		ID3D11RenderTargetView* render_target_view = GetRenderTargetView();
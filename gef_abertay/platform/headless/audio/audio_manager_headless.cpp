@@ -0,0 +1,121 @@
+#include "audio_manager_headless.h"
+
+namespace gef
+{
+	AudioManager* AudioManager::Create()
+	{
+		return new AudioManagerHeadless();
+	}
+
+	AudioManagerHeadless::AudioManagerHeadless() :
+		play_sample_count_(0)
+	{
+	}
+
+	AudioManagerHeadless::~AudioManagerHeadless()
+	{
+		UnloadAllSamples();
+		UnloadMusic();
+	}
+
+	Int32 AudioManagerHeadless::LoadSample(const char *strFileName, const Platform& platform)
+	{
+		samples_.push_back(strFileName);
+		return (Int32)samples_.size() - 1;
+	}
+
+	Int32 AudioManagerHeadless::LoadMusic(const char *strFileName, const Platform& platform)
+	{
+		music_ = strFileName;
+		return 0;
+	}
+
+	void AudioManagerHeadless::UnloadMusic()
+	{
+		music_.clear();
+	}
+
+	void AudioManagerHeadless::UnloadSample(Int32 sample_num)
+	{
+		if (sample_num >= 0 && sample_num < (Int32)samples_.size())
+			samples_[sample_num].clear();
+	}
+
+	void AudioManagerHeadless::UnloadAllSamples()
+	{
+		samples_.clear();
+	}
+
+	Int32 AudioManagerHeadless::PlayMusic()
+	{
+		return music_.empty() ? -1 : 0;
+	}
+
+	Int32 AudioManagerHeadless::StopMusic()
+	{
+		return 0;
+	}
+
+	Int32 AudioManagerHeadless::PlaySample(const Int32 sample_index, const bool looping)
+	{
+		if (sample_index < 0 || sample_index >= (Int32)samples_.size() || samples_[sample_index].empty())
+			return -1;
+
+		// voices finish immediately so voice 0 is always free
+		++play_sample_count_;
+		return 0;
+	}
+
+	Int32 AudioManagerHeadless::StopPlayingSampleVoice(const Int32 voice_index)
+	{
+		return 0;
+	}
+
+	Int32 AudioManagerHeadless::SetSamplePitch(const Int32 voice_index, float pitch)
+	{
+		return 0;
+	}
+
+	Int32 AudioManagerHeadless::SetMusicPitch(float pitch)
+	{
+		return 0;
+	}
+
+	Int32 AudioManagerHeadless::GetSampleVoiceVolumeInfo(const Int32 voice_index, struct VolumeInfo& volume_info)
+	{
+		volume_info = VolumeInfo();
+		return 0;
+	}
+
+	Int32 AudioManagerHeadless::SetSampleVoiceVolumeInfo(const Int32 voice_index, const struct VolumeInfo& volume_info)
+	{
+		return 0;
+	}
+
+	Int32 AudioManagerHeadless::GetMusicVolumeInfo(struct VolumeInfo& volume_info)
+	{
+		volume_info = music_volume_info_;
+		return 0;
+	}
+
+	Int32 AudioManagerHeadless::SetMusicVolumeInfo(const struct VolumeInfo& volume_info)
+	{
+		music_volume_info_ = volume_info;
+		return 0;
+	}
+
+	Int32 AudioManagerHeadless::SetMasterVolume(float volume)
+	{
+		return 0;
+	}
+
+	bool AudioManagerHeadless::sample_voice_playing(const UInt32 voice_index)
+	{
+		return false;
+	}
+
+	bool AudioManagerHeadless::sample_voice_looping(const UInt32 voice_index)
+	{
+		return false;
+	}
+}
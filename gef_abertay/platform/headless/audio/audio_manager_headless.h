@@ -0,0 +1,49 @@
+#ifndef _GEF_AUDIO_MANAGER_HEADLESS_H
+#define _GEF_AUDIO_MANAGER_HEADLESS_H
+
+#include <audio/audio_manager.h>
+#include <vector>
+#include <string>
+
+namespace gef
+{
+	/// Keeps track of what was loaded and played without producing any sound
+	class AudioManagerHeadless : public AudioManager
+	{
+	public:
+		AudioManagerHeadless();
+		~AudioManagerHeadless();
+
+		Int32 LoadSample(const char *strFileName, const Platform& platform);
+		Int32 LoadMusic(const char *strFileName, const Platform& platform);
+		void UnloadMusic();
+		void UnloadSample(Int32 sample_num);
+		void UnloadAllSamples();
+
+		Int32 PlayMusic();
+		Int32 StopMusic();
+		Int32 PlaySample(const Int32 sample_index, const bool looping = false);
+		Int32 StopPlayingSampleVoice(const Int32 voice_index);
+
+		Int32 SetSamplePitch(const Int32 voice_index, float pitch);
+		Int32 SetMusicPitch(float pitch);
+		Int32 GetSampleVoiceVolumeInfo(const Int32 voice_index, struct VolumeInfo& volume_info);
+		Int32 SetSampleVoiceVolumeInfo(const Int32 voice_index, const struct VolumeInfo& volume_info);
+		Int32 GetMusicVolumeInfo(struct VolumeInfo& volume_info);
+		Int32 SetMusicVolumeInfo(const struct VolumeInfo& volume_info);
+		Int32 SetMasterVolume(float volume);
+
+		bool sample_voice_playing(const UInt32 voice_index);
+		bool sample_voice_looping(const UInt32 voice_index);
+
+		inline UInt32 play_sample_count() const { return play_sample_count_; }
+
+	private:
+		std::vector<std::string> samples_;
+		std::string music_;
+		VolumeInfo music_volume_info_;
+		UInt32 play_sample_count_;
+	};
+}
+
+#endif // _GEF_AUDIO_MANAGER_HEADLESS_H
@@ -0,0 +1,52 @@
+#include <platform/headless/graphics/index_buffer_headless.h>
+#include <cstdlib>
+#include <cstring>
+
+namespace gef
+{
+	IndexBuffer* IndexBuffer::Create(Platform& platform)
+	{
+		return new IndexBufferHeadless();
+	}
+
+	IndexBufferHeadless::IndexBufferHeadless() :
+		bind_count_(0)
+	{
+	}
+
+	IndexBufferHeadless::~IndexBufferHeadless()
+	{
+	}
+
+	bool IndexBufferHeadless::Init(const Platform& platform, const void* indices, const UInt32 num_indices, const UInt32 index_byte_size, const bool read_only)
+	{
+		num_indices_ = num_indices;
+		index_byte_size_ = index_byte_size;
+
+		if (read_only)
+			return true;
+
+		index_data_ = malloc(index_byte_size * num_indices);
+		if (!index_data_)
+			return false;
+
+		if (indices)
+			memcpy(index_data_, indices, index_byte_size * num_indices);
+
+		return true;
+	}
+
+	void IndexBufferHeadless::Bind(const Platform& platform) const
+	{
+		++bind_count_;
+	}
+
+	void IndexBufferHeadless::Unbind(const Platform& platform) const
+	{
+	}
+
+	bool IndexBufferHeadless::Update(const Platform& platform)
+	{
+		return index_data_ != NULL;
+	}
+}
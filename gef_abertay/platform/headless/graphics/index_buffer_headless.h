@@ -0,0 +1,25 @@
+#ifndef _GEF_INDEX_BUFFER_HEADLESS_H
+#define _GEF_INDEX_BUFFER_HEADLESS_H
+
+#include <graphics/index_buffer.h>
+
+namespace gef
+{
+	class IndexBufferHeadless : public IndexBuffer
+	{
+	public:
+		IndexBufferHeadless();
+		~IndexBufferHeadless();
+
+		bool Init(const Platform& platform, const void* indices, const UInt32 num_indices, const UInt32 index_byte_size, const bool read_only = true);
+		void Bind(const Platform& platform) const;
+		void Unbind(const Platform& platform) const;
+		bool Update(const Platform& platform);
+
+		inline UInt32 bind_count() const { return bind_count_; }
+	private:
+		mutable UInt32 bind_count_;
+	};
+}
+
+#endif // _GEF_INDEX_BUFFER_HEADLESS_H
@@ -0,0 +1,157 @@
+#include <platform/headless/graphics/renderer_3d_headless.h>
+#include <system/platform.h>
+#include <graphics/mesh_instance.h>
+#include <graphics/mesh.h>
+#include <graphics/primitive.h>
+#include <graphics/vertex_buffer.h>
+#include <graphics/index_buffer.h>
+#include <graphics/material.h>
+#include <graphics/shader_interface.h>
+
+namespace gef
+{
+	Renderer3D* Renderer3D::Create(Platform& platform)
+	{
+		return new Renderer3DHeadless(platform);
+	}
+
+	Renderer3DHeadless::Renderer3DHeadless(Platform& platform) :
+		Renderer3D(platform),
+		begin_count_(0),
+		draw_mesh_count_(0),
+		draw_primitive_count_(0),
+		index_count_(0),
+		fill_mode_(kSolid),
+		depth_test_(kLessEqual),
+		primitive_type_(TRIANGLE_LIST)
+	{
+		platform_.AddShader(&default_shader_);
+		shader_ = &default_shader_;
+	}
+
+	Renderer3DHeadless::~Renderer3DHeadless()
+	{
+		platform_.RemoveShader(&default_shader_);
+	}
+
+	void Renderer3DHeadless::ResetCounts()
+	{
+		begin_count_ = 0;
+		draw_mesh_count_ = 0;
+		draw_primitive_count_ = 0;
+		index_count_ = 0;
+	}
+
+	void Renderer3DHeadless::Begin(bool clear)
+	{
+		++begin_count_;
+
+		platform_.BeginScene();
+		if (clear)
+			platform_.Clear();
+	}
+
+	void Renderer3DHeadless::End()
+	{
+		platform_.EndScene();
+
+		set_clear_render_target_enabled(true);
+		set_clear_depth_buffer_enabled(true);
+		set_clear_stencil_buffer_enabled(true);
+	}
+
+	void Renderer3DHeadless::DrawMesh(const MeshInstance& mesh_instance)
+	{
+		// set up the shader data for default shader
+		if (shader_ == &default_shader_)
+			default_shader_.SetSceneData(default_shader_data_, view_matrix_, projection_matrix_);
+
+		const Mesh* mesh = mesh_instance.mesh();
+		if (mesh != NULL)
+		{
+			++draw_mesh_count_;
+			set_world_matrix(mesh_instance.transform());
+
+			if (mesh->vertex_buffer() && shader_)
+			{
+				shader_->SetMeshData(mesh_instance);
+				DrawPrimitives(*mesh);
+			}
+		}
+	}
+
+	void Renderer3DHeadless::DrawMesh(const Mesh& mesh, const gef::Matrix44& transform)
+	{
+		// set up the shader data for default shader
+		if (shader_ == &default_shader_)
+			default_shader_.SetSceneData(default_shader_data_, view_matrix_, projection_matrix_);
+
+		++draw_mesh_count_;
+		set_world_matrix(transform);
+
+		if (mesh.vertex_buffer() && shader_)
+		{
+			shader_->SetMeshData(transform);
+			DrawPrimitives(mesh);
+		}
+	}
+
+	void Renderer3DHeadless::DrawPrimitives(const Mesh& mesh)
+	{
+		const VertexBuffer* vertex_buffer = mesh.vertex_buffer();
+
+		shader_->device_interface()->UseProgram();
+		vertex_buffer->Bind(platform_);
+		shader_->device_interface()->SetVertexFormat();
+
+		for (UInt32 primitive_index = 0; primitive_index < mesh.num_primitives(); ++primitive_index)
+		{
+			const Primitive* primitive = mesh.GetPrimitive(primitive_index);
+			const IndexBuffer* index_buffer = primitive->index_buffer();
+			if (primitive->type() != UNDEFINED && index_buffer)
+			{
+				const Material* material;
+				if (override_material_)
+					material = override_material_;
+				else
+					material = primitive->material();
+
+				shader_->SetMaterialData(material);
+				shader_->device_interface()->SetVariableData();
+				shader_->device_interface()->BindTextureResources(platform_);
+
+				SetPrimitiveType(primitive->type());
+				int num_indices = index_buffer->num_indices() > 0 ? index_buffer->num_indices() : vertex_buffer->num_vertices();
+				index_buffer->Bind(platform_);
+				DrawPrimitive(index_buffer, num_indices);
+				index_buffer->Unbind(platform_);
+
+				shader_->device_interface()->UnbindTextureResources(platform_);
+			}
+		}
+
+		shader_->device_interface()->ClearVertexFormat();
+		vertex_buffer->Unbind(platform_);
+	}
+
+	void Renderer3DHeadless::SetFillMode(FillMode fill_mode)
+	{
+		fill_mode_ = fill_mode;
+	}
+
+	void Renderer3DHeadless::SetDepthTest(DepthTest depth_test)
+	{
+		depth_test_ = depth_test;
+	}
+
+	void Renderer3DHeadless::SetPrimitiveType(gef::PrimitiveType type)
+	{
+		primitive_type_ = type;
+	}
+
+	void Renderer3DHeadless::DrawPrimitive(const IndexBuffer* index_buffer, int num_indices)
+	{
+		++draw_primitive_count_;
+		index_count_ += num_indices;
+	}
+}
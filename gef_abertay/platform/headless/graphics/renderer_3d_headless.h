@@ -0,0 +1,51 @@
+#ifndef _GEF_RENDERER_3D_HEADLESS_H
+#define _GEF_RENDERER_3D_HEADLESS_H
+
+#include <graphics/renderer_3d.h>
+
+namespace gef
+{
+	/// Runs the same shader data setup as the hardware renderers so the CPU cost of
+	/// drawing is still measured, but submits nothing and counts the calls instead.
+	class Renderer3DHeadless : public Renderer3D
+	{
+	public:
+		Renderer3DHeadless(Platform& platform);
+		~Renderer3DHeadless();
+
+		void Begin(bool clear = true);
+		void End();
+
+		void DrawMesh(const MeshInstance& mesh_instance);
+		void DrawMesh(const Mesh& mesh, const gef::Matrix44& matrix);
+		void SetFillMode(FillMode fill_mode);
+		void SetDepthTest(DepthTest depth_test);
+		void SetPrimitiveType(gef::PrimitiveType type);
+		void DrawPrimitive(const IndexBuffer* index_buffer, int num_indices);
+
+		/// Set all the call counters back to zero
+		void ResetCounts();
+
+		inline UInt32 begin_count() const { return begin_count_; }
+		inline UInt32 draw_mesh_count() const { return draw_mesh_count_; }
+		inline UInt32 draw_primitive_count() const { return draw_primitive_count_; }
+		inline UInt64 index_count() const { return index_count_; }
+		inline FillMode fill_mode() const { return fill_mode_; }
+		inline DepthTest depth_test() const { return depth_test_; }
+		inline gef::PrimitiveType primitive_type() const { return primitive_type_; }
+
+	private:
+		void DrawPrimitives(const Mesh& mesh);
+
+		UInt32 begin_count_;
+		UInt32 draw_mesh_count_;
+		UInt32 draw_primitive_count_;
+		UInt64 index_count_;
+
+		FillMode fill_mode_;
+		DepthTest depth_test_;
+		gef::PrimitiveType primitive_type_;
+	};
+}
+
+#endif // _GEF_RENDERER_3D_HEADLESS_H
@@ -0,0 +1,62 @@
+#include <platform/headless/graphics/shader_interface_headless.h>
+#include <graphics/texture.h>
+
+namespace gef
+{
+	ShaderInterface* ShaderInterface::Create(const Platform& platform)
+	{
+		return new ShaderInterfaceHeadless();
+	}
+
+	ShaderInterfaceHeadless::ShaderInterfaceHeadless() :
+		use_program_count_(0),
+		set_variable_data_count_(0)
+	{
+	}
+
+	ShaderInterfaceHeadless::~ShaderInterfaceHeadless()
+	{
+	}
+
+	bool ShaderInterfaceHeadless::CreateProgram()
+	{
+		// shaders write their variables straight into this data, so it is still needed
+		AllocateVariableData();
+		return true;
+	}
+
+	void ShaderInterfaceHeadless::CreateVertexFormat()
+	{
+	}
+
+	void ShaderInterfaceHeadless::UseProgram()
+	{
+		++use_program_count_;
+	}
+
+	void ShaderInterfaceHeadless::SetVariableData()
+	{
+		++set_variable_data_count_;
+	}
+
+	void ShaderInterfaceHeadless::SetVertexFormat()
+	{
+	}
+
+	void ShaderInterfaceHeadless::ClearVertexFormat()
+	{
+	}
+
+	void ShaderInterfaceHeadless::BindTextureResources(const Platform& platform) const
+	{
+		for (std::vector<TextureSampler>::const_iterator sampler_iter = texture_samplers_.begin(); sampler_iter != texture_samplers_.end(); ++sampler_iter)
+		{
+			if (sampler_iter->texture)
+				sampler_iter->texture->Bind(platform, 0);
+		}
+	}
+
+	void ShaderInterfaceHeadless::UnbindTextureResources(const Platform& platform) const
+	{
+	}
+}
@@ -0,0 +1,36 @@
+#ifndef _GEF_SHADER_INTERFACE_HEADLESS_H
+#define _GEF_SHADER_INTERFACE_HEADLESS_H
+
+#include <graphics/shader_interface.h>
+
+namespace gef
+{
+	/// Keeps the CPU side variable data of a shader so shaders can be filled in as normal,
+	/// but never compiles or uploads anything.
+	class ShaderInterfaceHeadless : public ShaderInterface
+	{
+	public:
+		ShaderInterfaceHeadless();
+		~ShaderInterfaceHeadless();
+
+		bool CreateProgram();
+		void CreateVertexFormat();
+
+		void UseProgram();
+
+		void SetVariableData();
+		void SetVertexFormat();
+		void ClearVertexFormat();
+
+		void BindTextureResources(const Platform& platform) const;
+		void UnbindTextureResources(const Platform& platform) const;
+
+		inline UInt32 use_program_count() const { return use_program_count_; }
+		inline UInt32 set_variable_data_count() const { return set_variable_data_count_; }
+	private:
+		UInt32 use_program_count_;
+		UInt32 set_variable_data_count_;
+	};
+}
+
+#endif // _GEF_SHADER_INTERFACE_HEADLESS_H
@@ -0,0 +1,69 @@
+#include <platform/headless/graphics/sprite_renderer_headless.h>
+#include <system/platform.h>
+#include <graphics/sprite.h>
+#include <graphics/shader_interface.h>
+
+namespace gef
+{
+	SpriteRenderer* SpriteRenderer::Create(Platform& platform)
+	{
+		return new SpriteRendererHeadless(platform);
+	}
+
+	SpriteRendererHeadless::SpriteRendererHeadless(Platform& platform) :
+		SpriteRenderer(platform),
+		begin_count_(0),
+		sprite_count_(0)
+	{
+		platform_.AddShader(&default_shader_);
+		shader_ = &default_shader_;
+
+		projection_matrix_ = platform_.OrthographicFrustum(0.0f, (float)platform_.width(), 0.0f, (float)platform_.height(), -1.0f, 1.0f);
+	}
+
+	SpriteRendererHeadless::~SpriteRendererHeadless()
+	{
+		platform_.RemoveShader(&default_shader_);
+	}
+
+	void SpriteRendererHeadless::ResetCounts()
+	{
+		begin_count_ = 0;
+		sprite_count_ = 0;
+	}
+
+	void SpriteRendererHeadless::Begin(bool clear)
+	{
+		++begin_count_;
+
+		platform_.BeginScene();
+		if (clear)
+			platform_.Clear();
+
+		if (shader_)
+		{
+			shader_->device_interface()->UseProgram();
+			shader_->device_interface()->SetVertexFormat();
+		}
+	}
+
+	void SpriteRendererHeadless::DrawSprite(const Sprite& sprite, const gef::Matrix33& transform)
+	{
+		if (shader_ == &default_shader_)
+		{
+			default_shader_.SetSpriteData(sprite, transform, sprite.texture() ? sprite.texture() : platform_.default_texture());
+			default_shader_.device_interface()->SetVariableData();
+			default_shader_.device_interface()->BindTextureResources(platform_);
+		}
+
+		++sprite_count_;
+
+		if (shader_ == &default_shader_)
+			default_shader_.device_interface()->UnbindTextureResources(platform_);
+	}
+
+	void SpriteRendererHeadless::End()
+	{
+		platform_.EndScene();
+	}
+}
@@ -0,0 +1,32 @@
+#ifndef _GEF_SPRITE_RENDERER_HEADLESS_H
+#define _GEF_SPRITE_RENDERER_HEADLESS_H
+
+#include <graphics/sprite_renderer.h>
+
+namespace gef
+{
+	class Platform;
+
+	class SpriteRendererHeadless : public SpriteRenderer
+	{
+	public:
+		SpriteRendererHeadless(Platform& platform);
+		~SpriteRendererHeadless();
+
+		void Begin(bool clear = true);
+		void DrawSprite(const Sprite& sprite, const gef::Matrix33& transform);
+		void End();
+
+		/// Set all the call counters back to zero
+		void ResetCounts();
+
+		inline UInt32 begin_count() const { return begin_count_; }
+		inline UInt32 sprite_count() const { return sprite_count_; }
+
+	private:
+		UInt32 begin_count_;
+		UInt32 sprite_count_;
+	};
+}
+
+#endif // _GEF_SPRITE_RENDERER_HEADLESS_H
@@ -0,0 +1,32 @@
+#include <platform/headless/graphics/texture_headless.h>
+#include <graphics/image_data.h>
+
+namespace gef
+{
+	Texture* Texture::Create(const Platform& platform, const ImageData& image_data)
+	{
+		return new TextureHeadless(platform, image_data);
+	}
+
+	// the image data isn't kept, only the dimensions
+	TextureHeadless::TextureHeadless(const Platform& platform, const ImageData& image_data) :
+		Texture(platform, image_data),
+		width_(image_data.width()),
+		height_(image_data.height()),
+		bind_count_(0)
+	{
+	}
+
+	TextureHeadless::~TextureHeadless()
+	{
+	}
+
+	void TextureHeadless::Bind(const Platform& platform, const int texture_stage_num) const
+	{
+		++bind_count_;
+	}
+
+	void TextureHeadless::Unbind(const Platform& platform, const int texture_stage_num) const
+	{
+	}
+}
@@ -0,0 +1,29 @@
+#ifndef _GEF_TEXTURE_HEADLESS_H
+#define _GEF_TEXTURE_HEADLESS_H
+
+#include <graphics/texture.h>
+
+namespace gef
+{
+
+class TextureHeadless : public Texture
+{
+public:
+	TextureHeadless(const Platform& platform, const ImageData& image_data);
+	~TextureHeadless();
+
+	void Bind(const Platform& platform, const int texture_stage_num) const;
+	void Unbind(const Platform& platform, const int texture_stage_num) const;
+
+	inline UInt32 width() const { return width_; }
+	inline UInt32 height() const { return height_; }
+	inline UInt32 bind_count() const { return bind_count_; }
+
+private:
+	UInt32 width_;
+	UInt32 height_;
+	mutable UInt32 bind_count_;
+};
+
+}
+#endif // _GEF_TEXTURE_HEADLESS_H
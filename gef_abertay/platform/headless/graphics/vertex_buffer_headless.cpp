@@ -0,0 +1,56 @@
+#include <platform/headless/graphics/vertex_buffer_headless.h>
+#include <cstdlib>
+#include <cstring>
+
+namespace gef
+{
+	VertexBuffer* VertexBuffer::Create(Platform& platform)
+	{
+		return new VertexBufferHeadless();
+	}
+
+	VertexBufferHeadless::VertexBufferHeadless() :
+		update_count_(0),
+		bind_count_(0)
+	{
+	}
+
+	VertexBufferHeadless::~VertexBufferHeadless()
+	{
+	}
+
+	bool VertexBufferHeadless::Init(const Platform& platform, const void* vertices, const UInt32 num_vertices, const UInt32 vertex_byte_size, const bool read_only)
+	{
+		num_vertices_ = num_vertices;
+		vertex_byte_size_ = vertex_byte_size;
+
+		// there is no device copy of read only buffers, so they don't need to be kept either
+		if (read_only)
+			return true;
+
+		// take a copy of the vertex data so dynamic buffers can be written to through vertex_data()
+		vertex_data_ = malloc(vertex_byte_size * num_vertices);
+		if (!vertex_data_)
+			return false;
+
+		if (vertices)
+			memcpy(vertex_data_, vertices, vertex_byte_size * num_vertices);
+
+		return true;
+	}
+
+	bool VertexBufferHeadless::Update(const Platform& platform)
+	{
+		++update_count_;
+		return vertex_data_ != NULL;
+	}
+
+	void VertexBufferHeadless::Bind(const Platform& platform) const
+	{
+		++bind_count_;
+	}
+
+	void VertexBufferHeadless::Unbind(const Platform& platform) const
+	{
+	}
+}
@@ -0,0 +1,27 @@
+#ifndef _GEF_VERTEX_BUFFER_HEADLESS_H
+#define _GEF_VERTEX_BUFFER_HEADLESS_H
+
+#include <graphics/vertex_buffer.h>
+
+namespace gef
+{
+	class VertexBufferHeadless : public VertexBuffer
+	{
+	public:
+		VertexBufferHeadless();
+		~VertexBufferHeadless();
+		bool Init(const Platform& platform, const void* vertices, const UInt32 num_vertices, const UInt32 vertex_byte_size, const bool read_only = true);
+		bool Update(const Platform& platform);
+
+		void Bind(const Platform& platform) const;
+		void Unbind(const Platform& platform) const;
+
+		inline UInt32 update_count() const { return update_count_; }
+		inline UInt32 bind_count() const { return bind_count_; }
+	private:
+		UInt32 update_count_;
+		mutable UInt32 bind_count_;
+	};
+}
+
+#endif // _GEF_VERTEX_BUFFER_HEADLESS_H
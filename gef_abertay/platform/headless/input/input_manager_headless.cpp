@@ -0,0 +1,37 @@
+#include "input_manager_headless.h"
+#include "touch_input_manager_headless.h"
+#include "keyboard_headless.h"
+#include <system/platform.h>
+
+namespace gef
+{
+	InputManager* InputManager::Create(Platform& platform)
+	{
+		return new InputManagerHeadless(platform);
+	}
+
+	InputManagerHeadless::InputManagerHeadless(Platform& platform)
+		: InputManager(platform)
+		, platform_(platform)
+		, update_count_(0)
+	{
+		// there are no devices to poll, but apps expect a mouse and keyboard to query
+		touch_manager_ = new TouchInputManagerHeadless();
+		platform.set_touch_input_manager(touch_manager_);
+		keyboard_ = new KeyboardHeadless();
+	}
+
+	InputManagerHeadless::~InputManagerHeadless()
+	{
+		delete touch_manager_;
+		platform_.set_touch_input_manager(NULL);
+
+		delete keyboard_;
+	}
+
+	void InputManagerHeadless::Update()
+	{
+		++update_count_;
+		InputManager::Update();
+	}
+}
@@ -0,0 +1,26 @@
+#ifndef _GEF_INPUT_MANAGER_HEADLESS_H
+#define _GEF_INPUT_MANAGER_HEADLESS_H
+
+#include <input/input_manager.h>
+
+namespace gef
+{
+	class Platform;
+
+	class InputManagerHeadless : public InputManager
+	{
+	public:
+		InputManagerHeadless(Platform& platform);
+		~InputManagerHeadless();
+
+		void Update();
+
+		inline unsigned int update_count() const { return update_count_; }
+
+	private:
+		Platform& platform_;
+		unsigned int update_count_;
+	};
+}
+
+#endif // _GEF_INPUT_MANAGER_HEADLESS_H
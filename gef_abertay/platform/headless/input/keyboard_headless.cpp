@@ -0,0 +1,16 @@
+#include "keyboard_headless.h"
+
+namespace gef
+{
+	KeyboardHeadless::KeyboardHeadless()
+	{
+	}
+
+	KeyboardHeadless::~KeyboardHeadless()
+	{
+	}
+
+	void KeyboardHeadless::Update()
+	{
+	}
+}
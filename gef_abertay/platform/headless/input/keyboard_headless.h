@@ -0,0 +1,19 @@
+#ifndef _GEF_INPUT_KEYBOARD_HEADLESS_H
+#define _GEF_INPUT_KEYBOARD_HEADLESS_H
+
+#include <input/keyboard.h>
+
+namespace gef
+{
+	/// A keyboard with no keys ever held down
+	class KeyboardHeadless : public Keyboard
+	{
+	public:
+		KeyboardHeadless();
+		~KeyboardHeadless();
+
+		void Update();
+	};
+}
+
+#endif // _GEF_INPUT_KEYBOARD_HEADLESS_H
@@ -0,0 +1,32 @@
+#include "touch_input_manager_headless.h"
+
+namespace gef
+{
+	TouchInputManagerHeadless::TouchInputManagerHeadless() :
+		mouse_position_(0.0f, 0.0f),
+		mouse_rel_(0.0f, 0.0f, 0.0f)
+	{
+		panels_.resize(max_num_panels());
+		panel_enabled_[0] = false;
+	}
+
+	TouchInputManagerHeadless::~TouchInputManagerHeadless()
+	{
+	}
+
+	void TouchInputManagerHeadless::Update()
+	{
+		CleanupReleasedTouches();
+	}
+
+	void TouchInputManagerHeadless::EnablePanel(const Int32 panel_index)
+	{
+		panel_enabled_[panel_index] = true;
+	}
+
+	void TouchInputManagerHeadless::DisablePanel(const Int32 panel_index)
+	{
+		panel_enabled_[panel_index] = false;
+		panels_[panel_index].clear();
+	}
+}
@@ -0,0 +1,33 @@
+#ifndef _GEF_TOUCH_INPUT_MANAGER_HEADLESS_H
+#define _GEF_TOUCH_INPUT_MANAGER_HEADLESS_H
+
+#include <input/touch_input_manager.h>
+
+namespace gef
+{
+	/// A single panel mouse that stays at the origin with no buttons pressed
+	class TouchInputManagerHeadless : public TouchInputManager
+	{
+	public:
+		TouchInputManagerHeadless();
+		~TouchInputManagerHeadless();
+
+		void Update();
+
+		void EnablePanel(const Int32 panel_index);
+		void DisablePanel(const Int32 panel_index);
+		const Int32 max_num_panels() const { return 1; }
+		const bool panel_enabled(const Int32 panel_index) const { return panel_enabled_[panel_index]; }
+
+		inline const gef::Vector2 mouse_position() const { return mouse_position_; }
+		inline const gef::Vector4 mouse_rel() const { return mouse_rel_; }
+		inline bool is_button_down(Int32 button_num) const { return false; }
+
+	private:
+		bool panel_enabled_[1];
+		gef::Vector2 mouse_position_;
+		gef::Vector4 mouse_rel_;
+	};
+}
+
+#endif // _GEF_TOUCH_INPUT_MANAGER_HEADLESS_H
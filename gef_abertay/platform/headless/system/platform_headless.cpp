@@ -0,0 +1,131 @@
+#include <platform/headless/system/platform_headless.h>
+#include <graphics/texture.h>
+#include <maths/matrix44.h>
+#include <chrono>
+
+namespace gef
+{
+	PlatformHeadless::PlatformHeadless(UInt32 width, UInt32 height, UInt32 max_frames) :
+		clock_last_frame_(0),
+		frame_count_(0),
+		max_frames_(max_frames),
+		clear_count_(0),
+		begin_scene_count_(0)
+	{
+		set_width(width);
+		set_height(height);
+		set_depth_clear_value(1.0f);
+		set_stencil_clear_value(0);
+
+		// create default texture
+		default_texture_ = Texture::CreateCheckerTexture(16, 1, *this);
+		AddTexture(default_texture_);
+	}
+
+	PlatformHeadless::~PlatformHeadless()
+	{
+		Release();
+	}
+
+	void PlatformHeadless::Release()
+	{
+		if (default_texture_)
+		{
+			RemoveTexture(default_texture_);
+			delete default_texture_;
+			default_texture_ = NULL;
+		}
+	}
+
+	bool PlatformHeadless::Update()
+	{
+		// there is no window to close, so the frame limit is the only way to stop the application
+		++frame_count_;
+		return (max_frames_ == 0) || (frame_count_ <= max_frames_);
+	}
+
+	float PlatformHeadless::GetFrameTime()
+	{
+		// calculate the time between updates
+		// steady_clock is monotonic so wall clock adjustments can't produce negative frame times
+		UInt64 clock = (UInt64)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		if(clock_last_frame_ == 0)
+			clock_last_frame_ = clock;
+
+		UInt64 elapsed = clock - clock_last_frame_;
+		clock_last_frame_ = clock;
+
+		return (float)((double)elapsed * 1.0e-9);
+	}
+
+	void PlatformHeadless::PreRender()
+	{
+	}
+
+	void PlatformHeadless::PostRender()
+	{
+	}
+
+	void PlatformHeadless::Clear() const
+	{
+		++clear_count_;
+	}
+
+	std::string PlatformHeadless::FormatFilename(const std::string& filename) const
+	{
+		return filename;
+	}
+
+	std::string PlatformHeadless::FormatFilename(const char* filename) const
+	{
+		return std::string(filename);
+	}
+
+	// use the D3D conventions so applications can keep their ndc_zmin of 0
+	Matrix44 PlatformHeadless::PerspectiveProjectionFov(const float fov, const float aspect_ratio, const float near_distance, const float far_distance) const
+	{
+		Matrix44 projection_matrix;
+		projection_matrix.PerspectiveFovD3D(fov, aspect_ratio, near_distance, far_distance);
+		return projection_matrix;
+	}
+
+	Matrix44 PlatformHeadless::PerspectiveProjectionFrustum(const float left, const float right, const float top, const float bottom, const float near_distance, const float far_distance) const
+	{
+		Matrix44 projection_matrix;
+		projection_matrix.PerspectiveFrustumD3D(left, right, top, bottom, near_distance, far_distance);
+		return projection_matrix;
+	}
+
+	Matrix44 PlatformHeadless::OrthographicFrustum(const float left, const float right, const float top, const float bottom, const float near_distance, const float far_distance) const
+	{
+		Matrix44 projection_matrix;
+		projection_matrix.OrthographicFrustumD3D(left, right, top, bottom, near_distance, far_distance);
+		return projection_matrix;
+	}
+
+	float PlatformHeadless::NdcZMin() const
+	{
+		return 0.0f;
+	}
+
+	void PlatformHeadless::BeginScene() const
+	{
+		++begin_scene_count_;
+	}
+
+	void PlatformHeadless::EndScene() const
+	{
+	}
+
+	// shaders are never compiled, but the default shaders still load their source
+	// so point them at the d3d11 sources that every application's media folder already has
+	const char* PlatformHeadless::GetShaderDirectory() const
+	{
+		return "d3d11";
+	}
+
+	const char* PlatformHeadless::GetShaderFileExtension() const
+	{
+		return "hlsl";
+	}
+}
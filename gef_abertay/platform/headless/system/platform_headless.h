@@ -0,0 +1,58 @@
+#ifndef _GEF_PLATFORM_HEADLESS_H
+#define _GEF_PLATFORM_HEADLESS_H
+
+#include <system/platform.h>
+
+namespace gef
+{
+	/// A platform with no window, graphics device or input devices.
+	/// Everything that would touch hardware is a no-op that records how many times it was called,
+	/// so the animation, IK and scene loading code can be run and profiled on machines without a GPU.
+	class PlatformHeadless : public Platform
+	{
+	public:
+		/// @param[in] width		The width reported for the virtual back buffer.
+		/// @param[in] height		The height reported for the virtual back buffer.
+		/// @param[in] max_frames	The number of frames Update will allow before returning false [0 = run forever].
+		PlatformHeadless(UInt32 width, UInt32 height, UInt32 max_frames = 0);
+		~PlatformHeadless();
+
+		bool Update();
+		float GetFrameTime();
+		void PreRender();
+		void PostRender();
+		void Clear() const;
+
+		std::string FormatFilename(const std::string& filename) const;
+		std::string FormatFilename(const char* filename) const;
+
+		Matrix44 PerspectiveProjectionFov(const float fov, const float aspect_ratio, const float near_distance, const float far_distance) const;
+		Matrix44 PerspectiveProjectionFrustum(const float left, const float right, const float top, const float bottom, const float near_distance, const float far_distance) const;
+		Matrix44 OrthographicFrustum(const float left, const float right, const float top, const float bottom, const float near_distance, const float far_distance) const;
+		float NdcZMin() const;
+
+		void BeginScene() const;
+		void EndScene() const;
+		const char* GetShaderDirectory() const;
+		const char* GetShaderFileExtension() const;
+
+		inline UInt32 frame_count() const { return frame_count_; }
+		inline UInt32 max_frames() const { return max_frames_; }
+		inline void set_max_frames(UInt32 max_frames) { max_frames_ = max_frames; }
+		inline UInt32 clear_count() const { return clear_count_; }
+		inline UInt32 begin_scene_count() const { return begin_scene_count_; }
+
+	private:
+		void Release();
+
+		UInt64 clock_last_frame_;
+		UInt32 frame_count_;
+		UInt32 max_frames_;
+
+		// BeginScene, EndScene and Clear are const in the Platform interface
+		mutable UInt32 clear_count_;
+		mutable UInt32 begin_scene_count_;
+	};
+}
+
+#endif // _GEF_PLATFORM_HEADLESS_H
@@ -89,4 +89,14 @@ namespace gef
         return (stat (filename, &buffer) == 0);
     }
 
+    bool FileStd::GetModifiedTime(const char* const filename, UInt64& modified_time)
+    {
+        struct stat buffer;
+        if (stat(filename, &buffer) != 0)
+            return false;
+
+        modified_time = (UInt64)buffer.st_mtime;
+        return true;
+    }
+
 }
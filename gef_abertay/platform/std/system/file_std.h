@@ -30,6 +30,7 @@ namespace gef
 		bool GetSize(Int32 &size);
 
         bool Exists(const char *const filename) override;
+        bool GetModifiedTime(const char* const filename, UInt64& modified_time) override;
 
     private:
 		FILE* file_handle_;
@@ -0,0 +1,60 @@
+#include "mapped_file_std.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace gef
+{
+	MappedFile* MappedFile::Create()
+	{
+		return new MappedFileStd();
+	}
+
+	MappedFileStd::MappedFileStd()
+	{
+	}
+
+	MappedFileStd::~MappedFileStd()
+	{
+		Close();
+	}
+
+	bool MappedFileStd::Open(const char* const filename)
+	{
+		Close();
+
+		int file_descriptor = open(filename, O_RDONLY);
+		if (file_descriptor < 0)
+			return false;
+
+		struct stat file_stat;
+		bool success = fstat(file_descriptor, &file_stat) == 0 && file_stat.st_size > 0;
+		if (success)
+		{
+			// private mapping so writes go to copies of the pages
+			void* data = mmap(NULL, file_stat.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file_descriptor, 0);
+			success = data != MAP_FAILED;
+			if (success)
+			{
+				data_ = data;
+				size_ = (Int32)file_stat.st_size;
+			}
+		}
+
+		// the mapping stays valid after the file is closed
+		close(file_descriptor);
+
+		return success;
+	}
+
+	void MappedFileStd::Close()
+	{
+		if (data_)
+		{
+			munmap(data_, size_);
+			data_ = NULL;
+			size_ = 0;
+		}
+	}
+}
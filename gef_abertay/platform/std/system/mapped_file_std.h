@@ -0,0 +1,19 @@
+#ifndef _GEF_MAPPED_FILE_STD_H
+#define _GEF_MAPPED_FILE_STD_H
+
+#include <system/mapped_file.h>
+
+namespace gef
+{
+	class MappedFileStd : public MappedFile
+	{
+	public:
+		MappedFileStd();
+		~MappedFileStd();
+
+		bool Open(const char* const filename);
+		void Close();
+	};
+}
+
+#endif // _GEF_MAPPED_FILE_STD_H
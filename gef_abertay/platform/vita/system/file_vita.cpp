@@ -88,6 +88,12 @@ bool FileVita::Exists(const char* const filename)
 	return true;
 }
 
+bool FileVita::GetModifiedTime(const char* const filename, UInt64& modified_time)
+{
+	// not yet implemented, data on the vita is built offline
+	return false;
+}
+
 bool FileVita::Close()
 {
 	bool success = true;
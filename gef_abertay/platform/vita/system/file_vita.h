@@ -23,6 +23,7 @@ public:
 	bool Read(void *buffer, const Int32 size, const Int32 offset, Int32& bytes_read);
 	bool Close();
 	bool GetSize(Int32 &size);
+	bool GetModifiedTime(const char* const filename, UInt64& modified_time);
 
 
 
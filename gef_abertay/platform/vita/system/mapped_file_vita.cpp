@@ -0,0 +1,60 @@
+#include <platform/vita/system/mapped_file_vita.h>
+#include <system/file.h>
+#include <cstdlib>
+
+namespace gef
+{
+	MappedFile* MappedFile::Create()
+	{
+		return new MappedFileVita();
+	}
+
+	MappedFileVita::MappedFileVita()
+	{
+	}
+
+	MappedFileVita::~MappedFileVita()
+	{
+		Close();
+	}
+
+	bool MappedFileVita::Open(const char* const filename)
+	{
+		Close();
+
+		File* file = File::Create();
+		bool success = file->Open(filename);
+		if (success)
+		{
+			Int32 file_size = 0;
+			success = file->GetSize(file_size) && file_size > 0;
+			if (success)
+			{
+				data_ = malloc(file_size);
+				success = data_ != NULL;
+			}
+
+			if (success)
+			{
+				Int32 bytes_read = 0;
+				success = file->Read(data_, file_size, bytes_read) && bytes_read == file_size;
+				size_ = file_size;
+			}
+
+			file->Close();
+		}
+		delete file;
+
+		if (!success)
+			Close();
+
+		return success;
+	}
+
+	void MappedFileVita::Close()
+	{
+		free(data_);
+		data_ = NULL;
+		size_ = 0;
+	}
+}
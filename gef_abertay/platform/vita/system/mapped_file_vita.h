@@ -0,0 +1,20 @@
+#ifndef _GEF_MAPPED_FILE_VITA_H
+#define _GEF_MAPPED_FILE_VITA_H
+
+#include <system/mapped_file.h>
+
+namespace gef
+{
+	// there is no file mapping, so the whole file is read into memory instead
+	class MappedFileVita : public MappedFile
+	{
+	public:
+		MappedFileVita();
+		~MappedFileVita();
+
+		bool Open(const char* const filename);
+		void Close();
+	};
+}
+
+#endif // _GEF_MAPPED_FILE_VITA_H
@@ -1037,6 +1037,11 @@ buffers before starting the next frame.
         return projection_matrix;
     }
 
+    float PlatformVita::NdcZMin() const
+    {
+        return -1.0f;
+    }
+
     RenderTarget* PlatformVita::CreateRenderTarget(const Int32 width, const Int32 height) const
     {
         //		return new RenderTargetVita(*this, width, height);
@@ -99,6 +99,7 @@ namespace gef
 		Matrix44 PerspectiveProjectionFov(const float fov, const float aspect_ratio, const float near_distance, const float far_distance) const;
 		Matrix44 PerspectiveProjectionFrustum(const float left, const float right, const float top, const float bottom, const float near_distance, const float far_distance) const;
 		Matrix44 OrthographicFrustum(const float left, const float right, const float top, const float bottom, const float near_distance, const float far_distance) const;
+		float NdcZMin() const;
 
 		SceGxmShaderPatcherId RegisterShaderProgram(const SceGxmProgram* program);
 		void DrawClearScreen() const;
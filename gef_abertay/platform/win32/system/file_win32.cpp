@@ -53,6 +53,16 @@ namespace gef
 		return found ;
 	}
 
+	bool FileWin32::GetModifiedTime(const char* const filename, UInt64& modified_time)
+	{
+		WIN32_FILE_ATTRIBUTE_DATA attribute_data;
+		if (!GetFileAttributesEx(filename, GetFileExInfoStandard, &attribute_data))
+			return false;
+
+		modified_time = ((UInt64)attribute_data.ftLastWriteTime.dwHighDateTime << 32) | attribute_data.ftLastWriteTime.dwLowDateTime;
+		return true;
+	}
+
 
 	bool FileWin32::Close()
 	{
@@ -0,0 +1,63 @@
+#include <platform/win32/system/mapped_file_win32.h>
+#include <Windows.h>
+
+namespace gef
+{
+	MappedFile* MappedFile::Create()
+	{
+		return new MappedFileWin32();
+	}
+
+	MappedFileWin32::MappedFileWin32()
+	{
+	}
+
+	MappedFileWin32::~MappedFileWin32()
+	{
+		Close();
+	}
+
+	bool MappedFileWin32::Open(const char* const filename)
+	{
+		Close();
+
+		HANDLE file_handle = CreateFile(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (file_handle == INVALID_HANDLE_VALUE)
+			return false;
+
+		bool success = false;
+		LARGE_INTEGER file_size;
+		if (GetFileSizeEx(file_handle, &file_size) && file_size.QuadPart > 0)
+		{
+			// copy on write so writes go to copies of the pages
+			HANDLE mapping_handle = CreateFileMapping(file_handle, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+			if (mapping_handle)
+			{
+				void* data = MapViewOfFile(mapping_handle, FILE_MAP_COPY, 0, 0, 0);
+				if (data)
+				{
+					data_ = data;
+					size_ = static_cast<Int32>(file_size.LowPart);
+					success = true;
+				}
+
+				// the view keeps the mapping open
+				CloseHandle(mapping_handle);
+			}
+		}
+
+		CloseHandle(file_handle);
+
+		return success;
+	}
+
+	void MappedFileWin32::Close()
+	{
+		if (data_)
+		{
+			UnmapViewOfFile(data_);
+			data_ = NULL;
+			size_ = 0;
+		}
+	}
+}
@@ -0,0 +1,19 @@
+#ifndef _GEF_MAPPED_FILE_WIN32_H
+#define _GEF_MAPPED_FILE_WIN32_H
+
+#include <system/mapped_file.h>
+
+namespace gef
+{
+	class MappedFileWin32 : public MappedFile
+	{
+	public:
+		MappedFileWin32();
+		~MappedFileWin32();
+
+		bool Open(const char* const filename);
+		void Close();
+	};
+}
+
+#endif // _GEF_MAPPED_FILE_WIN32_H
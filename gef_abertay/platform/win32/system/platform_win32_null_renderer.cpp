@@ -71,6 +71,11 @@ namespace gef
 		return projection_matrix;
 	}
 
+	float PlatformWin32NullRenderer::NdcZMin() const
+	{
+		return 0.0f;
+	}
+
 	void PlatformWin32NullRenderer::BeginScene() const
 	{
 	}
@@ -1,12 +1,18 @@
 #include <system/application.h>
 #include <system/platform.h>
+#include <system/profiler.h>
+#include <system/memory_tracker.h>
 
 namespace gef
 {
 
 Application::Application(Platform& platform) :
 	platform_(platform),
-	running_(true)
+	running_(true),
+	fixed_time_step_(0.0f),
+	time_accumulator_(0.0f),
+	interpolation_alpha_(1.0f),
+	real_frame_time_(0.0f)
 {
 }
 
@@ -22,6 +28,9 @@ void Application::Run()
 	const float kTargetFrameTime = 1.0f / 60.0f;
 	const float kTooLargeFrameTime = 1.0f / 10.f;
 
+	// limit on fixed updates in one frame so a slow update can't keep the loop from ever rendering
+	const int kMaxFixedUpdatesPerFrame = 5;
+
 	// start off assuming target frame rate
 	
 	// as this is the first frame there is no previous
@@ -34,9 +43,13 @@ void Application::Run()
 
 	while(running_)
 	{
+		MemoryTracker::NewFrame();
+
 		running_ = platform_.Update();
 		if(running_)
 		{
+			real_frame_time_ = previous_frame_time;
+
 			// check to see if frame time is too large
 			// if it is we need use the target frame rate 
 			// as using a large frame time compound any frame rate drop
@@ -44,11 +57,37 @@ void Application::Run()
 				previous_frame_time = kTargetFrameTime;
 
 			// UPDATE
-			running_ = Update(previous_frame_time);
+			if(fixed_time_step_ > 0.0f)
+			{
+				// step the simulation in fixed increments of the real time that has passed
+				// whatever is left over is used to interpolate between the last two updates when rendering
+				time_accumulator_ += previous_frame_time;
+
+				int num_updates = 0;
+				while(running_ && time_accumulator_ >= fixed_time_step_ && num_updates < kMaxFixedUpdatesPerFrame)
+				{
+					GEF_PROFILE_ZONE("Application::Update");
+					running_ = Update(fixed_time_step_);
+					time_accumulator_ -= fixed_time_step_;
+					++num_updates;
+				}
+
+				// fallen too far behind, drop the time that couldn't be simulated
+				if(time_accumulator_ >= fixed_time_step_)
+					time_accumulator_ = 0.0f;
+
+				interpolation_alpha_ = time_accumulator_ / fixed_time_step_;
+			}
+			else
+			{
+				GEF_PROFILE_ZONE("Application::Update");
+				running_ = Update(previous_frame_time);
+			}
 
 			// RENDER
 			if(platform_.ReadyToRender())
 			{
+				GEF_PROFILE_ZONE("Application::Render");
 				platform_.PreRender();
 				Render();
 				platform_.PostRender();
@@ -20,10 +20,24 @@ namespace gef
 
 		inline Platform& platform() { return platform_; }
 
+		/// Run Update at a fixed rate, e.g. 1.0f / 30.0f. Zero (the default) passes the real frame time to Update
+		inline void set_fixed_time_step(float time_step) { fixed_time_step_ = time_step; time_accumulator_ = 0.0f; interpolation_alpha_ = 1.0f; }
+		inline float fixed_time_step() const { return fixed_time_step_; }
+
+		/// How far between the last two fixed updates the current render is, from 0 to 1
+		inline float interpolation_alpha() const { return interpolation_alpha_; }
+
+		/// Real time the previous frame took, even when Update is passed the fixed time step or a clamped frame time
+		inline float real_frame_time() const { return real_frame_time_; }
+
 	protected:
 		class Platform& platform_;
 	private:
 		bool running_;
+		float fixed_time_step_;
+		float time_accumulator_;
+		float interpolation_alpha_;
+		float real_frame_time_;
 	};
 }
 
@@ -1,9 +1,64 @@
 #include <system/crc.h>
 #include <string.h>
-#include <cctype>
 
 namespace gef
 {
+	// gf bit reversed, the form the residual is clocked with
+	static const UInt32 kReflectedGenerator = 0xedb88320;
+
+	// tables[0] advances the residual over one byte, tables[n] over a byte followed by n zero bytes
+	struct CRCTables
+	{
+		CRCTables()
+		{
+			for (UInt32 byte = 0; byte < 256; ++byte)
+			{
+				UInt32 r = byte;
+				for (Int32 bit = 0; bit < 8; ++bit)
+					r = (r >> 1) ^ (kReflectedGenerator & (0u - (r & 1)));
+				tables[0][byte] = r;
+			}
+
+			for (Int32 table_num = 1; table_num < 8; ++table_num)
+			{
+				for (UInt32 byte = 0; byte < 256; ++byte)
+				{
+					const UInt32 r = tables[table_num - 1][byte];
+					tables[table_num][byte] = (r >> 8) ^ tables[0][r & 0xff];
+				}
+			}
+		}
+
+		UInt32 tables[8][256];
+	};
+
+	// built on first use so string ids can be made during static initialisation
+	static const CRCTables& GetCRCTables()
+	{
+		static const CRCTables crc_tables;
+		return crc_tables;
+	}
+
+	static inline UInt32 ToUpper(UInt32 byte)
+	{
+		return byte >= 'a' && byte <= 'z' ? byte - ('a' - 'A') : byte;
+	}
+
+	// upper cases a-z in all four bytes of a word at once, every other byte is left as it is
+	static inline UInt32 ToUpperBytes(UInt32 word)
+	{
+		const UInt32 low_bits = word & 0x7f7f7f7f;
+		const UInt32 at_least_a = low_bits + 0x1f1f1f1f;		// top bit set from 'a' up
+		const UInt32 above_z = low_bits + 0x05050505;		// top bit set from 'z' + 1 up
+		const UInt32 lower_case = at_least_a & ~above_z & ~word & 0x80808080;
+		return word ^ (lower_case >> 2);
+	}
+
+	static inline UInt32 LoadWord(const UInt8* bytes)
+	{
+		return (UInt32)bytes[0] | ((UInt32)bytes[1] << 8) | ((UInt32)bytes[2] << 16) | ((UInt32)bytes[3] << 24);
+	}
+
 	UInt32 CRC::GetCRC(const char* string)
 	{
 		CRC crc;
@@ -30,50 +85,51 @@ namespace gef
 		return crc.GetU32();
 	}
 
-
-	CRC::CRC(UInt32 _r) : r(_r)
+	UInt32 CRC::GetICRC(const char* string, Int32 length)
 	{
+		CRC crc;
 
-	}
+		if(string)
+			crc.Update(string, length, true);
 
-	// This reverses CRC::clk(0)
-	// in Galois terms: R := i + R*X
-	void CRC::ClkRev()
-	{
-		if (r & 0x80000000)
-			r = (r << 1) ^ gf;
-		else
-			r = (r << 1);
+		return crc.GetU32();
 	}
 
-	// this is the basic "gut's" of crc calcuation.
-	// and updates the crc's 32 bit residual for a
-	// single bit, in terms of galois theory
-	// this is: R := R*X^(-1)
-	void CRC::Clk(int i)
+
+	CRC::CRC(UInt32 _r) : r(_r)
 	{
-		r ^= i;
-		// rotation combined with possible xor of "gf"
-		if (1 & r)
-			r = ((r^gf) >> 1) | 0x80000000;
-		else
-			r >>= 1;
+
 	}
 
-	// This does a byte at a time by calculating the
-	// crc bit by bit, lsb first. Slow, but clear.
+	// Slicing-by-8: eight bytes are combined with the residual and looked up in the tables at once,
+	// the tables are only 8KB so they stay in the cache while a string is hashed.
 	void CRC::Update(const char *buffer, int len, bool toUpper)
 	{
-		while (len--)
+		const UInt32 (*tables)[256] = GetCRCTables().tables;
+		const UInt8* bytes = reinterpret_cast<const UInt8*>(buffer);
+		UInt32 residual = r;
+
+		for (; len >= 8; len -= 8, bytes += 8)
 		{
-			int bitcnt, byte = *buffer++;
-			if(toUpper)
-				byte = std::toupper(byte);
-			for (bitcnt=0; bitcnt < 8; bitcnt++)
+			UInt32 low = LoadWord(bytes);
+			UInt32 high = LoadWord(bytes + 4);
+			if (toUpper)
 			{
-				Clk(byte & 1);
-				byte >>= 1;
+				low = ToUpperBytes(low);
+				high = ToUpperBytes(high);
 			}
+
+			low ^= residual;
+			residual = tables[7][low & 0xff] ^ tables[6][(low >> 8) & 0xff] ^ tables[5][(low >> 16) & 0xff] ^ tables[4][low >> 24]
+				^ tables[3][high & 0xff] ^ tables[2][(high >> 8) & 0xff] ^ tables[1][(high >> 16) & 0xff] ^ tables[0][high >> 24];
 		}
+
+		for (; len > 0; --len, ++bytes)
+		{
+			const UInt32 byte = toUpper ? ToUpper(*bytes) : *bytes;
+			residual = (residual >> 8) ^ tables[0][(residual ^ byte) & 0xff];
+		}
+
+		r = residual;
 	}
 }
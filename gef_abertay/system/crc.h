@@ -7,19 +7,21 @@ namespace gef
 {
 	// http://www.codeproject.com/Articles/4251/Spoofing-the-Wily-Zip-CRC
 
+	/// The standard reflected CRC-32, as used by zip.
+	/// Works through eight bytes at a time with the slicing-by-8 tables, giving the same values as clocking the residual through a bit at a time.
 	class CRC
 	{
 	public:
 		static UInt32 GetCRC(const char* _pString);
 		static UInt32 GetICRC(const char* _pString);
+
+		/// case insensitive CRC of length bytes, a-z are treated as A-Z
+		static UInt32 GetICRC(const char* _pString, Int32 length);
 		CRC(UInt32 _r=~0);
 	private:
 		void Update(const char *pbuf, int len, bool toUpper = false); // update crc residual 
 		inline UInt32 GetU32() { return ~r; } // object yields current CRC
 
-		void Clk(int i=0);     // clock in data, bit at a time
-		void ClkRev();        // clk residual backwards
-
 		enum{gf=0xdb710641};  // This is the generator
 		UInt32 r;                // residual, polynomial mod gf
 	};
@@ -27,6 +27,10 @@ namespace gef
 //		virtual bool Read(void *buffer, const Int32 size, const Int32 offset, Int32& bytes_read) =  0;
 		virtual bool Close() = 0;
 		virtual bool GetSize(Int32 &size) = 0;
+
+		/// Last write time of a file in platform specific units, only useful for comparing with an earlier result.
+		/// Returns false where the platform can't tell.
+		virtual bool GetModifiedTime(const char* const filename, UInt64& modified_time) = 0;
 		bool Load(const char* const filename, void** buffer, Int32& buffer_size);
 
 		static File* Create();
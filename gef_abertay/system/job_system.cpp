@@ -0,0 +1,106 @@
+#include <system/job_system.h>
+#include <algorithm>
+
+namespace gef
+{
+	JobSystem::JobSystem(Int32 num_workers) :
+		generation_(0),
+		busy_workers_(0),
+		quit_(false),
+		func_(NULL),
+		context_(NULL),
+		count_(0),
+		batch_size_(1),
+		next_index_(0)
+	{
+		if (num_workers < 0)
+			num_workers = std::max((Int32)std::thread::hardware_concurrency() - 1, 0);
+
+		workers_.reserve(num_workers);
+		for (Int32 worker_num = 0; worker_num < num_workers; ++worker_num)
+			workers_.push_back(std::thread(&JobSystem::WorkerMain, this));
+	}
+
+	JobSystem::~JobSystem()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			quit_ = true;
+		}
+		work_ready_.notify_all();
+
+		for (size_t worker_num = 0; worker_num < workers_.size(); ++worker_num)
+			workers_[worker_num].join();
+	}
+
+	void JobSystem::Run(Int32 count, Int32 batch_size, RangeFunc func, const void* context)
+	{
+		if (count <= 0)
+			return;
+		if (batch_size < 1)
+			batch_size = 1;
+
+		// not worth waking anyone up for a single batch
+		if (workers_.empty() || count <= batch_size)
+		{
+			func(context, 0, count);
+			return;
+		}
+
+		std::lock_guard<std::mutex> run_lock(run_mutex_);
+
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			func_ = func;
+			context_ = context;
+			count_ = count;
+			batch_size_ = batch_size;
+			next_index_.store(0, std::memory_order_relaxed);
+			busy_workers_ = (Int32)workers_.size();
+			++generation_;
+		}
+		work_ready_.notify_all();
+
+		RunBatches();
+
+		std::unique_lock<std::mutex> lock(mutex_);
+		work_done_.wait(lock, [this] { return busy_workers_ == 0; });
+	}
+
+	void JobSystem::RunBatches()
+	{
+		for (;;)
+		{
+			Int32 begin = next_index_.fetch_add(batch_size_, std::memory_order_relaxed);
+			if (begin >= count_)
+				break;
+
+			func_(context_, begin, std::min(begin + batch_size_, count_));
+		}
+	}
+
+	void JobSystem::WorkerMain()
+	{
+		UInt32 last_generation = 0;
+		for (;;)
+		{
+			{
+				std::unique_lock<std::mutex> lock(mutex_);
+				work_ready_.wait(lock, [this, last_generation] { return quit_ || generation_ != last_generation; });
+				if (quit_)
+					return;
+				last_generation = generation_;
+			}
+
+			RunBatches();
+
+			bool last_worker;
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				last_worker = --busy_workers_ == 0;
+			}
+			if (last_worker)
+				work_done_.notify_one();
+		}
+	}
+}
@@ -0,0 +1,65 @@
+#ifndef _GEF_JOB_SYSTEM_H
+#define _GEF_JOB_SYSTEM_H
+
+#include <gef.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gef
+{
+	/// Fixed pool of worker threads for data parallel work.
+	/// The calling thread joins in with the workers, so a job system with no workers simply runs everything inline.
+	class JobSystem
+	{
+	public:
+		/// num_workers of -1 uses one worker per hardware thread, less one for the calling thread
+		explicit JobSystem(Int32 num_workers = -1);
+		~JobSystem();
+
+		/// Calls func(begin, end) over [0, count) in batches of batch_size and returns once every batch is done.
+		/// Does not allocate, so it is safe to call every frame.
+		template<typename Func>
+		void ParallelFor(Int32 count, Int32 batch_size, const Func& func)
+		{
+			Run(count, batch_size, &InvokeRange<Func>, &func);
+		}
+
+		inline Int32 worker_count() const { return (Int32)workers_.size(); }
+
+	private:
+		typedef void (*RangeFunc)(const void* context, Int32 begin, Int32 end);
+
+		template<typename Func>
+		static void InvokeRange(const void* context, Int32 begin, Int32 end)
+		{
+			(*static_cast<const Func*>(context))(begin, end);
+		}
+
+		void Run(Int32 count, Int32 batch_size, RangeFunc func, const void* context);
+		void RunBatches();
+		void WorkerMain();
+
+		std::vector<std::thread> workers_;
+
+		// one ParallelFor runs at a time
+		std::mutex run_mutex_;
+
+		std::mutex mutex_;
+		std::condition_variable work_ready_;
+		std::condition_variable work_done_;
+		UInt32 generation_;
+		Int32 busy_workers_;
+		bool quit_;
+
+		RangeFunc func_;
+		const void* context_;
+		Int32 count_;
+		Int32 batch_size_;
+		std::atomic<Int32> next_index_;
+	};
+}
+
+#endif // _GEF_JOB_SYSTEM_H
@@ -0,0 +1,14 @@
+#include <system/mapped_file.h>
+
+namespace gef
+{
+	MappedFile::MappedFile() :
+		data_(NULL),
+		size_(0)
+	{
+	}
+
+	MappedFile::~MappedFile()
+	{
+	}
+}
@@ -0,0 +1,31 @@
+#ifndef _GEF_MAPPED_FILE_H
+#define _GEF_MAPPED_FILE_H
+
+#include <gef.h>
+#include <cstddef>
+
+namespace gef
+{
+	/// A whole file mapped into memory, so its contents are paged in as they are touched rather than read up front.
+	/// The mapping is copy on write: the data can be fixed up in place without changing the file on disk.
+	class MappedFile
+	{
+	public:
+		virtual ~MappedFile();
+
+		virtual bool Open(const char* const filename) = 0;
+		virtual void Close() = 0;
+
+		inline void* data() const { return data_; }
+		inline Int32 size() const { return size_; }
+
+		static MappedFile* Create();
+	protected:
+		MappedFile();
+
+		void* data_;
+		Int32 size_;
+	};
+}
+
+#endif // _GEF_MAPPED_FILE_H
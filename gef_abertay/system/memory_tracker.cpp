@@ -0,0 +1,203 @@
+#include <system/memory_tracker.h>
+#include <system/debug_log.h>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace gef
+{
+	// these are zero initialised before any constructors run, so allocations made during static initialisation are safe
+	static std::atomic<UInt64> live_bytes[MT_NUM_TAGS];
+	static std::atomic<UInt64> peak_bytes[MT_NUM_TAGS];
+	static std::atomic<UInt64> num_allocations[MT_NUM_TAGS];
+	static std::atomic<UInt64> current_frame_allocations[MT_NUM_TAGS];
+	static std::atomic<UInt64> current_frame_bytes[MT_NUM_TAGS];
+	static std::atomic<UInt64> last_frame_allocations[MT_NUM_TAGS];
+	static std::atomic<UInt64> last_frame_bytes[MT_NUM_TAGS];
+
+	static thread_local MemoryTag thread_memory_tag = MT_GENERAL;
+
+#ifdef GEF_TRACK_ALLOCATIONS
+	// stored in front of every tracked allocation so frees can be attributed to the tag that made them
+	// the size keeps the returned memory aligned for any type
+	struct AllocationHeader
+	{
+		UInt64 size;
+		UInt64 tag;
+	};
+
+	static void* TrackedAlloc(size_t size)
+	{
+		AllocationHeader* header = static_cast<AllocationHeader*>(std::malloc(sizeof(AllocationHeader) + size));
+		if (!header)
+			return NULL;
+
+		MemoryTag tag = thread_memory_tag;
+		header->size = size;
+		header->tag = tag;
+
+		UInt64 live = live_bytes[tag].fetch_add(size, std::memory_order_relaxed) + size;
+		UInt64 peak = peak_bytes[tag].load(std::memory_order_relaxed);
+		while (live > peak && !peak_bytes[tag].compare_exchange_weak(peak, live, std::memory_order_relaxed))
+			;
+
+		num_allocations[tag].fetch_add(1, std::memory_order_relaxed);
+		current_frame_allocations[tag].fetch_add(1, std::memory_order_relaxed);
+		current_frame_bytes[tag].fetch_add(size, std::memory_order_relaxed);
+
+		return header + 1;
+	}
+
+	static void TrackedFree(void* memory)
+	{
+		if (!memory)
+			return;
+
+		AllocationHeader* header = static_cast<AllocationHeader*>(memory) - 1;
+		live_bytes[header->tag].fetch_sub(header->size, std::memory_order_relaxed);
+		std::free(header);
+	}
+#else
+	static void* TrackedAlloc(size_t size)
+	{
+		return std::malloc(size);
+	}
+
+	static void TrackedFree(void* memory)
+	{
+		std::free(memory);
+	}
+#endif
+
+	void* MemoryTracker::Malloc(size_t size)
+	{
+		return TrackedAlloc(size);
+	}
+
+	void MemoryTracker::Free(void* memory)
+	{
+		TrackedFree(memory);
+	}
+
+	void MemoryTracker::NewFrame()
+	{
+		for (Int32 tag = 0; tag < MT_NUM_TAGS; ++tag)
+		{
+			last_frame_allocations[tag].store(current_frame_allocations[tag].exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+			last_frame_bytes[tag].store(current_frame_bytes[tag].exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+		}
+	}
+
+	MemoryStats MemoryTracker::GetStats(MemoryTag tag)
+	{
+		MemoryStats stats;
+		stats.live_bytes = live_bytes[tag].load(std::memory_order_relaxed);
+		stats.peak_bytes = peak_bytes[tag].load(std::memory_order_relaxed);
+		stats.num_allocations = num_allocations[tag].load(std::memory_order_relaxed);
+		stats.frame_allocations = last_frame_allocations[tag].load(std::memory_order_relaxed);
+		stats.frame_bytes = last_frame_bytes[tag].load(std::memory_order_relaxed);
+		return stats;
+	}
+
+	UInt64 MemoryTracker::frame_allocations()
+	{
+		UInt64 total = 0;
+		for (Int32 tag = 0; tag < MT_NUM_TAGS; ++tag)
+			total += last_frame_allocations[tag].load(std::memory_order_relaxed);
+		return total;
+	}
+
+	const char* MemoryTracker::tag_name(MemoryTag tag)
+	{
+		static const char* tag_names[MT_NUM_TAGS] =
+		{
+			"general",
+			"animation",
+			"scene",
+			"rendering",
+			"ik",
+			"physics"
+		};
+
+		return tag_names[tag];
+	}
+
+	MemoryTag MemoryTracker::current_tag()
+	{
+		return thread_memory_tag;
+	}
+
+	void MemoryTracker::set_current_tag(MemoryTag tag)
+	{
+		thread_memory_tag = tag;
+	}
+
+	void MemoryTracker::LogStats()
+	{
+		DebugOut("%-10s %12s %12s %12s %12s %12s\n", "tag", "live", "peak", "allocs", "frame allocs", "frame bytes");
+		for (Int32 tag = 0; tag < MT_NUM_TAGS; ++tag)
+		{
+			MemoryStats stats = GetStats((MemoryTag)tag);
+			DebugOut("%-10s %12llu %12llu %12llu %12llu %12llu\n", tag_name((MemoryTag)tag),
+				stats.live_bytes, stats.peak_bytes, stats.num_allocations, stats.frame_allocations, stats.frame_bytes);
+		}
+	}
+}
+
+#ifdef GEF_TRACK_ALLOCATIONS
+void* operator new(size_t size)
+{
+	void* memory = gef::TrackedAlloc(size);
+	if (!memory)
+		throw std::bad_alloc();
+	return memory;
+}
+
+void* operator new[](size_t size)
+{
+	void* memory = gef::TrackedAlloc(size);
+	if (!memory)
+		throw std::bad_alloc();
+	return memory;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	return gef::TrackedAlloc(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+	return gef::TrackedAlloc(size);
+}
+
+void operator delete(void* memory) noexcept
+{
+	gef::TrackedFree(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+	gef::TrackedFree(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept
+{
+	gef::TrackedFree(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept
+{
+	gef::TrackedFree(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+	gef::TrackedFree(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept
+{
+	gef::TrackedFree(memory);
+}
+#endif
@@ -0,0 +1,82 @@
+#ifndef _GEF_MEMORY_TRACKER_H
+#define _GEF_MEMORY_TRACKER_H
+
+#include <gef.h>
+#include <cstddef>
+
+namespace gef
+{
+	/// Subsystem that allocations made on the current thread are attributed to
+	enum MemoryTag
+	{
+		MT_GENERAL = 0,
+		MT_ANIMATION,
+		MT_SCENE,
+		MT_RENDERING,
+		MT_IK,
+		MT_PHYSICS,
+		MT_NUM_TAGS
+	};
+
+	struct MemoryStats
+	{
+		UInt64 live_bytes;
+		UInt64 peak_bytes;
+		UInt64 num_allocations;			// since the program started
+		UInt64 frame_allocations;		// during the last complete frame
+		UInt64 frame_bytes;				// allocated during the last complete frame
+	};
+
+	/// Counts heap allocations per subsystem. Only records anything when built with GEF_TRACK_ALLOCATIONS,
+	/// which replaces the global operator new and delete.
+	class MemoryTracker
+	{
+	public:
+		static void* Malloc(size_t size);
+		static void Free(void* memory);
+
+		/// Start counting allocations for a new frame, called by Application::Run
+		static void NewFrame();
+
+		static MemoryStats GetStats(MemoryTag tag);
+
+		/// Allocations made by all subsystems during the last complete frame
+		static UInt64 frame_allocations();
+
+		static const char* tag_name(MemoryTag tag);
+		static MemoryTag current_tag();
+		static void set_current_tag(MemoryTag tag);
+
+		static void LogStats();
+	};
+
+	/// Attributes allocations on this thread to a subsystem until the end of the scope
+	class MemoryTagScope
+	{
+	public:
+		inline MemoryTagScope(MemoryTag tag) :
+			previous_tag_(MemoryTracker::current_tag())
+		{
+			MemoryTracker::set_current_tag(tag);
+		}
+
+		inline ~MemoryTagScope()
+		{
+			MemoryTracker::set_current_tag(previous_tag_);
+		}
+
+	private:
+		MemoryTag previous_tag_;
+	};
+}
+
+#define GEF_MEMORY_TAG_CONCAT_INNER(a, b) a##b
+#define GEF_MEMORY_TAG_CONCAT(a, b) GEF_MEMORY_TAG_CONCAT_INNER(a, b)
+
+#ifdef GEF_TRACK_ALLOCATIONS
+#define GEF_MEMORY_TAG(tag) gef::MemoryTagScope GEF_MEMORY_TAG_CONCAT(gef_memory_tag_, __LINE__)(tag)
+#else
+#define GEF_MEMORY_TAG(tag)
+#endif
+
+#endif // _GEF_MEMORY_TRACKER_H
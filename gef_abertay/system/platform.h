@@ -78,6 +78,9 @@ namespace gef
 		virtual Matrix44 PerspectiveProjectionFrustum(const float left, const float right, const float top, const float bottom, const float near_distance, const float far_distance) const = 0;
 		virtual Matrix44 OrthographicFrustum(const float left, const float right, const float top, const float bottom, const float near_distance, const float far_distance) const = 0;
 
+		/// Clip space z/w at the near plane of the projections above, 0 for the D3D convention and -1 for GL.
+		virtual float NdcZMin() const = 0;
+
 		virtual void BeginScene() const = 0;
 		virtual void EndScene() const = 0;
 		virtual const char* GetShaderDirectory() const = 0;
@@ -0,0 +1,124 @@
+#include <system/profiler.h>
+#include <chrono>
+#include <cstdio>
+
+namespace gef
+{
+	std::atomic<bool> Profiler::enabled_(false);
+	std::mutex Profiler::buffers_mutex_;
+	std::vector<Profiler::ThreadBuffer*> Profiler::buffers_;
+
+	Profiler::ThreadBuffer::ThreadBuffer(UInt32 thread_id, UInt32 capacity) :
+		thread_id_(thread_id),
+		events_(capacity),
+		write_count_(0)
+	{
+	}
+
+	void Profiler::ThreadBuffer::Push(const char* name, UInt64 start_ns, UInt64 duration_ns)
+	{
+		// only the owning thread writes, the release store publishes the event to the exporter
+		UInt64 write_count = write_count_.load(std::memory_order_relaxed);
+		ZoneEvent& zone_event = events_[write_count % events_.size()];
+		zone_event.name = name;
+		zone_event.start_ns = start_ns;
+		zone_event.duration_ns = duration_ns;
+		write_count_.store(write_count + 1, std::memory_order_release);
+	}
+
+	void Profiler::ThreadBuffer::Clear()
+	{
+		write_count_.store(0, std::memory_order_release);
+	}
+
+	void Profiler::set_enabled(bool enabled)
+	{
+		// make sure the time origin is set before any zones start
+		GetTimeNs();
+		enabled_.store(enabled, std::memory_order_relaxed);
+	}
+
+	UInt64 Profiler::GetTimeNs()
+	{
+		static const std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+		return (UInt64)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_time).count();
+	}
+
+	Profiler::ThreadBuffer* Profiler::GetThreadBuffer()
+	{
+		// buffers live until the program exits so a trace can still be written after a thread has finished
+		static thread_local ThreadBuffer* thread_buffer = NULL;
+		if (!thread_buffer)
+		{
+			std::lock_guard<std::mutex> lock(buffers_mutex_);
+			thread_buffer = new ThreadBuffer((UInt32)buffers_.size(), kEventsPerThread);
+			buffers_.push_back(thread_buffer);
+		}
+
+		return thread_buffer;
+	}
+
+	void Profiler::RecordZone(const char* name, UInt64 start_ns, UInt64 end_ns)
+	{
+		GetThreadBuffer()->Push(name, start_ns, end_ns - start_ns);
+	}
+
+	void Profiler::Clear()
+	{
+		std::lock_guard<std::mutex> lock(buffers_mutex_);
+		for (std::vector<ThreadBuffer*>::iterator buffer_iter = buffers_.begin(); buffer_iter != buffers_.end(); ++buffer_iter)
+			(*buffer_iter)->Clear();
+	}
+
+	static void WriteJsonString(FILE* file, const char* text)
+	{
+		fputc('"', file);
+		for (const char* character = text; *character; ++character)
+		{
+			if (*character == '"' || *character == '\\')
+				fputc('\\', file);
+			fputc(*character, file);
+		}
+		fputc('"', file);
+	}
+
+	bool Profiler::WriteChromeTrace(const char* filename)
+	{
+		FILE* file = fopen(filename, "w");
+		if (!file)
+			return false;
+
+		fprintf(file, "{\"traceEvents\":[\n");
+
+		bool first_event = true;
+		std::lock_guard<std::mutex> lock(buffers_mutex_);
+		for (std::vector<ThreadBuffer*>::const_iterator buffer_iter = buffers_.begin(); buffer_iter != buffers_.end(); ++buffer_iter)
+		{
+			const ThreadBuffer* buffer = *buffer_iter;
+
+			// if the ring buffer has wrapped only the most recent events are still there
+			UInt64 end_event = buffer->num_events_written();
+			UInt64 start_event = end_event > buffer->capacity() ? end_event - buffer->capacity() : 0;
+
+			for (UInt64 event_num = start_event; event_num < end_event; ++event_num)
+			{
+				const ZoneEvent& zone_event = buffer->event(event_num);
+
+				if (!first_event)
+					fprintf(file, ",\n");
+				first_event = false;
+
+				// chrome expects times in microseconds
+				fprintf(file, "{\"name\":");
+				WriteJsonString(file, zone_event.name);
+				fprintf(file, ",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+					buffer->thread_id(), (double)zone_event.start_ns / 1000.0, (double)zone_event.duration_ns / 1000.0);
+			}
+		}
+
+		fprintf(file, "\n],\"displayTimeUnit\":\"ms\"}\n");
+		fclose(file);
+
+		return true;
+	}
+}
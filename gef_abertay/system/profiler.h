@@ -0,0 +1,100 @@
+#ifndef _GEF_PROFILER_H
+#define _GEF_PROFILER_H
+
+#include <gef.h>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace gef
+{
+	/// Records timed zones per thread and writes them out in the Chrome about:tracing JSON format.
+	/// Zones are only recorded while the profiler is enabled, so instrumented code costs one branch otherwise.
+	class Profiler
+	{
+	public:
+		struct ZoneEvent
+		{
+			const char* name;	// must be a string literal, only the pointer is stored
+			UInt64 start_ns;
+			UInt64 duration_ns;
+		};
+
+		/// Each thread writes to its own ring buffer, so recording a zone never takes a lock
+		class ThreadBuffer
+		{
+		public:
+			ThreadBuffer(UInt32 thread_id, UInt32 capacity);
+
+			void Push(const char* name, UInt64 start_ns, UInt64 duration_ns);
+			void Clear();
+
+			inline UInt32 thread_id() const { return thread_id_; }
+			inline UInt32 capacity() const { return (UInt32)events_.size(); }
+			inline UInt64 num_events_written() const { return write_count_.load(std::memory_order_acquire); }
+			inline const ZoneEvent& event(UInt64 event_num) const { return events_[event_num % events_.size()]; }
+
+		private:
+			UInt32 thread_id_;
+			std::vector<ZoneEvent> events_;
+			std::atomic<UInt64> write_count_;
+		};
+
+		static inline bool enabled() { return enabled_.load(std::memory_order_relaxed); }
+		static void set_enabled(bool enabled);
+
+		/// Nanoseconds since the profiler was first used
+		static UInt64 GetTimeNs();
+
+		static void RecordZone(const char* name, UInt64 start_ns, UInt64 end_ns);
+
+		/// Throw away all recorded zones, only call while no zones are being recorded
+		static void Clear();
+
+		static bool WriteChromeTrace(const char* filename);
+
+		/// Number of zones kept per thread before the oldest are overwritten
+		static const UInt32 kEventsPerThread = 1 << 16;
+
+	private:
+		static ThreadBuffer* GetThreadBuffer();
+
+		static std::atomic<bool> enabled_;
+		static std::mutex buffers_mutex_;
+		static std::vector<ThreadBuffer*> buffers_;
+	};
+
+	class ProfileZone
+	{
+	public:
+		inline ProfileZone(const char* name) :
+			name_(name),
+			active_(Profiler::enabled()),
+			start_ns_(active_ ? Profiler::GetTimeNs() : 0)
+		{
+		}
+
+		inline ~ProfileZone()
+		{
+			if (active_)
+				Profiler::RecordZone(name_, start_ns_, Profiler::GetTimeNs());
+		}
+
+	private:
+		const char* name_;
+		bool active_;
+		UInt64 start_ns_;
+	};
+}
+
+#define GEF_PROFILE_CONCAT_INNER(a, b) a##b
+#define GEF_PROFILE_CONCAT(a, b) GEF_PROFILE_CONCAT_INNER(a, b)
+
+// times the rest of the enclosing scope
+#ifndef GEF_DISABLE_PROFILER
+#define GEF_PROFILE_ZONE(name) gef::ProfileZone GEF_PROFILE_CONCAT(gef_profile_zone_, __LINE__)(name)
+#else
+#define GEF_PROFILE_ZONE(name)
+#endif
+
+#endif // _GEF_PROFILER_H
@@ -29,6 +29,11 @@ namespace gef
 
 	StringId GetStringId(const std::string& text)
 	{
-		return CRC::GetICRC(text.c_str());
+		return CRC::GetICRC(text.c_str(), (Int32)text.size());
+	}
+
+	StringId GetStringId(const char* text)
+	{
+		return CRC::GetICRC(text);
 	}
 }
\ No newline at end of file
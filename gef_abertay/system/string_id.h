@@ -22,5 +22,26 @@ namespace gef
 	};
 
 	extern StringId GetStringId(const std::string& text);
+	extern StringId GetStringId(const char* text);
+
+	/// GetStringId worked out by the compiler, for names known when the code is written.
+	/// Only guaranteed to cost nothing at run time where a constant is needed, so make the result constexpr or use it as a case label, e.g.
+	///     static constexpr gef::StringId kJumpBlend = gef::ConstStringId("jump_blend");
+	/// Works out the same CRC as gef::CRC a bit at a time, so the ids always match GetStringId's.
+	constexpr StringId ConstStringId(const char* text)
+	{
+		UInt32 r = ~0u;
+		for (; *text; ++text)
+		{
+			UInt32 byte = (UInt8)*text;
+			if (byte >= 'a' && byte <= 'z')
+				byte -= 'a' - 'A';
+
+			r ^= byte;
+			for (Int32 bit = 0; bit < 8; ++bit)
+				r = (r >> 1) ^ (0xedb88320 & (0u - (r & 1)));
+		}
+		return ~r;
+	}
 }
 #endif // _STRING_ID_TABLE_H
\ No newline at end of file
@@ -0,0 +1,299 @@
+#include <platform/headless/system/platform_headless.h>
+#include <assets/asset_loader.h>
+#include <assets/texture_cache.h>
+#include <graphics/scene.h>
+#include <graphics/font.h>
+#include <graphics/texture.h>
+#include <system/memory_tracker.h>
+#include <system/profiler.h>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+// Checks AssetLoader on the headless platform: queued loads completing through Update, loads of missing files failing,
+// Update taking one creation step at a time on a zero budget, requests released while queued, loading or being created,
+// and loader threads writing the same texture cache file at once.
+// usage: asset_loader_test [texture_cache_directory]
+// Run from blendtrees/media, it loads the tesla model and clip and the comic_sans font.
+// Without a cache directory the texture cache check is skipped, rather than writing cache files into the media.
+
+static const char* const kModelFilename = "tesla/tesla.scn";
+static const char* const kClipFilename = "tesla/tesla@walk.scn";
+static const char* const kTextureFilename = "comic_sans_0.png";
+static const char* const kFontName = "comic_sans";
+
+// how long to wait for a loader thread before giving up on a check
+static const UInt64 kTimeoutNs = 10000000000ull;
+
+static int g_failures = 0;
+
+static bool Check(bool condition, const char* test_name, const char* description)
+{
+	if (!condition)
+	{
+		printf("%s: %s\n", test_name, description);
+		g_failures++;
+	}
+	return condition;
+}
+
+static void Yield()
+{
+	std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+
+// live bytes across every subsystem, always 0 without GEF_TRACK_ALLOCATIONS
+static UInt64 LiveBytes()
+{
+	UInt64 live_bytes = 0;
+	for (Int32 tag = 0; tag < gef::MT_NUM_TAGS; ++tag)
+		live_bytes += gef::MemoryTracker::GetStats((gef::MemoryTag)tag).live_bytes;
+	return live_bytes;
+}
+
+// waits for the loader threads to move the request past state, without calling Update
+static bool WaitWhile(const gef::AssetRequest* request, gef::AssetLoadState state)
+{
+	const UInt64 start_ns = gef::Profiler::GetTimeNs();
+	while (request->state() == state)
+	{
+		if (gef::Profiler::GetTimeNs() - start_ns > kTimeoutNs)
+			return false;
+		Yield();
+	}
+	return true;
+}
+
+// calls Update until nothing is pending, returns false on timeout
+static bool UpdateUntilIdle(gef::AssetLoader& loader, float time_budget_ms)
+{
+	const UInt64 start_ns = gef::Profiler::GetTimeNs();
+	while (loader.pending_count() > 0)
+	{
+		if (gef::Profiler::GetTimeNs() - start_ns > kTimeoutNs)
+			return false;
+		loader.Update(time_budget_ms);
+		Yield();
+	}
+	return true;
+}
+
+static void TestQueue(gef::Platform& platform)
+{
+	const char* const test_name = "queue";
+
+	gef::AssetLoader loader(platform, 2);
+	gef::AssetRequest* model_request = loader.LoadScene(kModelFilename);
+	gef::AssetRequest* clip_request = loader.LoadScene(kClipFilename, 0);
+	gef::AssetRequest* texture_request = loader.LoadTexture(kTextureFilename);
+	gef::AssetRequest* font_request = loader.LoadFont(kFontName);
+
+	// nothing can complete before Update creates it
+	Check(loader.pending_count() == 4, test_name, "every request should be pending before the first Update");
+
+	if (!Check(UpdateUntilIdle(loader, 2.0f), test_name, "timed out waiting for the loads"))
+		return;
+
+	if (Check(model_request->succeeded(), test_name, "model failed to load"))
+	{
+		gef::Scene* scene = model_request->scene();
+		Check(!scene->mesh_data.empty() && scene->meshes.size() == scene->mesh_data.size(), test_name, "model meshes weren't all created");
+		Check(scene->materials.size() == scene->material_data.size(), test_name, "model materials weren't all created");
+		delete scene;
+	}
+
+	if (Check(clip_request->succeeded(), test_name, "clip failed to load"))
+	{
+		gef::Scene* scene = clip_request->scene();
+		Check(!scene->animations.empty(), test_name, "clip has no animation");
+		Check(scene->meshes.empty() && scene->materials.empty(), test_name, "clip loaded without flags created meshes or materials");
+		delete scene;
+	}
+
+	if (Check(texture_request->succeeded() && texture_request->texture() != NULL, test_name, "texture failed to load"))
+		delete texture_request->texture();
+
+	if (Check(font_request->succeeded() && font_request->font() != NULL, test_name, "font failed to load"))
+		delete font_request->font();
+
+	loader.Release(model_request);
+	loader.Release(clip_request);
+	loader.Release(texture_request);
+	loader.Release(font_request);
+}
+
+static void TestFailure(gef::Platform& platform)
+{
+	const char* const test_name = "failure";
+
+	gef::AssetLoader loader(platform);
+	gef::AssetRequest* scene_request = loader.LoadScene("missing.scn");
+	gef::AssetRequest* texture_request = loader.LoadTexture("missing.png");
+	gef::AssetRequest* font_request = loader.LoadFont("missing");
+
+	// failing needs no main thread step
+	const bool finished = WaitWhile(scene_request, gef::ALS_QUEUED) && WaitWhile(scene_request, gef::ALS_LOADING)
+		&& WaitWhile(texture_request, gef::ALS_QUEUED) && WaitWhile(texture_request, gef::ALS_LOADING)
+		&& WaitWhile(font_request, gef::ALS_QUEUED) && WaitWhile(font_request, gef::ALS_LOADING);
+	if (Check(finished, test_name, "timed out waiting for the loads"))
+	{
+		Check(scene_request->state() == gef::ALS_FAILED && scene_request->scene() == NULL, test_name, "missing scene didn't fail");
+		Check(texture_request->state() == gef::ALS_FAILED && texture_request->texture() == NULL, test_name, "missing texture didn't fail");
+		Check(font_request->state() == gef::ALS_FAILED && font_request->font() == NULL, test_name, "missing font didn't fail");
+		Check(loader.pending_count() == 0, test_name, "failed loads are still pending");
+	}
+
+	loader.Release(scene_request);
+	loader.Release(texture_request);
+	loader.Release(font_request);
+}
+
+static void TestBudget(gef::Platform& platform)
+{
+	const char* const test_name = "budget";
+
+	gef::AssetLoader loader(platform);
+	gef::AssetRequest* request = loader.LoadScene(kModelFilename);
+	if (!Check(WaitWhile(request, gef::ALS_QUEUED) && WaitWhile(request, gef::ALS_LOADING), test_name, "timed out waiting for the load"))
+	{
+		loader.Release(request);
+		return;
+	}
+
+	// a zero budget still takes one step a call, a material or a mesh each
+	Int32 update_count = 0;
+	while (request->state() == gef::ALS_CREATING && update_count < 1000)
+	{
+		loader.Update(0.0f);
+		update_count++;
+	}
+
+	if (Check(request->succeeded(), test_name, "model failed to load"))
+	{
+		gef::Scene* scene = request->scene();
+		const Int32 step_count = (Int32)(scene->material_data.size() + scene->mesh_data.size());
+		Check(step_count > 1, test_name, "model should take more than one step to create");
+		Check(update_count == step_count, test_name, "a zero budget Update should take exactly one step");
+		delete scene;
+	}
+	loader.Release(request);
+
+	// a generous budget creates the whole scene in one call
+	request = loader.LoadScene(kModelFilename);
+	if (Check(WaitWhile(request, gef::ALS_QUEUED) && WaitWhile(request, gef::ALS_LOADING), test_name, "timed out waiting for the load"))
+	{
+		loader.Update(10000.0f);
+		Check(request->succeeded(), test_name, "a large budget should finish the scene in one Update");
+		delete request->scene();
+	}
+	loader.Release(request);
+}
+
+static void TestRelease(gef::Platform& platform)
+{
+	const char* const test_name = "release";
+
+	const UInt64 live_bytes = LiveBytes();
+	{
+		gef::AssetLoader loader(platform);
+
+		// the single loader thread is busy with the first, so the rest are still queued
+		gef::AssetRequest* requests[4];
+		for (Int32 request_num = 0; request_num < 4; ++request_num)
+			requests[request_num] = loader.LoadScene(kModelFilename);
+		for (Int32 request_num = 3; request_num >= 0; --request_num)
+			loader.Release(requests[request_num]);
+
+		// released while the loader thread has it
+		bool released_loading = false;
+		for (Int32 attempt = 0; attempt < 20 && !released_loading; ++attempt)
+		{
+			gef::AssetRequest* request = loader.LoadScene(kModelFilename);
+			if (!WaitWhile(request, gef::ALS_QUEUED))
+				break;
+			released_loading = request->state() == gef::ALS_LOADING;
+			loader.Release(request);
+			UpdateUntilIdle(loader, 0.0f);
+		}
+		Check(released_loading, test_name, "never caught a request while it was loading");
+
+		// released part way through being created
+		gef::AssetRequest* request = loader.LoadScene(kModelFilename);
+		if (Check(WaitWhile(request, gef::ALS_QUEUED) && WaitWhile(request, gef::ALS_LOADING), test_name, "timed out waiting for the load"))
+		{
+			loader.Update(0.0f);
+			Check(request->state() == gef::ALS_CREATING, test_name, "request should still be being created");
+		}
+		loader.Release(request);
+
+		Check(UpdateUntilIdle(loader, 0.0f), test_name, "released requests are still pending");
+
+		// abandoned by the destructor
+		loader.LoadScene(kModelFilename);
+		loader.LoadTexture(kTextureFilename);
+	}
+	Check(LiveBytes() == live_bytes, test_name, "released requests leaked memory");
+}
+
+static void TestSharedTextureCache(gef::Platform& platform, const char* cache_directory)
+{
+	const char* const test_name = "shared texture cache";
+	const Int32 kThreadCount = 4;
+
+	gef::TextureCache texture_cache(platform, cache_directory);
+	const std::string cache_filename = texture_cache.CacheFilename(kTextureFilename);
+
+	gef::AssetLoader loader(platform, kThreadCount, &texture_cache);
+	for (Int32 round = 0; round < 8; ++round)
+	{
+		// every thread finds the cache file missing and writes it
+		remove(cache_filename.c_str());
+
+		gef::AssetRequest* requests[kThreadCount];
+		for (Int32 request_num = 0; request_num < kThreadCount; ++request_num)
+			requests[request_num] = loader.LoadTexture(kTextureFilename);
+
+		Check(UpdateUntilIdle(loader, 2.0f), test_name, "timed out waiting for the loads");
+
+		for (Int32 request_num = 0; request_num < kThreadCount; ++request_num)
+		{
+			Check(requests[request_num]->succeeded(), test_name, "texture failed to load");
+			delete requests[request_num]->texture();
+			loader.Release(requests[request_num]);
+		}
+	}
+
+	// whichever write landed last is a complete cache file
+	UInt32 magic = 0;
+	FILE* cache_file = fopen(cache_filename.c_str(), "rb");
+	if (cache_file)
+	{
+		if (fread(&magic, sizeof(magic), 1, cache_file) != 1)
+			magic = 0;
+		fclose(cache_file);
+	}
+	Check(magic == gef::TextureCache::kMagic, test_name, "cache file wasn't written");
+	remove(cache_filename.c_str());
+}
+
+int main(int argc, char* argv[])
+{
+	gef::PlatformHeadless platform(960, 544);
+
+	TestQueue(platform);
+	TestFailure(platform);
+	TestBudget(platform);
+	TestRelease(platform);
+	if (argc > 1)
+		TestSharedTextureCache(platform, argv[1]);
+
+	if (g_failures)
+	{
+		printf("%d checks failed\n", g_failures);
+		return 1;
+	}
+
+	printf("all checks passed\n");
+	return 0;
+}
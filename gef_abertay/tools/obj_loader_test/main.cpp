@@ -0,0 +1,516 @@
+#include <platform/headless/system/platform_headless.h>
+#include <assets/obj_loader.h>
+#include <graphics/model.h>
+#include <graphics/mesh.h>
+#include <graphics/primitive.h>
+#include <graphics/index_buffer.h>
+#include <graphics/material.h>
+#include <graphics/vertex_buffer.h>
+#include <maths/aabb.h>
+#include <system/job_system.h>
+#include <system/memory_tracker.h>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Checks OBJLoader on the headless platform: a generated model parsed on the calling thread and split across the
+// job system giving the same primitives and cache file, a reload from the cache matching the fresh parse, a changed
+// source replacing its cache, and missing files, malformed lines and corrupt cache files failing without leaking.
+// usage: obj_loader_test output_directory
+// Run from blendtrees/media, the generated materials use comic_sans_0.png and tesla/backpack.png.
+// The generated .obj, .mtl and cache files are written to the output directory, which can't contain spaces.
+
+static const char* const kTextureFilenames[] = { "comic_sans_0.png", "tesla/backpack.png" };
+
+// materials the generated model switches between, with the texture each is drawn with, -1 for none
+struct MaterialDef
+{
+	const char* name;
+	Int32 texture_num;
+};
+
+// "missing" isn't in the .mtl, "red" and "blue" share a texture
+static const MaterialDef kMaterials[] =
+{
+	{ "red", 0 },
+	{ "blue", 0 },
+	{ "plain", -1 },
+	{ "green", 1 },
+	{ "missing", -1 }
+};
+static const Int32 kMaterialCount = sizeof(kMaterials) / sizeof(kMaterials[0]);
+
+// a grid of quads, with the material changed every kRowsPerMaterial rows
+static const Int32 kGridColumns = 64;
+static const Int32 kGridRows = 128;
+static const Int32 kRowsPerMaterial = 8;
+static const Int32 kPrimitiveCount = kGridRows / kRowsPerMaterial;
+static const Int32 kIndicesPerPrimitive = kRowsPerMaterial * kGridColumns * 6;
+
+static int g_failures = 0;
+
+static bool Check(bool condition, const char* test_name, const char* description)
+{
+	if (!condition)
+	{
+		printf("%s: %s\n", test_name, description);
+		g_failures++;
+	}
+	return condition;
+}
+
+// live bytes across every subsystem, always 0 without GEF_TRACK_ALLOCATIONS
+static UInt64 LiveBytes()
+{
+	UInt64 live_bytes = 0;
+	for (Int32 tag = 0; tag < gef::MT_NUM_TAGS; ++tag)
+		live_bytes += gef::MemoryTracker::GetStats((gef::MemoryTag)tag).live_bytes;
+	return live_bytes;
+}
+
+static bool WriteFile(const std::string& filename, const std::string& contents)
+{
+	FILE* file = fopen(filename.c_str(), "wb");
+	if (!file)
+		return false;
+
+	const bool success = fwrite(contents.data(), 1, contents.size(), file) == contents.size();
+	return fclose(file) == 0 && success;
+}
+
+static bool ReadFile(const std::string& filename, std::string& contents)
+{
+	contents.clear();
+	FILE* file = fopen(filename.c_str(), "rb");
+	if (!file)
+		return false;
+
+	char buffer[4096];
+	size_t bytes_read;
+	while ((bytes_read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+		contents.append(buffer, bytes_read);
+	fclose(file);
+	return true;
+}
+
+static void AppendLine(std::string& text, const char* line, bool crlf)
+{
+	text += line;
+	text += crlf ? "\r\n" : "\n";
+}
+
+// Builds the grid model, a row of vertices at a time followed by the faces that reach back to the previous row,
+// so material changes and faces are spread through every chunk of a parallel parse.
+// Face corners are written in every form the loader reads, numbers in decimal and scientific notation, and
+// odd rows end in CRLF.
+static std::string GenerateOBJ(const std::string& mtl_filename, float* bounds_min, float* bounds_max)
+{
+	std::string text;
+	char line[256];
+
+	AppendLine(text, "# obj_loader_test grid", false);
+	snprintf(line, sizeof(line), "mtllib %s", mtl_filename.c_str());
+	AppendLine(text, line, false);
+	AppendLine(text, "o grid", false);
+
+	for (Int32 axis = 0; axis < 3; ++axis)
+	{
+		bounds_min[axis] = FLT_MAX;
+		bounds_max[axis] = -FLT_MAX;
+	}
+
+	const Int32 row_size = kGridColumns + 1;
+	for (Int32 row = 0; row <= kGridRows; ++row)
+	{
+		const bool crlf = (row & 1) != 0;
+		for (Int32 column = 0; column <= kGridColumns; ++column)
+		{
+			const float position[3] = { column * 0.25f - 8.0f, sinf(row * 0.3f + column * 0.7f), row * -0.125f };
+			if ((row + column) % 7 == 0)
+				snprintf(line, sizeof(line), "v %e %e %e", position[0], position[1], position[2]);
+			else
+				snprintf(line, sizeof(line), "v %.6f %.6f %.6f", position[0], position[1], position[2]);
+			AppendLine(text, line, crlf);
+
+			for (Int32 axis = 0; axis < 3; ++axis)
+			{
+				bounds_min[axis] = std::min(bounds_min[axis], position[axis]);
+				bounds_max[axis] = std::max(bounds_max[axis], position[axis]);
+			}
+
+			snprintf(line, sizeof(line), "vt %.4f %.4f", column / (float)kGridColumns, row / (float)kGridRows);
+			AppendLine(text, line, crlf);
+			snprintf(line, sizeof(line), "vn %.5f %.5f %.5f", 0.0f, 0.8f, (column % 5) * -0.15f);
+			AppendLine(text, line, crlf);
+		}
+
+		if (row == 0)
+			continue;
+
+		const Int32 face_row = row - 1;
+		if (face_row % kRowsPerMaterial == 0)
+		{
+			const Int32 primitive_num = face_row / kRowsPerMaterial;
+
+			// a material that is replaced before anything is drawn with it
+			if (primitive_num == 5)
+			{
+				snprintf(line, sizeof(line), "usemtl %s", kMaterials[(primitive_num + 1) % kMaterialCount].name);
+				AppendLine(text, line, crlf);
+				AppendLine(text, "", crlf);
+			}
+
+			snprintf(line, sizeof(line), "usemtl %s", kMaterials[primitive_num % kMaterialCount].name);
+			AppendLine(text, line, crlf);
+			AppendLine(text, "s off", crlf);
+		}
+
+		for (Int32 column = 0; column < kGridColumns; ++column)
+		{
+			const Int32 a = face_row * row_size + column + 1;
+			const Int32 b = a + 1;
+			const Int32 c = b + row_size;
+			const Int32 d = a + row_size;
+
+			switch (column % 4)
+			{
+			case 0:
+				snprintf(line, sizeof(line), "f %d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d", a, a, a, b, b, b, c, c, c, d, d, d);
+				AppendLine(text, line, crlf);
+				break;
+			case 1:
+				snprintf(line, sizeof(line), "f %d//%d %d//%d %d//%d", a, a, b, b, c, c);
+				AppendLine(text, line, crlf);
+				snprintf(line, sizeof(line), "f %d//%d %d//%d %d//%d # second half", a, a, c, c, d, d);
+				AppendLine(text, line, crlf);
+				break;
+			case 2:
+				snprintf(line, sizeof(line), "f %d/%d %d/%d %d/%d %d/%d", a, a, b, b, c, c, d, d);
+				AppendLine(text, line, crlf);
+				break;
+			default:
+				snprintf(line, sizeof(line), "f  %d\t%d %d %d ", a, b, c, d);
+				AppendLine(text, line, crlf);
+				break;
+			}
+		}
+	}
+
+	return text;
+}
+
+static std::string GenerateMTL()
+{
+	std::string text;
+	char line[256];
+	for (Int32 material_num = 0; material_num < kMaterialCount; ++material_num)
+	{
+		if (strcmp(kMaterials[material_num].name, "missing") == 0)
+			continue;
+
+		snprintf(line, sizeof(line), "newmtl %s\nKd 1.0 1.0 1.0\n", kMaterials[material_num].name);
+		text += line;
+		if (kMaterials[material_num].texture_num >= 0)
+		{
+			snprintf(line, sizeof(line), "map_Kd %s\n", kTextureFilenames[kMaterials[material_num].texture_num]);
+			text += line;
+		}
+	}
+	return text;
+}
+
+// the index of a primitive's material in the model, -1 for none or one that isn't the model's
+static Int32 MaterialIndex(const gef::Model& model, const gef::Primitive& primitive)
+{
+	const Int32 texture_count = sizeof(kTextureFilenames) / sizeof(kTextureFilenames[0]);
+	for (Int32 material_num = 0; material_num < texture_count; ++material_num)
+	{
+		if (primitive.material() && primitive.material() == model.material(material_num))
+			return material_num;
+	}
+	return -1;
+}
+
+static bool SameVector(const gef::Vector4& a, const gef::Vector4& b)
+{
+	return a.x() == b.x() && a.y() == b.y() && a.z() == b.z();
+}
+
+// the vertex data isn't kept by headless buffers, so this compares what was created from it, the cache files are compared for the data
+static void CheckSameModel(gef::Model& model, gef::Model& expected, const char* test_name)
+{
+	gef::Mesh* mesh = model.mesh();
+	gef::Mesh* expected_mesh = expected.mesh();
+	if (!Check(mesh != NULL && expected_mesh != NULL, test_name, "model has no mesh"))
+		return;
+
+	Check(mesh->vertex_buffer()->num_vertices() == expected_mesh->vertex_buffer()->num_vertices(), test_name, "vertex counts differ");
+	Check(SameVector(mesh->aabb().min_vtx(), expected_mesh->aabb().min_vtx()) && SameVector(mesh->aabb().max_vtx(), expected_mesh->aabb().max_vtx()),
+		test_name, "bounds differ");
+
+	if (!Check(mesh->num_primitives() == expected_mesh->num_primitives(), test_name, "primitive counts differ"))
+		return;
+
+	for (UInt32 primitive_num = 0; primitive_num < mesh->num_primitives(); ++primitive_num)
+	{
+		const gef::Primitive* primitive = mesh->GetPrimitive(primitive_num);
+		const gef::Primitive* expected_primitive = expected_mesh->GetPrimitive(primitive_num);
+		Check(primitive->type() == expected_primitive->type(), test_name, "primitive types differ");
+		Check(primitive->index_buffer()->num_indices() == expected_primitive->index_buffer()->num_indices(), test_name, "primitive index counts differ");
+		Check(MaterialIndex(model, *primitive) == MaterialIndex(expected, *expected_primitive), test_name, "primitive materials differ");
+	}
+}
+
+// checks the grid model against what was generated, so the comparisons between loads aren't of two equally wrong models
+static void CheckGridModel(gef::Model& model, const float* bounds_min, const float* bounds_max, const char* test_name)
+{
+	gef::Mesh* mesh = model.mesh();
+	if (!Check(mesh != NULL, test_name, "model has no mesh"))
+		return;
+
+	Check(mesh->vertex_buffer()->num_vertices() == (UInt32)(kPrimitiveCount * kIndicesPerPrimitive), test_name, "every triangle corner should be a vertex");
+
+	const gef::Vector4& min_vtx = mesh->aabb().min_vtx();
+	const gef::Vector4& max_vtx = mesh->aabb().max_vtx();
+	const float tolerance = 1e-5f;
+	Check(fabsf(min_vtx.x() - bounds_min[0]) < tolerance && fabsf(min_vtx.y() - bounds_min[1]) < tolerance && fabsf(min_vtx.z() - bounds_min[2]) < tolerance
+		&& fabsf(max_vtx.x() - bounds_max[0]) < tolerance && fabsf(max_vtx.y() - bounds_max[1]) < tolerance && fabsf(max_vtx.z() - bounds_max[2]) < tolerance,
+		test_name, "bounds don't match the generated positions");
+
+	if (!Check(mesh->num_primitives() == kPrimitiveCount, test_name, "there should be a primitive for each material change"))
+		return;
+
+	// the texture numbers of the materials the primitives ended up with
+	const gef::Material* texture_materials[2] = { NULL, NULL };
+	for (Int32 primitive_num = 0; primitive_num < kPrimitiveCount; ++primitive_num)
+	{
+		const gef::Primitive* primitive = mesh->GetPrimitive(primitive_num);
+		Check(primitive->index_buffer()->num_indices() == kIndicesPerPrimitive, test_name, "primitive has the wrong index count");
+
+		const Int32 texture_num = kMaterials[primitive_num % kMaterialCount].texture_num;
+		if (texture_num < 0)
+		{
+			Check(primitive->material() == NULL, test_name, "primitive without a texture has a material");
+			continue;
+		}
+
+		if (!Check(primitive->material() != NULL && primitive->material()->texture() != NULL, test_name, "primitive with a texture has no material"))
+			continue;
+
+		if (texture_materials[texture_num] == NULL)
+			texture_materials[texture_num] = primitive->material();
+		Check(primitive->material() == texture_materials[texture_num], test_name, "materials with the same texture should share a material");
+	}
+
+	Check(texture_materials[0] != texture_materials[1], test_name, "materials with different textures share a material");
+}
+
+static void TestParallelParse(gef::Platform& platform, const std::string& obj_filename, const float* bounds_min, const float* bounds_max)
+{
+	const char* const test_name = "parallel parse";
+
+	gef::OBJLoader serial_loader;
+	serial_loader.set_use_cache(true);
+	const std::string cache_filename = serial_loader.CacheFilename(obj_filename.c_str());
+
+	// the caches are written from the parsed data, so comparing them compares the vertices too
+	remove(cache_filename.c_str());
+	gef::Model serial_model;
+	std::string serial_cache;
+	if (!Check(serial_loader.Load(obj_filename.c_str(), platform, serial_model), test_name, "serial load failed"))
+		return;
+	Check(ReadFile(cache_filename, serial_cache), test_name, "serial load didn't write a cache file");
+	CheckGridModel(serial_model, bounds_min, bounds_max, test_name);
+
+	gef::JobSystem job_system(3);
+	gef::OBJLoader parallel_loader;
+	parallel_loader.set_use_cache(true);
+	parallel_loader.set_job_system(&job_system);
+
+	remove(cache_filename.c_str());
+	gef::Model parallel_model;
+	std::string parallel_cache;
+	if (!Check(parallel_loader.Load(obj_filename.c_str(), platform, parallel_model), test_name, "parallel load failed"))
+		return;
+	Check(ReadFile(cache_filename, parallel_cache), test_name, "parallel load didn't write a cache file");
+
+	CheckSameModel(parallel_model, serial_model, test_name);
+	Check(!serial_cache.empty() && parallel_cache == serial_cache, test_name, "serial and parallel parses wrote different cache files");
+}
+
+static void TestCache(gef::Platform& platform, const std::string& obj_filename, const std::string& obj_text)
+{
+	const char* const test_name = "cache";
+
+	gef::OBJLoader loader;
+	loader.set_use_cache(true);
+	const std::string cache_filename = loader.CacheFilename(obj_filename.c_str());
+
+	remove(cache_filename.c_str());
+	gef::Model parsed_model;
+	std::string cache;
+	if (!Check(loader.Load(obj_filename.c_str(), platform, parsed_model), test_name, "load failed")
+		|| !Check(ReadFile(cache_filename, cache), test_name, "load didn't write a cache file"))
+		return;
+
+	// the source is unchanged, so this maps the cache
+	{
+		gef::Model cached_model;
+		if (Check(loader.Load(obj_filename.c_str(), platform, cached_model), test_name, "cached load failed"))
+			CheckSameModel(cached_model, parsed_model, test_name);
+	}
+
+	// an unreadable cache is parsed again and replaced
+	{
+		Check(WriteFile(cache_filename, cache.substr(0, cache.size() / 2)), test_name, "couldn't truncate the cache file");
+		gef::Model reparsed_model;
+		std::string rewritten_cache;
+		if (Check(loader.Load(obj_filename.c_str(), platform, reparsed_model), test_name, "load with a truncated cache file failed"))
+			CheckSameModel(reparsed_model, parsed_model, test_name);
+		Check(ReadFile(cache_filename, rewritten_cache) && rewritten_cache == cache, test_name, "truncated cache file wasn't replaced");
+	}
+
+	// a changed source is parsed again and its cache replaced
+	{
+		Check(WriteFile(obj_filename, obj_text + "# edited\n"), test_name, "couldn't change the source");
+		gef::Model reparsed_model;
+		std::string rewritten_cache;
+		if (Check(loader.Load(obj_filename.c_str(), platform, reparsed_model), test_name, "load of the changed source failed"))
+			CheckSameModel(reparsed_model, parsed_model, test_name);
+		Check(ReadFile(cache_filename, rewritten_cache) && rewritten_cache.size() == cache.size() && rewritten_cache != cache, test_name,
+			"cache file of the changed source wasn't replaced");
+
+		Check(WriteFile(obj_filename, obj_text) && WriteFile(cache_filename, cache), test_name, "couldn't restore the source and cache file");
+	}
+
+	// without the source only the cache can be loaded
+	const std::string moved_filename = obj_filename + ".moved";
+	if (!Check(rename(obj_filename.c_str(), moved_filename.c_str()) == 0, test_name, "couldn't move the source"))
+		return;
+
+	{
+		gef::Model cached_model;
+		if (Check(loader.Load(obj_filename.c_str(), platform, cached_model), test_name, "cached load without the source failed"))
+			CheckSameModel(cached_model, parsed_model, test_name);
+	}
+
+	const UInt64 live_bytes = LiveBytes();
+	{
+		gef::Model model;
+		Check(WriteFile(cache_filename, cache.substr(0, cache.size() - 1)), test_name, "couldn't truncate the cache file");
+		Check(!loader.Load(obj_filename.c_str(), platform, model) && model.mesh() == NULL, test_name, "truncated cache file without the source loaded");
+
+		// a header that claims more vertices than the file holds, the count follows the magic, version, source time and size
+		std::string oversized_cache = cache;
+		memset(&oversized_cache[sizeof(UInt32) * 3 + sizeof(UInt64)], 0x7f, sizeof(Int32));
+		Check(WriteFile(cache_filename, oversized_cache), test_name, "couldn't write the cache file");
+		Check(!loader.Load(obj_filename.c_str(), platform, model) && model.mesh() == NULL, test_name, "cache file with a bad vertex count loaded");
+
+		Check(WriteFile(cache_filename, std::string("GOBJ")), test_name, "couldn't write the cache file");
+		Check(!loader.Load(obj_filename.c_str(), platform, model) && model.mesh() == NULL, test_name, "cache file shorter than its header loaded");
+
+		remove(cache_filename.c_str());
+		Check(!loader.Load(obj_filename.c_str(), platform, model) && model.mesh() == NULL, test_name, "missing source and cache file loaded");
+	}
+	Check(LiveBytes() == live_bytes, test_name, "failed loads leaked memory");
+
+	Check(rename(moved_filename.c_str(), obj_filename.c_str()) == 0, test_name, "couldn't move the source back");
+}
+
+static void TestFailure(gef::Platform& platform, const std::string& directory, const std::string& obj_text)
+{
+	const char* const test_name = "failure";
+
+	const char* const kBadModels[] =
+	{
+		"v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 4\n",			// position past the end
+		"v 0 0 0\nv 1 0 0\nv 0 1 0\nf -1 -2 -3\n",		// relative indices
+		"v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2\n",			// too few corners
+		"v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1/1 2/1 3/1\n",	// uv that doesn't exist
+		"v 0 zero 0\nv 1 0 0\nv 0 1 0\nf 1 2 3\n",		// not a number
+		"v 0 0\n"										// too few components, with no line end
+	};
+	const Int32 bad_model_count = sizeof(kBadModels) / sizeof(kBadModels[0]);
+
+	const std::string bad_filename = directory + "/obj_loader_test_bad.obj";
+
+	gef::JobSystem job_system(3);
+	gef::OBJLoader serial_loader;
+	gef::OBJLoader parallel_loader;
+	parallel_loader.set_job_system(&job_system);
+
+	const UInt64 live_bytes = LiveBytes();
+	{
+		gef::Model model;
+		Check(!serial_loader.Load((directory + "/missing.obj").c_str(), platform, model) && model.mesh() == NULL, test_name, "missing file loaded");
+
+		for (Int32 bad_model_num = 0; bad_model_num < bad_model_count; ++bad_model_num)
+		{
+			if (!Check(WriteFile(bad_filename, kBadModels[bad_model_num]), test_name, "couldn't write the bad model"))
+				continue;
+			Check(!serial_loader.Load(bad_filename.c_str(), platform, model) && model.mesh() == NULL, test_name, "bad model loaded");
+		}
+
+		// a bad line in one chunk of a parallel parse fails the whole model
+		std::string bad_text = obj_text;
+		const size_t middle = bad_text.find("\nf ", bad_text.size() / 2) + 1;
+		bad_text.insert(middle, "f 1 2 999999\n");
+		if (Check(WriteFile(bad_filename, bad_text), test_name, "couldn't write the bad model"))
+		{
+			Check(!parallel_loader.Load(bad_filename.c_str(), platform, model) && model.mesh() == NULL, test_name, "bad line in a parallel parse loaded");
+			Check(!serial_loader.Load(bad_filename.c_str(), platform, model) && model.mesh() == NULL, test_name, "bad line in a large serial parse loaded");
+		}
+	}
+	Check(LiveBytes() == live_bytes, test_name, "failed loads leaked memory");
+
+	remove(bad_filename.c_str());
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		printf("usage: obj_loader_test output_directory\n");
+		return 1;
+	}
+
+	gef::PlatformHeadless platform(960, 544);
+
+	const std::string directory = argv[1];
+	const std::string obj_filename = directory + "/obj_loader_test.obj";
+	const std::string mtl_filename = directory + "/obj_loader_test.mtl";
+
+	float bounds_min[3];
+	float bounds_max[3];
+	const std::string obj_text = GenerateOBJ(mtl_filename, bounds_min, bounds_max);
+	if (!WriteFile(obj_filename, obj_text) || !WriteFile(mtl_filename, GenerateMTL()))
+	{
+		printf("couldn't write the model to %s\n", directory.c_str());
+		return 1;
+	}
+
+	// large enough to be split into several chunks
+	Check(obj_text.size() >= 4 * gef::OBJLoader::kParallelParseSize, "setup", "generated model is too small for a parallel parse");
+
+	TestParallelParse(platform, obj_filename, bounds_min, bounds_max);
+	TestCache(platform, obj_filename, obj_text);
+	TestFailure(platform, directory, obj_text);
+
+	gef::OBJLoader loader;
+	remove(loader.CacheFilename(obj_filename.c_str()).c_str());
+	remove(obj_filename.c_str());
+	remove(mtl_filename.c_str());
+
+	if (g_failures)
+	{
+		printf("%d checks failed\n", g_failures);
+		return 1;
+	}
+
+	printf("all checks passed\n");
+	return 0;
+}
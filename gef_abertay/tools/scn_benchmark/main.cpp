@@ -0,0 +1,186 @@
+#include <platform/headless/system/platform_headless.h>
+#include <graphics/scene.h>
+#include <graphics/scene_file.h>
+#include <system/profiler.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#if defined(__unix__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Compares loading .scn files stored uncompressed and with compressed sections, from a cold and a warm page cache.
+// usage: scn_benchmark [-n loads] [-z level] input.scn...
+// Each input is written out both ways next to the working directory, loaded n times each way and the files removed again.
+// A load reads the scene and touches every vertex and index so the mapped data is paged in, as it would be by a mesh upload.
+
+static const char* const kRawFilename = "scn_benchmark_raw.scn";
+static const char* const kCompressedFilename = "scn_benchmark_compressed.scn";
+
+static long FileSize(const char* filename)
+{
+	FILE* file = fopen(filename, "rb");
+	if (!file)
+		return 0;
+
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fclose(file);
+	return size;
+}
+
+// drops the file from the page cache, returns false where that isn't possible
+static bool EvictFromPageCache(const char* filename)
+{
+#if defined(__unix__) && defined(POSIX_FADV_DONTNEED)
+	int fd = open(filename, O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	// only clean pages can be dropped
+	fdatasync(fd);
+	bool success = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+	close(fd);
+	return success;
+#else
+	return false;
+#endif
+}
+
+static UInt32 TouchBytes(const void* data, Int32 size)
+{
+	const UInt8* bytes = static_cast<const UInt8*>(data);
+	UInt32 sum = 0;
+	for (Int32 byte_num = 0; byte_num < size; ++byte_num)
+		sum += bytes[byte_num];
+	return sum;
+}
+
+// returns the load time in milliseconds, or a negative value if the file couldn't be read
+static double TimeLoad(const gef::Platform& platform, const char* filename, UInt32& checksum)
+{
+	const UInt64 start_ns = gef::Profiler::GetTimeNs();
+
+	gef::Scene scene;
+	if (!scene.ReadSceneFromFile(platform, filename))
+		return -1.0;
+
+	for (std::list<gef::MeshData>::const_iterator mesh_iter = scene.mesh_data.begin(); mesh_iter != scene.mesh_data.end(); ++mesh_iter)
+	{
+		const gef::VertexData& vertex_data = mesh_iter->vertex_data;
+		checksum += TouchBytes(vertex_data.vertices, vertex_data.num_vertices * vertex_data.vertex_byte_size);
+
+		for (std::vector<gef::PrimitiveData*>::const_iterator prim_iter = mesh_iter->primitives.begin(); prim_iter != mesh_iter->primitives.end(); ++prim_iter)
+			checksum += TouchBytes((*prim_iter)->indices, (*prim_iter)->num_indices * (*prim_iter)->index_byte_size);
+	}
+
+	return (double)(gef::Profiler::GetTimeNs() - start_ns) / 1000000.0;
+}
+
+// average of load_count loads, negative if any load failed
+static double AverageLoad(const gef::Platform& platform, const char* filename, int load_count, bool cold, UInt32& checksum)
+{
+	double total_ms = 0.0;
+	for (int load_num = 0; load_num < load_count; ++load_num)
+	{
+		if (cold)
+			EvictFromPageCache(filename);
+
+		double load_ms = TimeLoad(platform, filename, checksum);
+		if (load_ms < 0.0)
+			return -1.0;
+		total_ms += load_ms;
+	}
+
+	return total_ms / load_count;
+}
+
+int main(int argc, char* argv[])
+{
+	int load_count = 20;
+	Int32 compression_level = 6;
+	std::vector<const char*> input_filenames;
+
+	for (int arg_num = 1; arg_num < argc; ++arg_num)
+	{
+		if (strcmp(argv[arg_num], "-n") == 0 && arg_num + 1 < argc)
+			load_count = atoi(argv[++arg_num]);
+		else if (strcmp(argv[arg_num], "-z") == 0 && arg_num + 1 < argc)
+			compression_level = atoi(argv[++arg_num]);
+		else
+			input_filenames.push_back(argv[arg_num]);
+	}
+
+	if (input_filenames.empty() || load_count < 1 || compression_level < 1 || compression_level > 9)
+	{
+		printf("usage: scn_benchmark [-n loads] [-z level] input.scn...\n");
+		return 1;
+	}
+
+	gef::PlatformHeadless platform(960, 544);
+
+	const bool cold_supported = EvictFromPageCache(input_filenames[0]);
+	if (!cold_supported)
+		printf("dropping files from the page cache isn't supported here, only warm loads are timed\n");
+
+	printf("%d loads each, compression level %d, times in ms\n\n", load_count, compression_level);
+	printf("%-32s %10s %10s %7s %9s %9s %9s %9s\n", "file", "raw bytes", "z bytes", "ratio", "raw cold", "z cold", "raw warm", "z warm");
+
+	int result = 0;
+	UInt32 checksum = 0;
+	for (size_t input_num = 0; input_num < input_filenames.size(); ++input_num)
+	{
+		const char* input_filename = input_filenames[input_num];
+
+		bool success = true;
+		{
+			gef::Scene scene;
+			success = scene.ReadSceneFromFile(platform, input_filename)
+				&& scene.WriteSceneToFile(platform, kRawFilename, gef::SceneFile::kVersion, 0)
+				&& scene.WriteSceneToFile(platform, kCompressedFilename, gef::SceneFile::kVersion, compression_level);
+		}
+
+		if (!success)
+		{
+			printf("%-32s failed to read or convert\n", input_filename);
+			result = 1;
+			continue;
+		}
+
+		const long raw_size = FileSize(kRawFilename);
+		const long compressed_size = FileSize(kCompressedFilename);
+
+		double raw_cold_ms = 0.0;
+		double compressed_cold_ms = 0.0;
+		if (cold_supported)
+		{
+			raw_cold_ms = AverageLoad(platform, kRawFilename, load_count, true, checksum);
+			compressed_cold_ms = AverageLoad(platform, kCompressedFilename, load_count, true, checksum);
+		}
+
+		// one untimed load each to make sure both are in the cache
+		TimeLoad(platform, kRawFilename, checksum);
+		TimeLoad(platform, kCompressedFilename, checksum);
+		const double raw_warm_ms = AverageLoad(platform, kRawFilename, load_count, false, checksum);
+		const double compressed_warm_ms = AverageLoad(platform, kCompressedFilename, load_count, false, checksum);
+
+		std::string name(input_filename);
+		if (name.size() > 32)
+			name = "..." + name.substr(name.size() - 29);
+
+		printf("%-32s %10ld %10ld %6.2fx %9.3f %9.3f %9.3f %9.3f\n", name.c_str(), raw_size, compressed_size,
+			compressed_size > 0 ? (double)raw_size / compressed_size : 0.0,
+			raw_cold_ms, compressed_cold_ms, raw_warm_ms, compressed_warm_ms);
+	}
+
+	remove(kRawFilename);
+	remove(kCompressedFilename);
+
+	// stops the touched data being optimised away
+	printf("\nchecksum %08x\n", checksum);
+
+	return result;
+}
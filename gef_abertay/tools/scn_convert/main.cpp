@@ -0,0 +1,69 @@
+#include <platform/headless/system/platform_headless.h>
+#include <graphics/scene.h>
+#include <graphics/scene_file.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+// Converts .scn files between versions, by default to the current memory mapped format
+// usage: scn_convert [-v version] [-z level] input.scn output.scn
+// -v 1 writes the original stream format, -z 1 to 9 compresses the mesh, skeleton and animation data of a mapped file
+// The input can be any version and the output can be the same file as the input
+int main(int argc, char* argv[])
+{
+	UInt32 version = gef::SceneFile::kVersion;
+	Int32 compression_level = 0;
+	const char* input_filename = NULL;
+	const char* output_filename = NULL;
+
+	for (int arg_num = 1; arg_num < argc; ++arg_num)
+	{
+		if (strcmp(argv[arg_num], "-v") == 0 && arg_num + 1 < argc)
+			version = (UInt32)strtoul(argv[++arg_num], NULL, 10);
+		else if (strcmp(argv[arg_num], "-z") == 0 && arg_num + 1 < argc)
+			compression_level = atoi(argv[++arg_num]);
+		else if (!input_filename)
+			input_filename = argv[arg_num];
+		else
+			output_filename = argv[arg_num];
+	}
+
+	if (!input_filename || !output_filename || (version != 1 && version != gef::SceneFile::kVersion) || compression_level < 0 || compression_level > 9)
+	{
+		printf("usage: scn_convert [-v version] [-z level] input.scn output.scn\n");
+		return 1;
+	}
+
+	gef::PlatformHeadless platform(960, 544);
+
+	// converted in memory first, a version 2 input stays mapped until the scene is gone and may be the output file
+	std::ostringstream converted;
+	{
+		gef::Scene scene;
+		if (!scene.ReadSceneFromFile(platform, input_filename))
+		{
+			printf("scn_convert: failed to read %s\n", input_filename);
+			return 1;
+		}
+
+		bool success = version == gef::SceneFile::kVersion ? gef::SceneFile::Write(scene, converted, compression_level) : scene.WriteScene(converted);
+		if (!success)
+		{
+			printf("scn_convert: failed to convert %s\n", input_filename);
+			return 1;
+		}
+	}
+
+	std::ofstream output_stream(output_filename, std::ios::out | std::ios::binary);
+	const std::string& converted_data = converted.str();
+	output_stream.write(converted_data.data(), converted_data.size());
+	if (!output_stream)
+	{
+		printf("scn_convert: failed to write %s\n", output_filename);
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,138 @@
+#include <system/crc.h>
+#include <system/string_id.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+// Checks CRC and the string ids made from it against values worked out by the original bit at a time CRC,
+// so ids saved in scene files and hard coded in games keep matching whatever the CRC is optimised into.
+// usage: string_id_test
+
+struct KnownCRC
+{
+	const char* text;
+	UInt32 crc;
+	UInt32 icrc;
+};
+
+// from the bit at a time CRC that gef shipped with, covering the lengths either side of the eight byte steps,
+// mixed case, punctuation either side of a-z and bytes above 0x7f, including those that are a-z plus 0x80
+static const KnownCRC kKnownCRCs[] =
+{
+	{ "", 0x00000000, 0x00000000 },
+	{ "a", 0xe8b7be43, 0xd3d99e8b },
+	{ "A", 0xd3d99e8b, 0xd3d99e8b },
+	{ "root", 0x16f4f95b, 0x206114ef },
+	{ "Hips", 0xded10611, 0x4876449b },
+	{ "walk", 0x8d917a55, 0xbb0497e1 },
+	{ "123456789", 0xcbf43926, 0xcbf43926 },
+	{ "jump_blend", 0xa89a2303, 0xa4a93b0a },
+	{ "tesla@walk.scn", 0x30093bfc, 0xf9e26c5c },
+	{ "mixamorig:LeftHand", 0x9ca797f7, 0x40256d28 },
+	{ "mixamorig:lefthand", 0xc5e35a9f, 0x40256d28 },
+	{ "MIXAMORIG:LEFTHAND", 0x40256d28, 0x40256d28 },
+	{ "Bip01 R UpperArm [x]{}@`~", 0x8c421d9a, 0x97ed2c2d },
+	{ "caf\xc3\xa9 \xff\x80", 0x102d2f11, 0x214a71ed },
+	{ "na\xefve caf\xe9s \xe1\xfa", 0x0f37d0d6, 0x29b99e3e },
+	{ "The quick brown fox jumps over the lazy dog", 0x414fa339, 0x4c32b6b9 },
+};
+
+// ConstStringId has to agree with GetStringId without running anything
+static_assert(gef::ConstStringId("") == 0x00000000, "ConstStringId doesn't match GetStringId");
+static_assert(gef::ConstStringId("walk") == 0xbb0497e1, "ConstStringId doesn't match GetStringId");
+static_assert(gef::ConstStringId("jump_blend") == 0xa4a93b0a, "ConstStringId doesn't match GetStringId");
+static_assert(gef::ConstStringId("mixamorig:LeftHand") == 0x40256d28, "ConstStringId doesn't match GetStringId");
+static_assert(gef::ConstStringId("Bip01 R UpperArm [x]{}@`~") == 0x97ed2c2d, "ConstStringId doesn't match GetStringId");
+
+static int g_failures = 0;
+
+static bool Check(bool condition, const char* test_name, const char* description)
+{
+	if (!condition)
+	{
+		printf("%s: %s\n", test_name, description);
+		g_failures++;
+	}
+	return condition;
+}
+
+static void TestKnownValues()
+{
+	const char* const test_name = "known values";
+
+	const Int32 known_count = (Int32)(sizeof(kKnownCRCs) / sizeof(kKnownCRCs[0]));
+	for (Int32 known_num = 0; known_num < known_count; ++known_num)
+	{
+		const KnownCRC& known = kKnownCRCs[known_num];
+		const std::string text(known.text);
+
+		if (gef::CRC::GetCRC(known.text) != known.crc)
+			Check(false, test_name, (std::string("GetCRC changed for \"") + text + "\"").c_str());
+		if (gef::CRC::GetICRC(known.text) != known.icrc || gef::CRC::GetICRC(known.text, (Int32)text.size()) != known.icrc)
+			Check(false, test_name, (std::string("GetICRC changed for \"") + text + "\"").c_str());
+		if (gef::GetStringId(known.text) != known.icrc || gef::GetStringId(text) != known.icrc)
+			Check(false, test_name, (std::string("GetStringId changed for \"") + text + "\"").c_str());
+		if (gef::ConstStringId(known.text) != known.icrc)
+			Check(false, test_name, (std::string("ConstStringId changed for \"") + text + "\"").c_str());
+	}
+
+	Check(gef::CRC::GetCRC(NULL) == 0 && gef::CRC::GetICRC(NULL) == 0, test_name, "a NULL string should have the CRC of an empty one");
+}
+
+// the eight byte steps load words a byte at a time, so a string anywhere in memory and of any length hashes the same
+static void TestAlignment()
+{
+	const char* const test_name = "alignment";
+	const char* const text = "The quick brown fox jumps over the lazy dog";
+	const Int32 text_length = (Int32)strlen(text);
+
+	char buffer[64];
+	Int32 mismatches = 0;
+	for (Int32 offset = 0; offset < 8; ++offset)
+	{
+		for (Int32 length = 0; length <= text_length; ++length)
+		{
+			memcpy(buffer + offset, text, length);
+			buffer[offset + length] = '\0';
+
+			const std::string prefix(text, length);
+			const UInt32 expected = gef::ConstStringId(prefix.c_str());
+			if (gef::CRC::GetICRC(buffer + offset) != expected || gef::CRC::GetICRC(buffer + offset, length) != expected)
+				mismatches++;
+		}
+	}
+	Check(mismatches == 0, test_name, "GetICRC depends on where the string is or how long it is");
+
+	// the length overload stops where it's told, not at the terminator
+	Check(gef::CRC::GetICRC("walk_blend", 4) == gef::GetStringId("WALK"), test_name, "GetICRC read past the given length");
+}
+
+static void TestTable()
+{
+	const char* const test_name = "table";
+
+	gef::StringIdTable table;
+	const gef::StringId id = table.Add("mixamorig:LeftHand");
+	Check(id == 0x40256d28, test_name, "Add returned a different id from GetStringId");
+	Check(table.Add("MIXAMORIG:LEFTHAND") == id && table.table().size() == 1, test_name, "names differing only in case should share an entry");
+
+	std::string name;
+	Check(table.Find(id, name) && name == "mixamorig:LeftHand", test_name, "Find should return the first name added");
+	Check(!table.Find(gef::ConstStringId("walk"), name), test_name, "Find found a name that was never added");
+}
+
+int main(int argc, char* argv[])
+{
+	TestKnownValues();
+	TestAlignment();
+	TestTable();
+
+	if (g_failures)
+	{
+		printf("%d checks failed\n", g_failures);
+		return 1;
+	}
+
+	printf("all checks passed\n");
+	return 0;
+}
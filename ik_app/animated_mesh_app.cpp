@@ -15,13 +15,17 @@
 #include <maths/math_utils.h>
 #include <graphics/renderer_3d.h>
 #include <graphics/scene.h>
+#include <system/job_system.h>
 #include <animation/skeleton.h>
 #include <animation/animation.h>
 #include <system/debug_log.h>
 #include <maths/math_utils.h>
+#include <system/profiler.h>
 
 #include "picking.h"
 #include "ccd.h"
+#include "fabrik.h"
+#include "two_bone.h"
 
 std::string model_name("xbot");
 
@@ -36,7 +40,10 @@ AnimatedMeshApp::AnimatedMeshApp(gef::Platform& platform) :
 	model_scene_(NULL),
 	primitive_builder_(NULL),
 	primitive_renderer_(NULL),
-	effector_position_(gef::Vector4::kZero)
+	effector_position_(gef::Vector4::kZero),
+	ik_solver_(&ccd_solver_),
+	solve_time_ms_(0.0f),
+	picked_joint_(-1)
 {
 }
 
@@ -60,7 +67,11 @@ void AnimatedMeshApp::Init()
 	model_scene_->ReadSceneFromFile(platform_, model_scene_name.c_str());
 
 	// we do want to render the data stored in the scene file so lets create the materials from the material data present in the scene file
-	model_scene_->CreateMaterials(platform_);
+	// the textures are decoded on every core, the job system is only needed while loading
+	{
+		gef::JobSystem load_job_system;
+		model_scene_->CreateMaterials(platform_, &load_job_system);
+	}
 
 	// if there is mesh data in the scene, create a mesh to draw from the first mesh
 	mesh_ = GetFirstMesh(model_scene_);
@@ -83,6 +94,24 @@ void AnimatedMeshApp::Init()
 		}
 
 		ik_pose_ = player_->bind_pose();
+
+		std::vector<int> bone_indices;
+		bone_indices.push_back(16); // left shoulder
+		bone_indices.push_back(17); // left elbow
+		bone_indices.push_back(18); // left wrist
+
+		std::vector<std::pair<float, float>> constraints;
+		constraints.push_back(std::pair<float, float>(0.0f, gef::DegToRad(360.0f)));
+		constraints.push_back(std::pair<float, float>(0.0f, gef::DegToRad(360.0f)));
+		constraints.push_back(std::pair<float, float>(0.0f, gef::DegToRad(360.0f)));
+
+		ccd_solver_.Init(*skeleton, bone_indices, constraints);
+		fabrik_solver_.Init(*skeleton, bone_indices, constraints);
+		two_bone_solver_.Init(*skeleton, bone_indices, constraints);
+
+		// capsules around the bones for picking, fitted to the skin of the mesh
+		character_picker_.Init(*skeleton, model_scene_->mesh_data.empty() ? NULL : &model_scene_->mesh_data.front());
+		pick_scene_.Init(1);
 	}
 
 	primitive_builder_ = new PrimitiveBuilder(platform_);
@@ -144,8 +173,25 @@ bool AnimatedMeshApp::Update(float frame_time)
 			if (keyboard->IsKeyPressed(gef::Keyboard::KC_SPACE))
 			{
 				ik_pose_ = player_->bind_pose();
+				ccd_solver_.Reset();
+				fabrik_solver_.Reset();
+				two_bone_solver_.Reset();
 				player_->UpdateBoneMatrices(ik_pose_);
 			}
+
+			// switch solvers, the new one starts from whatever pose the last one left behind
+			IKSolver* selected_solver = ik_solver_;
+			if (keyboard->IsKeyPressed(gef::Keyboard::KC_1))
+				selected_solver = &ccd_solver_;
+			if (keyboard->IsKeyPressed(gef::Keyboard::KC_2))
+				selected_solver = &fabrik_solver_;
+			if (keyboard->IsKeyPressed(gef::Keyboard::KC_3))
+				selected_solver = &two_bone_solver_;
+			if (selected_solver != ik_solver_)
+			{
+				ik_solver_ = selected_solver;
+				ik_solver_->Reset();
+			}
 		}
 
 		// mouse
@@ -154,7 +200,7 @@ bool AnimatedMeshApp::Update(float frame_time)
 	}
 
 
-	if (mb_down)
+	if (mb_down && player_)
 	{
 		gef::Vector4 mouse_ray_start_point, mouse_ray_direction;
 		//mouse_position = gef::Vector2(600, 300);
@@ -162,21 +208,13 @@ bool AnimatedMeshApp::Update(float frame_time)
 
 		if (RayPlaneIntersect(mouse_ray_start_point, mouse_ray_direction, gef::Vector4(0.0f, 0.0f, 0.0f), gef::Vector4(0.0f, 0.0f, 1.0f), effector_position_))
 		{
-			std::vector<int> bone_indices;
-			bone_indices.push_back(16); // left shoulder
-			bone_indices.push_back(17); // left elbow
-			bone_indices.push_back(18); // left wrist
-
-			std::vector<std::pair<float, float>> constraints;
-			constraints.push_back(std::pair<float, float>(0.0f, gef::DegToRad(360.0f)));
-			constraints.push_back(std::pair<float, float>(0.0f, gef::DegToRad(360.0f)));
-			constraints.push_back(std::pair<float, float>(0.0f, gef::DegToRad(360.0f)));
+			// the solver works in model space
+			gef::Matrix44 world_to_model;
+			world_to_model.Inverse(player_->transform());
 
-			std::vector<int> priority_bones;
-			priority_bones.push_back(0);
-			priority_bones.push_back(1);
-
-			CalculateCCD(ik_pose_, *player_, effector_position_, bone_indices, constraints, priority_bones);
+			UInt64 solve_start = gef::Profiler::GetTimeNs();
+			ik_solver_->Solve(ik_pose_, effector_position_.Transform(world_to_model));
+			solve_time_ms_ = (float)(gef::Profiler::GetTimeNs() - solve_start) * 1e-6f;
 
 			player_->UpdateBoneMatrices(ik_pose_);
 		}
@@ -184,7 +222,17 @@ bool AnimatedMeshApp::Update(float frame_time)
 
 	if (player_)
 	{
+		// find the bone under the mouse
+		gef::Vector4 mouse_ray_start_point, mouse_ray_direction;
+		GetScreenPosRay(mouse_position, renderer_3d_->projection_matrix(), renderer_3d_->view_matrix(), mouse_ray_start_point, mouse_ray_direction, (float)platform_.width(), (float)platform_.height(), ndc_zmin_);
 
+		character_picker_.Refit(ik_pose_);
+		pick_scene_.Clear();
+		pick_scene_.AddCharacter(character_picker_, player_->transform());
+		pick_scene_.Build();
+
+		PickResult pick_result;
+		picked_joint_ = pick_scene_.Raycast(mouse_ray_start_point, mouse_ray_direction, pick_result) ? pick_result.joint : -1;
 	}
 
 	return true;
@@ -250,6 +298,17 @@ void AnimatedMeshApp::DrawHUD()
 	{
 		// display frame rate
 		font_->RenderText(sprite_renderer_, gef::Vector4(850.0f, 510.0f, -0.9f), 1.0f, 0xffffffff, gef::TJ_LEFT, "FPS: %.1f", fps_);
+
+		// compare the solvers on the last solve
+		font_->RenderText(sprite_renderer_, gef::Vector4(10.0f, 10.0f, -0.9f), 1.0f, 0xffffffff, gef::TJ_LEFT, "%s (1: CCD, 2: FABRIK, 3: Two bone)", ik_solver_->name());
+		font_->RenderText(sprite_renderer_, gef::Vector4(10.0f, 40.0f, -0.9f), 1.0f, 0xffffffff, gef::TJ_LEFT, "Iterations: %d Error: %.4f Time: %.3fms", ik_solver_->iterations(), ik_solver_->error(), solve_time_ms_);
+
+		if (picked_joint_ != -1)
+		{
+			std::string bone_name;
+			model_scene_->string_id_table.Find(player_->bind_pose().skeleton()->joint(picked_joint_).name_id, bone_name);
+			font_->RenderText(sprite_renderer_, gef::Vector4(10.0f, 70.0f, -0.9f), 1.0f, 0xffffffff, gef::TJ_LEFT, "Bone: %d %s", picked_joint_, bone_name.c_str());
+		}
 	}
 }
 
@@ -10,6 +10,10 @@
 #include <graphics/skinned_mesh_instance.h>
 #include "primitive_builder.h"
 #include "primitive_renderer.h"
+#include "ccd.h"
+#include "fabrik.h"
+#include "two_bone.h"
+#include "character_picking.h"
 
 // FRAMEWORK FORWARD DECLARATIONS
 namespace gef
@@ -72,6 +76,15 @@ private:
 
 	gef::Vector4 effector_position_;
 	gef::SkeletonPose ik_pose_;
+	CCDSolver ccd_solver_;
+	FABRIKSolver fabrik_solver_;
+	TwoBoneSolver two_bone_solver_;
+	IKSolver* ik_solver_;
+	float solve_time_ms_;
+
+	CharacterPicker character_picker_;
+	PickScene pick_scene_;
+	int picked_joint_;
 	float ndc_zmin_;
 };
 
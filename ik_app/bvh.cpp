@@ -0,0 +1,118 @@
+#include "bvh.h"
+#include <algorithm>
+
+bool RayAabbIntersect(const gef::Vector4& start, const gef::Vector4& inv_direction, const gef::Aabb& box, float max_t, float& t_near)
+{
+	float t1 = (box.min_vtx().x() - start.x()) * inv_direction.x();
+	float t2 = (box.max_vtx().x() - start.x()) * inv_direction.x();
+	float t_min = std::min(t1, t2);
+	float t_max = std::max(t1, t2);
+
+	t1 = (box.min_vtx().y() - start.y()) * inv_direction.y();
+	t2 = (box.max_vtx().y() - start.y()) * inv_direction.y();
+	t_min = std::max(t_min, std::min(t1, t2));
+	t_max = std::min(t_max, std::max(t1, t2));
+
+	t1 = (box.min_vtx().z() - start.z()) * inv_direction.z();
+	t2 = (box.max_vtx().z() - start.z()) * inv_direction.z();
+	t_min = std::max(t_min, std::min(t1, t2));
+	t_max = std::min(t_max, std::max(t1, t2));
+
+	t_near = std::max(t_min, 0.0f);
+	return t_max >= t_near && t_near <= max_t;
+}
+
+Bvh::Bvh() :
+	build_bounds_(NULL)
+{
+}
+
+void Bvh::Reserve(int max_leaves)
+{
+	nodes_.reserve(max_leaves * 2);
+	leaf_order_.reserve(max_leaves);
+	leaf_centres_.reserve(max_leaves);
+}
+
+void Bvh::Build(const std::vector<gef::Aabb>& leaf_bounds, int leaf_count)
+{
+	nodes_.clear();
+	leaf_order_.resize(leaf_count);
+	leaf_centres_.resize(leaf_count);
+	if (leaf_count == 0)
+		return;
+
+	for (int leaf = 0; leaf < leaf_count; ++leaf)
+	{
+		leaf_order_[leaf] = leaf;
+		leaf_centres_[leaf] = (leaf_bounds[leaf].min_vtx() + leaf_bounds[leaf].max_vtx()) * 0.5f;
+	}
+
+	build_bounds_ = &leaf_bounds;
+	BuildNode(0, leaf_count);
+	build_bounds_ = NULL;
+}
+
+int Bvh::BuildNode(int first, int count)
+{
+	const std::vector<gef::Aabb>& leaf_bounds = *build_bounds_;
+
+	const int node_num = (int)nodes_.size();
+	nodes_.push_back(Node());
+	Node node;
+	node.left = -1;
+	node.right = -1;
+	node.leaf = -1;
+
+	if (count == 1)
+	{
+		node.leaf = leaf_order_[first];
+		node.bounds = leaf_bounds[node.leaf];
+		nodes_[node_num] = node;
+		return node_num;
+	}
+
+	// split at the median leaf centre along the longest axis of the centres
+	gef::Aabb centre_bounds;
+	for (int i = first; i < first + count; ++i)
+		centre_bounds.Update(leaf_centres_[leaf_order_[i]]);
+	gef::Vector4 extent = centre_bounds.max_vtx() - centre_bounds.min_vtx();
+	int axis = extent.x() > extent.y() ? (extent.x() > extent.z() ? 0 : 2) : (extent.y() > extent.z() ? 1 : 2);
+
+	const int half = count / 2;
+	const std::vector<gef::Vector4>& centres = leaf_centres_;
+	std::nth_element(leaf_order_.begin() + first, leaf_order_.begin() + first + half, leaf_order_.begin() + first + count,
+		[&centres, axis](int a, int b)
+		{
+			const gef::Vector4& centre_a = centres[a];
+			const gef::Vector4& centre_b = centres[b];
+			return axis == 0 ? centre_a.x() < centre_b.x() : (axis == 1 ? centre_a.y() < centre_b.y() : centre_a.z() < centre_b.z());
+		});
+
+	node.left = BuildNode(first, half);
+	node.right = BuildNode(first + half, count - half);
+	node.bounds = nodes_[node.left].bounds;
+	node.bounds.Update(nodes_[node.right].bounds.min_vtx());
+	node.bounds.Update(nodes_[node.right].bounds.max_vtx());
+	nodes_[node_num] = node;
+
+	return node_num;
+}
+
+void Bvh::Refit(const std::vector<gef::Aabb>& leaf_bounds)
+{
+	for (int node_num = (int)nodes_.size() - 1; node_num >= 0; --node_num)
+	{
+		Node& node = nodes_[node_num];
+		if (node.leaf != -1)
+		{
+			node.bounds = leaf_bounds[node.leaf];
+		}
+		else
+		{
+			node.bounds = nodes_[node.left].bounds;
+			node.bounds.Update(nodes_[node.right].bounds.min_vtx());
+			node.bounds.Update(nodes_[node.right].bounds.max_vtx());
+		}
+	}
+}
@@ -0,0 +1,110 @@
+#ifndef _BVH_H
+#define _BVH_H
+
+#include <maths/aabb.h>
+#include <vector>
+
+// Bounding volume hierarchy over a fixed set of leaf boxes.
+// The tree shape is built once from the leaf bounds and the boxes can then be refitted as the leaves
+// move, which keeps it cheap to update every frame. Nodes are stored with every parent before its
+// children, so refitting is a single backwards walk.
+class Bvh
+{
+public:
+	struct Node
+	{
+		gef::Aabb bounds;
+		int left;		// child nodes, -1 for a leaf
+		int right;
+		int leaf;		// leaf index for a leaf node, -1 otherwise
+	};
+
+	Bvh();
+
+	// allocate space for max_leaves so building and refitting never allocates
+	void Reserve(int max_leaves);
+
+	void Build(const std::vector<gef::Aabb>& leaf_bounds, int leaf_count);
+	void Refit(const std::vector<gef::Aabb>& leaf_bounds);
+
+	// finds the closest leaf along the ray, leaf_test(leaf, closest_t, t) must return true and set t when
+	// the ray hits something in the leaf closer than closest_t. direction does not have to be normalised,
+	// t is in multiples of it
+	template<typename LeafTest>
+	bool Raycast(const gef::Vector4& start, const gef::Vector4& direction, float max_t, LeafTest& leaf_test, float& hit_t, int& hit_leaf) const;
+
+	inline bool empty() const { return nodes_.empty(); }
+	inline const gef::Aabb& bounds() const { return nodes_.front().bounds; }
+	inline const std::vector<Node>& nodes() const { return nodes_; }
+
+private:
+	int BuildNode(int first, int count);
+
+	std::vector<Node> nodes_;
+	std::vector<int> leaf_order_;
+	std::vector<gef::Vector4> leaf_centres_;
+	const std::vector<gef::Aabb>* build_bounds_;
+
+	// deep enough for any tree built from the median splits below
+	static const int kMaxStackDepth = 64;
+};
+
+// slab test, returns the distance along the ray to the box in t_near
+bool RayAabbIntersect(const gef::Vector4& start, const gef::Vector4& inv_direction, const gef::Aabb& box, float max_t, float& t_near);
+
+template<typename LeafTest>
+bool Bvh::Raycast(const gef::Vector4& start, const gef::Vector4& direction, float max_t, LeafTest& leaf_test, float& hit_t, int& hit_leaf) const
+{
+	if (nodes_.empty())
+		return false;
+
+	// infinite components are fine here, the slab test still gives the right answer
+	const gef::Vector4 inv_direction(1.0f / direction.x(), 1.0f / direction.y(), 1.0f / direction.z());
+
+	float closest_t = max_t;
+	hit_leaf = -1;
+
+	int stack[kMaxStackDepth];
+	int stack_size = 0;
+	stack[stack_size++] = 0;
+
+	while (stack_size > 0)
+	{
+		const Node& node = nodes_[stack[--stack_size]];
+
+		float node_t;
+		if (!RayAabbIntersect(start, inv_direction, node.bounds, closest_t, node_t))
+			continue;
+
+		if (node.leaf != -1)
+		{
+			float leaf_t;
+			if (leaf_test(node.leaf, closest_t, leaf_t))
+			{
+				closest_t = leaf_t;
+				hit_leaf = node.leaf;
+			}
+			continue;
+		}
+
+		// visit the nearer child first so the further one is more likely to be culled
+		float left_t, right_t;
+		bool hit_left = RayAabbIntersect(start, inv_direction, nodes_[node.left].bounds, closest_t, left_t);
+		bool hit_right = RayAabbIntersect(start, inv_direction, nodes_[node.right].bounds, closest_t, right_t);
+		if (hit_left && hit_right)
+		{
+			bool left_first = left_t <= right_t;
+			stack[stack_size++] = left_first ? node.right : node.left;
+			stack[stack_size++] = left_first ? node.left : node.right;
+		}
+		else if (hit_left)
+			stack[stack_size++] = node.left;
+		else if (hit_right)
+			stack[stack_size++] = node.right;
+	}
+
+	hit_t = closest_t;
+	return hit_leaf != -1;
+}
+
+#endif // _BVH_H
@@ -2,15 +2,21 @@
 #include <algorithm>
 #include <system/debug_log.h>
 #include <maths/math_utils.h>
+#include <system/profiler.h>
+#include <system/memory_tracker.h>
 
 bool CalculateCCD(
 	gef::SkeletonPose& pose,
 	const gef::SkinnedMeshInstance& animatedModel,
 	const gef::Vector4& destPoint,
 	const std::vector<int>& boneIndices,
-	std::vector<std::pair<float, float>> constraints,
-	std::vector<int> priorityBones)
+	const std::vector<std::pair<float, float>>& constraints,
+	const std::vector<int>& priorityBones,
+	int* iterations)
 {
+	GEF_PROFILE_ZONE("CalculateCCD");
+	GEF_MEMORY_TAG(gef::MT_IK);
+
 	std::vector<gef::Matrix44> global_pose;
 	std::vector<gef::Matrix44> local_pose;
 	local_pose.resize(pose.skeleton()->joint_count());
@@ -40,7 +46,8 @@ bool CalculateCCD(
 	//min distance
 	float epsilon = 0.001f;
 	//max number of iterations is used to stop CCD if there is no solution
-	int maxIterations = 200;
+	const int iterationLimit = 200;
+	int maxIterations = iterationLimit;
 
 	//perform the CCD algorithm if all the following conditions are valid
 	/*
@@ -89,7 +96,7 @@ bool CalculateCCD(
 				angle = acosf(vecDot);
 			}
 
-			//enforce contraint of joint so that joint does not rotate past an angle
+			//enforce constraint of joint so that joint does not rotate past an angle
 			angle = std::max(angle, constraints[index].first);
 			angle = std::min(angle, constraints[index].second);
 
@@ -191,6 +198,8 @@ bool CalculateCCD(
 	pose.CalculateLocalPose(global_pose);
 	pose.CalculateGlobalPose();
 
+	if (iterations)
+		*iterations = iterationLimit - maxIterations;
 
 	if (maxIterations <= 0)
 	{
@@ -205,3 +214,72 @@ bool CalculateCCD(
 	}
 
 }
+
+
+bool CCDSolver::Solve(gef::SkeletonPose& pose, const gef::Vector4& target)
+{
+	GEF_PROFILE_ZONE("CCDSolver::Solve");
+	GEF_MEMORY_TAG(gef::MT_IK);
+
+	const int chain_length = (int)bone_indices_.size();
+	if (chain_length == 0)
+		return false;
+
+	ReadChain(pose);
+
+	const gef::Vector4& end_effector = global_positions_[chain_length - 1];
+	error_ = (end_effector - target).Length();
+	iterations_ = 0;
+
+	while (error_ > epsilon_ && iterations_ < max_iterations_)
+	{
+		++iterations_;
+		const float previous_error = error_;
+
+		// the end effector is the last joint, so rotating it can't move it towards the target
+		for (int joint_num = chain_length - 2; joint_num >= 0 && error_ > epsilon_; --joint_num)
+		{
+			const gef::Vector4& joint_position = global_positions_[joint_num];
+
+			gef::Vector4 to_end_effector = end_effector - joint_position;
+			gef::Vector4 to_target = target - joint_position;
+			float to_end_effector_length = to_end_effector.Length();
+			float to_target_length = to_target.Length();
+			if (to_end_effector_length < epsilon_ || to_target_length < epsilon_)
+				continue;
+
+			to_end_effector /= to_end_effector_length;
+			to_target /= to_target_length;
+
+			gef::Vector4 axis = to_end_effector.CrossProduct(to_target);
+			float axis_length = axis.Length();
+			if (axis_length < 1e-9f)
+				continue;
+			axis /= axis_length;
+
+			// acosf of the dot product can't resolve angles below about 3e-4 radians in float precision,
+			// which left the end effector stuck short of the target on larger models
+			float angle = atan2f(axis_length, to_end_effector.DotProduct(to_target));
+
+			// enforce constraint of joint so that joint does not rotate past an angle
+			angle = std::max(angle, constraints_[joint_num].first);
+			angle = std::min(angle, constraints_[joint_num].second);
+			if (angle == 0.0f)
+				continue;
+
+			// model space rotation that swings the end effector towards the target
+			float sin_half_angle = sinf(angle * 0.5f);
+			RotateJoint(joint_num, gef::Quaternion(axis.x() * sin_half_angle, axis.y() * sin_half_angle, axis.z() * sin_half_angle, cosf(angle * 0.5f)));
+
+			error_ = (end_effector - target).Length();
+		}
+
+		// stop once a pass barely moves the end effector, an unreachable or blocked target won't get any closer
+		if (previous_error - error_ < epsilon_ * 0.01f)
+			break;
+	}
+
+	WriteChain(pose);
+
+	return error_ <= epsilon_;
+}
@@ -1,14 +1,27 @@
 #ifndef _CCD_H
+#define _CCD_H
 
 #include <animation/skeleton.h>
 #include <graphics/skinned_mesh_instance.h>
+#include "ik_solver.h"
+#include <vector>
 
 bool CalculateCCD(
 	gef::SkeletonPose& pose,
 	const gef::SkinnedMeshInstance& animatedModel,
 	const gef::Vector4& destPoint,
 	const std::vector<int>& boneIndices,
-	std::vector<std::pair<float, float>> constraints,
-	std::vector<int> priority_bones);
+	const std::vector<std::pair<float, float>>& constraints,
+	const std::vector<int>& priority_bones,
+	int* iterations = NULL);
+
+// Cyclic coordinate descent, rotates each joint in turn from the end of the chain back to the root
+// so the end effector points at the target
+class CCDSolver : public IKSolver
+{
+public:
+	bool Solve(gef::SkeletonPose& pose, const gef::Vector4& target);
+	const char* name() const { return "CCD"; }
+};
 
 #endif // !_CCD_H
@@ -0,0 +1,267 @@
+#include "character_picking.h"
+#include "picking.h"
+#include <graphics/mesh.h>
+#include <graphics/mesh_data.h>
+#include <system/profiler.h>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+bool CharacterPicker::Init(const gef::Skeleton& skeleton, const gef::MeshData* mesh_data, float default_radius_scale)
+{
+	const int joint_count = skeleton.joint_count();
+	capsules_.clear();
+	capsules_.reserve(joint_count);
+
+	// bind pose positions, then the average position of each joint's children in the joint's own space
+	std::vector<gef::Vector4> bind_positions(joint_count);
+	for (int joint_num = 0; joint_num < joint_count; ++joint_num)
+	{
+		gef::Matrix44 bind_pose;
+		bind_pose.Inverse(skeleton.joint(joint_num).inv_bind_pose);
+		bind_positions[joint_num] = bind_pose.GetTranslation();
+	}
+
+	std::vector<gef::Vector4> child_centres(joint_count, gef::Vector4(0.0f, 0.0f, 0.0f));
+	std::vector<int> child_counts(joint_count, 0);
+	for (int joint_num = 0; joint_num < joint_count; ++joint_num)
+	{
+		int parent = skeleton.joint(joint_num).parent;
+		if (parent == -1)
+			continue;
+		child_centres[parent] += bind_positions[joint_num].Transform(skeleton.joint(parent).inv_bind_pose);
+		++child_counts[parent];
+	}
+
+	// every vertex belongs to the bone with the largest weight, moved into that bone's space
+	std::vector<gef::Vector4> local_vertices;
+	std::vector<int> vertex_joints;
+	std::vector<gef::Vector4> vertex_centres(joint_count, gef::Vector4(0.0f, 0.0f, 0.0f));
+	std::vector<int> vertex_counts(joint_count, 0);
+	if (mesh_data && mesh_data->vertex_data.vertex_byte_size == sizeof(gef::Mesh::SkinnedVertex))
+	{
+		const gef::Mesh::SkinnedVertex* vertices = static_cast<const gef::Mesh::SkinnedVertex*>(mesh_data->vertex_data.vertices);
+		local_vertices.resize(mesh_data->vertex_data.num_vertices);
+		vertex_joints.resize(mesh_data->vertex_data.num_vertices);
+		for (int vertex_num = 0; vertex_num < mesh_data->vertex_data.num_vertices; ++vertex_num)
+		{
+			const gef::Mesh::SkinnedVertex& vertex = vertices[vertex_num];
+			int influence = 0;
+			for (int i = 1; i < 4; ++i)
+			{
+				if (vertex.bone_weights[i] > vertex.bone_weights[influence])
+					influence = i;
+			}
+
+			int joint_num = vertex.bone_indices[influence];
+			if (joint_num >= joint_count)
+			{
+				vertex_joints[vertex_num] = -1;
+				continue;
+			}
+
+			vertex_joints[vertex_num] = joint_num;
+			local_vertices[vertex_num] = gef::Vector4(vertex.px, vertex.py, vertex.pz).Transform(skeleton.joint(joint_num).inv_bind_pose);
+			vertex_centres[joint_num] += local_vertices[vertex_num];
+			++vertex_counts[joint_num];
+		}
+	}
+
+	// the capsule runs along the bone towards the children, or towards the middle of the skin for an end bone
+	std::vector<gef::Vector4> axes(joint_count);
+	std::vector<float> axis_lengths(joint_count, 0.0f);
+	for (int joint_num = 0; joint_num < joint_count; ++joint_num)
+	{
+		gef::Vector4 axis(0.0f, 0.0f, 0.0f);
+		if (child_counts[joint_num] > 0)
+			axis = child_centres[joint_num] / (float)child_counts[joint_num];
+		if (axis.LengthSqr() < 1e-8f && vertex_counts[joint_num] > 0)
+			axis = vertex_centres[joint_num] / (float)vertex_counts[joint_num];
+
+		axis_lengths[joint_num] = axis.Length();
+		axes[joint_num] = axis_lengths[joint_num] > 1e-4f ? axis / axis_lengths[joint_num] : gef::Vector4(0.0f, 1.0f, 0.0f);
+	}
+
+	// fit the skin with the extents of the vertices along and around the bone
+	std::vector<float> along_min(joint_count, 0.0f);
+	std::vector<float> along_max(joint_count, 0.0f);
+	std::vector<float> radii(joint_count, 0.0f);
+	for (size_t vertex_num = 0; vertex_num < local_vertices.size(); ++vertex_num)
+	{
+		int joint_num = vertex_joints[vertex_num];
+		if (joint_num == -1)
+			continue;
+
+		const gef::Vector4& vertex = local_vertices[vertex_num];
+		float along = vertex.DotProduct(axes[joint_num]);
+		float around = (vertex - axes[joint_num] * along).Length();
+		along_min[joint_num] = std::min(along_min[joint_num], along);
+		along_max[joint_num] = std::max(along_max[joint_num], along);
+		radii[joint_num] = std::max(radii[joint_num], around);
+	}
+
+	for (int joint_num = 0; joint_num < joint_count; ++joint_num)
+	{
+		const gef::Vector4& axis = axes[joint_num];
+		if (vertex_counts[joint_num] > 0 && radii[joint_num] > 0.0f)
+		{
+			// pull the ends in by the radius so the rounded caps sit on the extents
+			float radius = radii[joint_num];
+			float start = along_min[joint_num] + radius;
+			float end = along_max[joint_num] - radius;
+			if (start > end)
+				start = end = (along_min[joint_num] + along_max[joint_num]) * 0.5f;
+			AddCapsule(joint_num, axis * start, axis * end, radius);
+		}
+		else if (child_counts[joint_num] > 0 && axis_lengths[joint_num] > 1e-4f)
+		{
+			AddCapsule(joint_num, gef::Vector4(0.0f, 0.0f, 0.0f), axis * axis_lengths[joint_num], axis_lengths[joint_num] * default_radius_scale);
+		}
+	}
+
+	if (capsules_.empty())
+		return false;
+
+	// build the tree around the bind pose
+	gef::SkeletonPose bind_pose;
+	bind_pose.CreateBindPose(&skeleton);
+	bind_pose.CalculateGlobalPose();
+	capsule_bounds_.resize(capsules_.size());
+	bvh_.Reserve((int)capsules_.size());
+	for (size_t capsule_num = 0; capsule_num < capsules_.size(); ++capsule_num)
+	{
+		Capsule& capsule = capsules_[capsule_num];
+		capsule.start = capsule.local_start.Transform(bind_pose.global_pose()[capsule.joint]);
+		capsule.end = capsule.local_end.Transform(bind_pose.global_pose()[capsule.joint]);
+	}
+	CalculateBounds();
+	bvh_.Build(capsule_bounds_, (int)capsules_.size());
+
+	return true;
+}
+
+void CharacterPicker::AddCapsule(int joint, const gef::Vector4& local_start, const gef::Vector4& local_end, float radius)
+{
+	Capsule capsule;
+	capsule.joint = joint;
+	capsule.local_start = local_start;
+	capsule.local_end = local_end;
+	capsule.start = local_start;
+	capsule.end = local_end;
+	capsule.radius = radius;
+	capsules_.push_back(capsule);
+}
+
+void CharacterPicker::CalculateBounds()
+{
+	for (size_t capsule_num = 0; capsule_num < capsules_.size(); ++capsule_num)
+	{
+		const Capsule& capsule = capsules_[capsule_num];
+		const gef::Vector4 radius(capsule.radius, capsule.radius, capsule.radius);
+		gef::Aabb& bounds = capsule_bounds_[capsule_num];
+		bounds = gef::Aabb();
+		bounds.Update(capsule.start - radius);
+		bounds.Update(capsule.start + radius);
+		bounds.Update(capsule.end - radius);
+		bounds.Update(capsule.end + radius);
+	}
+}
+
+void CharacterPicker::Refit(const gef::SkeletonPose& pose)
+{
+	GEF_PROFILE_ZONE("CharacterPicker::Refit");
+
+	for (size_t capsule_num = 0; capsule_num < capsules_.size(); ++capsule_num)
+	{
+		Capsule& capsule = capsules_[capsule_num];
+		const gef::Matrix44& joint_transform = pose.global_pose()[capsule.joint];
+		capsule.start = capsule.local_start.Transform(joint_transform);
+		capsule.end = capsule.local_end.Transform(joint_transform);
+	}
+
+	CalculateBounds();
+	bvh_.Refit(capsule_bounds_);
+}
+
+bool CharacterPicker::Raycast(const gef::Vector4& start, const gef::Vector4& direction, float max_t, float& hit_t, int& hit_joint) const
+{
+	const std::vector<Capsule>& capsules = capsules_;
+	auto leaf_test = [&](int leaf, float closest_t, float& t)
+	{
+		const Capsule& capsule = capsules[leaf];
+		return RayCapsuleIntersect(start, direction, capsule.start, capsule.end, capsule.radius, t) && t < closest_t;
+	};
+
+	int hit_capsule;
+	if (!bvh_.Raycast(start, direction, max_t, leaf_test, hit_t, hit_capsule))
+		return false;
+
+	hit_joint = capsules_[hit_capsule].joint;
+	return true;
+}
+
+void PickScene::Init(int max_characters)
+{
+	characters_.reserve(max_characters);
+	character_bounds_.reserve(max_characters);
+	bvh_.Reserve(max_characters);
+}
+
+void PickScene::Clear()
+{
+	characters_.clear();
+	character_bounds_.clear();
+}
+
+int PickScene::AddCharacter(const CharacterPicker& picker, const gef::Matrix44& transform)
+{
+	Character character;
+	character.picker = &picker;
+	character.transform = transform;
+	character.inv_transform.Inverse(transform);
+	characters_.push_back(character);
+	character_bounds_.push_back(picker.bounds().Transform(transform));
+
+	return (int)characters_.size() - 1;
+}
+
+void PickScene::Build()
+{
+	GEF_PROFILE_ZONE("PickScene::Build");
+
+	// characters move anywhere from frame to frame, so rebuild rather than refit
+	bvh_.Build(character_bounds_, (int)characters_.size());
+}
+
+bool PickScene::Raycast(const gef::Vector4& start, const gef::Vector4& direction, PickResult& result) const
+{
+	GEF_PROFILE_ZONE("PickScene::Raycast");
+
+	const std::vector<Character>& characters = characters_;
+	int hit_joint = -1;
+	auto leaf_test = [&](int leaf, float closest_t, float& t)
+	{
+		// the model space ray keeps the same t as the world space one
+		const Character& character = characters[leaf];
+		gef::Vector4 model_start = start.Transform(character.inv_transform);
+		gef::Vector4 model_direction = direction.TransformNoTranslation(character.inv_transform);
+
+		int joint;
+		if (!character.picker->Raycast(model_start, model_direction, closest_t, t, joint))
+			return false;
+		hit_joint = joint;
+		return true;
+	};
+
+	float hit_t;
+	int hit_character;
+	if (!bvh_.Raycast(start, direction, FLT_MAX, leaf_test, hit_t, hit_character))
+		return false;
+
+	result.character = hit_character;
+	result.joint = hit_joint;
+	result.t = hit_t;
+	result.world_position = start + direction * hit_t;
+	result.model_position = result.world_position.Transform(characters_[hit_character].inv_transform);
+	return true;
+}
@@ -0,0 +1,95 @@
+#ifndef _CHARACTER_PICKING_H
+#define _CHARACTER_PICKING_H
+
+#include <animation/skeleton.h>
+#include <maths/matrix44.h>
+#include "bvh.h"
+#include <vector>
+
+namespace gef
+{
+	struct MeshData;
+}
+
+// A capsule around each bone of a skeleton, in a BVH so a ray only tests the bones it passes near.
+// The capsules are sized once from the bind pose, then moved with the joints by calling Refit with
+// each new pose. The tree shape never changes, refitting only updates the bounding boxes.
+class CharacterPicker
+{
+public:
+	struct Capsule
+	{
+		int joint;
+		// ends of the capsule in the joint's bind space and in model space after the last refit
+		gef::Vector4 local_start;
+		gef::Vector4 local_end;
+		gef::Vector4 start;
+		gef::Vector4 end;
+		float radius;
+	};
+
+	// mesh_data is the skinned mesh the capsules are fitted around. Without it, or for bones that no vertex
+	// is mainly weighted to, a capsule runs from the joint to its children with a radius of
+	// default_radius_scale times the bone length
+	bool Init(const gef::Skeleton& skeleton, const gef::MeshData* mesh_data, float default_radius_scale = 0.15f);
+
+	// move the capsules to the global pose of the character
+	void Refit(const gef::SkeletonPose& pose);
+
+	// start and direction are in model space, returns the joint whose capsule is hit first
+	bool Raycast(const gef::Vector4& start, const gef::Vector4& direction, float max_t, float& hit_t, int& hit_joint) const;
+
+	inline const std::vector<Capsule>& capsules() const { return capsules_; }
+
+	// model space bounds of all the capsules
+	inline const gef::Aabb& bounds() const { return bvh_.bounds(); }
+
+private:
+	void AddCapsule(int joint, const gef::Vector4& local_start, const gef::Vector4& local_end, float radius);
+	void CalculateBounds();
+
+	std::vector<Capsule> capsules_;
+	std::vector<gef::Aabb> capsule_bounds_;
+	Bvh bvh_;
+};
+
+struct PickResult
+{
+	int character;			// index the character was added at
+	int joint;
+	float t;				// distance along the world ray in multiples of its direction
+	gef::Vector4 world_position;
+	gef::Vector4 model_position;
+};
+
+// All the characters that can be picked this frame, in a second BVH over their world bounds
+class PickScene
+{
+public:
+	// allocate space for max_characters so rebuilding every frame never allocates
+	void Init(int max_characters);
+
+	// characters must be refitted before they are added, the picker has to stay alive until the next Clear
+	void Clear();
+	int AddCharacter(const CharacterPicker& picker, const gef::Matrix44& transform);
+	void Build();
+
+	// start and direction are in world space
+	bool Raycast(const gef::Vector4& start, const gef::Vector4& direction, PickResult& result) const;
+
+	inline int character_count() const { return (int)characters_.size(); }
+
+private:
+	struct Character
+	{
+		const CharacterPicker* picker;
+		gef::Matrix44 transform;
+		gef::Matrix44 inv_transform;
+	};
+
+	std::vector<Character> characters_;
+	std::vector<gef::Aabb> character_bounds_;
+	Bvh bvh_;
+};
+
+#endif // _CHARACTER_PICKING_H
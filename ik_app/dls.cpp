@@ -0,0 +1,434 @@
+#include "dls.h"
+#include <system/profiler.h>
+#include <system/memory_tracker.h>
+#include <algorithm>
+#include <cmath>
+
+// largest rotation any joint can make in one iteration, keeps the linearised step trustworthy
+static const float kMaxStepAngle = 0.25f;
+
+static inline int RoundUpToFour(int value)
+{
+	return (value + 3) & ~3;
+}
+
+// the model space rotation vector, axis times angle, that turns from round to to
+static gef::Vector4 RotationVectorBetween(const gef::Quaternion& from, const gef::Quaternion& to)
+{
+	// parent rotations apply last, so the turn applied after from is from^-1 to
+	gef::Quaternion inv_from;
+	inv_from.Conjugate(from);
+	gef::Quaternion turn = inv_from * to;
+	if (turn.w < 0.0f)
+		turn = -turn;
+
+	gef::Vector4 axis(turn.x, turn.y, turn.z);
+	float sin_half_angle = axis.Length();
+	if (sin_half_angle < 1e-8f)
+		return gef::Vector4(0.0f, 0.0f, 0.0f);
+
+	return axis * (2.0f * atan2f(sin_half_angle, turn.w) / sin_half_angle);
+}
+
+DLSSolver::DLSSolver() :
+	rows_(0),
+	columns_(0),
+	column_stride_(0),
+	row_stride_(0),
+	chain_length_(1.0f),
+	damping_(0.02f),
+	epsilon_(0.001f),
+	max_iterations_(100),
+	warm_start_(true),
+	has_solution_(false),
+	iterations_(0),
+	error_(0.0f)
+{
+}
+
+bool DLSSolver::Init(const gef::Skeleton& skeleton, const std::vector<int>& effector_joints, int root_joint)
+{
+	const int skeleton_joint_count = skeleton.joint_count();
+	if (effector_joints.empty() || root_joint >= skeleton_joint_count)
+		return false;
+
+	// gather every joint between the effectors and the root
+	std::vector<char> in_chain(skeleton_joint_count, 0);
+	for (size_t effector_num = 0; effector_num < effector_joints.size(); ++effector_num)
+	{
+		int effector_joint = effector_joints[effector_num];
+		if (effector_joint < 0 || effector_joint >= skeleton_joint_count || effector_joint == root_joint)
+			return false;
+
+		bool reached_root = root_joint == -1;
+		for (int joint = skeleton.joint(effector_joint).parent; joint != -1; joint = skeleton.joint(joint).parent)
+		{
+			in_chain[joint] = 1;
+			if (joint == root_joint)
+			{
+				reached_root = true;
+				break;
+			}
+		}
+
+		if (!reached_root || skeleton.joint(effector_joint).parent == -1)
+			return false;
+	}
+
+	// order the joints by depth so parents are always processed before their children
+	std::vector<std::pair<int, int>> depth_sorted;
+	for (int joint = 0; joint < skeleton_joint_count; ++joint)
+	{
+		if (!in_chain[joint])
+			continue;
+
+		int depth = 0;
+		for (int parent = skeleton.joint(joint).parent; parent != -1; parent = skeleton.joint(parent).parent)
+			++depth;
+		depth_sorted.push_back(std::make_pair(depth, joint));
+	}
+	std::sort(depth_sorted.begin(), depth_sorted.end());
+
+	std::vector<int> chain_index(skeleton_joint_count, -1);
+	const int joint_count = (int)depth_sorted.size();
+	joint_indices_.resize(joint_count);
+	joint_parents_.resize(joint_count);
+	parent_joints_.resize(joint_count);
+	for (int joint_num = 0; joint_num < joint_count; ++joint_num)
+	{
+		int joint = depth_sorted[joint_num].second;
+		joint_indices_[joint_num] = joint;
+		chain_index[joint] = joint_num;
+		parent_joints_[joint_num] = skeleton.joint(joint).parent;
+		joint_parents_[joint_num] = parent_joints_[joint_num] != -1 ? chain_index[parent_joints_[joint_num]] : -1;
+	}
+
+	fixed_parent_rotations_.resize(joint_count);
+	fixed_parent_positions_.resize(joint_count);
+	fixed_parent_scales_.resize(joint_count);
+	local_rotations_.resize(joint_count);
+	local_translations_.resize(joint_count);
+	local_scales_.resize(joint_count);
+	global_rotations_.resize(joint_count);
+	global_positions_.resize(joint_count);
+	global_scales_.resize(joint_count);
+
+	const int effector_count = (int)effector_joints.size();
+	effector_joints_ = effector_joints;
+	effector_parents_.resize(effector_count);
+	effector_chain_joints_.resize(effector_count);
+	effector_translations_.resize(effector_count);
+	effector_positions_.resize(effector_count);
+	effector_local_rotations_.resize(effector_count);
+	effector_rotations_.resize(effector_count);
+	targets_.assign(effector_count, gef::Vector4(0.0f, 0.0f, 0.0f));
+	weights_.assign(effector_count, 1.0f);
+	orientation_targets_.assign(effector_count, gef::Quaternion(0.0f, 0.0f, 0.0f, 1.0f));
+	orientation_weights_.assign(effector_count, 0.0f);
+
+	moves_effector_.assign(effector_count * joint_count, 0);
+	for (int effector_num = 0; effector_num < effector_count; ++effector_num)
+	{
+		effector_parents_[effector_num] = chain_index[skeleton.joint(effector_joints[effector_num]).parent];
+		effector_chain_joints_[effector_num] = chain_index[effector_joints[effector_num]];
+
+		// an effector that other effectors hang below turns itself too, that only changes its orientation
+		const int first_joint = effector_chain_joints_[effector_num] != -1 ? effector_chain_joints_[effector_num] : effector_parents_[effector_num];
+		for (int joint_num = first_joint; joint_num != -1; joint_num = joint_parents_[joint_num])
+			moves_effector_[effector_num * joint_count + joint_num] = 1;
+	}
+
+	// the damping and orientation rows are scaled by the longest reach from the root to an effector in the bind pose
+	gef::SkeletonPose bind_pose;
+	bind_pose.CreateBindPose(&skeleton);
+	chain_length_ = 0.0f;
+	for (int effector_num = 0; effector_num < effector_count; ++effector_num)
+	{
+		float length = 0.0f;
+		int child = effector_joints[effector_num];
+		for (int joint_num = effector_parents_[effector_num]; joint_num != -1; joint_num = joint_parents_[joint_num])
+		{
+			length += (bind_pose.global_pose()[child].GetTranslation() - bind_pose.global_pose()[joint_indices_[joint_num]].GetTranslation()).Length();
+			child = joint_indices_[joint_num];
+		}
+		chain_length_ = std::max(chain_length_, length);
+	}
+	if (chain_length_ <= 0.0f)
+		chain_length_ = 1.0f;
+
+	const int max_rows = effector_count * 6;
+	row_groups_.assign(effector_count * 2, 0);
+	rows_ = 0;
+	columns_ = joint_count * 3;
+	column_stride_ = RoundUpToFour(columns_);
+	row_stride_ = RoundUpToFour(max_rows);
+	jacobian_.assign(max_rows * column_stride_, 0.0f);
+	system_.assign(max_rows * row_stride_, 0.0f);
+	errors_.assign(max_rows, 0.0f);
+	solution_.assign(max_rows, 0.0f);
+	step_.assign(column_stride_, 0.0f);
+
+	has_solution_ = false;
+	return true;
+}
+
+void DLSSolver::CalculateGlobals()
+{
+	for (size_t joint_num = 0; joint_num < joint_indices_.size(); ++joint_num)
+	{
+		int parent = joint_parents_[joint_num];
+		const gef::Quaternion& parent_rotation = parent != -1 ? global_rotations_[parent] : fixed_parent_rotations_[joint_num];
+		const gef::Vector4& parent_position = parent != -1 ? global_positions_[parent] : fixed_parent_positions_[joint_num];
+		float parent_scale = parent != -1 ? global_scales_[parent] : fixed_parent_scales_[joint_num];
+
+		global_positions_[joint_num] = parent_position + RotateVector(parent_rotation, local_translations_[joint_num]) * parent_scale;
+		global_rotations_[joint_num] = local_rotations_[joint_num] * parent_rotation;
+		global_scales_[joint_num] = local_scales_[joint_num] * parent_scale;
+	}
+
+	for (size_t effector_num = 0; effector_num < effector_joints_.size(); ++effector_num)
+	{
+		int parent = effector_parents_[effector_num];
+		effector_positions_[effector_num] = global_positions_[parent] + RotateVector(global_rotations_[parent], effector_translations_[effector_num]) * global_scales_[parent];
+		const int chain_joint = effector_chain_joints_[effector_num];
+		effector_rotations_[effector_num] = chain_joint != -1 ? global_rotations_[chain_joint] : effector_local_rotations_[effector_num] * global_rotations_[parent];
+	}
+}
+
+float DLSSolver::CalculateErrors()
+{
+	// only weighted positions and orientations get rows
+	float max_error = 0.0f;
+	rows_ = 0;
+	for (int effector_num = 0; effector_num < (int)effector_joints_.size(); ++effector_num)
+	{
+		for (int orientation = 0; orientation < 2; ++orientation)
+		{
+			const float weight = orientation ? orientation_weights_[effector_num] : weights_[effector_num];
+			if (weight <= 0.0f)
+				continue;
+
+			gef::Vector4 error = orientation
+				? RotationVectorBetween(effector_rotations_[effector_num], orientation_targets_[effector_num]) * chain_length_
+				: targets_[effector_num] - effector_positions_[effector_num];
+			max_error = std::max(max_error, error.Length());
+
+			error *= weight;
+			row_groups_[rows_ / 3] = effector_num * 2 + orientation;
+			errors_[rows_] = error.x();
+			errors_[rows_ + 1] = error.y();
+			errors_[rows_ + 2] = error.z();
+			rows_ += 3;
+		}
+	}
+
+	return max_error;
+}
+
+void DLSSolver::BuildJacobian()
+{
+	std::fill(jacobian_.begin(), jacobian_.begin() + rows_ * column_stride_, 0.0f);
+
+	const int joint_count = (int)joint_indices_.size();
+	for (int row = 0; row < rows_; row += 3)
+	{
+		const int effector_num = row_groups_[row / 3] / 2;
+		const bool orientation = (row_groups_[row / 3] & 1) != 0;
+
+		float* row_x = &jacobian_[row * column_stride_];
+		float* row_y = row_x + column_stride_;
+		float* row_z = row_y + column_stride_;
+		const char* moves = &moves_effector_[effector_num * joint_count];
+
+		if (orientation)
+		{
+			// rotating any joint above the effector about a model space axis turns the effector about the same axis
+			const float weight = orientation_weights_[effector_num] * chain_length_;
+			for (int joint_num = 0; joint_num < joint_count; ++joint_num)
+			{
+				if (!moves[joint_num])
+					continue;
+
+				const int column = joint_num * 3;
+				row_x[column] = weight;
+				row_y[column + 1] = weight;
+				row_z[column + 2] = weight;
+			}
+			continue;
+		}
+
+		const float weight = weights_[effector_num];
+		for (int joint_num = 0; joint_num < joint_count; ++joint_num)
+		{
+			if (!moves[joint_num])
+				continue;
+
+			// rotating about a model space axis moves the effector by axis x (effector - joint)
+			gef::Vector4 r = (effector_positions_[effector_num] - global_positions_[joint_num]) * weight;
+			const int column = joint_num * 3;
+
+			// x axis
+			row_y[column] = -r.z();
+			row_z[column] = r.y();
+			// y axis
+			row_x[column + 1] = r.z();
+			row_z[column + 1] = -r.x();
+			// z axis
+			row_x[column + 2] = -r.y();
+			row_y[column + 2] = r.x();
+		}
+	}
+}
+
+bool DLSSolver::SolveStep()
+{
+	// system = J J^T + damping^2 I, only the lower triangle is needed for the Cholesky factorisation
+	const float damping_sqr = damping_ * damping_ * chain_length_ * chain_length_;
+	for (int row = 0; row < rows_; ++row)
+	{
+		const float* jacobian_row = &jacobian_[row * column_stride_];
+		for (int column = 0; column <= row; ++column)
+		{
+			const float* jacobian_column = &jacobian_[column * column_stride_];
+			float sum = 0.0f;
+			for (int i = 0; i < column_stride_; ++i)
+				sum += jacobian_row[i] * jacobian_column[i];
+			system_[row * row_stride_ + column] = sum;
+		}
+		system_[row * row_stride_ + row] += damping_sqr;
+	}
+
+	// factorise in place, system = L L^T
+	for (int column = 0; column < rows_; ++column)
+	{
+		float* column_row = &system_[column * row_stride_];
+		float diagonal = column_row[column];
+		for (int k = 0; k < column; ++k)
+			diagonal -= column_row[k] * column_row[k];
+		if (diagonal <= 0.0f)
+			return false;
+		diagonal = sqrtf(diagonal);
+		column_row[column] = diagonal;
+
+		const float inv_diagonal = 1.0f / diagonal;
+		for (int row = column + 1; row < rows_; ++row)
+		{
+			float* lower_row = &system_[row * row_stride_];
+			float sum = lower_row[column];
+			for (int k = 0; k < column; ++k)
+				sum -= lower_row[k] * column_row[k];
+			lower_row[column] = sum * inv_diagonal;
+		}
+	}
+
+	// forward then back substitution for (J J^T + damping^2 I) solution = errors
+	for (int row = 0; row < rows_; ++row)
+	{
+		const float* lower_row = &system_[row * row_stride_];
+		float sum = errors_[row];
+		for (int k = 0; k < row; ++k)
+			sum -= lower_row[k] * solution_[k];
+		solution_[row] = sum / lower_row[row];
+	}
+	for (int row = rows_ - 1; row >= 0; --row)
+	{
+		float sum = solution_[row];
+		for (int k = row + 1; k < rows_; ++k)
+			sum -= system_[k * row_stride_ + row] * solution_[k];
+		solution_[row] = sum / system_[row * row_stride_ + row];
+	}
+
+	// step = J^T solution
+	std::fill(step_.begin(), step_.end(), 0.0f);
+	for (int row = 0; row < rows_; ++row)
+	{
+		const float* jacobian_row = &jacobian_[row * column_stride_];
+		const float scale = solution_[row];
+		for (int i = 0; i < column_stride_; ++i)
+			step_[i] += jacobian_row[i] * scale;
+	}
+
+	return true;
+}
+
+bool DLSSolver::Solve(gef::SkeletonPose& pose)
+{
+	GEF_PROFILE_ZONE("DLSSolver::Solve");
+	GEF_MEMORY_TAG(gef::MT_IK);
+
+	const int joint_count = (int)joint_indices_.size();
+	if (joint_count == 0)
+		return false;
+
+	for (int joint_num = 0; joint_num < joint_count; ++joint_num)
+	{
+		const gef::JointPose& joint_pose = pose.local_pose()[joint_indices_[joint_num]];
+		if (!warm_start_ || !has_solution_)
+			local_rotations_[joint_num] = joint_pose.rotation();
+		local_translations_[joint_num] = joint_pose.translation();
+		local_scales_[joint_num] = joint_pose.scale().x();
+
+		// joints whose parent is outside the solved set hang off that parent's current global transform
+		fixed_parent_rotations_[joint_num] = gef::Quaternion(0.0f, 0.0f, 0.0f, 1.0f);
+		fixed_parent_positions_[joint_num] = gef::Vector4(0.0f, 0.0f, 0.0f);
+		fixed_parent_scales_[joint_num] = 1.0f;
+		if (joint_parents_[joint_num] == -1 && parent_joints_[joint_num] != -1)
+			DecomposeUniform(pose.global_pose()[parent_joints_[joint_num]], fixed_parent_rotations_[joint_num], fixed_parent_positions_[joint_num], fixed_parent_scales_[joint_num]);
+	}
+
+	for (size_t effector_num = 0; effector_num < effector_joints_.size(); ++effector_num)
+	{
+		effector_translations_[effector_num] = pose.local_pose()[effector_joints_[effector_num]].translation();
+		effector_local_rotations_[effector_num] = pose.local_pose()[effector_joints_[effector_num]].rotation();
+	}
+
+	iterations_ = 0;
+	for (;;)
+	{
+		CalculateGlobals();
+		error_ = CalculateErrors();
+		if (error_ <= epsilon_ || iterations_ >= max_iterations_)
+			break;
+
+		++iterations_;
+		BuildJacobian();
+		if (!SolveStep())
+			break;
+
+		// scale the whole step down if any joint would turn too far
+		float max_angle_sqr = 0.0f;
+		for (int joint_num = 0; joint_num < joint_count; ++joint_num)
+		{
+			const float* step = &step_[joint_num * 3];
+			max_angle_sqr = std::max(max_angle_sqr, step[0] * step[0] + step[1] * step[1] + step[2] * step[2]);
+		}
+		const float step_scale = max_angle_sqr > kMaxStepAngle * kMaxStepAngle ? kMaxStepAngle / sqrtf(max_angle_sqr) : 1.0f;
+
+		// apply every joint's model space rotation through the parent transforms from before the step
+		for (int joint_num = 0; joint_num < joint_count; ++joint_num)
+		{
+			gef::Vector4 rotation_vector(step_[joint_num * 3], step_[joint_num * 3 + 1], step_[joint_num * 3 + 2]);
+			rotation_vector *= step_scale;
+			float angle = rotation_vector.Length();
+			if (angle < 1e-8f)
+				continue;
+
+			gef::Vector4 axis = rotation_vector * (sinf(angle * 0.5f) / angle);
+			gef::Quaternion delta(axis.x(), axis.y(), axis.z(), cosf(angle * 0.5f));
+
+			int parent = joint_parents_[joint_num];
+			const gef::Quaternion& parent_rotation = parent != -1 ? global_rotations_[parent] : fixed_parent_rotations_[joint_num];
+			gef::Quaternion inv_parent_rotation;
+			inv_parent_rotation.Conjugate(parent_rotation);
+			local_rotations_[joint_num] = local_rotations_[joint_num] * parent_rotation * delta * inv_parent_rotation;
+			local_rotations_[joint_num].Normalise();
+		}
+	}
+
+	for (int joint_num = 0; joint_num < joint_count; ++joint_num)
+		pose.local_pose()[joint_indices_[joint_num]].set_rotation(local_rotations_[joint_num]);
+	pose.CalculateGlobalPose();
+
+	has_solution_ = true;
+	return error_ <= epsilon_;
+}
@@ -0,0 +1,126 @@
+#ifndef _DLS_H
+#define _DLS_H
+
+#include "ik_solver.h"
+
+// Damped least squares solver for several end effectors on one skeleton at once, e.g. both hands, both feet and
+// the head. Every effector pulls on the union of the joints between it and the root joint, so chains that share
+// joints are solved together instead of fighting each other. An effector can have a target position, a target
+// orientation or both. Each iteration builds one Jacobian with three rows for every weighted position and
+// orientation and three rotation axes per joint, and takes the step J^T (J J^T + damping^2 I)^-1 e.
+// Orientation rows are scaled by the chain length, so turning an effector by a radian weighs the same as moving it
+// a chain length, which keeps the damping and epsilon in proportion whatever units the skeleton is in.
+// Init allocates every buffer, Solve never allocates. Joint scales are assumed to be uniform.
+class DLSSolver
+{
+public:
+	DLSSolver();
+
+	// effector_joints are the joints that should reach the targets, all of them must hang below root_joint
+	// root_joint is the highest joint that is allowed to rotate, -1 lets every ancestor of the effectors move
+	bool Init(const gef::Skeleton& skeleton, const std::vector<int>& effector_joints, int root_joint);
+
+	// targets are in model space, an effector with zero weight is ignored
+	inline void set_target(int effector_num, const gef::Vector4& target) { targets_[effector_num] = target; }
+	inline const gef::Vector4& target(int effector_num) const { return targets_[effector_num]; }
+	inline void set_weight(int effector_num, float weight) { weights_[effector_num] = weight; }
+	inline float weight(int effector_num) const { return weights_[effector_num]; }
+
+	// the model space rotation the effector joint should end up with, e.g. for a head to look at something
+	// orientations are ignored until they are given a weight, which they have none of by default
+	inline void set_orientation_target(int effector_num, const gef::Quaternion& orientation) { orientation_targets_[effector_num] = orientation; }
+	inline const gef::Quaternion& orientation_target(int effector_num) const { return orientation_targets_[effector_num]; }
+	inline void set_orientation_weight(int effector_num, float weight) { orientation_weights_[effector_num] = weight; }
+	inline float orientation_weight(int effector_num) const { return orientation_weights_[effector_num]; }
+
+	// returns true if every weighted effector got within epsilon of its target position, and within epsilon
+	// divided by the chain length radians of its target orientation
+	bool Solve(gef::SkeletonPose& pose);
+
+	// forget the previous solution so the next solve starts from the pose that is passed in
+	inline void Reset() { has_solution_ = false; }
+
+	// damping is a fraction of the chain length, larger values trade convergence speed for stability near singular poses
+	inline void set_damping(float damping) { damping_ = damping; }
+	inline float damping() const { return damping_; }
+	inline void set_epsilon(float epsilon) { epsilon_ = epsilon; }
+	inline float epsilon() const { return epsilon_; }
+	inline void set_max_iterations(int max_iterations) { max_iterations_ = max_iterations; }
+	inline int max_iterations() const { return max_iterations_; }
+	inline void set_warm_start(bool warm_start) { warm_start_ = warm_start; }
+	inline bool warm_start() const { return warm_start_; }
+
+	inline int effector_count() const { return (int)effector_joints_.size(); }
+	inline const std::vector<int>& joint_indices() const { return joint_indices_; }
+
+	// the longest bind pose distance from the root joint through the joints to an effector
+	inline float chain_length() const { return chain_length_; }
+
+	// results of the last solve, error is the largest distance of a weighted effector from its target, with
+	// orientations counted as their angle from the target times the chain length
+	inline int iterations() const { return iterations_; }
+	inline float error() const { return error_; }
+
+private:
+	void CalculateGlobals();
+	float CalculateErrors();
+	void BuildJacobian();
+	bool SolveStep();
+
+	// joints that can rotate, parents always come before their children
+	std::vector<int> joint_indices_;
+	std::vector<int> joint_parents_;
+	std::vector<int> parent_joints_;
+	std::vector<gef::Quaternion> fixed_parent_rotations_;
+	std::vector<gef::Vector4> fixed_parent_positions_;
+	std::vector<float> fixed_parent_scales_;
+
+	std::vector<gef::Quaternion> local_rotations_;
+	std::vector<gef::Vector4> local_translations_;
+	std::vector<float> local_scales_;
+	std::vector<gef::Quaternion> global_rotations_;
+	std::vector<gef::Vector4> global_positions_;
+	std::vector<float> global_scales_;
+
+	std::vector<int> effector_joints_;
+	std::vector<int> effector_parents_;
+	std::vector<int> effector_chain_joints_;
+	std::vector<gef::Vector4> effector_translations_;
+	std::vector<gef::Quaternion> effector_local_rotations_;
+	std::vector<gef::Vector4> effector_positions_;
+	std::vector<gef::Quaternion> effector_rotations_;
+	std::vector<gef::Vector4> targets_;
+	std::vector<float> weights_;
+	std::vector<gef::Quaternion> orientation_targets_;
+	std::vector<float> orientation_weights_;
+
+	// effector_count x joint_count, non zero where the joint moves the effector
+	std::vector<char> moves_effector_;
+
+	// the effector and kind of each group of three rows in use, effector_num * 2 plus one for an orientation
+	std::vector<int> row_groups_;
+
+	// dense workspace, rows are padded to a multiple of four floats so the inner loops vectorise cleanly
+	// there is room for a position and an orientation for every effector, rows_ is how many are in use
+	int rows_;
+	int columns_;
+	int column_stride_;
+	int row_stride_;
+	std::vector<float> jacobian_;
+	std::vector<float> system_;
+	std::vector<float> errors_;
+	std::vector<float> solution_;
+	std::vector<float> step_;
+
+	float chain_length_;
+	float damping_;
+	float epsilon_;
+	int max_iterations_;
+	bool warm_start_;
+	bool has_solution_;
+
+	int iterations_;
+	float error_;
+};
+
+#endif // _DLS_H
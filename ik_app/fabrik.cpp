@@ -0,0 +1,204 @@
+#include "fabrik.h"
+#include <system/profiler.h>
+#include <system/memory_tracker.h>
+#include <algorithm>
+#include <cmath>
+
+bool FABRIKSolver::Init(const gef::Skeleton& skeleton, const std::vector<int>& bone_indices, const std::vector<std::pair<float, float>>& constraints)
+{
+	if (!IKSolver::Init(skeleton, bone_indices, constraints))
+		return false;
+
+	size_t chain_length = bone_indices.size();
+	positions_.resize(chain_length);
+	bone_lengths_.resize(chain_length - 1);
+	rest_directions_.resize(chain_length - 1);
+
+	// the limits are measured from the bind pose so they stay put when warm starting from the last solution
+	gef::SkeletonPose bind_pose;
+	bind_pose.CreateBindPose(&skeleton);
+	for (size_t bone_num = 0; bone_num < chain_length - 1; ++bone_num)
+	{
+		const gef::Quaternion& rest_rotation = bind_pose.local_pose()[bone_indices[bone_num]].rotation();
+		gef::Vector4 direction = RotateVector(rest_rotation, bind_pose.local_pose()[bone_indices[bone_num + 1]].translation());
+		float length = direction.Length();
+		rest_directions_[bone_num] = length > 0.0f ? direction / length : gef::Vector4(0.0f, 1.0f, 0.0f);
+	}
+
+	return true;
+}
+
+void FABRIKSolver::ConstrainBone(int bone_num, const gef::Quaternion& parent_rotation)
+{
+	if (bone_lengths_[bone_num] <= 0.0f)
+		return;
+
+	// keep the swing away from the bind pose direction of the bone within the joint limits
+	gef::Vector4 direction = positions_[bone_num + 1] - positions_[bone_num];
+	direction /= bone_lengths_[bone_num];
+
+	const gef::Vector4 start_direction = RotateVector(parent_rotation, rest_directions_[bone_num]);
+	gef::Vector4 perpendicular = start_direction.CrossProduct(direction);
+	float cos_angle = start_direction.DotProduct(direction);
+	float angle = atan2f(perpendicular.Length(), cos_angle);
+
+	float min_angle = constraints_[bone_num].first;
+	float max_angle = constraints_[bone_num].second;
+	if (angle >= min_angle && angle <= max_angle)
+		return;
+
+	float clamped_angle = angle < min_angle ? min_angle : max_angle;
+
+	// rebuild the direction in the plane of the swing
+	perpendicular = direction - start_direction * cos_angle;
+	float perpendicular_length = perpendicular.Length();
+	if (perpendicular_length < 1e-6f)
+		return;
+	perpendicular /= perpendicular_length;
+
+	direction = start_direction * cosf(clamped_angle) + perpendicular * sinf(clamped_angle);
+	positions_[bone_num + 1] = positions_[bone_num] + direction * bone_lengths_[bone_num];
+}
+
+gef::Quaternion FABRIKSolver::SolvedRotation(int bone_num, gef::Quaternion& swing) const
+{
+	// global rotation the joint ends up with once the solved positions are turned into rotations, swing gathers
+	// the rotations of the joints above it, the same way RotateJoint applies them
+	if (bone_lengths_[bone_num] > 0.0f)
+	{
+		gef::Vector4 current_direction = RotateVector(swing, (global_positions_[bone_num + 1] - global_positions_[bone_num]) / bone_lengths_[bone_num]);
+		gef::Vector4 solved_direction = (positions_[bone_num + 1] - positions_[bone_num]) / bone_lengths_[bone_num];
+		swing = swing * RotationBetween(current_direction, solved_direction);
+		swing.Normalise();
+	}
+	return global_rotations_[bone_num] * swing;
+}
+
+void FABRIKSolver::PlaceElbow(int bone_num, const gef::Vector4& target)
+{
+	// put the joint at the end of this bone on the circle where the last two bones meet with the end effector
+	// on the target, on the side the joint is already bent towards
+	const float upper_length = bone_lengths_[bone_num];
+	const float lower_length = bone_lengths_[bone_num + 1];
+	const gef::Vector4& root = positions_[bone_num];
+
+	gef::Vector4 axis = target - root;
+	float distance = axis.Length();
+	if (distance < 1e-6f)
+		return;
+	axis /= distance;
+	distance = std::max(distance, fabsf(upper_length - lower_length));
+	distance = std::min(distance, upper_length + lower_length);
+
+	gef::Vector4 bend = positions_[bone_num + 1] - root;
+	bend -= axis * bend.DotProduct(axis);
+	float bend_length = bend.Length();
+	if (bend_length < 1e-6f)
+		return;
+	bend /= bend_length;
+
+	float along = (upper_length * upper_length + distance * distance - lower_length * lower_length) / (2.0f * distance);
+	float across = sqrtf(std::max(upper_length * upper_length - along * along, 0.0f));
+	positions_[bone_num + 1] = root + axis * along + bend * across;
+}
+
+bool FABRIKSolver::Solve(gef::SkeletonPose& pose, const gef::Vector4& target)
+{
+	GEF_PROFILE_ZONE("FABRIKSolver::Solve");
+	GEF_MEMORY_TAG(gef::MT_IK);
+
+	const int chain_length = (int)bone_indices_.size();
+	if (chain_length == 0)
+		return false;
+
+	ReadChain(pose);
+
+	float chain_reach = 0.0f;
+	for (int i = 0; i < chain_length; ++i)
+		positions_[i] = global_positions_[i];
+	for (int bone_num = 0; bone_num < chain_length - 1; ++bone_num)
+	{
+		bone_lengths_[bone_num] = (positions_[bone_num + 1] - positions_[bone_num]).Length();
+		chain_reach += bone_lengths_[bone_num];
+	}
+
+	const gef::Vector4 root_position = positions_[0];
+	error_ = (positions_[chain_length - 1] - target).Length();
+	iterations_ = 0;
+
+	if ((target - root_position).Length() >= chain_reach)
+	{
+		// out of reach, point the chain straight at the target
+		iterations_ = 1;
+		gef::Vector4 direction = target - root_position;
+		direction.Normalise();
+		gef::Quaternion parent_rotation = chain_parent_rotation_;
+		gef::Quaternion swing(0.0f, 0.0f, 0.0f, 1.0f);
+		for (int bone_num = 0; bone_num < chain_length - 1; ++bone_num)
+		{
+			positions_[bone_num + 1] = positions_[bone_num] + direction * bone_lengths_[bone_num];
+			ConstrainBone(bone_num, parent_rotation);
+			parent_rotation = SolvedRotation(bone_num, swing);
+		}
+		error_ = (positions_[chain_length - 1] - target).Length();
+	}
+	else
+	{
+		while (error_ > epsilon_ && iterations_ < max_iterations_)
+		{
+			++iterations_;
+			const float previous_error = error_;
+
+			// backward pass, pin the end effector to the target and drag the chain after it
+			positions_[chain_length - 1] = target;
+			for (int bone_num = chain_length - 2; bone_num >= 0; --bone_num)
+			{
+				gef::Vector4 direction = positions_[bone_num] - positions_[bone_num + 1];
+				float length = direction.Length();
+				if (length > 0.0f)
+					positions_[bone_num] = positions_[bone_num + 1] + direction * (bone_lengths_[bone_num] / length);
+			}
+
+			// forward pass, pin the root back in place and apply the joint limits on the way out
+			positions_[0] = root_position;
+			gef::Quaternion parent_rotation = chain_parent_rotation_;
+			gef::Quaternion swing(0.0f, 0.0f, 0.0f, 1.0f);
+			for (int bone_num = 0; bone_num < chain_length - 1; ++bone_num)
+			{
+				gef::Vector4 direction = positions_[bone_num + 1] - positions_[bone_num];
+				float length = direction.Length();
+				if (length > 0.0f)
+					positions_[bone_num + 1] = positions_[bone_num] + direction * (bone_lengths_[bone_num] / length);
+				if (bone_num == chain_length - 3)
+					PlaceElbow(bone_num, target);
+				ConstrainBone(bone_num, parent_rotation);
+				parent_rotation = SolvedRotation(bone_num, swing);
+			}
+
+			error_ = (positions_[chain_length - 1] - target).Length();
+
+			// the joint limits can keep the target out of reach, stop once the passes stop getting any closer
+			if (previous_error - error_ < epsilon_ * 0.01f)
+				break;
+		}
+	}
+
+	// turn the positions into rotations, rotating each joint so its bone points at the solved child position
+	for (int joint_num = 0; joint_num < chain_length - 1; ++joint_num)
+	{
+		if (bone_lengths_[joint_num] <= 0.0f)
+			continue;
+
+		gef::Vector4 current_direction = global_positions_[joint_num + 1] - global_positions_[joint_num];
+		gef::Vector4 solved_direction = positions_[joint_num + 1] - positions_[joint_num];
+		current_direction /= bone_lengths_[joint_num];
+		solved_direction /= bone_lengths_[joint_num];
+
+		RotateJoint(joint_num, RotationBetween(current_direction, solved_direction));
+	}
+	error_ = (global_positions_[chain_length - 1] - target).Length();
+
+	WriteChain(pose);
+
+	return error_ <= epsilon_;
+}
@@ -0,0 +1,30 @@
+#ifndef _FABRIK_H
+#define _FABRIK_H
+
+#include "ik_solver.h"
+
+// Forward and backward reaching IK, moves the joint positions directly by dragging the chain to the target
+// from the end effector and back again from the root, then turns the new positions into joint rotations.
+// Each constraint limits how far a bone can swing away from its bind pose direction, relative to its parent.
+// When the chain has a third joint from the end the last two bones are placed to reach the target exactly, as
+// with the two bone solver, which stops the passes crawling when the target is close to that joint.
+class FABRIKSolver : public IKSolver
+{
+public:
+	bool Init(const gef::Skeleton& skeleton, const std::vector<int>& bone_indices, const std::vector<std::pair<float, float>>& constraints);
+	bool Solve(gef::SkeletonPose& pose, const gef::Vector4& target);
+	const char* name() const { return "FABRIK"; }
+
+private:
+	void ConstrainBone(int bone_num, const gef::Quaternion& parent_rotation);
+	gef::Quaternion SolvedRotation(int bone_num, gef::Quaternion& swing) const;
+	void PlaceElbow(int bone_num, const gef::Vector4& target);
+
+	std::vector<gef::Vector4> positions_;
+	std::vector<float> bone_lengths_;
+
+	// bind pose direction of each bone in the space of the joint's parent
+	std::vector<gef::Vector4> rest_directions_;
+};
+
+#endif // _FABRIK_H
@@ -0,0 +1,258 @@
+#include "foot_placement.h"
+#include <system/job_system.h>
+#include <system/profiler.h>
+#include <system/memory_tracker.h>
+#include <algorithm>
+#include <cmath>
+
+// enough work per job to cover the cost of handing it to a worker
+static const int kPosesPerJob = 8;
+static const int kLegsPerJob = 64;
+
+FootPlacementBatch::FootPlacementBatch() :
+	max_legs_(0),
+	leg_count_(0)
+{
+}
+
+void FootPlacementBatch::Init(int max_legs)
+{
+	max_legs_ = max_legs;
+	leg_count_ = 0;
+
+	poses_.reserve(max_legs);
+	pose_first_legs_.reserve(max_legs + 1);
+	hip_joints_.resize(max_legs);
+	knee_joints_.resize(max_legs);
+	ankle_joints_.resize(max_legs);
+	components_.assign(NUM_COMPONENTS * max_legs, 0.0f);
+
+	Clear();
+}
+
+void FootPlacementBatch::Clear()
+{
+	leg_count_ = 0;
+	poses_.clear();
+	pose_first_legs_.clear();
+	pose_first_legs_.push_back(0);
+}
+
+int FootPlacementBatch::AddLeg(gef::SkeletonPose& pose, int hip_joint, int knee_joint, int ankle_joint, const gef::Vector4& ground_point, const gef::Vector4& ground_normal)
+{
+	if (leg_count_ >= max_legs_)
+		return -1;
+
+	if (poses_.empty() || poses_.back() != &pose)
+	{
+		poses_.push_back(&pose);
+		pose_first_legs_.push_back(leg_count_);
+	}
+
+	const int leg_num = leg_count_++;
+	pose_first_legs_.back() = leg_count_;
+
+	hip_joints_[leg_num] = hip_joint;
+	knee_joints_[leg_num] = knee_joint;
+	ankle_joints_[leg_num] = ankle_joint;
+
+	gef::Vector4 normal = ground_normal;
+	normal.Normalise();
+	component(GROUND_X)[leg_num] = ground_point.x();
+	component(GROUND_Y)[leg_num] = ground_point.y();
+	component(GROUND_Z)[leg_num] = ground_point.z();
+	component(NORMAL_X)[leg_num] = normal.x();
+	component(NORMAL_Y)[leg_num] = normal.y();
+	component(NORMAL_Z)[leg_num] = normal.z();
+
+	return leg_num;
+}
+
+void FootPlacementBatch::Gather(int pose_num)
+{
+	const gef::SkeletonPose& pose = *poses_[pose_num];
+	for (int leg_num = pose_first_legs_[pose_num]; leg_num < pose_first_legs_[pose_num + 1]; ++leg_num)
+	{
+		gef::Vector4 hip = pose.global_pose()[hip_joints_[leg_num]].GetTranslation();
+		gef::Vector4 knee = pose.global_pose()[knee_joints_[leg_num]].GetTranslation();
+		gef::Vector4 ankle = pose.global_pose()[ankle_joints_[leg_num]].GetTranslation();
+
+		component(HIP_X)[leg_num] = hip.x();
+		component(HIP_Y)[leg_num] = hip.y();
+		component(HIP_Z)[leg_num] = hip.z();
+		component(KNEE_X)[leg_num] = knee.x();
+		component(KNEE_Y)[leg_num] = knee.y();
+		component(KNEE_Z)[leg_num] = knee.z();
+		component(ANKLE_X)[leg_num] = ankle.x();
+		component(ANKLE_Y)[leg_num] = ankle.y();
+		component(ANKLE_Z)[leg_num] = ankle.z();
+	}
+}
+
+void FootPlacementBatch::SolveLegs(int begin, int end)
+{
+	const float* hip_x = component(HIP_X);
+	const float* hip_y = component(HIP_Y);
+	const float* hip_z = component(HIP_Z);
+	const float* knee_x = component(KNEE_X);
+	const float* knee_y = component(KNEE_Y);
+	const float* knee_z = component(KNEE_Z);
+	const float* ankle_x = component(ANKLE_X);
+	const float* ankle_y = component(ANKLE_Y);
+	const float* ankle_z = component(ANKLE_Z);
+	const float* ground_x = component(GROUND_X);
+	const float* ground_y = component(GROUND_Y);
+	const float* ground_z = component(GROUND_Z);
+	const float* normal_x = component(NORMAL_X);
+	const float* normal_y = component(NORMAL_Y);
+	const float* normal_z = component(NORMAL_Z);
+	float* solved_knee_x = component(SOLVED_KNEE_X);
+	float* solved_knee_y = component(SOLVED_KNEE_Y);
+	float* solved_knee_z = component(SOLVED_KNEE_Z);
+	float* solved_ankle_x = component(SOLVED_ANKLE_X);
+	float* solved_ankle_y = component(SOLVED_ANKLE_Y);
+	float* solved_ankle_z = component(SOLVED_ANKLE_Z);
+
+	// no branches in here, every leg does the same work so the loop vectorises across legs
+	for (int i = begin; i < end; ++i)
+	{
+		// height of the ground plane directly under the ankle, the animated ankle height is kept on top of it
+		const float inv_normal_y = 1.0f / std::max(normal_y[i], 1e-3f);
+		const float ground_height = ground_y[i] - (normal_x[i] * (ankle_x[i] - ground_x[i]) + normal_z[i] * (ankle_z[i] - ground_z[i])) * inv_normal_y;
+		const float target_x = ankle_x[i];
+		const float target_y = ankle_y[i] + ground_height;
+		const float target_z = ankle_z[i];
+
+		const float upper_x = knee_x[i] - hip_x[i];
+		const float upper_y = knee_y[i] - hip_y[i];
+		const float upper_z = knee_z[i] - hip_z[i];
+		const float lower_x = ankle_x[i] - knee_x[i];
+		const float lower_y = ankle_y[i] - knee_y[i];
+		const float lower_z = ankle_z[i] - knee_z[i];
+		const float upper_length = sqrtf(upper_x * upper_x + upper_y * upper_y + upper_z * upper_z);
+		const float lower_length = sqrtf(lower_x * lower_x + lower_y * lower_y + lower_z * lower_z);
+
+		float aim_x = target_x - hip_x[i];
+		float aim_y = target_y - hip_y[i];
+		float aim_z = target_z - hip_z[i];
+		const float aim_length = sqrtf(aim_x * aim_x + aim_y * aim_y + aim_z * aim_z);
+		const float inv_aim_length = 1.0f / std::max(aim_length, 1e-6f);
+		aim_x *= inv_aim_length;
+		aim_y *= inv_aim_length;
+		aim_z *= inv_aim_length;
+
+		// a leg that can't reach is straightened towards the target
+		const float reach = std::min(std::max(aim_length, fabsf(upper_length - lower_length) + 1e-4f), (upper_length + lower_length) * 0.9999f);
+
+		// keep the knee bending the way it did in the animation
+		const float upper_along_aim = upper_x * aim_x + upper_y * aim_y + upper_z * aim_z;
+		float bend_x = upper_x - aim_x * upper_along_aim;
+		float bend_y = upper_y - aim_y * upper_along_aim;
+		float bend_z = upper_z - aim_z * upper_along_aim;
+		const float inv_bend_length = 1.0f / std::max(sqrtf(bend_x * bend_x + bend_y * bend_y + bend_z * bend_z), 1e-6f);
+		bend_x *= inv_bend_length;
+		bend_y *= inv_bend_length;
+		bend_z *= inv_bend_length;
+
+		// law of cosines for the angle at the hip between the aim and the thigh
+		float cos_hip = (upper_length * upper_length + reach * reach - lower_length * lower_length) / std::max(2.0f * upper_length * reach, 1e-6f);
+		cos_hip = std::min(std::max(cos_hip, -1.0f), 1.0f);
+		const float sin_hip = sqrtf(1.0f - cos_hip * cos_hip);
+
+		solved_knee_x[i] = hip_x[i] + (aim_x * cos_hip + bend_x * sin_hip) * upper_length;
+		solved_knee_y[i] = hip_y[i] + (aim_y * cos_hip + bend_y * sin_hip) * upper_length;
+		solved_knee_z[i] = hip_z[i] + (aim_z * cos_hip + bend_z * sin_hip) * upper_length;
+		solved_ankle_x[i] = hip_x[i] + aim_x * reach;
+		solved_ankle_y[i] = hip_y[i] + aim_y * reach;
+		solved_ankle_z[i] = hip_z[i] + aim_z * reach;
+	}
+}
+
+void FootPlacementBatch::Scatter(int pose_num)
+{
+	gef::SkeletonPose& pose = *poses_[pose_num];
+	const gef::Skeleton& skeleton = *pose.skeleton();
+
+	for (int leg_num = pose_first_legs_[pose_num]; leg_num < pose_first_legs_[pose_num + 1]; ++leg_num)
+	{
+		gef::Vector4 hip(component(HIP_X)[leg_num], component(HIP_Y)[leg_num], component(HIP_Z)[leg_num]);
+		gef::Vector4 knee(component(KNEE_X)[leg_num], component(KNEE_Y)[leg_num], component(KNEE_Z)[leg_num]);
+		gef::Vector4 ankle(component(ANKLE_X)[leg_num], component(ANKLE_Y)[leg_num], component(ANKLE_Z)[leg_num]);
+		gef::Vector4 solved_knee(component(SOLVED_KNEE_X)[leg_num], component(SOLVED_KNEE_Y)[leg_num], component(SOLVED_KNEE_Z)[leg_num]);
+		gef::Vector4 solved_ankle(component(SOLVED_ANKLE_X)[leg_num], component(SOLVED_ANKLE_Y)[leg_num], component(SOLVED_ANKLE_Z)[leg_num]);
+		gef::Vector4 normal(component(NORMAL_X)[leg_num], component(NORMAL_Y)[leg_num], component(NORMAL_Z)[leg_num]);
+
+		gef::Vector4 upper = knee - hip;
+		gef::Vector4 lower = ankle - knee;
+		gef::Vector4 solved_upper = solved_knee - hip;
+		gef::Vector4 solved_lower = solved_ankle - solved_knee;
+		upper.Normalise();
+		lower.Normalise();
+		solved_upper.Normalise();
+		solved_lower.Normalise();
+
+		// model space rotations for the thigh and the shin, the foot keeps its animated orientation tilted onto the ground
+		gef::Quaternion hip_delta = RotationBetween(upper, solved_upper);
+		gef::Quaternion knee_delta = RotationBetween(RotateVector(hip_delta, lower), solved_lower);
+		gef::Quaternion ankle_delta = RotationBetween(gef::Vector4(0.0f, 1.0f, 0.0f), normal);
+
+		const int hip_joint = hip_joints_[leg_num];
+		const int knee_joint = knee_joints_[leg_num];
+		const int ankle_joint = ankle_joints_[leg_num];
+		const int hip_parent = skeleton.joint(hip_joint).parent;
+
+		gef::Quaternion parent_rotation(0.0f, 0.0f, 0.0f, 1.0f), hip_rotation, knee_rotation, ankle_rotation;
+		gef::Vector4 translation;
+		float scale;
+		if (hip_parent != -1)
+			DecomposeUniform(pose.global_pose()[hip_parent], parent_rotation, translation, scale);
+		DecomposeUniform(pose.global_pose()[hip_joint], hip_rotation, translation, scale);
+		DecomposeUniform(pose.global_pose()[knee_joint], knee_rotation, translation, scale);
+		DecomposeUniform(pose.global_pose()[ankle_joint], ankle_rotation, translation, scale);
+
+		// new global rotations, then back to local with global = local * parent
+		gef::Quaternion solved_hip_rotation = hip_rotation * hip_delta;
+		gef::Quaternion solved_knee_rotation = knee_rotation * hip_delta * knee_delta;
+		gef::Quaternion solved_ankle_rotation = ankle_rotation * ankle_delta;
+
+		gef::Quaternion inv_rotation;
+		inv_rotation.Conjugate(parent_rotation);
+		gef::Quaternion local_rotation = solved_hip_rotation * inv_rotation;
+		local_rotation.Normalise();
+		pose.local_pose()[hip_joint].set_rotation(local_rotation);
+
+		inv_rotation.Conjugate(solved_hip_rotation);
+		local_rotation = solved_knee_rotation * inv_rotation;
+		local_rotation.Normalise();
+		pose.local_pose()[knee_joint].set_rotation(local_rotation);
+
+		inv_rotation.Conjugate(solved_knee_rotation);
+		local_rotation = solved_ankle_rotation * inv_rotation;
+		local_rotation.Normalise();
+		pose.local_pose()[ankle_joint].set_rotation(local_rotation);
+	}
+
+	pose.CalculateGlobalPose();
+}
+
+void FootPlacementBatch::Solve(gef::JobSystem* job_system)
+{
+	GEF_PROFILE_ZONE("FootPlacementBatch::Solve");
+	GEF_MEMORY_TAG(gef::MT_IK);
+
+	const int pose_count = (int)poses_.size();
+	if (job_system)
+	{
+		job_system->ParallelFor(pose_count, kPosesPerJob, [this](int begin, int end) { for (int i = begin; i < end; ++i) Gather(i); });
+		job_system->ParallelFor(leg_count_, kLegsPerJob, [this](int begin, int end) { SolveLegs(begin, end); });
+		job_system->ParallelFor(pose_count, kPosesPerJob, [this](int begin, int end) { for (int i = begin; i < end; ++i) Scatter(i); });
+	}
+	else
+	{
+		for (int pose_num = 0; pose_num < pose_count; ++pose_num)
+			Gather(pose_num);
+		SolveLegs(0, leg_count_);
+		for (int pose_num = 0; pose_num < pose_count; ++pose_num)
+			Scatter(pose_num);
+	}
+}
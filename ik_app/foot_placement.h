@@ -0,0 +1,72 @@
+#ifndef _FOOT_PLACEMENT_H
+#define _FOOT_PLACEMENT_H
+
+#include "ik_solver.h"
+#include <vector>
+
+namespace gef
+{
+	class JobSystem;
+}
+
+// Plants the feet of many characters on uneven ground in one pass.
+// Each leg is a hip, knee and ankle chain with the ground under the foot given as a point and normal.
+// The animated ankle height over flat ground is kept, so planted feet land on the ground and lifted feet
+// stay lifted, and the foot is tilted to match the ground normal. The characters' global poses are read
+// once, the two bone solve for every leg runs over structure of arrays data so it vectorises across legs,
+// then each pose gets its new local rotations and a single global pose update.
+// The model origin is assumed to be at ground level in the animation, y is up and the hips are not moved.
+class FootPlacementBatch
+{
+public:
+	FootPlacementBatch();
+
+	// allocate space for max_legs legs, adding legs and solving never allocates afterwards
+	void Init(int max_legs);
+	void Clear();
+
+	// pose must have an up to date global pose, all the legs of one pose must be added one after the other
+	// the knee must be the child of the hip and the ankle the child of the knee
+	// ground_point and ground_normal are in the model space of the pose, returns the leg number or -1 if full
+	int AddLeg(gef::SkeletonPose& pose, int hip_joint, int knee_joint, int ankle_joint, const gef::Vector4& ground_point, const gef::Vector4& ground_normal);
+
+	// job_system can be NULL to do all the work on the calling thread
+	void Solve(gef::JobSystem* job_system);
+
+	inline int leg_count() const { return leg_count_; }
+	inline int max_legs() const { return max_legs_; }
+
+private:
+	enum Component
+	{
+		HIP_X, HIP_Y, HIP_Z,
+		KNEE_X, KNEE_Y, KNEE_Z,
+		ANKLE_X, ANKLE_Y, ANKLE_Z,
+		GROUND_X, GROUND_Y, GROUND_Z,
+		NORMAL_X, NORMAL_Y, NORMAL_Z,
+		SOLVED_KNEE_X, SOLVED_KNEE_Y, SOLVED_KNEE_Z,
+		SOLVED_ANKLE_X, SOLVED_ANKLE_Y, SOLVED_ANKLE_Z,
+		NUM_COMPONENTS
+	};
+
+	inline float* component(Component c) { return &components_[c * max_legs_]; }
+
+	void Gather(int pose_num);
+	void SolveLegs(int begin, int end);
+	void Scatter(int pose_num);
+
+	int max_legs_;
+	int leg_count_;
+
+	std::vector<gef::SkeletonPose*> poses_;
+	std::vector<int> pose_first_legs_;
+
+	std::vector<int> hip_joints_;
+	std::vector<int> knee_joints_;
+	std::vector<int> ankle_joints_;
+
+	// NUM_COMPONENTS arrays of max_legs_ floats
+	std::vector<float> components_;
+};
+
+#endif // _FOOT_PLACEMENT_H
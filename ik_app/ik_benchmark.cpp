@@ -0,0 +1,820 @@
+// Benchmark and convergence test for the IK solvers.
+// Every solver gets the same randomised reachable and unreachable targets for one chain, each solve
+// starting from the bind pose, and the iterations, final error, time and heap allocations per solve are
+// reported. Then each solver follows a moving target with warm start, which should take a few iterations a frame.
+// On the tesla the DLS solver then moves both hands, both feet and the chest orientation at once, and every
+// effector's error is checked, and the foot placement batch plants both legs of a crowd.
+// Exits with a non zero code if a solver stops converging, slows down following the target or starts allocating.
+//
+// usage: ik_benchmark [-n targets] [-e epsilon] [-i max_iterations] [-s seed] [-a | -t joints | scene.scn root ... end]
+// With no scene the left arm of the tesla model is used, run it from blendtrees/media. -a uses an arm with the
+// proportions of the xbot built in code instead, in centimetres rather than metres. -t uses a tail of 3 to 14
+// joints built in code. A scene's chain is given as three or more joint indices from the root to the end effector.
+// The two bone solver only runs on chains of three joints.
+
+#include <platform/headless/system/platform_headless.h>
+#include <graphics/scene.h>
+#include <graphics/skinned_mesh_instance.h>
+#include <animation/skeleton.h>
+#include <maths/math_utils.h>
+#include <system/memory_tracker.h>
+#include <system/profiler.h>
+#include <system/file.h>
+#include <system/job_system.h>
+#include "ccd.h"
+#include "fabrik.h"
+#include "two_bone.h"
+#include "dls.h"
+#include "foot_placement.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+
+static const int kTrackingFrames = 600;
+static const int kFootPlacementCharacters = 256;
+
+struct BenchmarkSettings
+{
+	int target_count;
+	float epsilon;
+	int max_iterations;
+	unsigned int seed;
+	bool built_in_arm;
+	// joints in the built in tail, 0 for none
+	int tail_joints;
+};
+
+struct TargetSet
+{
+	const char* name;
+	bool reachable;
+	std::vector<gef::Vector4> targets;
+	// closest the end effector can get to each target
+	std::vector<float> best_errors;
+};
+
+struct SolveStats
+{
+	int converged;
+	long long total_iterations;
+	int max_iterations;
+	// error left over after the closest the chain can get
+	std::vector<float> errors;
+	UInt64 total_time_ns;
+	UInt64 allocations;
+};
+
+// allocations made by every subsystem since the program started, zero without GEF_TRACK_ALLOCATIONS
+static UInt64 TotalAllocations()
+{
+	UInt64 allocations = 0;
+	for (int tag = 0; tag < gef::MT_NUM_TAGS; ++tag)
+		allocations += gef::MemoryTracker::GetStats((gef::MemoryTag)tag).num_allocations;
+	return allocations;
+}
+
+// hips, spine, left shoulder, arm, fore arm and hand of a model the size of the xbot, in centimetres
+static void BuildXbotArm(gef::Skeleton& skeleton, std::vector<int>& chain)
+{
+	struct JointDesc
+	{
+		int parent;
+		gef::Vector4 translation;
+		gef::Vector4 rotation;
+	};
+
+	const JointDesc joints[] =
+	{
+		{ -1, gef::Vector4(0.0f, 104.0f, 0.0f), gef::Vector4(0.0f, 0.0f, 0.0f) },		// hips
+		{ 0, gef::Vector4(0.0f, 10.0f, -1.0f), gef::Vector4(0.05f, 0.0f, 0.0f) },		// spine
+		{ 1, gef::Vector4(0.0f, 12.0f, 0.0f), gef::Vector4(-0.02f, 0.0f, 0.0f) },		// spine1
+		{ 2, gef::Vector4(0.0f, 13.5f, 0.0f), gef::Vector4(-0.03f, 0.0f, 0.0f) },		// spine2
+		{ 3, gef::Vector4(6.0f, 11.0f, 0.5f), gef::Vector4(0.0f, 0.0f, -1.45f) },		// left shoulder
+		{ 4, gef::Vector4(0.0f, 12.5f, 0.0f), gef::Vector4(0.0f, 0.1f, 0.12f) },		// left arm
+		{ 5, gef::Vector4(0.0f, 27.5f, 0.0f), gef::Vector4(0.0f, 0.0f, -0.2f) },		// left fore arm
+		{ 6, gef::Vector4(0.0f, 27.8f, 0.0f), gef::Vector4(0.05f, 0.0f, 0.0f) },		// left hand
+	};
+
+	std::vector<gef::Matrix44> bind_globals;
+	for (size_t joint_num = 0; joint_num < sizeof(joints) / sizeof(joints[0]); ++joint_num)
+	{
+		const JointDesc& desc = joints[joint_num];
+
+		gef::Matrix44 rotation_x, rotation_y, rotation_z, local;
+		rotation_x.RotationX(desc.rotation.x());
+		rotation_y.RotationY(desc.rotation.y());
+		rotation_z.RotationZ(desc.rotation.z());
+		local = rotation_x * rotation_y * rotation_z;
+		local.SetTranslation(desc.translation);
+
+		gef::Matrix44 global = desc.parent == -1 ? local : local * bind_globals[desc.parent];
+		bind_globals.push_back(global);
+
+		gef::Joint joint;
+		joint.name_id = (gef::StringId)joint_num;
+		joint.parent = desc.parent;
+		joint.inv_bind_pose.Inverse(global);
+		skeleton.AddJoint(joint);
+	}
+
+	chain.clear();
+	chain.push_back(5);
+	chain.push_back(6);
+	chain.push_back(7);
+}
+
+// a root with a tail of joint_count joints curling away from it, each bone shorter than the last and bent a little
+// further, so there is no straight line through the chain
+static void BuildTail(gef::Skeleton& skeleton, std::vector<int>& chain, int joint_count)
+{
+	std::vector<gef::Matrix44> bind_globals;
+	chain.clear();
+	for (int joint_num = 0; joint_num <= joint_count; ++joint_num)
+	{
+		gef::Matrix44 rotation_x, rotation_z, local;
+		rotation_x.RotationX(joint_num == 0 ? 0.0f : 0.15f);
+		rotation_z.RotationZ(joint_num == 0 ? 0.0f : (joint_num & 1 ? 0.1f : -0.05f));
+		local = rotation_x * rotation_z;
+		local.SetTranslation(joint_num == 0 ? gef::Vector4(0.0f, 1.0f, 0.0f) : gef::Vector4(0.0f, 0.0f, -0.3f + 0.02f * joint_num));
+
+		gef::Matrix44 global = joint_num == 0 ? local : local * bind_globals.back();
+		bind_globals.push_back(global);
+
+		gef::Joint joint;
+		joint.name_id = (gef::StringId)joint_num;
+		joint.parent = joint_num - 1;
+		joint.inv_bind_pose.Inverse(global);
+		skeleton.AddJoint(joint);
+
+		if (joint_num > 0)
+			chain.push_back(joint_num);
+	}
+}
+
+static void ChainReach(const gef::SkeletonPose& bind_pose, const std::vector<int>& chain, float& min_reach, float& max_reach)
+{
+	min_reach = 0.0f;
+	max_reach = 0.0f;
+	for (size_t i = 1; i < chain.size(); ++i)
+	{
+		float bone_length = (bind_pose.global_pose()[chain[i]].GetTranslation() - bind_pose.global_pose()[chain[i - 1]].GetTranslation()).Length();
+		min_reach = i == 1 ? bone_length : fabsf(min_reach - bone_length);
+		max_reach += bone_length;
+	}
+}
+
+static void GenerateTargets(const gef::SkeletonPose& bind_pose, const std::vector<int>& chain, const BenchmarkSettings& settings, TargetSet& reachable, TargetSet& unreachable)
+{
+	const gef::Vector4 root = bind_pose.global_pose()[chain[0]].GetTranslation();
+	float min_reach, max_reach;
+	ChainReach(bind_pose, chain, min_reach, max_reach);
+
+	std::mt19937 random(settings.seed);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> reachable_distance(min_reach + 0.05f * max_reach, 0.98f * max_reach);
+	std::uniform_real_distribution<float> unreachable_distance(1.05f * max_reach, 2.0f * max_reach);
+
+	reachable.name = "reachable";
+	reachable.reachable = true;
+	unreachable.name = "unreachable";
+	unreachable.reachable = false;
+
+	for (int target_num = 0; target_num < settings.target_count; ++target_num)
+	{
+		gef::Vector4 direction;
+		do
+		{
+			direction = gef::Vector4(unit(random), unit(random), unit(random));
+		} while (direction.LengthSqr() > 1.0f || direction.LengthSqr() < 1e-4f);
+		direction.Normalise();
+
+		reachable.targets.push_back(root + direction * reachable_distance(random));
+		reachable.best_errors.push_back(0.0f);
+
+		float distance = unreachable_distance(random);
+		unreachable.targets.push_back(root + direction * distance);
+		unreachable.best_errors.push_back(distance - max_reach);
+	}
+}
+
+// a target sweeping smoothly round the root of the chain at 60 frames a second, like a hand following a moving object
+static void GenerateTrack(const gef::SkeletonPose& bind_pose, const std::vector<int>& chain, int frame_count, TargetSet& track)
+{
+	const gef::Vector4 root = bind_pose.global_pose()[chain[0]].GetTranslation();
+	float min_reach, max_reach;
+	ChainReach(bind_pose, chain, min_reach, max_reach);
+	const float radius = 0.5f * (min_reach + max_reach);
+
+	track.name = "tracking";
+	track.reachable = true;
+	for (int frame_num = 0; frame_num < frame_count; ++frame_num)
+	{
+		float time = frame_num / 60.0f;
+		gef::Vector4 direction(cosf(time), 0.5f * sinf(2.0f * time), sinf(time));
+		direction.Normalise();
+		track.targets.push_back(root + direction * radius);
+		track.best_errors.push_back(0.0f);
+	}
+}
+
+// solve returns the number of iterations it took and whether it converged
+typedef std::function<bool(gef::SkeletonPose& pose, const gef::Vector4& target, int& iterations)> SolveFunc;
+
+// with warm_start each solve carries on from the pose the previous one left, otherwise it starts from the bind pose
+static SolveStats RunSolver(const SolveFunc& solve, const gef::SkeletonPose& bind_pose, int effector, const TargetSet& target_set, bool warm_start)
+{
+	SolveStats stats;
+	stats.converged = 0;
+	stats.total_iterations = 0;
+	stats.max_iterations = 0;
+	stats.errors.reserve(target_set.targets.size());
+	stats.total_time_ns = 0;
+	stats.allocations = 0;
+
+	gef::SkeletonPose pose = bind_pose;
+	for (size_t target_num = 0; target_num < target_set.targets.size(); ++target_num)
+	{
+		if (!warm_start)
+			pose = bind_pose;
+		const gef::Vector4& target = target_set.targets[target_num];
+
+		int iterations = 0;
+		UInt64 allocations_before = TotalAllocations();
+		UInt64 start_ns = gef::Profiler::GetTimeNs();
+		bool converged = solve(pose, target, iterations);
+		UInt64 end_ns = gef::Profiler::GetTimeNs();
+		stats.allocations += TotalAllocations() - allocations_before;
+		stats.total_time_ns += end_ns - start_ns;
+
+		stats.converged += converged ? 1 : 0;
+		stats.total_iterations += iterations;
+		stats.max_iterations = std::max(stats.max_iterations, iterations);
+
+		float error = (pose.global_pose()[effector].GetTranslation() - target).Length();
+		stats.errors.push_back(std::max(error - target_set.best_errors[target_num], 0.0f));
+	}
+
+	return stats;
+}
+
+// both legs of a crowd of tesla models planted on randomly raised and tilted ground, on the calling thread then
+// on the job system, returns the number of failures
+static int RunFootPlacement(const gef::Skeleton& skeleton, unsigned int seed)
+{
+	// hip, knee and ankle of each leg of the tesla
+	const int legs[2][3] = { { 5, 7, 10 }, { 6, 14, 17 } };
+
+	// the batch expects y up, the tesla is z up so tip the whole skeleton over through its bind pose
+	gef::Skeleton y_up_skeleton = skeleton;
+	gef::Matrix44 y_up_to_z_up;
+	y_up_to_z_up.RotationX(gef::DegToRad(90.0f));
+	for (int joint_num = 0; joint_num < y_up_skeleton.joint_count(); ++joint_num)
+		y_up_skeleton.joints()[joint_num].inv_bind_pose = y_up_to_z_up * skeleton.joint(joint_num).inv_bind_pose;
+
+	gef::SkeletonPose bind_pose;
+	bind_pose.CreateBindPose(&y_up_skeleton);
+	bind_pose.CalculateGlobalPose();
+
+	float leg_length = 0.0f;
+	for (int i = 1; i < 3; ++i)
+		leg_length += (bind_pose.global_pose()[legs[0][i]].GetTranslation() - bind_pose.global_pose()[legs[0][i - 1]].GetTranslation()).Length();
+
+	// ground under each foot, the animated ankle height is kept on top of the ground straight under the ankle
+	const int leg_count = kFootPlacementCharacters * 2;
+	std::vector<gef::Vector4> ground_points, ground_normals, targets;
+	std::mt19937 random(seed);
+	std::uniform_real_distribution<float> offset(-0.2f * leg_length, 0.2f * leg_length);
+	std::uniform_real_distribution<float> height(0.1f * leg_length, 0.3f * leg_length);
+	std::uniform_real_distribution<float> tilt(-gef::DegToRad(20.0f), gef::DegToRad(20.0f));
+	for (int leg_num = 0; leg_num < leg_count; ++leg_num)
+	{
+		const gef::Vector4 ankle = bind_pose.global_pose()[legs[leg_num & 1][2]].GetTranslation();
+		gef::Vector4 ground_point(ankle.x() + offset(random), height(random), ankle.z() + offset(random));
+		float tilt_x = tilt(random), tilt_z = tilt(random);
+		gef::Vector4 ground_normal(sinf(tilt_z), cosf(tilt_x) * cosf(tilt_z), sinf(tilt_x));
+		ground_normal.Normalise();
+
+		float ground_height = ground_point.y() - (ground_normal.x() * (ankle.x() - ground_point.x()) + ground_normal.z() * (ankle.z() - ground_point.z())) / ground_normal.y();
+		ground_points.push_back(ground_point);
+		ground_normals.push_back(ground_normal);
+		targets.push_back(gef::Vector4(ankle.x(), ankle.y() + ground_height, ankle.z()));
+	}
+
+	std::vector<gef::SkeletonPose> poses(kFootPlacementCharacters, bind_pose);
+	FootPlacementBatch batch;
+	batch.Init(leg_count);
+	gef::JobSystem job_system(3);
+
+	int failures = 0;
+	for (int run = 0; run < 2; ++run)
+	{
+		const char* run_name = run == 0 ? "serial" : "jobs";
+		for (size_t pose_num = 0; pose_num < poses.size(); ++pose_num)
+			poses[pose_num] = bind_pose;
+
+		UInt64 allocations_before = TotalAllocations();
+		batch.Clear();
+		for (int leg_num = 0; leg_num < leg_count; ++leg_num)
+		{
+			const int* leg = legs[leg_num & 1];
+			batch.AddLeg(poses[leg_num / 2], leg[0], leg[1], leg[2], ground_points[leg_num], ground_normals[leg_num]);
+		}
+		UInt64 start_ns = gef::Profiler::GetTimeNs();
+		batch.Solve(run == 0 ? NULL : &job_system);
+		UInt64 end_ns = gef::Profiler::GetTimeNs();
+		UInt64 allocations = TotalAllocations() - allocations_before;
+
+		float max_error = 0.0f;
+		for (int leg_num = 0; leg_num < leg_count; ++leg_num)
+		{
+			const gef::SkeletonPose& pose = poses[leg_num / 2];
+			const int* leg = legs[leg_num & 1];
+			float error = (pose.global_pose()[leg[2]].GetTranslation() - targets[leg_num]).Length();
+			max_error = std::max(max_error, error);
+		}
+
+		printf("%-10s %-12s %9d legs %11s %11.5f %9.3f %9.2f\n", "FootPlace", run_name, leg_count, "", max_error,
+			(end_ns - start_ns) * 1e-3f / leg_count, (float)allocations / leg_count);
+
+		if (max_error > 1e-4f * leg_length)
+		{
+			printf("FAIL: foot placement missed the ground by %g on the %s run\n", max_error, run_name);
+			++failures;
+		}
+		if (allocations > 0)
+		{
+			printf("FAIL: foot placement allocated on the %s run\n", run_name);
+			++failures;
+		}
+	}
+
+	return failures;
+}
+
+static float Percentile(std::vector<float> values, float percentile)
+{
+	if (values.empty())
+		return 0.0f;
+	size_t index = std::min((size_t)(percentile * (values.size() - 1) + 0.5f), values.size() - 1);
+	std::nth_element(values.begin(), values.begin() + index, values.end());
+	return values[index];
+}
+
+static float MeanError(const SolveStats& stats)
+{
+	float total_error = 0.0f;
+	for (size_t i = 0; i < stats.errors.size(); ++i)
+		total_error += stats.errors[i];
+	return stats.errors.empty() ? 0.0f : total_error / stats.errors.size();
+}
+
+// angle of the turn from one rotation to the other, which stays accurate for tiny angles unlike acos of the dot product
+static float AngleBetween(const gef::Quaternion& from, const gef::Quaternion& to)
+{
+	gef::Quaternion inv_from;
+	inv_from.Conjugate(from);
+	gef::Quaternion turn = inv_from * to;
+	return 2.0f * atan2f(sqrtf(turn.x * turn.x + turn.y * turn.y + turn.z * turn.z), fabsf(turn.w));
+}
+
+// Both hands and both feet of the tesla reaching for targets together while the top of its spine holds an
+// orientation, as a head looking at something would, all in one DLS solve from the bind pose.
+// The targets are read from random poses of the solved joints, so every one of them can be reached.
+// Returns the number of failures.
+static int RunFullBody(const gef::Skeleton& skeleton, const BenchmarkSettings& settings)
+{
+	// left and right wrist and ankle, then the top of the spine which only has an orientation target
+	const int effectors[] = { 31, 36, 10, 17, 23 };
+	const char* const effector_names[] = { "left hand", "right hand", "left foot", "right foot", "chest" };
+	const int effector_count = sizeof(effectors) / sizeof(effectors[0]);
+	const int orientation_effector = effector_count - 1;
+
+	DLSSolver solver;
+	if (!solver.Init(skeleton, std::vector<int>(effectors, effectors + effector_count), 0))
+	{
+		printf("FAIL: full body effectors are not below the root\n");
+		return 1;
+	}
+	solver.set_epsilon(settings.epsilon);
+	solver.set_max_iterations(settings.max_iterations);
+	solver.set_warm_start(false);
+	solver.set_weight(orientation_effector, 0.0f);
+	solver.set_orientation_weight(orientation_effector, 1.0f);
+
+	gef::SkeletonPose bind_pose;
+	bind_pose.CreateBindPose(&skeleton);
+	bind_pose.CalculateGlobalPose();
+
+	std::mt19937 random(settings.seed);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> angle(-0.4f, 0.4f);
+
+	// errors of each effector on every solve, orientations in radians
+	std::vector<std::vector<float>> errors(effector_count);
+	int converged = 0;
+	long long total_iterations = 0;
+	int max_iterations = 0;
+	UInt64 total_time_ns = 0;
+	UInt64 allocations = 0;
+
+	gef::SkeletonPose pose = bind_pose;
+	gef::SkeletonPose target_pose = bind_pose;
+	for (int target_num = 0; target_num < settings.target_count; ++target_num)
+	{
+		target_pose = bind_pose;
+		for (size_t joint_num = 0; joint_num < solver.joint_indices().size(); ++joint_num)
+		{
+			gef::Vector4 axis(unit(random), unit(random), unit(random));
+			axis.Normalise();
+			const float half_angle = 0.5f * angle(random);
+			gef::Quaternion turn(axis.x() * sinf(half_angle), axis.y() * sinf(half_angle), axis.z() * sinf(half_angle), cosf(half_angle));
+
+			gef::JointPose& joint_pose = target_pose.local_pose()[solver.joint_indices()[joint_num]];
+			gef::Quaternion rotation = turn * joint_pose.rotation();
+			rotation.Normalise();
+			joint_pose.set_rotation(rotation);
+		}
+		target_pose.CalculateGlobalPose();
+
+		gef::Quaternion orientation_target;
+		for (int effector_num = 0; effector_num < effector_count; ++effector_num)
+		{
+			gef::Vector4 translation;
+			float scale;
+			DecomposeUniform(target_pose.global_pose()[effectors[effector_num]], orientation_target, translation, scale);
+			solver.set_target(effector_num, translation);
+		}
+		solver.set_orientation_target(orientation_effector, orientation_target);
+
+		pose = bind_pose;
+		UInt64 allocations_before = TotalAllocations();
+		UInt64 start_ns = gef::Profiler::GetTimeNs();
+		converged += solver.Solve(pose) ? 1 : 0;
+		UInt64 end_ns = gef::Profiler::GetTimeNs();
+		allocations += TotalAllocations() - allocations_before;
+		total_time_ns += end_ns - start_ns;
+		total_iterations += solver.iterations();
+		max_iterations = std::max(max_iterations, solver.iterations());
+
+		for (int effector_num = 0; effector_num < effector_count; ++effector_num)
+		{
+			if (effector_num == orientation_effector)
+			{
+				gef::Quaternion rotation;
+				gef::Vector4 translation;
+				float scale;
+				DecomposeUniform(pose.global_pose()[effectors[effector_num]], rotation, translation, scale);
+				errors[effector_num].push_back(AngleBetween(rotation, orientation_target));
+			}
+			else
+			{
+				errors[effector_num].push_back((pose.global_pose()[effectors[effector_num]].GetTranslation() - solver.target(effector_num)).Length());
+			}
+		}
+	}
+
+	const float solves = (float)settings.target_count;
+	printf("%-10s %-12s %9.1f%% %9.1f %7d %11s %11s %11s %9.2f %9.2f\n", "DLS", "full body",
+		100.0f * converged / solves, total_iterations / solves, max_iterations, "", "", "", total_time_ns * 1e-3f / solves, allocations / solves);
+
+	int failures = 0;
+	for (int effector_num = 0; effector_num < effector_count; ++effector_num)
+	{
+		const std::vector<float>& effector_errors = errors[effector_num];
+		float mean_error = 0.0f;
+		for (size_t i = 0; i < effector_errors.size(); ++i)
+			mean_error += effector_errors[i];
+		mean_error = effector_errors.empty() ? 0.0f : mean_error / effector_errors.size();
+
+		printf("%-10s %-12s %10s %9s %7s %11.5f %11.5f %11.5f\n", "", effector_names[effector_num], "", "", "",
+			mean_error, Percentile(effector_errors, 0.95f), Percentile(effector_errors, 1.0f));
+
+		// the orientation is converged within epsilon over the chain length radians
+		const float max_mean_error = effector_num == orientation_effector ? settings.epsilon / solver.chain_length() : settings.epsilon;
+		if (mean_error > max_mean_error)
+		{
+			printf("FAIL: DLS missed the %s targets by more than %g on average\n", effector_names[effector_num], max_mean_error);
+			++failures;
+		}
+	}
+
+	if (converged < 0.99f * solves)
+	{
+		printf("FAIL: DLS converged on fewer than 99%% of full body targets\n");
+		++failures;
+	}
+	if (total_iterations > 30.0f * solves)
+	{
+		printf("FAIL: DLS took more than 30 iterations on average to reach full body targets\n");
+		++failures;
+	}
+	if (allocations > 0)
+	{
+		printf("FAIL: DLS allocated while solving the full body\n");
+		++failures;
+	}
+
+	return failures;
+}
+
+static void PrintStats(const char* solver_name, const TargetSet& target_set, const SolveStats& stats)
+{
+	const float solves = (float)target_set.targets.size();
+
+	printf("%-10s %-12s %9.1f%% %9.1f %7d %11.5f %11.5f %11.5f %9.2f %9.2f\n",
+		solver_name, target_set.name,
+		100.0f * stats.converged / solves,
+		stats.total_iterations / solves, stats.max_iterations,
+		MeanError(stats), Percentile(stats.errors, 0.95f), Percentile(stats.errors, 1.0f),
+		stats.total_time_ns * 1e-3f / solves,
+		stats.allocations / solves);
+}
+
+int main(int argc, char* argv[])
+{
+	BenchmarkSettings settings;
+	settings.target_count = 5000;
+	settings.epsilon = 0.001f;
+	settings.max_iterations = 200;
+	settings.seed = 12345;
+	settings.built_in_arm = false;
+	settings.tail_joints = 0;
+
+	std::vector<const char*> positional;
+	for (int arg_num = 1; arg_num < argc; ++arg_num)
+	{
+		if (strcmp(argv[arg_num], "-n") == 0 && arg_num + 1 < argc)
+			settings.target_count = atoi(argv[++arg_num]);
+		else if (strcmp(argv[arg_num], "-e") == 0 && arg_num + 1 < argc)
+			settings.epsilon = (float)atof(argv[++arg_num]);
+		else if (strcmp(argv[arg_num], "-i") == 0 && arg_num + 1 < argc)
+			settings.max_iterations = atoi(argv[++arg_num]);
+		else if (strcmp(argv[arg_num], "-s") == 0 && arg_num + 1 < argc)
+			settings.seed = (unsigned int)strtoul(argv[++arg_num], NULL, 10);
+		else if (strcmp(argv[arg_num], "-a") == 0)
+			settings.built_in_arm = true;
+		else if (strcmp(argv[arg_num], "-t") == 0 && arg_num + 1 < argc)
+			settings.tail_joints = atoi(argv[++arg_num]);
+		else
+			positional.push_back(argv[arg_num]);
+	}
+
+	gef::PlatformHeadless platform(960, 544);
+
+	// load the skeleton and arm chain
+	gef::Scene scene;
+	gef::Skeleton built_skeleton;
+	const gef::Skeleton* skeleton = NULL;
+	std::vector<int> chain;
+
+	if (settings.tail_joints > 0)
+	{
+		if (settings.tail_joints < 3 || settings.tail_joints > 14)
+		{
+			printf("the tail needs from 3 to 14 joints\n");
+			return 1;
+		}
+		BuildTail(built_skeleton, chain, settings.tail_joints);
+		skeleton = &built_skeleton;
+		printf("skeleton: built in tail\n");
+	}
+	else if (settings.built_in_arm)
+	{
+		BuildXbotArm(built_skeleton, chain);
+		skeleton = &built_skeleton;
+		printf("skeleton: built in arm with the proportions of the xbot\n");
+	}
+	else
+	{
+		const char* scene_filename = positional.size() >= 4 ? positional[0] : "tesla/tesla.scn";
+		if (positional.size() >= 4)
+		{
+			for (size_t i = 1; i < positional.size(); ++i)
+				chain.push_back(atoi(positional[i]));
+		}
+		else
+		{
+			// left shoulder, elbow and wrist of the tesla
+			chain.push_back(28);
+			chain.push_back(30);
+			chain.push_back(31);
+		}
+
+		gef::File* file = gef::File::Create();
+		bool scene_exists = file->Exists(scene_filename);
+		delete file;
+
+		if (!scene_exists || !scene.ReadSceneFromFile(platform, scene_filename) || scene.skeletons.empty())
+		{
+			printf("%s could not be loaded or has no skeleton\n", scene_filename);
+			return 1;
+		}
+		skeleton = scene.skeletons.front();
+		printf("skeleton: %s\n", scene_filename);
+	}
+
+	for (size_t i = 0; i < chain.size(); ++i)
+	{
+		if (chain[i] < 0 || chain[i] >= skeleton->joint_count())
+		{
+			printf("joint %d is not in the skeleton\n", chain[i]);
+			return 1;
+		}
+	}
+
+	gef::SkeletonPose bind_pose;
+	bind_pose.CreateBindPose(skeleton);
+	bind_pose.CalculateGlobalPose();
+	const int effector = chain.back();
+
+	float min_reach, max_reach;
+	ChainReach(bind_pose, chain, min_reach, max_reach);
+
+	TargetSet target_sets[2];
+	GenerateTargets(bind_pose, chain, settings, target_sets[0], target_sets[1]);
+	printf("chain:");
+	for (size_t i = 0; i < chain.size(); ++i)
+		printf(" %d", chain[i]);
+	printf(", reach %g, %d targets per set, epsilon %g, max iterations %d, seed %u\n\n",
+		max_reach, settings.target_count, settings.epsilon, settings.max_iterations, settings.seed);
+
+	// every solver can bend the joints all the way round
+	std::vector<std::pair<float, float>> constraints(chain.size(), std::pair<float, float>(0.0f, gef::DegToRad(360.0f)));
+
+	CCDSolver ccd_solver;
+	FABRIKSolver fabrik_solver;
+	TwoBoneSolver two_bone_solver;
+	DLSSolver dls_solver;
+
+	// the two bone solver only takes three joints, the rest take chains of any length
+	const bool long_chain = chain.size() > 3;
+	std::vector<IKSolver*> chain_solvers;
+	chain_solvers.push_back(&ccd_solver);
+	chain_solvers.push_back(&fabrik_solver);
+	if (!long_chain)
+		chain_solvers.push_back(&two_bone_solver);
+
+	bool chains_ok = true;
+	for (size_t solver_num = 0; solver_num < chain_solvers.size(); ++solver_num)
+	{
+		IKSolver* solver = chain_solvers[solver_num];
+		chains_ok &= solver->Init(*skeleton, chain, constraints);
+		solver->set_epsilon(settings.epsilon);
+		solver->set_max_iterations(settings.max_iterations);
+		solver->set_warm_start(false);
+	}
+	chains_ok &= dls_solver.Init(*skeleton, std::vector<int>(1, effector), chain[0]);
+	dls_solver.set_epsilon(settings.epsilon);
+	dls_solver.set_max_iterations(settings.max_iterations);
+	dls_solver.set_warm_start(false);
+	if (!chains_ok)
+	{
+		printf("chain is not a parent to child chain of joints\n");
+		return 1;
+	}
+
+	// the original function needs a skinned mesh instance for the model transform
+	gef::SkinnedMeshInstance legacy_instance(*skeleton);
+	std::vector<int> priority_bones;
+	for (int i = 0; i < (int)chain.size() - 1; ++i)
+		priority_bones.push_back(i);
+
+	// fraction of reachable targets the solver must hit, the most it may miss them by on average as a fraction
+	// of the length of the chain, the most iterations it may take on average and the most iterations a frame it
+	// may take on average following the moving target, warm started from the last frame
+	struct SolverLimits
+	{
+		float min_converged;
+		float max_mean_error;
+		float max_mean_iterations;
+		float max_tracking_iterations;
+	};
+
+	struct SolverEntry
+	{
+		const char* name;
+		SolveFunc solve;
+		// measured with the default epsilon and max iterations, on the tesla's arms and legs and the built in arm
+		// for three joints, and on the tesla's spine to hand and the built in tail for longer chains
+		SolverLimits three_joint_limits;
+		SolverLimits long_chain_limits;
+		bool allocation_free;
+		bool three_joints_only;
+	};
+
+	const SolverEntry solvers[] =
+	{
+		{ "Legacy", [&](gef::SkeletonPose& pose, const gef::Vector4& target, int& iterations)
+			{
+				return CalculateCCD(pose, legacy_instance, target, chain, constraints, priority_bones, &iterations);
+			}, { 0.0f, 0.04f, 200.0f, 200.0f }, { 0.0f, 0.04f, 200.0f, 200.0f }, false, false },
+		{ "CCD", [&](gef::SkeletonPose& pose, const gef::Vector4& target, int& iterations)
+			{
+				bool converged = ccd_solver.Solve(pose, target);
+				iterations = ccd_solver.iterations();
+				return converged;
+			}, { 0.99f, 0.002f, 30.0f, 8.0f }, { 0.95f, 0.002f, 40.0f, 16.0f }, true, false },
+		{ "FABRIK", [&](gef::SkeletonPose& pose, const gef::Vector4& target, int& iterations)
+			{
+				bool converged = fabrik_solver.Solve(pose, target);
+				iterations = fabrik_solver.iterations();
+				return converged;
+			}, { 0.99f, 0.0005f, 2.0f, 2.0f }, { 0.99f, 0.0005f, 10.0f, 3.0f }, true, false },
+		{ "TwoBone", [&](gef::SkeletonPose& pose, const gef::Vector4& target, int& iterations)
+			{
+				bool converged = two_bone_solver.Solve(pose, target);
+				iterations = two_bone_solver.iterations();
+				return converged;
+			}, { 0.99f, 0.0005f, 1.0f, 1.0f }, { 0.99f, 0.0005f, 1.0f, 1.0f }, true, true },
+		{ "DLS", [&](gef::SkeletonPose& pose, const gef::Vector4& target, int& iterations)
+			{
+				dls_solver.set_target(0, target);
+				bool converged = dls_solver.Solve(pose);
+				iterations = dls_solver.iterations();
+				return converged;
+			}, { 0.99f, 0.001f, 30.0f, 4.0f }, { 0.99f, 0.001f, 30.0f, 4.0f }, true, false },
+	};
+
+	printf("%-10s %-12s %10s %9s %7s %11s %11s %11s %9s %9s\n",
+		"solver", "targets", "converged", "mean its", "max its", "mean err", "p95 err", "max err", "us/solve", "allocs");
+
+	int failures = 0;
+	for (size_t solver_num = 0; solver_num < sizeof(solvers) / sizeof(solvers[0]); ++solver_num)
+	{
+		const SolverEntry& entry = solvers[solver_num];
+		if (long_chain && entry.three_joints_only)
+			continue;
+
+		const SolverLimits& limits = long_chain ? entry.long_chain_limits : entry.three_joint_limits;
+		for (int set_num = 0; set_num < 2; ++set_num)
+		{
+			const TargetSet& target_set = target_sets[set_num];
+			SolveStats stats = RunSolver(entry.solve, bind_pose, effector, target_set, false);
+			PrintStats(entry.name, target_set, stats);
+
+			if (target_set.reachable && stats.converged < limits.min_converged * target_set.targets.size())
+			{
+				printf("FAIL: %s converged on fewer than %.0f%% of reachable targets\n", entry.name, limits.min_converged * 100.0f);
+				++failures;
+			}
+			if (target_set.reachable && MeanError(stats) > limits.max_mean_error * max_reach)
+			{
+				printf("FAIL: %s missed reachable targets by more than %g on average\n", entry.name, limits.max_mean_error * max_reach);
+				++failures;
+			}
+			if (target_set.reachable && stats.total_iterations > limits.max_mean_iterations * target_set.targets.size())
+			{
+				printf("FAIL: %s took more than %g iterations on average to reach targets\n", entry.name, limits.max_mean_iterations);
+				++failures;
+			}
+			if (entry.allocation_free && stats.allocations > 0)
+			{
+				printf("FAIL: %s allocated while solving\n", entry.name);
+				++failures;
+			}
+		}
+	}
+
+	// follow a moving target frame by frame, each solver starting from where it left off
+	TargetSet track;
+	GenerateTrack(bind_pose, chain, kTrackingFrames, track);
+	for (size_t solver_num = 0; solver_num < chain_solvers.size(); ++solver_num)
+		chain_solvers[solver_num]->set_warm_start(true);
+	dls_solver.set_warm_start(true);
+
+	for (size_t solver_num = 0; solver_num < sizeof(solvers) / sizeof(solvers[0]); ++solver_num)
+	{
+		const SolverEntry& entry = solvers[solver_num];
+		if (long_chain && entry.three_joints_only)
+			continue;
+
+		const SolverLimits& limits = long_chain ? entry.long_chain_limits : entry.three_joint_limits;
+		SolveStats stats = RunSolver(entry.solve, bind_pose, effector, track, true);
+		PrintStats(entry.name, track, stats);
+
+		if (stats.total_iterations > limits.max_tracking_iterations * track.targets.size())
+		{
+			printf("FAIL: %s took more than %g iterations a frame following a moving target\n", entry.name, limits.max_tracking_iterations);
+			++failures;
+		}
+		if (stats.converged < limits.min_converged * track.targets.size())
+		{
+			printf("FAIL: %s converged on fewer than %.0f%% of frames following a moving target\n", entry.name, limits.min_converged * 100.0f);
+			++failures;
+		}
+	}
+
+	// the leg joints are only known for the tesla
+	if (!settings.built_in_arm && settings.tail_joints == 0 && positional.size() < 4)
+	{
+		failures += RunFullBody(*skeleton, settings);
+		failures += RunFootPlacement(*skeleton, settings.seed);
+	}
+
+	return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,157 @@
+#include "ik_solver.h"
+
+gef::Quaternion RotationBetween(const gef::Vector4& from, const gef::Vector4& to)
+{
+	float cos_angle = from.DotProduct(to);
+	gef::Quaternion rotation;
+
+	if (cos_angle < -0.99999f)
+	{
+		// opposite directions, turn half way round any axis at right angles to from
+		gef::Vector4 axis = gef::Vector4(1.0f, 0.0f, 0.0f).CrossProduct(from);
+		if (axis.LengthSqr() < 1e-6f)
+			axis = gef::Vector4(0.0f, 1.0f, 0.0f).CrossProduct(from);
+		axis.Normalise();
+		rotation = gef::Quaternion(axis.x(), axis.y(), axis.z(), 0.0f);
+	}
+	else
+	{
+		// half way quaternion, avoids any trig
+		gef::Vector4 axis = from.CrossProduct(to);
+		rotation = gef::Quaternion(axis.x(), axis.y(), axis.z(), 1.0f + cos_angle);
+		rotation.Normalise();
+	}
+
+	return rotation;
+}
+
+void DecomposeUniform(const gef::Matrix44& matrix, gef::Quaternion& rotation, gef::Vector4& translation, float& scale)
+{
+	scale = gef::Vector4(matrix.m(0, 0), matrix.m(0, 1), matrix.m(0, 2)).Length();
+
+	gef::Matrix44 rotation_matrix = matrix;
+	if (scale > 0.0f)
+	{
+		float inv_scale = 1.0f / scale;
+		for (int row = 0; row < 3; ++row)
+			rotation_matrix.SetRow(row, rotation_matrix.GetRow(row) * inv_scale);
+	}
+
+	rotation.SetFromMatrix(rotation_matrix);
+	rotation.Normalise();
+	translation = matrix.GetTranslation();
+}
+
+IKSolver::IKSolver() :
+	parent_index_(-1),
+	chain_parent_rotation_(0.0f, 0.0f, 0.0f, 1.0f),
+	chain_parent_position_(0.0f, 0.0f, 0.0f),
+	chain_parent_scale_(1.0f),
+	epsilon_(0.001f),
+	max_iterations_(200),
+	warm_start_(true),
+	has_solution_(false),
+	iterations_(0),
+	error_(0.0f)
+{
+}
+
+IKSolver::~IKSolver()
+{
+}
+
+bool IKSolver::Init(const gef::Skeleton& skeleton, const std::vector<int>& bone_indices, const std::vector<std::pair<float, float>>& constraints)
+{
+	if (bone_indices.size() < 2 || constraints.size() < bone_indices.size())
+		return false;
+
+	// the chain is walked parent to child, so each joint must hang directly off the one before it
+	for (size_t i = 1; i < bone_indices.size(); ++i)
+	{
+		if (skeleton.joint(bone_indices[i]).parent != bone_indices[i - 1])
+			return false;
+	}
+
+	bone_indices_ = bone_indices;
+	constraints_.assign(constraints.begin(), constraints.begin() + bone_indices.size());
+	parent_index_ = skeleton.joint(bone_indices.front()).parent;
+
+	size_t chain_length = bone_indices.size();
+	local_rotations_.resize(chain_length);
+	local_translations_.resize(chain_length);
+	local_scales_.resize(chain_length);
+	global_rotations_.resize(chain_length);
+	global_positions_.resize(chain_length);
+	global_scales_.resize(chain_length);
+
+	has_solution_ = false;
+	return true;
+}
+
+void IKSolver::ReadChain(const gef::SkeletonPose& pose)
+{
+	for (size_t i = 0; i < bone_indices_.size(); ++i)
+	{
+		const gef::JointPose& joint_pose = pose.local_pose()[bone_indices_[i]];
+		if (!warm_start_ || !has_solution_)
+			local_rotations_[i] = joint_pose.rotation();
+		local_translations_[i] = joint_pose.translation();
+		local_scales_[i] = joint_pose.scale().x();
+	}
+
+	// start from the global transform of the joint the chain hangs off
+	chain_parent_rotation_ = gef::Quaternion(0.0f, 0.0f, 0.0f, 1.0f);
+	chain_parent_position_ = gef::Vector4(0.0f, 0.0f, 0.0f);
+	chain_parent_scale_ = 1.0f;
+	if (parent_index_ != -1)
+		DecomposeUniform(pose.global_pose()[parent_index_], chain_parent_rotation_, chain_parent_position_, chain_parent_scale_);
+
+	CalculateChainGlobals();
+}
+
+void IKSolver::CalculateChainGlobals()
+{
+	gef::Quaternion parent_rotation = chain_parent_rotation_;
+	gef::Vector4 parent_position = chain_parent_position_;
+	float parent_scale = chain_parent_scale_;
+
+	for (size_t i = 0; i < bone_indices_.size(); ++i)
+	{
+		global_positions_[i] = parent_position + RotateVector(parent_rotation, local_translations_[i]) * parent_scale;
+		global_rotations_[i] = local_rotations_[i] * parent_rotation;
+		global_scales_[i] = local_scales_[i] * parent_scale;
+
+		parent_position = global_positions_[i];
+		parent_rotation = global_rotations_[i];
+		parent_scale = global_scales_[i];
+	}
+}
+
+void IKSolver::RotateJoint(int joint_num, const gef::Quaternion& delta)
+{
+	// move the rotation into the parent's space so it can be applied to the local rotation
+	// local' * parent = local * parent * delta
+	const gef::Quaternion& parent_rotation = joint_num > 0 ? global_rotations_[joint_num - 1] : chain_parent_rotation_;
+	gef::Quaternion inv_parent_rotation;
+	inv_parent_rotation.Conjugate(parent_rotation);
+	local_rotations_[joint_num] = local_rotations_[joint_num] * parent_rotation * delta * inv_parent_rotation;
+	local_rotations_[joint_num].Normalise();
+
+	// everything below the joint swings around it, no need to rebuild the chain from scratch
+	const gef::Vector4 joint_position = global_positions_[joint_num];
+	global_rotations_[joint_num] = global_rotations_[joint_num] * delta;
+	for (size_t child_num = joint_num + 1; child_num < bone_indices_.size(); ++child_num)
+	{
+		global_positions_[child_num] = joint_position + RotateVector(delta, global_positions_[child_num] - joint_position);
+		global_rotations_[child_num] = global_rotations_[child_num] * delta;
+	}
+}
+
+void IKSolver::WriteChain(gef::SkeletonPose& pose)
+{
+	for (size_t i = 0; i < bone_indices_.size(); ++i)
+		pose.local_pose()[bone_indices_[i]].set_rotation(local_rotations_[i]);
+	pose.CalculateGlobalPose();
+
+	has_solution_ = true;
+}
@@ -0,0 +1,94 @@
+#ifndef _IK_SOLVER_H
+#define _IK_SOLVER_H
+
+#include <animation/skeleton.h>
+#include <maths/quaternion.h>
+#include <maths/vector4.h>
+#include <vector>
+
+// rotate a vector by a normalised quaternion, the same as transforming it by the matrix built from the quaternion
+inline gef::Vector4 RotateVector(const gef::Quaternion& rotation, const gef::Vector4& v)
+{
+	gef::Vector4 axis(rotation.x, rotation.y, rotation.z);
+	gef::Vector4 t = axis.CrossProduct(v) * 2.0f;
+	return v + t * rotation.w + axis.CrossProduct(t);
+}
+
+// shortest rotation that turns unit vector from onto unit vector to
+gef::Quaternion RotationBetween(const gef::Vector4& from, const gef::Vector4& to);
+
+// split a matrix made of a uniform scale, rotation and translation into its parts
+void DecomposeUniform(const gef::Matrix44& matrix, gef::Quaternion& rotation, gef::Vector4& translation, float& scale);
+
+// Base for solvers that move a single chain of joints so its last joint reaches a target.
+// Init allocates all the scratch space for the chain so solving never allocates. Solvers work on the
+// local rotations of the chain joints only and, with warm start enabled, begin from the rotations they
+// found on the previous solve. Joint scales are assumed to be uniform.
+class IKSolver
+{
+public:
+	IKSolver();
+	virtual ~IKSolver();
+
+	// bone_indices run from the root of the chain to the end effector, each joint must be the parent of the next
+	// constraints give the minimum and maximum angle each joint can rotate by in a single step
+	virtual bool Init(const gef::Skeleton& skeleton, const std::vector<int>& bone_indices, const std::vector<std::pair<float, float>>& constraints);
+
+	// target is in model space, returns true if the end effector got within epsilon of it
+	virtual bool Solve(gef::SkeletonPose& pose, const gef::Vector4& target) = 0;
+
+	virtual const char* name() const = 0;
+
+	// forget the previous solution so the next solve starts from the pose that is passed in
+	inline void Reset() { has_solution_ = false; }
+
+	inline void set_epsilon(float epsilon) { epsilon_ = epsilon; }
+	inline float epsilon() const { return epsilon_; }
+	inline void set_max_iterations(int max_iterations) { max_iterations_ = max_iterations; }
+	inline int max_iterations() const { return max_iterations_; }
+	inline void set_warm_start(bool warm_start) { warm_start_ = warm_start; }
+	inline bool warm_start() const { return warm_start_; }
+
+	inline const std::vector<int>& bone_indices() const { return bone_indices_; }
+
+	// results of the last solve
+	inline int iterations() const { return iterations_; }
+	inline float error() const { return error_; }
+
+protected:
+	// fill the chain from the pose and work out the model space transforms of its joints
+	void ReadChain(const gef::SkeletonPose& pose);
+	void CalculateChainGlobals();
+
+	// rotate one joint by a model space rotation, swinging everything below it around the joint
+	void RotateJoint(int joint_num, const gef::Quaternion& delta);
+
+	// copy the chain rotations into the pose and rebuild its global pose once
+	void WriteChain(gef::SkeletonPose& pose);
+
+	std::vector<int> bone_indices_;
+	std::vector<std::pair<float, float>> constraints_;
+	int parent_index_;
+
+	gef::Quaternion chain_parent_rotation_;
+	gef::Vector4 chain_parent_position_;
+	float chain_parent_scale_;
+
+	std::vector<gef::Quaternion> local_rotations_;
+	std::vector<gef::Vector4> local_translations_;
+	std::vector<float> local_scales_;
+
+	std::vector<gef::Quaternion> global_rotations_;
+	std::vector<gef::Vector4> global_positions_;
+	std::vector<float> global_scales_;
+
+	float epsilon_;
+	int max_iterations_;
+	bool warm_start_;
+	bool has_solution_;
+
+	int iterations_;
+	float error_;
+};
+
+#endif // _IK_SOLVER_H
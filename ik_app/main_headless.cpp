@@ -0,0 +1,29 @@
+#include <platform/headless/system/platform_headless.h>
+#include <system/profiler.h>
+#include "animated_mesh_app.h"
+#include <cstdlib>
+
+int main(int argc, char* argv[])
+{
+	// optional number of frames to run for, zero runs until the app quits
+	unsigned int max_frames = 0;
+	if (argc > 1)
+		max_frames = (unsigned int)std::strtoul(argv[1], NULL, 10);
+
+	// optional file to write a chrome://tracing profile to
+	const char* trace_filename = argc > 2 ? argv[2] : NULL;
+	if (trace_filename)
+		gef::Profiler::set_enabled(true);
+
+	// initialisation
+	gef::PlatformHeadless platform(960, 544, max_frames);
+
+	AnimatedMeshApp myApp(platform);
+	myApp.set_ndc_zmin(0.0f);
+	myApp.Run();
+
+	if (trace_filename)
+		gef::Profiler::WriteChromeTrace(trace_filename);
+
+	return 0;
+}
@@ -1,9 +1,10 @@
 #include "picking.h"
 #include <math.h>
+#include <algorithm>
 
 // http://antongerdelan.net/opengl/raycasting.html
 // https://forum.libcinder.org/topic/picking-ray-from-mouse-coords
-void GetScreenPosRay(const gef::Vector2& screen_position, const gef::Matrix44& projection, const gef::Matrix44& view, gef::Vector4& start_point, gef::Vector4& direction, float screen_width, float screen_height, float ndc_z_min)
+static void ScreenPosRay(const gef::Vector2& screen_position, const gef::Matrix44& inv_view_projection, gef::Vector4& start_point, gef::Vector4& direction, float screen_width, float screen_height, float ndc_z_min)
 {
 	gef::Vector2 ndc;
 
@@ -13,13 +14,10 @@ void GetScreenPosRay(const gef::Vector2& screen_position, const gef::Matrix44& p
 	ndc.x = (static_cast<float>(screen_position.x) - hw) / hw;
 	ndc.y = (hh - static_cast<float>(screen_position.y)) / hh;
 
-	gef::Matrix44 projectionInverse;
-	projectionInverse.Inverse(view * projection);
-
 	gef::Vector4 nearPoint, farPoint;
 
-	nearPoint = gef::Vector4(ndc.x, ndc.y, ndc_z_min, 1.0f).TransformW(projectionInverse);
-	farPoint = gef::Vector4(ndc.x, ndc.y, 1.0f, 1.0f).TransformW(projectionInverse);
+	nearPoint = gef::Vector4(ndc.x, ndc.y, ndc_z_min, 1.0f).TransformW(inv_view_projection);
+	farPoint = gef::Vector4(ndc.x, ndc.y, 1.0f, 1.0f).TransformW(inv_view_projection);
 
 	nearPoint /= nearPoint.w();
 	farPoint /= farPoint.w();
@@ -29,6 +27,23 @@ void GetScreenPosRay(const gef::Vector2& screen_position, const gef::Matrix44& p
 	direction.Normalise();
 }
 
+void GetScreenPosRay(const gef::Vector2& screen_position, const gef::Matrix44& projection, const gef::Matrix44& view, gef::Vector4& start_point, gef::Vector4& direction, float screen_width, float screen_height, float ndc_z_min)
+{
+	gef::Matrix44 projectionInverse;
+	projectionInverse.Inverse(view * projection);
+
+	ScreenPosRay(screen_position, projectionInverse, start_point, direction, screen_width, screen_height, ndc_z_min);
+}
+
+void GetScreenPosRays(const gef::Vector2* screen_positions, int count, const gef::Matrix44& projection, const gef::Matrix44& view, gef::Vector4* start_points, gef::Vector4* directions, float screen_width, float screen_height, float ndc_z_min)
+{
+	gef::Matrix44 projectionInverse;
+	projectionInverse.Inverse(view * projection);
+
+	for (int i = 0; i < count; ++i)
+		ScreenPosRay(screen_positions[i], projectionInverse, start_points[i], directions[i], screen_width, screen_height, ndc_z_min);
+}
+
 // modified from https://gamedev.stackexchange.com/questions/96459/fast-ray-sphere-collision-code
 bool RaySphereIntersect(const gef::Vector4& start_point, const gef::Vector4& direction, const gef::Vector4& sphere_centre, float sphere_radius, gef::Vector4& hitpoint)
 {
@@ -85,3 +100,145 @@ bool RayPlaneIntersect(gef::Vector4& start_point, gef::Vector4& direction, const
 	return false;
 }
 
+
+
+// https://iquilezles.org/articles/intersectors/ extended to rays that are not normalised
+bool RayCapsuleIntersect(const gef::Vector4& start_point, const gef::Vector4& direction, const gef::Vector4& capsule_start, const gef::Vector4& capsule_end, float capsule_radius, float& t)
+{
+	gef::Vector4 ba = capsule_end - capsule_start;
+	gef::Vector4 oa = start_point - capsule_start;
+	float baba = ba.DotProduct(ba);
+	float bard = ba.DotProduct(direction);
+	float baoa = ba.DotProduct(oa);
+	float rdoa = direction.DotProduct(oa);
+	float rdrd = direction.DotProduct(direction);
+	float radius_sqr = capsule_radius * capsule_radius;
+
+	// the side of the capsule, an infinite cylinder clipped to the segment
+	float a = baba * rdrd - bard * bard;
+	if (a > 1e-12f)
+	{
+		float b = baba * rdoa - baoa * bard;
+		float c = baba * oa.LengthSqr() - baoa * baoa - radius_sqr * baba;
+		float h = b * b - a * c;
+		if (h < 0.0f)
+			return false;
+
+		float side_t = (-b - sqrtf(h)) / a;
+		float y = baoa + side_t * bard;
+		if (side_t >= 0.0f && y > 0.0f && y < baba)
+		{
+			t = side_t;
+			return true;
+		}
+	}
+
+	// a ray starting inside the capsule hits it straight away
+	float segment_t = baba > 0.0f ? baoa / baba : 0.0f;
+	segment_t = segment_t < 0.0f ? 0.0f : (segment_t > 1.0f ? 1.0f : segment_t);
+	if ((oa - ba * segment_t).LengthSqr() <= radius_sqr)
+	{
+		t = 0.0f;
+		return true;
+	}
+
+	// otherwise the ray can only hit the end caps, keep the nearer hit
+	bool hit = false;
+	const gef::Vector4 cap_centres[2] = { capsule_start, capsule_end };
+	for (int cap = 0; cap < 2; ++cap)
+	{
+		gef::Vector4 oc = start_point - cap_centres[cap];
+		float b = direction.DotProduct(oc);
+		float c = oc.LengthSqr() - radius_sqr;
+		float h = b * b - rdrd * c;
+		if (h < 0.0f || b > 0.0f)
+			continue;
+
+		float cap_t = (-b - sqrtf(h)) / rdrd;
+		if (!hit || cap_t < t)
+			t = cap_t;
+		hit = true;
+	}
+
+	return hit;
+}
+
+// The packet versions below work lane by lane with selects instead of branches, so the compiler can turn each
+// loop over the rays of a packet into a few SIMD instructions on any target
+
+template<int kWidth>
+int RaySpherePacketIntersect(const RayPacket<kWidth>& rays, const float* sphere_x, const float* sphere_y, const float* sphere_z, const float* sphere_radius, int sphere_count, float* hit_t, int* hit_spheres)
+{
+	float closest_t[kWidth];
+	int closest_sphere[kWidth];
+	for (int ray = 0; ray < kWidth; ++ray)
+	{
+		closest_t[ray] = rays.max_t[ray];
+		closest_sphere[ray] = -1;
+	}
+
+	for (int sphere = 0; sphere < sphere_count; ++sphere)
+	{
+		const float centre_x = sphere_x[sphere];
+		const float centre_y = sphere_y[sphere];
+		const float centre_z = sphere_z[sphere];
+		const float radius_sqr = sphere_radius[sphere] * sphere_radius[sphere];
+
+		for (int ray = 0; ray < kWidth; ++ray)
+		{
+			const float m_x = rays.start_x[ray] - centre_x;
+			const float m_y = rays.start_y[ray] - centre_y;
+			const float m_z = rays.start_z[ray] - centre_z;
+			const float b = m_x * rays.direction_x[ray] + m_y * rays.direction_y[ray] + m_z * rays.direction_z[ray];
+			const float c = m_x * m_x + m_y * m_y + m_z * m_z - radius_sqr;
+			const float discr = b * b - c;
+
+			// same rules as RaySphereIntersect, a ray starting inside the sphere hits it at zero
+			// bitwise rather than logical operators so there is nothing to branch on
+			const float t = std::max(-b - sqrtf(std::max(discr, 0.0f)), 0.0f);
+			const bool hit = ((c <= 0.0f) | (b <= 0.0f)) & (discr >= 0.0f) & (t < closest_t[ray]);
+
+			closest_t[ray] = hit ? t : closest_t[ray];
+			closest_sphere[ray] = hit ? sphere : closest_sphere[ray];
+		}
+	}
+
+	int hit_mask = 0;
+	for (int ray = 0; ray < kWidth; ++ray)
+	{
+		hit_t[ray] = closest_t[ray];
+		hit_spheres[ray] = closest_sphere[ray];
+		hit_mask |= (closest_sphere[ray] != -1) << ray;
+	}
+
+	return hit_mask;
+}
+
+template<int kWidth>
+int RayPlanePacketIntersect(const RayPacket<kWidth>& rays, const gef::Vector4& point_on_plane, const gef::Vector4& plane_normal, float* hit_t)
+{
+	const float normal_x = plane_normal.x();
+	const float normal_y = plane_normal.y();
+	const float normal_z = plane_normal.z();
+	const float plane_d = point_on_plane.DotProduct(plane_normal);
+
+	int hit_mask = 0;
+	for (int ray = 0; ray < kWidth; ++ray)
+	{
+		const float denom = normal_x * rays.direction_x[ray] + normal_y * rays.direction_y[ray] + normal_z * rays.direction_z[ray];
+		const float distance = plane_d - (normal_x * rays.start_x[ray] + normal_y * rays.start_y[ray] + normal_z * rays.start_z[ray]);
+		const bool parallel = fabsf(denom) <= 1e-6f;
+		const float t = distance / (parallel ? 1.0f : denom);
+		const bool hit = !parallel & (t >= 0.0f) & (t <= rays.max_t[ray]);
+
+		hit_t[ray] = t;
+		hit_mask |= hit << ray;
+	}
+
+	return hit_mask;
+}
+
+template int RaySpherePacketIntersect<4>(const RayPacket<4>&, const float*, const float*, const float*, const float*, int, float*, int*);
+template int RaySpherePacketIntersect<8>(const RayPacket<8>&, const float*, const float*, const float*, const float*, int, float*, int*);
+template int RayPlanePacketIntersect<4>(const RayPacket<4>&, const gef::Vector4&, const gef::Vector4&, float*);
+template int RayPlanePacketIntersect<8>(const RayPacket<8>&, const gef::Vector4&, const gef::Vector4&, float*);
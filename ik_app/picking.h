@@ -9,7 +9,51 @@
 #include <math.h>
 
 void GetScreenPosRay(const gef::Vector2& screen_position, const gef::Matrix44& projection, const gef::Matrix44& view, gef::Vector4& start_point, gef::Vector4& direction, float screen_width, float screen_height, float ndc_z_min);
+// rays for many screen positions at once, the view projection matrix is only inverted once
+void GetScreenPosRays(const gef::Vector2* screen_positions, int count, const gef::Matrix44& projection, const gef::Matrix44& view, gef::Vector4* start_points, gef::Vector4* directions, float screen_width, float screen_height, float ndc_z_min);
 bool RaySphereIntersect(const gef::Vector4& start_point, const gef::Vector4& direction, const gef::Vector4& sphere_centre, float sphere_radius, gef::Vector4& hitpoint);
 bool RayPlaneIntersect(gef::Vector4& start_point, gef::Vector4& direction, const gef::Vector4& point_on_plane, const gef::Vector4& plane_normal, gef::Vector4& hitpoint);
+// direction does not need to be normalised, t is the distance along the ray in multiples of direction
+bool RayCapsuleIntersect(const gef::Vector4& start_point, const gef::Vector4& direction, const gef::Vector4& capsule_start, const gef::Vector4& capsule_end, float capsule_radius, float& t);
+
+// A group of rays stored as structure of arrays so each query tests every ray in the packet together.
+// Directions must be normalised, max_t limits how far along each ray a hit counts, e.g. the distance
+// to the target of a line of sight check.
+template<int kWidth>
+struct RayPacket
+{
+	float start_x[kWidth];
+	float start_y[kWidth];
+	float start_z[kWidth];
+	float direction_x[kWidth];
+	float direction_y[kWidth];
+	float direction_z[kWidth];
+	float max_t[kWidth];
+
+	inline void Set(int ray, const gef::Vector4& start_point, const gef::Vector4& direction, float ray_max_t)
+	{
+		start_x[ray] = start_point.x();
+		start_y[ray] = start_point.y();
+		start_z[ray] = start_point.z();
+		direction_x[ray] = direction.x();
+		direction_y[ray] = direction.y();
+		direction_z[ray] = direction.z();
+		max_t[ray] = ray_max_t;
+	}
+
+	static const int kRayCount = kWidth;
+};
+
+typedef RayPacket<4> RayPacket4;
+typedef RayPacket<8> RayPacket8;
+
+// Closest sphere along each ray of the packet. Spheres are structure of arrays too, hit_spheres is -1 for a
+// ray that misses them all. Returns a bit mask of the rays that hit something.
+template<int kWidth>
+int RaySpherePacketIntersect(const RayPacket<kWidth>& rays, const float* sphere_x, const float* sphere_y, const float* sphere_z, const float* sphere_radius, int sphere_count, float* hit_t, int* hit_spheres);
+
+// Every ray of the packet against one plane, returns a bit mask of the rays that hit it
+template<int kWidth>
+int RayPlanePacketIntersect(const RayPacket<kWidth>& rays, const gef::Vector4& point_on_plane, const gef::Vector4& plane_normal, float* hit_t);
 
 #endif // _PICKING_H
\ No newline at end of file
@@ -0,0 +1,560 @@
+// Checks the picking queries against the simple versions they speed up: the 4 and 8 wide ray packets against
+// RaySphereIntersect and RayPlaneIntersect one ray at a time, GetScreenPosRays against GetScreenPosRay, and the
+// character and scene BVHs against testing every capsule of every character.
+// usage: picking_test [-s seed]
+// Run from blendtrees/media, the capsules are fitted to the tesla model.
+
+#include <platform/headless/system/platform_headless.h>
+#include <graphics/scene.h>
+#include <animation/skeleton.h>
+#include <maths/math_utils.h>
+#include <system/file.h>
+#include "picking.h"
+#include "character_picking.h"
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+static const char* const kModelFilename = "tesla/tesla.scn";
+static const int kRayCount = 4096;
+static const int kSphereCount = 32;
+static const int kCharacterCount = 16;
+static const float kScreenWidth = 960.0f;
+static const float kScreenHeight = 544.0f;
+
+static int g_failures = 0;
+
+static bool Check(bool condition, const char* test_name, const char* description)
+{
+	if (!condition)
+	{
+		printf("%s: %s\n", test_name, description);
+		g_failures++;
+	}
+	return condition;
+}
+
+static bool Near(float a, float b, float tolerance)
+{
+	return fabsf(a - b) <= tolerance * (1.0f + fabsf(a) + fabsf(b));
+}
+
+static bool Near(const gef::Vector4& a, const gef::Vector4& b, float tolerance)
+{
+	return Near(a.x(), b.x(), tolerance) && Near(a.y(), b.y(), tolerance) && Near(a.z(), b.z(), tolerance);
+}
+
+static gef::Vector4 RandomDirection(std::mt19937& random)
+{
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	gef::Vector4 direction;
+	do
+	{
+		direction = gef::Vector4(unit(random), unit(random), unit(random));
+	} while (direction.LengthSqr() < 0.01f);
+	direction.Normalise();
+	return direction;
+}
+
+struct Ray
+{
+	gef::Vector4 start;
+	gef::Vector4 direction;
+	float max_t;
+};
+
+// camera rays from GetScreenPosRays through random pixels, then random rays: aimed at a sphere, starting inside one,
+// running parallel to the plane or pointing anywhere, a quarter of them stopping short
+static void GenerateRays(std::mt19937& random, const std::vector<gef::Vector4>& sphere_centres, const std::vector<float>& sphere_radii,
+	const gef::Vector4& plane_normal, const gef::Matrix44& projection, const gef::Matrix44& view, std::vector<Ray>& rays)
+{
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	std::uniform_int_distribution<int> pick_sphere(0, (int)sphere_centres.size() - 1);
+
+	const int screen_ray_count = kRayCount / 4;
+	std::vector<gef::Vector2> screen_positions(screen_ray_count);
+	std::vector<gef::Vector4> start_points(screen_ray_count);
+	std::vector<gef::Vector4> directions(screen_ray_count);
+	for (int ray_num = 0; ray_num < screen_ray_count; ++ray_num)
+		screen_positions[ray_num] = gef::Vector2(unit(random) * kScreenWidth, unit(random) * kScreenHeight);
+	GetScreenPosRays(&screen_positions[0], screen_ray_count, projection, view, &start_points[0], &directions[0], kScreenWidth, kScreenHeight, -1.0f);
+
+	rays.resize(kRayCount);
+	for (int ray_num = 0; ray_num < kRayCount; ++ray_num)
+	{
+		Ray& ray = rays[ray_num];
+		const int sphere = pick_sphere(random);
+		if (ray_num < screen_ray_count)
+		{
+			ray.start = start_points[ray_num];
+			ray.direction = directions[ray_num];
+		}
+		else
+		{
+			ray.start = gef::Vector4(unit(random) * 20.0f - 10.0f, unit(random) * 20.0f - 10.0f, unit(random) * 20.0f - 10.0f);
+			switch (ray_num & 3)
+			{
+			case 0:
+				ray.direction = sphere_centres[sphere] + RandomDirection(random) * (sphere_radii[sphere] * unit(random)) - ray.start;
+				ray.direction.Normalise();
+				break;
+			case 1:
+				ray.start = sphere_centres[sphere] + RandomDirection(random) * (sphere_radii[sphere] * 0.9f * unit(random));
+				ray.direction = RandomDirection(random);
+				break;
+			case 2:
+				ray.direction = RandomDirection(random).CrossProduct(plane_normal);
+				ray.direction.Normalise();
+				break;
+			default:
+				ray.direction = RandomDirection(random);
+				break;
+			}
+		}
+		ray.max_t = unit(random) < 0.25f ? unit(random) * 15.0f : FLT_MAX;
+	}
+}
+
+static void TestScreenRays(std::mt19937& random, const gef::Matrix44& projection, const gef::Matrix44& view)
+{
+	const char* const test_name = "screen rays";
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+	const int kPositionCount = 64;
+	gef::Vector2 screen_positions[kPositionCount];
+	gef::Vector4 start_points[kPositionCount];
+	gef::Vector4 directions[kPositionCount];
+	for (int position_num = 0; position_num < kPositionCount; ++position_num)
+		screen_positions[position_num] = gef::Vector2(unit(random) * kScreenWidth, unit(random) * kScreenHeight);
+	GetScreenPosRays(screen_positions, kPositionCount, projection, view, start_points, directions, kScreenWidth, kScreenHeight, -1.0f);
+
+	int mismatches = 0;
+	int off_screen_position = 0;
+	for (int position_num = 0; position_num < kPositionCount; ++position_num)
+	{
+		gef::Vector4 start_point, direction;
+		GetScreenPosRay(screen_positions[position_num], projection, view, start_point, direction, kScreenWidth, kScreenHeight, -1.0f);
+		if (!Near(start_point, start_points[position_num], 1e-6f) || !Near(direction, directions[position_num], 1e-6f))
+			mismatches++;
+
+		// any point along the ray projects back onto the pixel it was cast through
+		gef::Vector4 point = start_points[position_num] + directions[position_num] * 5.0f;
+		gef::Vector4 clip = gef::Vector4(point.x(), point.y(), point.z(), 1.0f).TransformW(view * projection);
+		const float screen_x = (clip.x() / clip.w() + 1.0f) * 0.5f * kScreenWidth;
+		const float screen_y = (1.0f - clip.y() / clip.w()) * 0.5f * kScreenHeight;
+		if (fabsf(screen_x - screen_positions[position_num].x) > 0.01f || fabsf(screen_y - screen_positions[position_num].y) > 0.01f)
+			off_screen_position++;
+	}
+	Check(mismatches == 0, test_name, "batched rays differ from GetScreenPosRay");
+	Check(off_screen_position == 0, test_name, "a ray doesn't pass back through its screen position");
+}
+
+// closest sphere along the ray one sphere at a time, the same rules as the packets: a hit has to be nearer than max_t
+// and an equally near later sphere doesn't replace an earlier one
+static int ClosestSphere(const Ray& ray, const std::vector<gef::Vector4>& sphere_centres, const std::vector<float>& sphere_radii, std::vector<float>& sphere_t)
+{
+	int closest_sphere = -1;
+	float closest_t = ray.max_t;
+	for (size_t sphere = 0; sphere < sphere_centres.size(); ++sphere)
+	{
+		gef::Vector4 hitpoint;
+		sphere_t[sphere] = FLT_MAX;
+		if (!RaySphereIntersect(ray.start, ray.direction, sphere_centres[sphere], sphere_radii[sphere], hitpoint))
+			continue;
+
+		sphere_t[sphere] = (hitpoint - ray.start).DotProduct(ray.direction);
+		if (sphere_t[sphere] < closest_t)
+		{
+			closest_t = sphere_t[sphere];
+			closest_sphere = (int)sphere;
+		}
+	}
+	return closest_sphere;
+}
+
+template<int kWidth>
+static void TestSpherePacket(const char* test_name, const std::vector<Ray>& rays, const std::vector<gef::Vector4>& sphere_centres, const std::vector<float>& sphere_radii)
+{
+	std::vector<float> sphere_x, sphere_y, sphere_z;
+	for (size_t sphere = 0; sphere < sphere_centres.size(); ++sphere)
+	{
+		sphere_x.push_back(sphere_centres[sphere].x());
+		sphere_y.push_back(sphere_centres[sphere].y());
+		sphere_z.push_back(sphere_centres[sphere].z());
+	}
+
+	int hit_count = 0;
+	int wrong_mask = 0;
+	int wrong_sphere = 0;
+	int wrong_t = 0;
+	std::vector<float> sphere_t(sphere_centres.size());
+	for (size_t first_ray = 0; first_ray + kWidth <= rays.size(); first_ray += kWidth)
+	{
+		RayPacket<kWidth> packet;
+		for (int ray = 0; ray < kWidth; ++ray)
+			packet.Set(ray, rays[first_ray + ray].start, rays[first_ray + ray].direction, rays[first_ray + ray].max_t);
+
+		float hit_t[kWidth];
+		int hit_spheres[kWidth];
+		const int hit_mask = RaySpherePacketIntersect(packet, &sphere_x[0], &sphere_y[0], &sphere_z[0], &sphere_radii[0], (int)sphere_centres.size(), hit_t, hit_spheres);
+
+		for (int ray = 0; ray < kWidth; ++ray)
+		{
+			const int closest_sphere = ClosestSphere(rays[first_ray + ray], sphere_centres, sphere_radii, sphere_t);
+			const bool hit = closest_sphere != -1;
+			if (hit != (((hit_mask >> ray) & 1) != 0) || hit != (hit_spheres[ray] != -1))
+			{
+				wrong_mask++;
+				continue;
+			}
+			if (!hit)
+				continue;
+
+			hit_count++;
+			// spheres hit at almost the same distance can come out in either order
+			if (hit_spheres[ray] != closest_sphere && !Near(sphere_t[hit_spheres[ray]], sphere_t[closest_sphere], 1e-5f))
+				wrong_sphere++;
+			else if (!Near(hit_t[ray], sphere_t[closest_sphere], 1e-5f))
+				wrong_t++;
+		}
+	}
+
+	Check(hit_count > (int)rays.size() / 4 && hit_count < (int)rays.size() * 3 / 4, test_name, "too few rays hit or miss the spheres for a useful test");
+	Check(wrong_mask == 0, test_name, "packet and scalar rays disagree on hitting a sphere");
+	Check(wrong_sphere == 0, test_name, "packet and scalar rays hit different spheres");
+	Check(wrong_t == 0, test_name, "packet and scalar rays hit a sphere at different distances");
+}
+
+template<int kWidth>
+static void TestPlanePacket(const char* test_name, const std::vector<Ray>& rays, const gef::Vector4& point_on_plane, const gef::Vector4& plane_normal)
+{
+	int hit_count = 0;
+	int parallel_count = 0;
+	int wrong_mask = 0;
+	int wrong_t = 0;
+	for (size_t first_ray = 0; first_ray + kWidth <= rays.size(); first_ray += kWidth)
+	{
+		RayPacket<kWidth> packet;
+		for (int ray = 0; ray < kWidth; ++ray)
+			packet.Set(ray, rays[first_ray + ray].start, rays[first_ray + ray].direction, rays[first_ray + ray].max_t);
+
+		float hit_t[kWidth];
+		const int hit_mask = RayPlanePacketIntersect(packet, point_on_plane, plane_normal, hit_t);
+
+		for (int ray = 0; ray < kWidth; ++ray)
+		{
+			// RayPlaneIntersect takes its ray by non const reference
+			gef::Vector4 start = rays[first_ray + ray].start;
+			gef::Vector4 direction = rays[first_ray + ray].direction;
+			gef::Vector4 hitpoint;
+			bool hit = RayPlaneIntersect(start, direction, point_on_plane, plane_normal, hitpoint);
+			const float t = hit ? (hitpoint - start).DotProduct(direction) : 0.0f;
+			hit = hit && t <= rays[first_ray + ray].max_t;
+
+			if (fabsf(plane_normal.DotProduct(direction)) <= 1e-6f)
+				parallel_count++;
+			if (hit != (((hit_mask >> ray) & 1) != 0))
+				wrong_mask++;
+			else if (hit && !Near(hit_t[ray], t, 1e-5f))
+				wrong_t++;
+			hit_count += hit;
+		}
+	}
+
+	Check(hit_count > (int)rays.size() / 8 && parallel_count > 0, test_name, "too few rays hit the plane or run parallel to it for a useful test");
+	Check(wrong_mask == 0, test_name, "packet and scalar rays disagree on hitting the plane");
+	Check(wrong_t == 0, test_name, "packet and scalar rays hit the plane at different distances");
+}
+
+static void TestPackets(std::mt19937& random, const gef::Matrix44& projection, const gef::Matrix44& view)
+{
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+	std::vector<gef::Vector4> sphere_centres(kSphereCount);
+	std::vector<float> sphere_radii(kSphereCount);
+	for (int sphere = 0; sphere < kSphereCount; ++sphere)
+	{
+		sphere_centres[sphere] = gef::Vector4(unit(random) * 16.0f - 8.0f, unit(random) * 16.0f - 8.0f, unit(random) * 16.0f - 8.0f);
+		sphere_radii[sphere] = 0.25f + unit(random) * 1.5f;
+	}
+
+	const gef::Vector4 plane_normal = RandomDirection(random);
+	const gef::Vector4 point_on_plane = plane_normal * (unit(random) * 4.0f - 2.0f);
+
+	std::vector<Ray> rays;
+	GenerateRays(random, sphere_centres, sphere_radii, plane_normal, projection, view, rays);
+
+	TestSpherePacket<4>("sphere packet 4", rays, sphere_centres, sphere_radii);
+	TestSpherePacket<8>("sphere packet 8", rays, sphere_centres, sphere_radii);
+	TestPlanePacket<4>("plane packet 4", rays, point_on_plane, plane_normal);
+	TestPlanePacket<8>("plane packet 8", rays, point_on_plane, plane_normal);
+}
+
+// nearest capsule of one character, testing every capsule
+static bool BruteForceRaycast(const CharacterPicker& picker, const gef::Vector4& start, const gef::Vector4& direction, float max_t, float& hit_t, int& hit_capsule)
+{
+	hit_capsule = -1;
+	hit_t = max_t;
+	const std::vector<CharacterPicker::Capsule>& capsules = picker.capsules();
+	for (size_t capsule_num = 0; capsule_num < capsules.size(); ++capsule_num)
+	{
+		const CharacterPicker::Capsule& capsule = capsules[capsule_num];
+		float t;
+		if (RayCapsuleIntersect(start, direction, capsule.start, capsule.end, capsule.radius, t) && t < hit_t)
+		{
+			hit_t = t;
+			hit_capsule = (int)capsule_num;
+		}
+	}
+	return hit_capsule != -1;
+}
+
+// t of the ray against the capsule of a joint, FLT_MAX on a miss
+static float CapsuleT(const CharacterPicker& picker, int joint, const gef::Vector4& start, const gef::Vector4& direction)
+{
+	const std::vector<CharacterPicker::Capsule>& capsules = picker.capsules();
+	float closest_t = FLT_MAX;
+	for (size_t capsule_num = 0; capsule_num < capsules.size(); ++capsule_num)
+	{
+		const CharacterPicker::Capsule& capsule = capsules[capsule_num];
+		float t;
+		if (capsule.joint == joint && RayCapsuleIntersect(start, direction, capsule.start, capsule.end, capsule.radius, t) && t < closest_t)
+			closest_t = t;
+	}
+	return closest_t;
+}
+
+// distance from point to the surface of the capsule, negative inside
+static float CapsuleDistance(const CharacterPicker::Capsule& capsule, const gef::Vector4& point)
+{
+	const gef::Vector4 segment = capsule.end - capsule.start;
+	float s = segment.LengthSqr() > 0.0f ? (point - capsule.start).DotProduct(segment) / segment.LengthSqr() : 0.0f;
+	s = s < 0.0f ? 0.0f : (s > 1.0f ? 1.0f : s);
+	return (point - (capsule.start + segment * s)).Length() - capsule.radius;
+}
+
+static void RandomPose(std::mt19937& random, const gef::SkeletonPose& bind_pose, gef::SkeletonPose& pose)
+{
+	std::uniform_real_distribution<float> angle(-0.4f, 0.4f);
+	pose = bind_pose;
+	for (size_t joint_num = 0; joint_num < pose.local_pose().size(); ++joint_num)
+	{
+		const gef::Vector4 axis = RandomDirection(random);
+		const float half_angle = 0.5f * angle(random);
+		gef::Quaternion turn(axis.x() * sinf(half_angle), axis.y() * sinf(half_angle), axis.z() * sinf(half_angle), cosf(half_angle));
+
+		gef::JointPose& joint_pose = pose.local_pose()[joint_num];
+		gef::Quaternion rotation = turn * joint_pose.rotation();
+		rotation.Normalise();
+		joint_pose.set_rotation(rotation);
+	}
+	pose.CalculateGlobalPose();
+}
+
+// a ray from well outside the bounds towards a random point near them, so about half hit the body
+static void RandomRayAt(std::mt19937& random, const gef::Aabb& bounds, gef::Vector4& start, gef::Vector4& direction)
+{
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	const gef::Vector4 centre = (bounds.min_vtx() + bounds.max_vtx()) * 0.5f;
+	const gef::Vector4 size = bounds.max_vtx() - bounds.min_vtx();
+	const gef::Vector4 target(bounds.min_vtx().x() + size.x() * unit(random), bounds.min_vtx().y() + size.y() * unit(random), bounds.min_vtx().z() + size.z() * unit(random));
+	start = centre + RandomDirection(random) * (size.Length() * 2.0f);
+	direction = target - start;
+	direction.Normalise();
+}
+
+static void TestCharacter(std::mt19937& random, const CharacterPicker& picker)
+{
+	const char* const test_name = "character bvh";
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+	int hit_count = 0;
+	int wrong_hit = 0;
+	int wrong_joint = 0;
+	int wrong_t = 0;
+	int off_surface = 0;
+	for (int ray_num = 0; ray_num < kRayCount; ++ray_num)
+	{
+		gef::Vector4 start, direction;
+		RandomRayAt(random, picker.bounds(), start, direction);
+		// some rays stop short of the body
+		const float max_t = (ray_num & 7) == 0 ? (picker.bounds().max_vtx() - picker.bounds().min_vtx()).Length() * 3.0f * unit(random) : FLT_MAX;
+
+		float hit_t, expected_t;
+		int hit_joint, expected_capsule;
+		const bool hit = picker.Raycast(start, direction, max_t, hit_t, hit_joint);
+		const bool expected_hit = BruteForceRaycast(picker, start, direction, max_t, expected_t, expected_capsule);
+		if (hit != expected_hit)
+		{
+			wrong_hit++;
+			continue;
+		}
+		if (!hit)
+			continue;
+
+		hit_count++;
+		const CharacterPicker::Capsule& expected = picker.capsules()[expected_capsule];
+		// two capsules hit at exactly the same t, where bones meet, can come back in either order
+		if (hit_joint != expected.joint && CapsuleT(picker, hit_joint, start, direction) != expected_t)
+			wrong_joint++;
+		else if (hit_t != expected_t)
+			wrong_t++;
+
+		const gef::Vector4 hit_point = start + direction * hit_t;
+		if (hit_t > 0.0f && fabsf(CapsuleDistance(expected, hit_point)) > 1e-3f * (1.0f + expected.radius))
+			off_surface++;
+	}
+
+	Check(hit_count > kRayCount / 8 && hit_count < kRayCount * 7 / 8, test_name, "too few rays hit or miss the character for a useful test");
+	Check(wrong_hit == 0, test_name, "bvh and brute force disagree on hitting the character");
+	Check(wrong_joint == 0, test_name, "bvh and brute force hit different joints");
+	Check(wrong_t == 0, test_name, "bvh and brute force hit at different distances");
+	Check(off_surface == 0, test_name, "hit point isn't on the surface of the capsule");
+}
+
+static void TestScene(std::mt19937& random, const CharacterPicker* pickers, int picker_count)
+{
+	const char* const test_name = "scene bvh";
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+	// a loose crowd, close enough that rays pass through several characters
+	PickScene pick_scene;
+	pick_scene.Init(kCharacterCount);
+	std::vector<gef::Matrix44> transforms(kCharacterCount);
+	std::vector<gef::Matrix44> inv_transforms(kCharacterCount);
+	gef::Aabb crowd_bounds;
+	for (int character = 0; character < kCharacterCount; ++character)
+	{
+		gef::Matrix44 rotation, scale;
+		rotation.RotationZ(unit(random) * 2.0f * FRAMEWORK_PI);
+		scale.Scale(gef::Vector4(0.8f, 0.8f, 0.8f) + gef::Vector4(0.4f, 0.4f, 0.4f) * unit(random));
+		transforms[character] = scale * rotation;
+		transforms[character].SetTranslation(gef::Vector4(unit(random) * 3.0f - 1.5f, unit(random) * 3.0f - 1.5f, 0.0f));
+		inv_transforms[character].Inverse(transforms[character]);
+
+		const CharacterPicker& picker = pickers[character % picker_count];
+		Check(pick_scene.AddCharacter(picker, transforms[character]) == character, test_name, "characters should be numbered in the order they're added");
+		crowd_bounds.Update(picker.bounds().Transform(transforms[character]).min_vtx());
+		crowd_bounds.Update(picker.bounds().Transform(transforms[character]).max_vtx());
+	}
+	pick_scene.Build();
+
+	int hit_count = 0;
+	int wrong_hit = 0;
+	int wrong_joint = 0;
+	int wrong_position = 0;
+	for (int ray_num = 0; ray_num < kRayCount; ++ray_num)
+	{
+		gef::Vector4 start, direction;
+		RandomRayAt(random, crowd_bounds, start, direction);
+
+		PickResult result;
+		const bool hit = pick_scene.Raycast(start, direction, result);
+
+		// every capsule of every character, the same model space ray the scene uses
+		int expected_character = -1;
+		int expected_joint = -1;
+		float expected_t = FLT_MAX;
+		for (int character = 0; character < kCharacterCount; ++character)
+		{
+			const CharacterPicker& picker = pickers[character % picker_count];
+			const gef::Vector4 model_start = start.Transform(inv_transforms[character]);
+			const gef::Vector4 model_direction = direction.TransformNoTranslation(inv_transforms[character]);
+			float t;
+			int capsule;
+			if (BruteForceRaycast(picker, model_start, model_direction, expected_t, t, capsule))
+			{
+				expected_t = t;
+				expected_character = character;
+				expected_joint = picker.capsules()[capsule].joint;
+			}
+		}
+
+		if (hit != (expected_character != -1))
+		{
+			wrong_hit++;
+			continue;
+		}
+		if (!hit)
+			continue;
+
+		hit_count++;
+		if (result.character != expected_character || result.joint != expected_joint)
+		{
+			// an exact tie, between characters or between bones, can come back in either order
+			const CharacterPicker& picker = pickers[result.character % picker_count];
+			const gef::Vector4 model_start = start.Transform(inv_transforms[result.character]);
+			const gef::Vector4 model_direction = direction.TransformNoTranslation(inv_transforms[result.character]);
+			if (CapsuleT(picker, result.joint, model_start, model_direction) != expected_t)
+				wrong_joint++;
+		}
+
+		const gef::Vector4 expected_position = start + direction * expected_t;
+		if (!Near(result.world_position, expected_position, 1e-5f) || !Near(result.model_position, expected_position.Transform(inv_transforms[result.character]), 1e-4f))
+			wrong_position++;
+	}
+
+	Check(hit_count > kRayCount / 8 && hit_count < kRayCount * 7 / 8, test_name, "too few rays hit or miss the crowd for a useful test");
+	Check(wrong_hit == 0, test_name, "bvh and brute force disagree on hitting the crowd");
+	Check(wrong_joint == 0, test_name, "bvh and brute force hit different characters or joints");
+	Check(wrong_position == 0, test_name, "bvh and brute force hit at different positions");
+}
+
+int main(int argc, char* argv[])
+{
+	unsigned int seed = 1;
+	for (int arg_num = 1; arg_num < argc; ++arg_num)
+	{
+		if (strcmp(argv[arg_num], "-s") == 0 && arg_num + 1 < argc)
+			seed = (unsigned int)strtoul(argv[++arg_num], NULL, 10);
+	}
+	std::mt19937 random(seed);
+
+	gef::PlatformHeadless platform((Int32)kScreenWidth, (Int32)kScreenHeight);
+
+	gef::Matrix44 projection, view;
+	projection.PerspectiveFovGL(gef::DegToRad(45.0f), kScreenWidth / kScreenHeight, 0.1f, 100.0f);
+	view.LookAt(gef::Vector4(4.0f, 12.0f, 20.0f), gef::Vector4(0.0f, 0.0f, 0.0f), gef::Vector4(0.0f, 1.0f, 0.0f));
+
+	TestScreenRays(random, projection, view);
+	TestPackets(random, projection, view);
+
+	gef::File* file = gef::File::Create();
+	const bool scene_exists = file->Exists(kModelFilename);
+	delete file;
+
+	gef::Scene scene;
+	if (Check(scene_exists && scene.ReadSceneFromFile(platform, kModelFilename) && !scene.skeletons.empty() && !scene.mesh_data.empty(), "character bvh", "couldn't load the tesla"))
+	{
+		const gef::Skeleton& skeleton = *scene.skeletons.front();
+		gef::SkeletonPose bind_pose;
+		bind_pose.CreateBindPose(&skeleton);
+		bind_pose.CalculateGlobalPose();
+
+		// one picker fitted to the mesh and one from the bones alone, each in a different pose
+		CharacterPicker pickers[2];
+		gef::SkeletonPose pose;
+		for (int picker_num = 0; picker_num < 2; ++picker_num)
+		{
+			Check(pickers[picker_num].Init(skeleton, picker_num == 0 ? &scene.mesh_data.front() : NULL), "character bvh", "picker failed to initialise");
+			RandomPose(random, bind_pose, pose);
+			pickers[picker_num].Refit(pose);
+			TestCharacter(random, pickers[picker_num]);
+		}
+
+		TestScene(random, pickers, 2);
+	}
+
+	if (g_failures)
+	{
+		printf("%d checks failed\n", g_failures);
+		return 1;
+	}
+
+	printf("all checks passed\n");
+	return 0;
+}
@@ -1,10 +1,10 @@
 #include "primitive_renderer.h"
 #include "vertex_colour_unlit_shader.h"
-#include "system\platform.h"
-#include "graphics\vertex_buffer.h"
-#include "graphics\index_buffer.h"
-#include "graphics\renderer_3d.h"
-#include "graphics\shader_interface.h"
+#include "system/platform.h"
+#include "graphics/vertex_buffer.h"
+#include "graphics/index_buffer.h"
+#include "graphics/renderer_3d.h"
+#include "graphics/shader_interface.h"
 
 
 
@@ -40,7 +40,7 @@ PrimitiveRenderer::PrimitiveRenderer(gef::Platform& platform, UInt32 max_num_lin
 	triangles_index_buffer_ = gef::IndexBuffer::Create(platform);
 	triangles_index_buffer_->Init(platform, indices, max_num_triangles_ * 3, sizeof(UInt32));
 
-	delete indices;
+	delete[] indices;
 	indices = nullptr;
 }
 
@@ -0,0 +1,113 @@
+#include "two_bone.h"
+#include <system/profiler.h>
+#include <system/memory_tracker.h>
+#include <maths/math_utils.h>
+#include <algorithm>
+#include <cmath>
+
+static inline float Clamp(float value, float min_value, float max_value)
+{
+	return std::min(std::max(value, min_value), max_value);
+}
+
+// any unit vector at right angles to v
+static gef::Vector4 Perpendicular(const gef::Vector4& v)
+{
+	gef::Vector4 perpendicular = fabsf(v.x()) < 0.9f ? gef::Vector4(1.0f, 0.0f, 0.0f).CrossProduct(v) : gef::Vector4(0.0f, 1.0f, 0.0f).CrossProduct(v);
+	perpendicular.Normalise();
+	return perpendicular;
+}
+
+TwoBoneSolver::TwoBoneSolver() :
+	pole_vector_(0.0f, 0.0f, 0.0f),
+	use_pole_vector_(false)
+{
+}
+
+bool TwoBoneSolver::Init(const gef::Skeleton& skeleton, const std::vector<int>& bone_indices, const std::vector<std::pair<float, float>>& constraints)
+{
+	if (bone_indices.size() != 3)
+		return false;
+
+	return IKSolver::Init(skeleton, bone_indices, constraints);
+}
+
+bool TwoBoneSolver::Solve(gef::SkeletonPose& pose, const gef::Vector4& target)
+{
+	GEF_PROFILE_ZONE("TwoBoneSolver::Solve");
+	GEF_MEMORY_TAG(gef::MT_IK);
+
+	if (bone_indices_.size() != 3)
+		return false;
+
+	ReadChain(pose);
+
+	const gef::Vector4 root = global_positions_[0];
+	const gef::Vector4 upper = global_positions_[1] - root;
+	const gef::Vector4 lower = global_positions_[2] - global_positions_[1];
+	const float upper_length = upper.Length();
+	const float lower_length = lower.Length();
+	if (upper_length <= 0.0f || lower_length <= 0.0f)
+		return false;
+
+	// the bend limits of the middle joint give the shortest and longest reach of the limb
+	// reach^2 = upper^2 + lower^2 + 2 * upper * lower * cos(bend)
+	const float min_bend = Clamp(constraints_[1].first, 0.0f, FRAMEWORK_PI);
+	const float max_bend = Clamp(constraints_[1].second, min_bend, FRAMEWORK_PI);
+	const float length_sqr_sum = upper_length * upper_length + lower_length * lower_length;
+	const float length_product = 2.0f * upper_length * lower_length;
+	const float min_reach = sqrtf(std::max(length_sqr_sum + length_product * cosf(max_bend), 0.0f));
+	const float max_reach = sqrtf(length_sqr_sum + length_product * cosf(min_bend));
+
+	// aim at the target, or keep pointing the way the limb does if the target is on top of the root
+	gef::Vector4 to_target = target - root;
+	float target_distance = to_target.Length();
+	gef::Vector4 aim = target_distance > 1e-6f ? to_target / target_distance : (global_positions_[2] - root) / std::max((global_positions_[2] - root).Length(), 1e-6f);
+	const float reach = Clamp(target_distance, std::max(min_reach, 1e-4f), max_reach);
+
+	// the bend plane goes through the pole or through the current middle joint
+	gef::Vector4 bend = use_pole_vector_ ? pole_vector_ - root : upper;
+	bend -= aim * bend.DotProduct(aim);
+	float bend_length = bend.Length();
+	bend = bend_length > 1e-6f ? bend / bend_length : Perpendicular(aim);
+
+	// law of cosines for the angle at the root between the aim and the upper bone
+	const float cos_root_angle = Clamp((upper_length * upper_length + reach * reach - lower_length * lower_length) / (2.0f * upper_length * reach), -1.0f, 1.0f);
+	const float sin_root_angle = sqrtf(1.0f - cos_root_angle * cos_root_angle);
+
+	const gef::Vector4 solved_upper = (aim * cos_root_angle + bend * sin_root_angle) * upper_length;
+	const gef::Vector4 solved_lower = aim * reach - solved_upper;
+
+	// swing the root so the upper bone lines up with the solved one
+	const gef::Vector4 upper_direction = upper / upper_length;
+	const gef::Vector4 solved_upper_direction = solved_upper / upper_length;
+	gef::Quaternion swing = RotationBetween(upper_direction, solved_upper_direction);
+
+	// then twist it about the upper bone so the middle joint hinges in the bend plane
+	gef::Vector4 plane_normal = upper_direction.CrossProduct(lower);
+	gef::Vector4 solved_plane_normal = solved_upper_direction.CrossProduct(solved_lower);
+	float plane_normal_length = plane_normal.Length();
+	float solved_plane_normal_length = solved_plane_normal.Length();
+	if (plane_normal_length > 1e-6f && solved_plane_normal_length > 1e-6f)
+	{
+		// both normals are at right angles to the solved upper bone, so the twist is about it
+		gef::Vector4 swung_plane_normal = RotateVector(swing, plane_normal / plane_normal_length);
+		solved_plane_normal /= solved_plane_normal_length;
+		float half_twist = 0.5f * atan2f(swung_plane_normal.CrossProduct(solved_plane_normal).DotProduct(solved_upper_direction), swung_plane_normal.DotProduct(solved_plane_normal));
+		gef::Vector4 twist_axis = solved_upper_direction * sinf(half_twist);
+		swing = swing * gef::Quaternion(twist_axis.x(), twist_axis.y(), twist_axis.z(), cosf(half_twist));
+		swing.Normalise();
+	}
+	RotateJoint(0, swing);
+
+	// the middle joint now only has to bend
+	gef::Vector4 current_lower = global_positions_[2] - global_positions_[1];
+	RotateJoint(1, RotationBetween(current_lower / lower_length, solved_lower / lower_length));
+
+	iterations_ = 1;
+	error_ = (global_positions_[2] - target).Length();
+
+	WriteChain(pose);
+
+	return error_ <= epsilon_;
+}
@@ -0,0 +1,31 @@
+#ifndef _TWO_BONE_H
+#define _TWO_BONE_H
+
+#include "ik_solver.h"
+
+// Closed form solver for a three joint limb such as shoulder, elbow and wrist or hip, knee and ankle.
+// The law of cosines gives the bend of the middle joint directly, so a solve always costs the same.
+// The limb bends in the plane through the root, the target and the pole vector. Without a pole vector
+// the limb keeps the bend plane it already has. The constraint of the middle joint limits how far it
+// can bend, where zero is a straight limb, the other constraints are unused.
+class TwoBoneSolver : public IKSolver
+{
+public:
+	TwoBoneSolver();
+
+	bool Init(const gef::Skeleton& skeleton, const std::vector<int>& bone_indices, const std::vector<std::pair<float, float>>& constraints);
+	bool Solve(gef::SkeletonPose& pose, const gef::Vector4& target);
+	const char* name() const { return "Two bone"; }
+
+	// pole is a model space point the middle joint bends towards
+	inline void set_pole_vector(const gef::Vector4& pole) { pole_vector_ = pole; use_pole_vector_ = true; }
+	inline void clear_pole_vector() { use_pole_vector_ = false; }
+	inline const gef::Vector4& pole_vector() const { return pole_vector_; }
+	inline bool use_pole_vector() const { return use_pole_vector_; }
+
+private:
+	gef::Vector4 pole_vector_;
+	bool use_pole_vector_;
+};
+
+#endif // _TWO_BONE_H